@@ -4,19 +4,24 @@
 
 #include "chrome/browser/after_startup_task_utils.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
 #include <utility>
 
 #include "base/containers/circular_deque.h"
 #include "base/lazy_instance.h"
 #include "base/macros.h"
-#include "base/memory/ptr_util.h"
+#include "base/memory/ref_counted.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/process/process.h"
 #include "base/rand_util.h"
 #include "base/sequence_checker.h"
 #include "base/sequenced_task_runner.h"
 #include "base/synchronization/atomic_flag.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
 #include "build/build_config.h"
 #include "build/chromeos_buildflags.h"
 #include "content/public/browser/browser_task_traits.h"
@@ -45,24 +50,207 @@ using content::WebContentsObserver;
 
 namespace {
 
+using Priority = AfterStartupTaskUtils::Priority;
+
+constexpr size_t kPriorityCount =
+    static_cast<size_t>(Priority::kBestEffort) + 1;
+
+// Bounds of the number of queued tasks released at a time. The first slice is
+// released as soon as startup is complete.
+constexpr size_t kInitialSliceSize = 4;
+constexpr size_t kMaxSliceSize = 32;
+
+// The time between the release of two slices.
+constexpr base::TimeDelta kSliceInterval =
+    base::TimeDelta::FromMilliseconds(50);
+
+// A slice which waits longer than this for the UI thread past its interval
+// means that the UI thread is busy, and the slices shrink.
+constexpr base::TimeDelta kBusyUIThreadDelay =
+    base::TimeDelta::FromMilliseconds(16);
+
+// Released tasks which haven't run after this long no longer hold back the
+// next slices. Their sequence may not run them until much later, as with
+// BEST_EFFORT sequences while the browser is busy, and the queued tasks,
+// including kHigh ones, would wait on it.
+constexpr base::TimeDelta kMaxInFlightAge = base::TimeDelta::FromSeconds(1);
+
+// Counts the tasks of a slice which were released but have not run yet. Tasks
+// may run, or be dropped, on any sequence.
+class ReleasedSlice : public base::RefCountedThreadSafe<ReleasedSlice> {
+ public:
+  explicit ReleasedSlice(base::TimeTicks release_time)
+      : release_time_(release_time) {}
+  ReleasedSlice(const ReleasedSlice&) = delete;
+  ReleasedSlice& operator=(const ReleasedSlice&) = delete;
+
+  base::TimeTicks release_time() const { return release_time_; }
+
+  size_t tasks_in_flight() const {
+    return tasks_in_flight_.load(std::memory_order_relaxed);
+  }
+
+  void OnTaskReleased() {
+    tasks_in_flight_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void OnTaskDone() {
+    tasks_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ReleasedSlice>;
+  ~ReleasedSlice() = default;
+
+  const base::TimeTicks release_time_;
+  std::atomic<size_t> tasks_in_flight_{0};
+};
+
 struct AfterStartupTask {
   AfterStartupTask(const base::Location& from_here,
                    const scoped_refptr<base::SequencedTaskRunner>& task_runner,
-                   base::OnceClosure task)
-      : from_here(from_here), task_runner(task_runner), task(std::move(task)) {}
-  ~AfterStartupTask() {}
+                   base::OnceClosure task,
+                   Priority priority)
+      : from_here(from_here),
+        task_runner(task_runner),
+        task(std::move(task)),
+        priority(priority) {}
+  ~AfterStartupTask() {
+    if (released_slice)
+      released_slice->OnTaskDone();
+  }
 
   const base::Location from_here;
   const scoped_refptr<base::SequencedTaskRunner> task_runner;
   base::OnceClosure task;
+  const Priority priority;
+
+  // The slice the task was released in, if it was queued.
+  scoped_refptr<ReleasedSlice> released_slice;
+};
+
+void ScheduleTask(std::unique_ptr<AfterStartupTask> queued_task);
+void SetAfterStartupTasksReleased();
+
+// Holds the tasks posted during startup, and releases them a slice at a time
+// once startup is complete. A slice shrinks when the UI thread is busy, and
+// only makes up for the tasks of recent slices which have run: tasks waiting
+// on their sequences mean that those sequences, or the disk they block on, are
+// still busy. May only be accessed on the UI thread.
+class AfterStartupTaskQueue {
+ public:
+  AfterStartupTaskQueue() = default;
+  AfterStartupTaskQueue(const AfterStartupTaskQueue&) = delete;
+  AfterStartupTaskQueue& operator=(const AfterStartupTaskQueue&) = delete;
+
+  void Push(std::unique_ptr<AfterStartupTask> queued_task) {
+    queues_[static_cast<size_t>(queued_task->priority)].push_back(
+        std::move(queued_task));
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (const auto& queue : queues_)
+      size += queue.size();
+    return size;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Releases the first slice of tasks, and schedules the release of the rest.
+  void StartRelease() {
+    release_start_time_ = base::TimeTicks::Now();
+    ReleaseTasks();
+  }
+
+  void ResetForTesting() {
+    DCHECK(empty());
+    slice_size_ = kInitialSliceSize;
+    recent_slices_.clear();
+  }
+
+ private:
+  // |scheduled_time| is when the slice was meant to be released.
+  void ReleaseSlice(base::TimeTicks scheduled_time) {
+    if (base::TimeTicks::Now() - scheduled_time > kBusyUIThreadDelay)
+      slice_size_ = std::max<size_t>(slice_size_ / 2, 1);
+    else
+      slice_size_ = std::min(slice_size_ * 2, kMaxSliceSize);
+    ReleaseTasks();
+  }
+
+  void ReleaseTasks() {
+    const base::TimeTicks now = base::TimeTicks::Now();
+    while (!recent_slices_.empty() &&
+           now - recent_slices_.front()->release_time() > kMaxInFlightAge) {
+      recent_slices_.pop_front();
+    }
+    size_t in_flight = 0;
+    for (const auto& slice : recent_slices_)
+      in_flight += slice->tasks_in_flight();
+
+    auto slice = base::MakeRefCounted<ReleasedSlice>(now);
+    for (size_t released = in_flight; released < slice_size_ && !empty();
+         ++released) {
+      std::unique_ptr<AfterStartupTask> queued_task = Pop();
+      queued_task->released_slice = slice;
+      slice->OnTaskReleased();
+      ScheduleTask(std::move(queued_task));
+    }
+    recent_slices_.push_back(std::move(slice));
+
+    if (empty()) {
+      UMA_HISTOGRAM_LONG_TIMES("Startup.AfterStartupTaskReleaseTime",
+                               base::TimeTicks::Now() - release_start_time_);
+      SetAfterStartupTasksReleased();
+      return;
+    }
+
+    // Posted with USER_VISIBLE priority to avoid this becoming an after startup
+    // task itself. The queue is leaky, so it outlives the task.
+    content::GetUIThreadTaskRunner({base::TaskPriority::USER_VISIBLE})
+        ->PostDelayedTask(
+            FROM_HERE,
+            base::BindOnce(&AfterStartupTaskQueue::ReleaseSlice,
+                           base::Unretained(this),
+                           base::TimeTicks::Now() + kSliceInterval),
+            kSliceInterval);
+  }
+
+  // Removes the oldest task of the highest priority.
+  std::unique_ptr<AfterStartupTask> Pop() {
+    for (auto& queue : queues_) {
+      if (!queue.empty()) {
+        std::unique_ptr<AfterStartupTask> queued_task =
+            std::move(queue.front());
+        queue.pop_front();
+        return queued_task;
+      }
+    }
+    NOTREACHED();
+    return nullptr;
+  }
+
+  std::array<base::circular_deque<std::unique_ptr<AfterStartupTask>>,
+             kPriorityCount>
+      queues_;
+  size_t slice_size_ = kInitialSliceSize;
+  // The slices released within |kMaxInFlightAge|, oldest first.
+  base::circular_deque<scoped_refptr<ReleasedSlice>> recent_slices_;
+  base::TimeTicks release_start_time_;
 };
 
 // The flag may be read on any thread, but must only be set on the UI thread.
 base::LazyInstance<base::AtomicFlag>::Leaky g_startup_complete_flag;
 
+// Set once startup is complete and the queue is empty. Until then, tasks are
+// queued even after startup is complete, behind those queued during startup, so
+// that the tasks of a sequence run in the order they were posted. The flag may
+// be read on any thread, but must only be set on the UI thread.
+base::LazyInstance<base::AtomicFlag>::Leaky g_tasks_released_flag;
+
 // The queue may only be accessed on the UI thread.
-base::LazyInstance<base::circular_deque<AfterStartupTask*>>::Leaky
-    g_after_startup_tasks;
+base::LazyInstance<AfterStartupTaskQueue>::Leaky g_after_startup_tasks;
 
 bool IsBrowserStartupComplete() {
   // Be sure to initialize the LazyInstance on the main thread since the flag
@@ -72,10 +260,30 @@ bool IsBrowserStartupComplete() {
   return g_startup_complete_flag.Get().IsSet();
 }
 
+bool AreAfterStartupTasksReleased() {
+  // Like |g_startup_complete_flag|, the flag must be created on the UI thread.
+  if (!g_tasks_released_flag.IsCreated())
+    return false;
+  return g_tasks_released_flag.Get().IsSet();
+}
+
+void SetAfterStartupTasksReleased() {
+  DCHECK_CURRENTLY_ON(BrowserThread::UI);
+  DCHECK(IsBrowserStartupComplete());
+  g_tasks_released_flag.Get().Set();
+}
+
 void RunTask(std::unique_ptr<AfterStartupTask> queued_task) {
   // We're careful to delete the caller's |task| on the target runner's thread.
   DCHECK(queued_task->task_runner->RunsTasksInCurrentSequence());
+  // The origin of the task shows which tasks are expensive.
+  TRACE_EVENT2("startup", "AfterStartupTask", "src_file",
+               queued_task->from_here.file_name(), "src_func",
+               queued_task->from_here.function_name());
+  const base::TimeTicks start_time = base::TimeTicks::Now();
   std::move(queued_task->task).Run();
+  UMA_HISTOGRAM_TIMES("Startup.AfterStartupTaskRunTime",
+                      base::TimeTicks::Now() - start_time);
 }
 
 void ScheduleTask(std::unique_ptr<AfterStartupTask> queued_task) {
@@ -104,11 +312,13 @@ void QueueTask(std::unique_ptr<AfterStartupTask> queued_task) {
 
   // The flag may have been set while the task to invoke this method
   // on the UI thread was inflight.
-  if (IsBrowserStartupComplete()) {
+  if (AreAfterStartupTasksReleased()) {
     ScheduleTask(std::move(queued_task));
     return;
   }
-  g_after_startup_tasks.Get().push_back(queued_task.release());
+  // After startup is complete, the queue is still being released, and will
+  // release this task too.
+  g_after_startup_tasks.Get().Push(std::move(queued_task));
 }
 
 void SetBrowserStartupIsComplete() {
@@ -127,10 +337,7 @@ void SetBrowserStartupIsComplete() {
   UMA_HISTOGRAM_COUNTS_10000("Startup.AfterStartupTaskCount",
                              g_after_startup_tasks.Get().size());
   g_startup_complete_flag.Get().Set();
-  for (AfterStartupTask* queued_task : g_after_startup_tasks.Get())
-    ScheduleTask(base::WrapUnique(queued_task));
-  g_after_startup_tasks.Get().clear();
-  g_after_startup_tasks.Get().shrink_to_fit();
+  g_after_startup_tasks.Get().StartRelease();
 
 // TODO(crbug.com/1052397): Revisit the macro expression once build flag switch
 // of lacros-chrome is complete.
@@ -242,13 +449,22 @@ void AfterStartupTaskUtils::PostTask(
     const base::Location& from_here,
     const scoped_refptr<base::SequencedTaskRunner>& destination_runner,
     base::OnceClosure task) {
-  if (IsBrowserStartupComplete()) {
+  PostTaskWithPriority(from_here, destination_runner, std::move(task),
+                       Priority::kNormal);
+}
+
+void AfterStartupTaskUtils::PostTaskWithPriority(
+    const base::Location& from_here,
+    const scoped_refptr<base::SequencedTaskRunner>& destination_runner,
+    base::OnceClosure task,
+    Priority priority) {
+  if (AreAfterStartupTasksReleased()) {
     destination_runner->PostTask(from_here, std::move(task));
     return;
   }
 
-  std::unique_ptr<AfterStartupTask> queued_task(
-      new AfterStartupTask(from_here, destination_runner, std::move(task)));
+  std::unique_ptr<AfterStartupTask> queued_task(new AfterStartupTask(
+      from_here, destination_runner, std::move(task), priority));
   QueueTask(std::move(queued_task));
 }
 
@@ -265,7 +481,9 @@ bool AfterStartupTaskUtils::IsBrowserStartupComplete() {
 }
 
 void AfterStartupTaskUtils::UnsafeResetForTesting() {
-  DCHECK(g_after_startup_tasks.Get().empty());
+  g_after_startup_tasks.Get().ResetForTesting();
+  if (AreAfterStartupTasksReleased())
+    g_tasks_released_flag.Get().UnsafeResetForTesting();
   if (!IsBrowserStartupComplete())
     return;
   g_startup_complete_flag.Get().UnsafeResetForTesting();
@@ -21,17 +21,40 @@ class SequencedTaskRunner;
 
 class AfterStartupTaskUtils {
  public:
+  // The order in which tasks queued during startup are released once startup
+  // is complete. Tasks of the same priority are released in the order they
+  // were posted.
+  enum class Priority {
+    // Work which the user may soon wait for.
+    kHigh,
+    // The default.
+    kNormal,
+    // Maintenance which can wait until everything else has run, e.g. database
+    // cleanups.
+    kBestEffort,
+  };
+
   // Observes startup and when complete runs tasks that have accrued.
   static void StartMonitoringStartup();
 
   // Used to augment the behavior of BrowserThread::PostAfterStartupTask
-  // for chrome. Tasks are queued until startup is complete.
+  // for chrome. Tasks are queued until startup is complete, and then released
+  // a few at a time so that they don't all compete with the first interactions
+  // with the browser. Tasks posted while the queue is being released wait
+  // behind the queued ones, so the tasks of a sequence still run in order.
   // Note: see browser_thread.h
   static void PostTask(
       const base::Location& from_here,
       const scoped_refptr<base::SequencedTaskRunner>& destination_runner,
       base::OnceClosure task);
 
+  // Like PostTask(), but queued tasks are released in order of |priority|.
+  static void PostTaskWithPriority(
+      const base::Location& from_here,
+      const scoped_refptr<base::SequencedTaskRunner>& destination_runner,
+      base::OnceClosure task,
+      Priority priority);
+
   // Returns true if browser startup is complete. Only use this on a one-off
   // basis; If you need to poll this function constantly, use the above
   // PostTask() API instead.
@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
@@ -15,6 +16,7 @@
 #include "base/task/post_task.h"
 #include "base/task/thread_pool.h"
 #include "base/task_runner_util.h"
+#include "base/time/time.h"
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/test/browser_task_environment.h"
@@ -76,6 +78,35 @@ class WrappedTaskRunner : public base::SequencedTaskRunner {
   int ran_task_count_ = 0;
 };
 
+// Keeps the tasks posted to it without ever running them, as a sequence which
+// is too busy to run them would.
+class StalledTaskRunner : public base::SequencedTaskRunner {
+ public:
+  StalledTaskRunner() = default;
+
+  bool PostDelayedTask(const base::Location& from_here,
+                       base::OnceClosure task,
+                       base::TimeDelta delay) override {
+    tasks_.push_back(std::move(task));
+    return true;
+  }
+
+  bool PostNonNestableDelayedTask(const base::Location& from_here,
+                                  base::OnceClosure task,
+                                  base::TimeDelta delay) override {
+    return PostDelayedTask(from_here, std::move(task), delay);
+  }
+
+  bool RunsTasksInCurrentSequence() const override { return false; }
+
+  size_t posted_task_count() const { return tasks_.size(); }
+
+ private:
+  ~StalledTaskRunner() override {}
+
+  std::vector<base::OnceClosure> tasks_;
+};
+
 }  // namespace
 
 class AfterStartupTaskTest : public testing::Test {
@@ -128,6 +159,14 @@ class AfterStartupTaskTest : public testing::Test {
     EXPECT_TRUE(task_runner->RunsTasksInCurrentSequence());
   }
 
+  void FastForwardUntilNoTasksRemain() {
+    task_environment_.FastForwardUntilNoTasksRemain();
+  }
+
+  void FastForwardBy(base::TimeDelta delta) {
+    task_environment_.FastForwardBy(delta);
+  }
+
  protected:
   scoped_refptr<WrappedTaskRunner> ui_thread_;
   scoped_refptr<WrappedTaskRunner> background_sequence_;
@@ -140,7 +179,8 @@ class AfterStartupTaskTest : public testing::Test {
     loop->Quit();
   }
 
-  content::BrowserTaskEnvironment task_environment_;
+  content::BrowserTaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
 };
 
 TEST_F(AfterStartupTaskTest, IsStartupComplete) {
@@ -209,3 +249,87 @@ TEST_F(AfterStartupTaskTest, PostTask) {
   EXPECT_EQ(2, background_sequence_->ran_task_count());
   EXPECT_EQ(2, ui_thread_->ran_task_count());
 }
+
+TEST_F(AfterStartupTaskTest, ReleasesTasksInPriorityOrder) {
+  using Priority = AfterStartupTaskUtils::Priority;
+  std::vector<int> order;
+  auto record = [](std::vector<int>* order, int value) {
+    order->push_back(value);
+  };
+  AfterStartupTaskUtils::PostTaskWithPriority(
+      FROM_HERE, ui_thread_, base::BindOnce(record, &order, 3),
+      Priority::kBestEffort);
+  AfterStartupTaskUtils::PostTaskWithPriority(
+      FROM_HERE, ui_thread_, base::BindOnce(record, &order, 1),
+      Priority::kNormal);
+  AfterStartupTaskUtils::PostTaskWithPriority(
+      FROM_HERE, ui_thread_, base::BindOnce(record, &order, 0),
+      Priority::kHigh);
+  AfterStartupTaskUtils::PostTask(FROM_HERE, ui_thread_,
+                                  base::BindOnce(record, &order, 2));
+
+  AfterStartupTaskUtils::SetBrowserStartupIsCompleteForTesting();
+  FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), order);
+}
+
+TEST_F(AfterStartupTaskTest, TasksPostedDuringReleaseRunInOrder) {
+  std::vector<int> order;
+  auto record = [](std::vector<int>* order, int value) {
+    order->push_back(value);
+  };
+  for (int i = 0; i < 8; ++i) {
+    AfterStartupTaskUtils::PostTask(FROM_HERE, ui_thread_,
+                                    base::BindOnce(record, &order, i));
+  }
+
+  // The queued tasks are released over several slices. A task posted to the
+  // same sequence meanwhile waits behind them.
+  AfterStartupTaskUtils::SetBrowserStartupIsCompleteForTesting();
+  AfterStartupTaskUtils::PostTask(FROM_HERE, ui_thread_,
+                                  base::BindOnce(record, &order, 8));
+  FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8}), order);
+
+  // Once the queue is empty, tasks are posted right away.
+  ui_thread_->reset_task_counts();
+  AfterStartupTaskUtils::PostTask(FROM_HERE, ui_thread_, base::DoNothing());
+  EXPECT_EQ(1, ui_thread_->posted_task_count());
+}
+
+TEST_F(AfterStartupTaskTest, ReleasesTasksInSlices) {
+  for (int i = 0; i < 40; ++i)
+    AfterStartupTaskUtils::PostTask(FROM_HERE, ui_thread_, base::DoNothing());
+
+  // Only the first slice is released right away.
+  AfterStartupTaskUtils::SetBrowserStartupIsCompleteForTesting();
+  EXPECT_EQ(4, ui_thread_->posted_task_count());
+
+  // The others follow as the released tasks run.
+  FastForwardUntilNoTasksRemain();
+  EXPECT_EQ(40, ui_thread_->posted_task_count());
+  EXPECT_EQ(40, ui_thread_->ran_task_count());
+}
+
+TEST_F(AfterStartupTaskTest, ReleasedTasksWhichNeverRunDontBlockRelease) {
+  using Priority = AfterStartupTaskUtils::Priority;
+  auto stalled_runner = base::MakeRefCounted<StalledTaskRunner>();
+  for (int i = 0; i < 4; ++i) {
+    AfterStartupTaskUtils::PostTaskWithPriority(
+        FROM_HERE, stalled_runner, base::DoNothing(), Priority::kHigh);
+  }
+  AfterStartupTaskUtils::PostTaskWithPriority(FROM_HERE, ui_thread_,
+                                              base::DoNothing(),
+                                              Priority::kHigh);
+
+  // The first slice goes to the stalled sequence, and holds back the next
+  // slices while its tasks are recent.
+  AfterStartupTaskUtils::SetBrowserStartupIsCompleteForTesting();
+  EXPECT_EQ(4u, stalled_runner->posted_task_count());
+  FastForwardBy(base::TimeDelta::FromMilliseconds(500));
+  EXPECT_EQ(0, ui_thread_->posted_task_count());
+
+  // Once they are old enough, the remaining task is released anyway.
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+  EXPECT_EQ(1, ui_thread_->ran_task_count());
+}
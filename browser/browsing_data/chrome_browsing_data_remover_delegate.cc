@@ -30,6 +30,7 @@
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/browsing_data/chrome_browsing_data_remover_constants.h"
 #include "chrome/browser/browsing_data/navigation_entry_remover.h"
+#include "chrome/browser/browsing_data/site_data_size_collector.h"
 #include "chrome/browser/chrome_notification_types.h"
 #include "chrome/browser/content_settings/host_content_settings_map_factory.h"
 #include "chrome/browser/crash_upload_list/crash_upload_list.h"
@@ -1215,6 +1216,13 @@ void ChromeBrowsingDataRemoverDelegate::RemoveEmbedderData(
       (constants::DATA_TYPE_SITE_DATA | constants::DATA_TYPE_HISTORY)) {
     login_detection::prefs::RemoveLoginDetectionData(prefs);
   }
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Site data sizes:
+  // Drop the sizes cached for the storage settings. Sizes fetched while the
+  // removal is still running are corrected by the refresh of the next fetch.
+  if (remove_mask & constants::DATA_TYPE_SITE_DATA)
+    SiteDataSizeCollector::InvalidateForProfile(profile_);
 }
 
 void ChromeBrowsingDataRemoverDelegate::OnTaskStarted(
@@ -10,6 +10,7 @@
 #include <functional>
 #include <map>
 #include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -25,6 +26,7 @@
 #include "chrome/browser/browsing_data/access_context_audit_service_factory.h"
 #include "chrome/browser/browsing_data/browsing_data_file_system_util.h"
 #include "chrome/browser/browsing_data/browsing_data_quota_helper.h"
+#include "chrome/browser/browsing_data/site_data_size_collector.h"
 #include "chrome/browser/content_settings/cookie_settings_factory.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/grit/generated_resources.h"
@@ -75,8 +77,9 @@ struct NodeTitleComparator {
 
 // Comparison functor, for use in CookieTreeRootNode.
 struct HostNodeComparator {
+  template <typename T>
   bool operator()(const std::unique_ptr<CookieTreeNode>& lhs,
-                  const std::unique_ptr<CookieTreeHostNode>& rhs) {
+                  const std::unique_ptr<T>& rhs) {
     // This comparator is only meant to compare CookieTreeHostNode types. Make
     // sure we check this, as the static cast below is dangerous if we get the
     // wrong object type.
@@ -87,7 +90,8 @@ struct HostNodeComparator {
 
     const CookieTreeHostNode* ltn =
         static_cast<const CookieTreeHostNode*>(lhs.get());
-    const CookieTreeHostNode* rtn = rhs.get();
+    const CookieTreeHostNode* rtn =
+        static_cast<const CookieTreeHostNode*>(rhs.get());
 
     // We want to order by registry controlled domain, so we would get
     // google.com, ad.google.com, www.google.com,
@@ -168,15 +172,109 @@ bool TypeIsProtected(CookieTreeNode::DetailedInfo::NodeType type) {
 #endif
 
 // This function returns the local data container associated with a leaf tree
-// node. The app node is assumed to be 3 levels above the leaf because of the
-// following structure:
+// node, for the node to delete its item from. The app node is assumed to be 3
+// levels above the leaf because of the following structure:
 //   root -> origin -> storage type -> leaf node
 LocalDataContainer* GetLocalDataContainerForNode(CookieTreeNode* node) {
   CookieTreeHostNode* host = static_cast<CookieTreeHostNode*>(
       node->parent()->parent());
   CHECK_EQ(host->GetDetailedInfo().node_type,
            CookieTreeNode::DetailedInfo::TYPE_HOST);
-  return node->GetModel()->data_container();
+  CookiesTreeModel* model = node->GetModel();
+  model->ResetHostIndex();
+  return model->data_container();
+}
+
+// Tells the site data size collector of the model of |node|, if any, that the
+// data of |type| stored by |origin| was deleted, so that its cached sizes stay
+// accurate.
+void ReportDeletionToSizeCollector(CookieTreeNode* node,
+                                   SiteDataSizeCollector::StorageType type,
+                                   const url::Origin& origin) {
+  SiteDataSizeCollector* collector =
+      node->GetModel()->site_data_size_collector();
+  if (collector)
+    collector->OnStorageDeleted(type, origin);
+}
+
+// Returns the child of |root| for the host with |title|, or nullptr.
+CookieTreeHostNode* FindHostNode(CookieTreeNode* root,
+                                 const std::string& canonicalized_host,
+                                 const std::u16string& title) {
+  auto it = std::lower_bound(
+      root->children().begin(), root->children().end(), canonicalized_host,
+      [](const std::unique_ptr<CookieTreeNode>& node, const std::string& host) {
+        return static_cast<const CookieTreeHostNode*>(node.get())
+                   ->canonicalized_host() < host;
+      });
+  for (; it != root->children().end(); ++it) {
+    auto* host_node = static_cast<CookieTreeHostNode*>(it->get());
+    if (host_node->canonicalized_host() != canonicalized_host)
+      break;
+    if (host_node->GetTitle() == title)
+      return host_node;
+  }
+  return nullptr;
+}
+
+// Inserts |new_children|, sorted by |comparator|, among the children of
+// |parent|, sorted the same way, in linear time. A new child goes before the
+// existing children equal to it, as with CookieTreeNode::AddChildSortedByTitle.
+// If |parent| is in the tree, its observers are notified once per run of
+// consecutive new children.
+template <typename Comparator>
+void MergeChildren(CookieTreeNode* parent,
+                   std::vector<std::unique_ptr<CookieTreeNode>> new_children,
+                   Comparator comparator) {
+  if (new_children.empty())
+    return;
+
+  std::vector<std::unique_ptr<CookieTreeNode>> old_children;
+  old_children.reserve(parent->children().size());
+  while (!parent->children().empty())
+    old_children.push_back(parent->Remove(parent->children().size() - 1));
+  std::reverse(old_children.begin(), old_children.end());
+
+  // The start and size of the runs of new children.
+  std::vector<std::pair<size_t, size_t>> added_runs;
+  auto new_child = new_children.begin();
+  auto old_child = old_children.begin();
+  while (new_child != new_children.end() || old_child != old_children.end()) {
+    const size_t index = parent->children().size();
+    if (old_child == old_children.end() ||
+        (new_child != new_children.end() &&
+         !comparator(*old_child, *new_child))) {
+      if (!added_runs.empty() &&
+          added_runs.back().first + added_runs.back().second == index) {
+        ++added_runs.back().second;
+      } else {
+        added_runs.emplace_back(index, 1);
+      }
+      parent->Add(std::move(*new_child++), index);
+    } else {
+      parent->Add(std::move(*old_child++), index);
+    }
+  }
+
+  CookiesTreeModel* model = parent->GetModel();
+  if (!model)
+    return;
+  for (const auto& run : added_runs)
+    model->NotifyObserverTreeNodesAdded(parent, run.first, run.second);
+}
+
+// Creates the leaf nodes of |items|, sorted by title. Nodes with the same
+// title are in the reverse order of |items|, as if they were added one by one
+// with CookieTreeNode::AddChildSortedByTitle.
+template <typename LeafNode, typename Iterator>
+std::vector<std::unique_ptr<CookieTreeNode>> CreateLeafNodes(
+    const std::vector<Iterator>& items) {
+  std::vector<std::unique_ptr<CookieTreeNode>> nodes;
+  nodes.reserve(items.size());
+  for (auto it = items.rbegin(); it != items.rend(); ++it)
+    nodes.push_back(std::make_unique<LeafNode>(*it));
+  std::stable_sort(nodes.begin(), nodes.end(), NodeTitleComparator());
+  return nodes;
 }
 
 }  // namespace
@@ -327,8 +425,13 @@ void CookieTreeNode::AddChildSortedByTitle(
   DCHECK(new_child);
   auto iter = std::lower_bound(children().begin(), children().end(), new_child,
                                NodeTitleComparator());
-  GetModel()->Add(this, std::move(new_child),
-                  size_t{iter - children().begin()});
+  const size_t index = iter - children().begin();
+  // Nodes built apart from the tree are published when they are attached.
+  CookiesTreeModel* model = GetModel();
+  if (model)
+    model->Add(this, std::move(new_child), index);
+  else
+    Add(std::move(new_child), index);
 }
 
 void CookieTreeNode::ReportDeletionToAuditService(
@@ -359,6 +462,9 @@ class CookieTreeCookieNode : public CookieTreeNode {
     LocalDataContainer* container = GetLocalDataContainerForNode(this);
     container->cookie_helper_->DeleteCookie(*cookie_);
     container->cookie_list_.erase(cookie_);
+    // Cookies are measured as a whole, so no origin is needed.
+    ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kCookies,
+                                  url::Origin());
   }
   DetailedInfo GetDetailedInfo() const override {
     return DetailedInfo().InitCookie(&*cookie_);
@@ -394,6 +500,8 @@ class CookieTreeAppCacheNode : public CookieTreeNode {
 
     if (container) {
       container->appcache_helper_->DeleteAppCaches(usage_info_->origin);
+      ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kAppCache,
+                                    usage_info_->origin);
       container->appcache_info_list_.erase(usage_info_);
     }
   }
@@ -437,6 +545,8 @@ class CookieTreeDatabaseNode : public CookieTreeNode {
           AccessContextAuditDatabase::StorageAPIType::kWebDatabase);
 
       container->database_helper_->DeleteDatabase(usage_info_->origin);
+      ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kDatabases,
+                                    usage_info_->origin);
       container->database_info_list_.erase(usage_info_);
     }
   }
@@ -483,6 +593,8 @@ class CookieTreeLocalStorageNode : public CookieTreeNode {
 
       container->local_storage_helper_->DeleteOrigin(
           local_storage_info_->origin, base::DoNothing());
+      ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kLocalStorage,
+                                    local_storage_info_->origin);
       container->local_storage_info_list_.erase(local_storage_info_);
     }
   }
@@ -566,6 +678,8 @@ class CookieTreeIndexedDBNode : public CookieTreeNode {
 
       container->indexed_db_helper_->DeleteIndexedDB(usage_info_->origin,
                                                      base::DoNothing());
+      ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kIndexedDB,
+                                    usage_info_->origin);
       container->indexed_db_info_list_.erase(usage_info_);
     }
   }
@@ -612,6 +726,8 @@ class CookieTreeFileSystemNode : public CookieTreeNode {
 
       container->file_system_helper_->DeleteFileSystemOrigin(
           file_system_info_->origin);
+      ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kFileSystems,
+                                    file_system_info_->origin);
       container->file_system_info_list_.erase(file_system_info_);
     }
   }
@@ -655,7 +771,9 @@ class CookieTreeQuotaNode : public CookieTreeNode {
     // Calling this function may cause unexpected over-quota state of origin.
     // However, it'll caused no problem, just prevent usage growth of the
     // origin.
-    LocalDataContainer* container = GetModel()->data_container();
+    CookiesTreeModel* model = GetModel();
+    model->ResetHostIndex();
+    LocalDataContainer* container = model->data_container();
 
     if (container) {
       container->quota_helper_->RevokeHostQuota(quota_info_->host);
@@ -699,6 +817,8 @@ class CookieTreeServiceWorkerNode : public CookieTreeNode {
 
       container->service_worker_helper_->DeleteServiceWorkers(
           usage_info_->origin);
+      ReportDeletionToSizeCollector(
+          this, SiteDataSizeCollector::kServiceWorkers, usage_info_->origin);
       container->service_worker_info_list_.erase(usage_info_);
     }
   }
@@ -783,6 +903,8 @@ class CookieTreeCacheStorageNode : public CookieTreeNode {
           AccessContextAuditDatabase::StorageAPIType::kCacheStorage);
 
       container->cache_storage_helper_->DeleteCacheStorage(usage_info_->origin);
+      ReportDeletionToSizeCollector(this, SiteDataSizeCollector::kCacheStorage,
+                                    usage_info_->origin);
       container->cache_storage_info_list_.erase(usage_info_);
     }
   }
@@ -1455,19 +1577,7 @@ void CookiesTreeModel::UpdateSearchResults(const std::u16string& filter) {
   ScopedBatchUpdateNotifier notifier(this, root);
   notifier.StartBatchUpdate();
   root->DeleteAll();
-
-  PopulateCookieInfoWithFilter(data_container(), &notifier, filter);
-  PopulateDatabaseInfoWithFilter(data_container(), &notifier, filter);
-  PopulateLocalStorageInfoWithFilter(data_container(), &notifier, filter);
-  PopulateSessionStorageInfoWithFilter(data_container(), &notifier, filter);
-  PopulateAppCacheInfoWithFilter(data_container(), &notifier, filter);
-  PopulateIndexedDBInfoWithFilter(data_container(), &notifier, filter);
-  PopulateFileSystemInfoWithFilter(data_container(), &notifier, filter);
-  PopulateQuotaInfoWithFilter(data_container(), &notifier, filter);
-  PopulateServiceWorkerUsageInfoWithFilter(data_container(), &notifier, filter);
-  PopulateSharedWorkerInfoWithFilter(data_container(), &notifier, filter);
-  PopulateCacheStorageUsageInfoWithFilter(data_container(), &notifier, filter);
-  PopulateMediaLicenseInfoWithFilter(data_container(), &notifier, filter);
+  PopulateFromHostIndex(&notifier, filter, kAllStorageTypes);
 }
 
 #if BUILDFLAG(ENABLE_EXTENSIONS)
@@ -1501,380 +1611,325 @@ void CookiesTreeModel::RemoveCookiesTreeObserver(Observer* observer) {
 
 void CookiesTreeModel::PopulateAppCacheInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateAppCacheInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kAppCaches);
 }
 
 void CookiesTreeModel::PopulateCookieInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateCookieInfoWithFilter(container, &notifier, std::u16string());
+  notifier.StartBatchUpdate();
+  PopulateStorageType(container, &notifier, kCookies);
 }
 
 void CookiesTreeModel::PopulateDatabaseInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateDatabaseInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kDatabases);
 }
 
 void CookiesTreeModel::PopulateLocalStorageInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateLocalStorageInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kLocalStorages);
 }
 
 void CookiesTreeModel::PopulateSessionStorageInfo(
       LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateSessionStorageInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kSessionStorages);
 }
 
 void CookiesTreeModel::PopulateIndexedDBInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateIndexedDBInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kIndexedDBs);
 }
 
 void CookiesTreeModel::PopulateFileSystemInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateFileSystemInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kFileSystems);
 }
 
 void CookiesTreeModel::PopulateQuotaInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateQuotaInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kQuotas);
 }
 
 void CookiesTreeModel::PopulateServiceWorkerUsageInfo(
     LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateServiceWorkerUsageInfoWithFilter(container, &notifier,
-                                           std::u16string());
+  PopulateStorageType(container, &notifier, kServiceWorkers);
 }
 
 void CookiesTreeModel::PopulateSharedWorkerInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateSharedWorkerInfoWithFilter(container, &notifier, std::u16string());
+  PopulateStorageType(container, &notifier, kSharedWorkers);
 }
 
 void CookiesTreeModel::PopulateCacheStorageUsageInfo(
     LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateCacheStorageUsageInfoWithFilter(container, &notifier,
-                                          std::u16string());
+  PopulateStorageType(container, &notifier, kCacheStorages);
 }
 
 void CookiesTreeModel::PopulateMediaLicenseInfo(LocalDataContainer* container) {
   ScopedBatchUpdateNotifier notifier(this, GetRoot());
-  PopulateMediaLicenseInfoWithFilter(container, &notifier, std::u16string());
-}
-
-void CookiesTreeModel::PopulateAppCacheInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->appcache_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto it = container->appcache_info_list_.begin();
-       it != container->appcache_info_list_.end(); ++it) {
-    const GURL url = it->origin.GetURL();
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(url).find(filter) !=
-                           std::u16string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(url);
-      CookieTreeAppCachesNode* appcaches_node =
-          host_node->GetOrCreateAppCachesNode();
-      appcaches_node->AddAppCacheNode(
-          std::make_unique<CookieTreeAppCacheNode>(it));
-    }
-  }
-}
-
-void CookiesTreeModel::PopulateCookieInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  notifier->StartBatchUpdate();
-  for (auto it = container->cookie_list_.begin();
-       it != container->cookie_list_.end(); ++it) {
-    // Cookies ignore schemes, so group all HTTP and HTTPS cookies together.
-    // TODO(crbug.com/1031721): This will not be true when Scheme-Bound Cookies
-    // is implemented. Investigate whether passing it->SourceScheme() instead of
-    // false is appropriate here.
-    GURL source = (it->Domain() == ".")
-                      ? GURL("http://./")
-                      : net::cookie_util::CookieOriginToURL(
-                            it->Domain(), false /* is_https */);
-
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(source).find(
-                               filter) != std::u16string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(source);
-      CookieTreeCookiesNode* cookies_node =
-          host_node->GetOrCreateCookiesNode();
-      cookies_node->AddCookieNode(std::make_unique<CookieTreeCookieNode>(it));
-    }
-  }
-}
-
-void CookiesTreeModel::PopulateDatabaseInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->database_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto database_info = container->database_info_list_.begin();
-       database_info != container->database_info_list_.end(); ++database_info) {
-    if (filter.empty() ||
-        (CookieTreeHostNode::TitleForUrl(database_info->origin.GetURL())
-             .find(filter) != std::u16string::npos)) {
-      CookieTreeHostNode* host_node =
-          root->GetOrCreateHostNode(database_info->origin.GetURL());
-      CookieTreeDatabasesNode* databases_node =
-          host_node->GetOrCreateDatabasesNode();
-      databases_node->AddDatabaseNode(
-          std::make_unique<CookieTreeDatabaseNode>(database_info));
-    }
-  }
+  PopulateStorageType(container, &notifier, kMediaLicenses);
 }
 
-void CookiesTreeModel::PopulateLocalStorageInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->local_storage_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto local_storage_info = container->local_storage_info_list_.begin();
-       local_storage_info != container->local_storage_info_list_.end();
-       ++local_storage_info) {
-    const GURL& origin(local_storage_info->origin.GetURL());
-
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(origin)
-                               .find(filter) != std::string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(origin);
-      CookieTreeLocalStoragesNode* local_storages_node =
-          host_node->GetOrCreateLocalStoragesNode();
-      local_storages_node->AddLocalStorageNode(
-          std::make_unique<CookieTreeLocalStorageNode>(local_storage_info));
-    }
-  }
-}
-
-void CookiesTreeModel::PopulateSessionStorageInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->session_storage_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto session_storage_info =
-           container->session_storage_info_list_.begin();
-       session_storage_info != container->session_storage_info_list_.end();
-       ++session_storage_info) {
-    const GURL& origin = session_storage_info->origin.GetURL();
-
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(origin).find(
-                               filter) != std::u16string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(origin);
-      CookieTreeSessionStoragesNode* session_storages_node =
-          host_node->GetOrCreateSessionStoragesNode();
-      session_storages_node->AddSessionStorageNode(
-          std::make_unique<CookieTreeSessionStorageNode>(session_storage_info));
-    }
-  }
+void CookiesTreeModel::ResetHostIndex() {
+  host_index_.clear();
+  sorted_host_entries_.clear();
+  indexed_storage_types_ = 0;
 }
 
-void CookiesTreeModel::PopulateIndexedDBInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
+CookiesTreeModel::HostEntry::HostEntry(const GURL& url,
+                                       const std::u16string& title)
+    : url(url), title(title), canonicalized_host(CanonicalizeHost(url)) {}
 
-  if (container->indexed_db_info_list_.empty())
-    return;
+CookiesTreeModel::HostEntry::~HostEntry() = default;
 
-  notifier->StartBatchUpdate();
-  for (auto indexed_db_info = container->indexed_db_info_list_.begin();
-       indexed_db_info != container->indexed_db_info_list_.end();
-       ++indexed_db_info) {
-    const url::Origin& origin = indexed_db_info->origin;
-
-    if (filter.empty() ||
-        (CookieTreeHostNode::TitleForUrl(origin.GetURL()).find(filter) !=
-         std::u16string::npos)) {
-      CookieTreeHostNode* host_node =
-          root->GetOrCreateHostNode(origin.GetURL());
-      CookieTreeIndexedDBsNode* indexed_dbs_node =
-          host_node->GetOrCreateIndexedDBsNode();
-      indexed_dbs_node->AddIndexedDBNode(
-          std::make_unique<CookieTreeIndexedDBNode>(indexed_db_info));
-    }
-  }
+bool CookiesTreeModel::HostEntry::HasItems(uint32_t types) const {
+  return ((types & kCookies) && !cookies.empty()) ||
+         ((types & kDatabases) && !databases.empty()) ||
+         ((types & kLocalStorages) && !local_storages.empty()) ||
+         ((types & kSessionStorages) && !session_storages.empty()) ||
+         ((types & kAppCaches) && !appcaches.empty()) ||
+         ((types & kIndexedDBs) && !indexed_dbs.empty()) ||
+         ((types & kFileSystems) && !file_systems.empty()) ||
+         ((types & kQuotas) && !quotas.empty()) ||
+         ((types & kServiceWorkers) && !service_workers.empty()) ||
+         ((types & kSharedWorkers) && !shared_workers.empty()) ||
+         ((types & kCacheStorages) && !cache_storages.empty()) ||
+         ((types & kMediaLicenses) && !media_licenses.empty());
 }
 
-void CookiesTreeModel::PopulateServiceWorkerUsageInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->service_worker_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto service_worker_info = container->service_worker_info_list_.begin();
-       service_worker_info != container->service_worker_info_list_.end();
-       ++service_worker_info) {
-    const url::Origin& origin = service_worker_info->origin;
-
-    if (filter.empty() ||
-        (CookieTreeHostNode::TitleForUrl(origin.GetURL()).find(filter) !=
-         std::u16string::npos)) {
-      CookieTreeHostNode* host_node =
-          root->GetOrCreateHostNode(origin.GetURL());
-      CookieTreeServiceWorkersNode* service_workers_node =
-          host_node->GetOrCreateServiceWorkersNode();
-      service_workers_node->AddServiceWorkerNode(
-          std::make_unique<CookieTreeServiceWorkerNode>(service_worker_info));
-    }
-  }
+void CookiesTreeModel::PopulateStorageType(LocalDataContainer* container,
+                                           ScopedBatchUpdateNotifier* notifier,
+                                           StorageType type) {
+  DCHECK_EQ(data_container(), container);
+  // The container updated the items of |type|, so they are indexed again.
+  indexed_storage_types_ &= ~type;
+  PopulateFromHostIndex(notifier, std::u16string(), type);
 }
 
-void CookiesTreeModel::PopulateSharedWorkerInfoWithFilter(
-    LocalDataContainer* container,
+void CookiesTreeModel::PopulateFromHostIndex(
     ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
+    const std::u16string& filter,
+    uint32_t types) {
+  IndexStorageTypes(types);
 
-  if (container->shared_worker_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto shared_worker_info = container->shared_worker_info_list_.begin();
-       shared_worker_info != container->shared_worker_info_list_.end();
-       ++shared_worker_info) {
-    const GURL& worker = shared_worker_info->worker;
-
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(worker).find(
-                               filter) != std::u16string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(worker);
-      CookieTreeSharedWorkersNode* shared_workers_node =
-          host_node->GetOrCreateSharedWorkersNode();
-      shared_workers_node->AddSharedWorkerNode(
-          std::make_unique<CookieTreeSharedWorkerNode>(shared_worker_info));
-    }
-  }
-}
-
-void CookiesTreeModel::PopulateCacheStorageUsageInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
   CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->cache_storage_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto cache_storage_info = container->cache_storage_info_list_.begin();
-       cache_storage_info != container->cache_storage_info_list_.end();
-       ++cache_storage_info) {
-    const url::Origin& origin = cache_storage_info->origin;
-
-    if (filter.empty() ||
-        (CookieTreeHostNode::TitleForUrl(origin.GetURL()).find(filter) !=
-         std::u16string::npos)) {
-      CookieTreeHostNode* host_node =
-          root->GetOrCreateHostNode(origin.GetURL());
-      CookieTreeCacheStoragesNode* cache_storages_node =
-          host_node->GetOrCreateCacheStoragesNode();
-      cache_storages_node->AddCacheStorageNode(
-          std::make_unique<CookieTreeCacheStorageNode>(cache_storage_info));
+  std::vector<std::unique_ptr<CookieTreeNode>> new_host_nodes;
+  for (const HostEntry* entry : GetSortedHostEntries()) {
+    if (!entry->HasItems(types) ||
+        (!filter.empty() &&
+         entry->title.find(filter) == std::u16string::npos)) {
+      continue;
     }
-  }
-}
-
-void CookiesTreeModel::PopulateFileSystemInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->file_system_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto file_system_info = container->file_system_info_list_.begin();
-       file_system_info != container->file_system_info_list_.end();
-       ++file_system_info) {
-    GURL origin = file_system_info->origin.GetURL();
-
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(origin).find(
-                               filter) != std::u16string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(origin);
-      CookieTreeFileSystemsNode* file_systems_node =
-          host_node->GetOrCreateFileSystemsNode();
-      file_systems_node->AddFileSystemNode(
-          std::make_unique<CookieTreeFileSystemNode>(file_system_info));
+    notifier->StartBatchUpdate();
+
+    CookieTreeHostNode* host_node =
+        FindHostNode(root, entry->canonicalized_host, entry->title);
+    if (host_node) {
+      // Cookies node will create fake url with http scheme, so update the url
+      // if there is a more valid url.
+      if (host_node->GetDetailedInfo().origin.GetURL().SchemeIs(
+              url::kHttpScheme) &&
+          entry->url.SchemeIs(url::kHttpsScheme)) {
+        host_node->UpdateHostUrl(entry->url);
+      }
+      AddStorageNodes(*entry, types, host_node);
+    } else {
+      auto new_host_node = std::make_unique<CookieTreeHostNode>(entry->url);
+      AddStorageNodes(*entry, types, new_host_node.get());
+      new_host_nodes.push_back(std::move(new_host_node));
     }
   }
-}
-
-void CookiesTreeModel::PopulateQuotaInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
-
-  if (container->quota_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto quota_info = container->quota_info_list_.begin();
-       quota_info != container->quota_info_list_.end(); ++quota_info) {
-    if (filter.empty() || (base::UTF8ToUTF16(quota_info->host).find(filter) !=
-                           std::u16string::npos)) {
-      CookieTreeHostNode* host_node =
-          root->GetOrCreateHostNode(GURL("http://" + quota_info->host));
-      host_node->UpdateOrCreateQuotaNode(quota_info);
+  MergeChildren(root, std::move(new_host_nodes), HostNodeComparator());
+}
+
+void CookiesTreeModel::AddStorageNodes(const HostEntry& entry,
+                                       uint32_t types,
+                                       CookieTreeHostNode* host_node) {
+  if ((types & kCookies) && !entry.cookies.empty()) {
+    MergeChildren(host_node->GetOrCreateCookiesNode(),
+                  CreateLeafNodes<CookieTreeCookieNode>(entry.cookies),
+                  NodeTitleComparator());
+  }
+  if ((types & kDatabases) && !entry.databases.empty()) {
+    MergeChildren(host_node->GetOrCreateDatabasesNode(),
+                  CreateLeafNodes<CookieTreeDatabaseNode>(entry.databases),
+                  NodeTitleComparator());
+  }
+  if ((types & kLocalStorages) && !entry.local_storages.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateLocalStoragesNode(),
+        CreateLeafNodes<CookieTreeLocalStorageNode>(entry.local_storages),
+        NodeTitleComparator());
+  }
+  if ((types & kSessionStorages) && !entry.session_storages.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateSessionStoragesNode(),
+        CreateLeafNodes<CookieTreeSessionStorageNode>(entry.session_storages),
+        NodeTitleComparator());
+  }
+  if ((types & kAppCaches) && !entry.appcaches.empty()) {
+    MergeChildren(host_node->GetOrCreateAppCachesNode(),
+                  CreateLeafNodes<CookieTreeAppCacheNode>(entry.appcaches),
+                  NodeTitleComparator());
+  }
+  if ((types & kIndexedDBs) && !entry.indexed_dbs.empty()) {
+    MergeChildren(host_node->GetOrCreateIndexedDBsNode(),
+                  CreateLeafNodes<CookieTreeIndexedDBNode>(entry.indexed_dbs),
+                  NodeTitleComparator());
+  }
+  if ((types & kFileSystems) && !entry.file_systems.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateFileSystemsNode(),
+        CreateLeafNodes<CookieTreeFileSystemNode>(entry.file_systems),
+        NodeTitleComparator());
+  }
+  if ((types & kQuotas) && !entry.quotas.empty())
+    host_node->UpdateOrCreateQuotaNode(entry.quotas.front());
+  if ((types & kServiceWorkers) && !entry.service_workers.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateServiceWorkersNode(),
+        CreateLeafNodes<CookieTreeServiceWorkerNode>(entry.service_workers),
+        NodeTitleComparator());
+  }
+  if ((types & kSharedWorkers) && !entry.shared_workers.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateSharedWorkersNode(),
+        CreateLeafNodes<CookieTreeSharedWorkerNode>(entry.shared_workers),
+        NodeTitleComparator());
+  }
+  if ((types & kCacheStorages) && !entry.cache_storages.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateCacheStoragesNode(),
+        CreateLeafNodes<CookieTreeCacheStorageNode>(entry.cache_storages),
+        NodeTitleComparator());
+  }
+  if ((types & kMediaLicenses) && !entry.media_licenses.empty()) {
+    MergeChildren(
+        host_node->GetOrCreateMediaLicensesNode(),
+        CreateLeafNodes<CookieTreeMediaLicenseNode>(entry.media_licenses),
+        NodeTitleComparator());
+  }
+}
+
+template <typename List, typename GetUrl>
+void CookiesTreeModel::IndexItems(
+    List* list,
+    std::vector<typename List::iterator> HostEntry::*items,
+    StorageType type,
+    GetUrl get_url) {
+  for (auto& host : host_index_)
+    (host.second.*items).clear();
+
+  for (auto it = list->begin(); it != list->end(); ++it) {
+    const GURL url = get_url(*it);
+    const std::u16string title = CookieTreeHostNode::TitleForUrl(url);
+    auto result = host_index_.try_emplace(title, url, title);
+    HostEntry& entry = result.first->second;
+    // Cookies will create fake urls with http scheme, so keep the more valid
+    // url of the host.
+    if (!result.second && entry.url.SchemeIs(url::kHttpScheme) &&
+        url.SchemeIs(url::kHttpsScheme)) {
+      entry.url = url;
     }
+    (entry.*items).push_back(it);
   }
+  indexed_storage_types_ |= type;
 }
 
-void CookiesTreeModel::PopulateMediaLicenseInfoWithFilter(
-    LocalDataContainer* container,
-    ScopedBatchUpdateNotifier* notifier,
-    const std::u16string& filter) {
-  CookieTreeRootNode* root = static_cast<CookieTreeRootNode*>(GetRoot());
+void CookiesTreeModel::IndexStorageTypes(uint32_t types) {
+  LocalDataContainer* container = data_container();
+  auto get_origin_url = [](const auto& info) { return info.origin.GetURL(); };
 
-  if (container->media_license_info_list_.empty())
-    return;
-
-  notifier->StartBatchUpdate();
-  for (auto media_license_info = container->media_license_info_list_.begin();
-       media_license_info != container->media_license_info_list_.end();
-       ++media_license_info) {
-    GURL origin(media_license_info->origin);
-
-    if (filter.empty() || (CookieTreeHostNode::TitleForUrl(origin).find(
-                               filter) != std::u16string::npos)) {
-      CookieTreeHostNode* host_node = root->GetOrCreateHostNode(origin);
-      CookieTreeMediaLicensesNode* media_licenses_node =
-          host_node->GetOrCreateMediaLicensesNode();
-      media_licenses_node->AddMediaLicenseNode(
-          std::make_unique<CookieTreeMediaLicenseNode>(media_license_info));
-    }
-  }
+  types &= ~indexed_storage_types_;
+  if (types & kCookies) {
+    // Cookies ignore schemes, so group all HTTP and HTTPS cookies together.
+    // TODO(crbug.com/1031721): This will not be true when Scheme-Bound Cookies
+    // is implemented. Investigate whether passing it->SourceScheme() instead
+    // of false is appropriate here.
+    IndexItems(&container->cookie_list_, &HostEntry::cookies, kCookies,
+               [](const net::CanonicalCookie& cookie) {
+                 return cookie.Domain() == "."
+                            ? GURL("http://./")
+                            : net::cookie_util::CookieOriginToURL(
+                                  cookie.Domain(), false /* is_https */);
+               });
+  }
+  if (types & kDatabases) {
+    IndexItems(&container->database_info_list_, &HostEntry::databases,
+               kDatabases, get_origin_url);
+  }
+  if (types & kLocalStorages) {
+    IndexItems(&container->local_storage_info_list_,
+               &HostEntry::local_storages, kLocalStorages, get_origin_url);
+  }
+  if (types & kSessionStorages) {
+    IndexItems(&container->session_storage_info_list_,
+               &HostEntry::session_storages, kSessionStorages,
+               get_origin_url);
+  }
+  if (types & kAppCaches) {
+    IndexItems(&container->appcache_info_list_, &HostEntry::appcaches,
+               kAppCaches, get_origin_url);
+  }
+  if (types & kIndexedDBs) {
+    IndexItems(&container->indexed_db_info_list_, &HostEntry::indexed_dbs,
+               kIndexedDBs, get_origin_url);
+  }
+  if (types & kFileSystems) {
+    IndexItems(&container->file_system_info_list_, &HostEntry::file_systems,
+               kFileSystems, get_origin_url);
+  }
+  if (types & kQuotas) {
+    IndexItems(&container->quota_info_list_, &HostEntry::quotas, kQuotas,
+               [](const BrowsingDataQuotaHelper::QuotaInfo& quota_info) {
+                 return GURL("http://" + quota_info.host);
+               });
+  }
+  if (types & kServiceWorkers) {
+    IndexItems(&container->service_worker_info_list_,
+               &HostEntry::service_workers, kServiceWorkers, get_origin_url);
+  }
+  if (types & kSharedWorkers) {
+    IndexItems(
+        &container->shared_worker_info_list_, &HostEntry::shared_workers,
+        kSharedWorkers,
+        [](const browsing_data::SharedWorkerHelper::SharedWorkerInfo& info) {
+          return info.worker;
+        });
+  }
+  if (types & kCacheStorages) {
+    IndexItems(&container->cache_storage_info_list_,
+               &HostEntry::cache_storages, kCacheStorages, get_origin_url);
+  }
+  if (types & kMediaLicenses) {
+    IndexItems(
+        &container->media_license_info_list_, &HostEntry::media_licenses,
+        kMediaLicenses,
+        [](const BrowsingDataMediaLicenseHelper::MediaLicenseInfo& info) {
+          return GURL(info.origin);
+        });
+  }
+}
+
+const std::vector<CookiesTreeModel::HostEntry*>&
+CookiesTreeModel::GetSortedHostEntries() {
+  // Hosts are only added to the index until it is reset.
+  if (sorted_host_entries_.size() == host_index_.size())
+    return sorted_host_entries_;
+
+  sorted_host_entries_.clear();
+  sorted_host_entries_.reserve(host_index_.size());
+  for (auto& host : host_index_)
+    sorted_host_entries_.push_back(&host.second);
+  std::sort(sorted_host_entries_.begin(), sorted_host_entries_.end(),
+            [](const HostEntry* lhs, const HostEntry* rhs) {
+              return std::tie(lhs->canonicalized_host, lhs->title) <
+                     std::tie(rhs->canonicalized_host, rhs->title);
+            });
+  return sorted_host_entries_;
 }
 
 void CookiesTreeModel::SetBatchExpectation(int batches_expected, bool reset) {
@@ -1960,7 +2015,10 @@ std::unique_ptr<CookiesTreeModel> CookiesTreeModel::CreateForProfile(
       new browsing_data::CacheStorageHelper(storage_partition),
       BrowsingDataMediaLicenseHelper::Create(file_system_context));
 
-  return std::make_unique<CookiesTreeModel>(
+  auto model = std::make_unique<CookiesTreeModel>(
       std::move(container), profile->GetExtensionSpecialStoragePolicy(),
       AccessContextAuditServiceFactory::GetForProfile(profile));
+  model->set_site_data_size_collector(
+      SiteDataSizeCollector::GetForProfile(profile));
+  return model;
 }
@@ -5,9 +5,12 @@
 #ifndef CHROME_BROWSER_BROWSING_DATA_COOKIES_TREE_MODEL_H_
 #define CHROME_BROWSER_BROWSING_DATA_COOKIES_TREE_MODEL_H_
 
+#include <stdint.h>
+
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "base/macros.h"
@@ -17,6 +20,7 @@
 #include "components/content_settings/core/common/content_settings.h"
 #include "extensions/buildflags/buildflags.h"
 #include "ui/base/models/tree_node_model.h"
+#include "url/gurl.h"
 
 class AccessContextAuditService;
 class CookiesTreeModel;
@@ -45,6 +49,7 @@ class CookieTreeSharedWorkersNode;
 class CookieTreeSessionStorageNode;
 class CookieTreeSessionStoragesNode;
 class ExtensionSpecialStoragePolicy;
+class SiteDataSizeCollector;
 
 namespace content_settings {
 class CookieSettings;
@@ -373,10 +378,23 @@ class CookiesTreeModel : public ui::TreeNodeModel<CookieTreeNode> {
     return access_context_audit_service_;
   }
 
+  // Sets the collector whose cached site data sizes are updated as data is
+  // deleted through the model. Only set for models created for a profile.
+  void set_site_data_size_collector(SiteDataSizeCollector* collector) {
+    site_data_size_collector_ = collector;
+  }
+  SiteDataSizeCollector* site_data_size_collector() {
+    return site_data_size_collector_;
+  }
+
   LocalDataContainer* data_container() {
     return data_container_.get();
   }
 
+  // Drops the items grouped by host, which point into |data_container_|. Must
+  // be called before items are erased from the container.
+  void ResetHostIndex();
+
   // Set the number of |batches_expected| this class should expect to receive.
   // If |reset| is true, then this is a new set of batches, but if false, then
   // this is a revised number (batches originally counted should no longer be
@@ -407,44 +425,90 @@ class CookiesTreeModel : public ui::TreeNodeModel<CookieTreeNode> {
   // batches have finished processing.
   void MaybeNotifyBatchesEnded();
 
-  void PopulateAppCacheInfoWithFilter(LocalDataContainer* container,
-                                      ScopedBatchUpdateNotifier* notifier,
-                                      const std::u16string& filter);
-  void PopulateCookieInfoWithFilter(LocalDataContainer* container,
-                                    ScopedBatchUpdateNotifier* notifier,
-                                    const std::u16string& filter);
-  void PopulateDatabaseInfoWithFilter(LocalDataContainer* container,
-                                      ScopedBatchUpdateNotifier* notifier,
-                                      const std::u16string& filter);
-  void PopulateLocalStorageInfoWithFilter(LocalDataContainer* container,
-                                          ScopedBatchUpdateNotifier* notifier,
-                                          const std::u16string& filter);
-  void PopulateSessionStorageInfoWithFilter(LocalDataContainer* container,
-                                            ScopedBatchUpdateNotifier* notifier,
-                                            const std::u16string& filter);
-  void PopulateIndexedDBInfoWithFilter(LocalDataContainer* container,
-                                       ScopedBatchUpdateNotifier* notifier,
-                                       const std::u16string& filter);
-  void PopulateFileSystemInfoWithFilter(LocalDataContainer* container,
-                                        ScopedBatchUpdateNotifier* notifier,
-                                        const std::u16string& filter);
-  void PopulateQuotaInfoWithFilter(LocalDataContainer* container,
-                                   ScopedBatchUpdateNotifier* notifier,
-                                   const std::u16string& filter);
-  void PopulateServiceWorkerUsageInfoWithFilter(
-      LocalDataContainer* container,
-      ScopedBatchUpdateNotifier* notifier,
-      const std::u16string& filter);
-  void PopulateSharedWorkerInfoWithFilter(LocalDataContainer* container,
-                                          ScopedBatchUpdateNotifier* notifier,
-                                          const std::u16string& filter);
-  void PopulateCacheStorageUsageInfoWithFilter(
-      LocalDataContainer* container,
-      ScopedBatchUpdateNotifier* notifier,
-      const std::u16string& filter);
-  void PopulateMediaLicenseInfoWithFilter(LocalDataContainer* container,
-                                          ScopedBatchUpdateNotifier* notifier,
-                                          const std::u16string& filter);
+  // The storage types of LocalDataContainer, as bits of a mask.
+  enum StorageType : uint32_t {
+    kCookies = 1 << 0,
+    kDatabases = 1 << 1,
+    kLocalStorages = 1 << 2,
+    kSessionStorages = 1 << 3,
+    kAppCaches = 1 << 4,
+    kIndexedDBs = 1 << 5,
+    kFileSystems = 1 << 6,
+    kQuotas = 1 << 7,
+    kServiceWorkers = 1 << 8,
+    kSharedWorkers = 1 << 9,
+    kCacheStorages = 1 << 10,
+    kMediaLicenses = 1 << 11,
+    kAllStorageTypes = (1 << 12) - 1,
+  };
+
+  // The items of |data_container_| which belong under one host node.
+  struct HostEntry {
+    HostEntry(const GURL& url, const std::u16string& title);
+    ~HostEntry();
+
+    // Returns true if the entry has items of any of the storage |types|.
+    bool HasItems(uint32_t types) const;
+
+    GURL url;
+    const std::u16string title;
+    const std::string canonicalized_host;
+
+    std::vector<LocalDataContainer::CookieList::iterator> cookies;
+    std::vector<LocalDataContainer::DatabaseInfoList::iterator> databases;
+    std::vector<LocalDataContainer::LocalStorageInfoList::iterator>
+        local_storages;
+    std::vector<LocalDataContainer::SessionStorageInfoList::iterator>
+        session_storages;
+    std::vector<LocalDataContainer::AppCacheInfoList::iterator> appcaches;
+    std::vector<LocalDataContainer::IndexedDBInfoList::iterator> indexed_dbs;
+    std::vector<LocalDataContainer::FileSystemInfoList::iterator>
+        file_systems;
+    std::vector<LocalDataContainer::QuotaInfoList::iterator> quotas;
+    std::vector<LocalDataContainer::ServiceWorkerUsageInfoList::iterator>
+        service_workers;
+    std::vector<LocalDataContainer::SharedWorkerInfoList::iterator>
+        shared_workers;
+    std::vector<LocalDataContainer::CacheStorageUsageInfoList::iterator>
+        cache_storages;
+    std::vector<LocalDataContainer::MediaLicenseInfoList::iterator>
+        media_licenses;
+
+    DISALLOW_COPY_AND_ASSIGN(HostEntry);
+  };
+
+  // Indexes the items of storage |type|, which were just loaded into
+  // |container|, and adds them to the tree.
+  void PopulateStorageType(LocalDataContainer* container,
+                           ScopedBatchUpdateNotifier* notifier,
+                           StorageType type);
+
+  // Adds the items of the storage |types| whose host title contains |filter|
+  // to the tree, in one pass over the sorted host index. New nodes are built
+  // detached from the tree and merged into it, so that observers are notified
+  // once per run of new siblings instead of once per item.
+  void PopulateFromHostIndex(ScopedBatchUpdateNotifier* notifier,
+                             const std::u16string& filter,
+                             uint32_t types);
+
+  // Adds the nodes of the storage |types| of |entry| to |host_node|.
+  void AddStorageNodes(const HostEntry& entry,
+                       uint32_t types,
+                       CookieTreeHostNode* host_node);
+
+  // Groups the items of the storage |types| which aren't indexed yet by host.
+  void IndexStorageTypes(uint32_t types);
+
+  // Replaces the |items| of storage |type| of every host entry with the items
+  // of |list|, grouped under the host of the URL |get_url| returns for them.
+  template <typename List, typename GetUrl>
+  void IndexItems(List* list,
+                  std::vector<typename List::iterator> HostEntry::*items,
+                  StorageType type,
+                  GetUrl get_url);
+
+  // Returns the host entries in the order of the host nodes.
+  const std::vector<HostEntry*>& GetSortedHostEntries();
 
 #if BUILDFLAG(ENABLE_EXTENSIONS)
   // The extension special storage policy; see ExtensionsProtectingNode() above.
@@ -461,6 +525,9 @@ class CookiesTreeModel : public ui::TreeNodeModel<CookieTreeNode> {
 
   AccessContextAuditService* access_context_audit_service_ = nullptr;
 
+  // Owned by the profile, which outlives the model.
+  SiteDataSizeCollector* site_data_size_collector_ = nullptr;
+
   // Keeps track of how many batches the consumer of this class says it is going
   // to send.
   int batches_expected_ = 0;
@@ -474,6 +541,18 @@ class CookiesTreeModel : public ui::TreeNodeModel<CookieTreeNode> {
 
   // Counts how many batches have finished.
   int batches_ended_ = 0;
+
+  // The items of |data_container_| grouped by host title, so that the tree is
+  // built in one pass over the hosts, and rebuilt for a new filter without
+  // walking the container and computing the host of every item again.
+  std::unordered_map<std::u16string, HostEntry> host_index_;
+
+  // The entries of |host_index_| in the order of the host nodes, sorted again
+  // once new hosts are indexed.
+  std::vector<HostEntry*> sorted_host_entries_;
+
+  // The storage types whose items are in |host_index_|.
+  uint32_t indexed_storage_types_ = 0;
 };
 
 #endif  // CHROME_BROWSER_BROWSING_DATA_COOKIES_TREE_MODEL_H_
@@ -50,6 +50,35 @@ using content::BrowserThread;
 
 namespace {
 
+// Counts the host nodes added to a CookiesTreeModel, and the notifications of
+// those additions.
+class HostNodesAddedObserver : public CookiesTreeModel::Observer {
+ public:
+  size_t notifications() const { return notifications_; }
+  size_t host_nodes() const { return host_nodes_; }
+
+  // CookiesTreeModel::Observer:
+  void TreeNodesAdded(ui::TreeModel* model,
+                      ui::TreeModelNode* parent,
+                      size_t start,
+                      size_t count) override {
+    if (parent != model->GetRoot())
+      return;
+    ++notifications_;
+    host_nodes_ += count;
+  }
+  void TreeNodesRemoved(ui::TreeModel* model,
+                        ui::TreeModelNode* parent,
+                        size_t start,
+                        size_t count) override {}
+  void TreeNodeChanged(ui::TreeModel* model, ui::TreeModelNode* node) override {
+  }
+
+ private:
+  size_t notifications_ = 0;
+  size_t host_nodes_ = 0;
+};
+
 class CookiesTreeModelTest : public testing::Test {
  public:
   ~CookiesTreeModelTest() override {
@@ -1678,6 +1707,64 @@ TEST_F(CookiesTreeModelTest, CookiesFilter) {
   EXPECT_EQ("A,B,C,D", GetDisplayedCookies(&cookies_model));
 }
 
+TEST_F(CookiesTreeModelTest, BulkPopulation) {
+  auto container = std::make_unique<LocalDataContainer>(
+      mock_browsing_data_cookie_helper_, mock_browsing_data_database_helper_,
+      mock_browsing_data_local_storage_helper_,
+      mock_browsing_data_session_storage_helper_,
+      mock_browsing_data_appcache_helper_,
+      mock_browsing_data_indexed_db_helper_,
+      mock_browsing_data_file_system_helper_, mock_browsing_data_quota_helper_,
+      mock_browsing_data_service_worker_helper_,
+      mock_browsing_data_shared_worker_helper_,
+      mock_browsing_data_cache_storage_helper_,
+      mock_browsing_data_media_license_helper_);
+  CookiesTreeModel cookies_model(std::move(container),
+                                 special_storage_policy());
+  HostNodesAddedObserver observer;
+  cookies_model.AddCookiesTreeObserver(&observer);
+
+  mock_browsing_data_cookie_helper_->
+      AddCookieSamples(GURL("http://foo3.com"), "D=1");
+  mock_browsing_data_cookie_helper_->
+      AddCookieSamples(GURL("http://foo1.com"), "E=1");
+  mock_browsing_data_cookie_helper_->
+      AddCookieSamples(GURL("http://a.foo2.com"), "C=1");
+  mock_browsing_data_cookie_helper_->
+      AddCookieSamples(GURL("http://foo2.com"), "B=1");
+  mock_browsing_data_cookie_helper_->
+      AddCookieSamples(GURL("http://foo1.com"), "A=1");
+  mock_browsing_data_cookie_helper_->Notify();
+
+  // The new host nodes are published at once, in order.
+  EXPECT_EQ("A,E,B,C,D", GetDisplayedCookies(&cookies_model));
+  EXPECT_EQ(1u, observer.notifications());
+  EXPECT_EQ(4u, observer.host_nodes());
+
+  // Hosts of another storage type are merged with the existing ones.
+  mock_browsing_data_local_storage_helper_->AddLocalStorageSamples();
+  mock_browsing_data_local_storage_helper_->Notify();
+  EXPECT_EQ("http://host1:1/,http://host2:2/",
+            GetDisplayedLocalStorages(&cookies_model));
+  EXPECT_EQ(2u, observer.notifications());
+  EXPECT_EQ(6u, observer.host_nodes());
+
+  cookies_model.UpdateSearchResults(u"foo2");
+  EXPECT_EQ("B,C", GetDisplayedCookies(&cookies_model));
+  EXPECT_EQ("", GetDisplayedLocalStorages(&cookies_model));
+
+  // Deleting items drops the host index, which is rebuilt from the container
+  // for the next filter.
+  cookies_model.UpdateSearchResults(std::u16string());
+  DeleteStoredObjects(cookies_model.GetRoot()->children()[0].get());
+  cookies_model.UpdateSearchResults(std::u16string());
+  EXPECT_EQ("B,C,D", GetDisplayedCookies(&cookies_model));
+  EXPECT_EQ("http://host1:1/,http://host2:2/",
+            GetDisplayedLocalStorages(&cookies_model));
+
+  cookies_model.RemoveCookiesTreeObserver(&observer);
+}
+
 // Tests that cookie source URLs are stored correctly in the cookies
 // tree model.
 TEST_F(CookiesTreeModelTest, CanonicalizeCookieSource) {
@@ -4,20 +4,28 @@
 
 #include "chrome/browser/browsing_data/site_data_size_collector.h"
 
+#include <algorithm>
+#include <memory>
 #include <utility>
 
 #include "base/bind.h"
+#include "base/callback_helpers.h"
 #include "base/files/file_util.h"
+#include "base/notreached.h"
 #include "base/task/post_task.h"
 #include "base/task/thread_pool.h"
+#include "chrome/browser/browsing_data/browsing_data_file_system_util.h"
 #include "chrome/common/chrome_constants.h"
 #include "chrome/common/pref_names.h"
+#include "content/public/browser/browser_context.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/storage_usage_info.h"
 #include "content/public/common/content_constants.h"
 
 namespace {
 
+const char kSiteDataSizeCollectorKey[] = "SiteDataSizeCollector";
+
 int64_t GetFileSizeBlocking(const base::FilePath& file_path) {
   int64_t size = 0;
   bool success = base::GetFileSize(file_path, &size);
@@ -44,80 +52,195 @@ SiteDataSizeCollector::SiteDataSizeCollector(
       indexed_db_helper_(indexed_db_helper),
       file_system_helper_(file_system_helper),
       service_worker_helper_(service_worker_helper),
-      cache_storage_helper_(cache_storage_helper),
-      in_flight_operations_(0),
-      total_bytes_(0) {}
+      cache_storage_helper_(cache_storage_helper) {
+  fetching_.fill(false);
+  sizes_.fill(-1);
+}
 
 SiteDataSizeCollector::~SiteDataSizeCollector() {
 }
 
+// static
+SiteDataSizeCollector* SiteDataSizeCollector::GetForProfile(Profile* profile) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto* collector = static_cast<SiteDataSizeCollector*>(
+      profile->GetUserData(kSiteDataSizeCollectorKey));
+  if (collector)
+    return collector;
+
+  content::StoragePartition* storage_partition =
+      content::BrowserContext::GetDefaultStoragePartition(profile);
+  auto new_collector = std::make_unique<SiteDataSizeCollector>(
+      storage_partition->GetPath(),
+      new browsing_data::CookieHelper(storage_partition, base::NullCallback()),
+      new browsing_data::DatabaseHelper(profile),
+      new browsing_data::LocalStorageHelper(profile),
+      new browsing_data::AppCacheHelper(
+          storage_partition->GetAppCacheService()),
+      new browsing_data::IndexedDBHelper(storage_partition),
+      browsing_data::FileSystemHelper::Create(
+          storage_partition->GetFileSystemContext(),
+          browsing_data_file_system_util::GetAdditionalFileSystemTypes(),
+          storage_partition->GetNativeIOContext()),
+      new browsing_data::ServiceWorkerHelper(
+          storage_partition->GetServiceWorkerContext()),
+      new browsing_data::CacheStorageHelper(storage_partition));
+  collector = new_collector.get();
+  profile->SetUserData(kSiteDataSizeCollectorKey, std::move(new_collector));
+  return collector;
+}
+
+// static
+void SiteDataSizeCollector::InvalidateForProfile(Profile* profile) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto* collector = static_cast<SiteDataSizeCollector*>(
+      profile->GetUserData(kSiteDataSizeCollectorKey));
+  if (collector)
+    collector->Invalidate();
+}
+
 void SiteDataSizeCollector::Fetch(FetchCallback callback) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   DCHECK(!callback.is_null());
 
-  fetch_callback_ = std::move(callback);
-  total_bytes_ = 0;
-  in_flight_operations_ = 0;
-
-  if (appcache_helper_.get()) {
-    appcache_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnAppCacheModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
-  }
-  if (cookie_helper_.get()) {
-    cookie_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnCookiesModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
-  }
-  if (database_helper_.get()) {
-    database_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnDatabaseModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
-  }
-  if (local_storage_helper_.get()) {
-    local_storage_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnLocalStorageModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
+  int64_t total_bytes = -1;
+  if (has_snapshot_) {
+    total_bytes = GetTotalBytes();
+    callback.Run(total_bytes);
   }
-  if (indexed_db_helper_.get()) {
-    indexed_db_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnIndexedDBModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
-  }
-  if (file_system_helper_.get()) {
-    file_system_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnFileSystemModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
-  }
-  if (service_worker_helper_.get()) {
-    service_worker_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnServiceWorkerModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
+  pending_callbacks_.emplace_back(std::move(callback), total_bytes);
+  Refresh();
+}
+
+void SiteDataSizeCollector::Invalidate() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  has_snapshot_ = false;
+  if (!IsFetching())
+    return;
+
+  // The sizes being fetched may predate the deletion.
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  fetching_.fill(false);
+  for (auto& deleted_origins : deleted_origins_)
+    deleted_origins.clear();
+  if (!pending_callbacks_.empty())
+    Refresh();
+}
+
+void SiteDataSizeCollector::OnStorageDeleted(StorageType type,
+                                             const url::Origin& origin) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (type == kCookies) {
+    // Without a snapshot, the next fetch refreshes all the sizes anyway.
+    if (has_snapshot_)
+      StartFetching(kCookies);
+    return;
   }
-  if (cache_storage_helper_.get()) {
-    cache_storage_helper_->StartFetching(
-        base::BindOnce(&SiteDataSizeCollector::OnCacheStorageModelInfoLoaded,
-                       weak_ptr_factory_.GetWeakPtr()));
-    in_flight_operations_++;
+
+  if (fetching_[type])
+    deleted_origins_[type].insert(origin);
+  auto it = origin_sizes_[type].find(origin);
+  if (it == origin_sizes_[type].end())
+    return;
+  if (sizes_[type] >= it->second)
+    sizes_[type] -= it->second;
+  origin_sizes_[type].erase(it);
+}
+
+void SiteDataSizeCollector::StartFetching(StorageType type) {
+  if (fetching_[type])
+    return;
+
+  switch (type) {
+    case kAppCache:
+      if (!appcache_helper_.get())
+        return;
+      fetching_[type] = true;
+      appcache_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnAppCacheModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kCookies:
+      if (!cookie_helper_.get())
+        return;
+      fetching_[type] = true;
+      cookie_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnCookiesModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kDatabases:
+      if (!database_helper_.get())
+        return;
+      fetching_[type] = true;
+      database_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnDatabaseModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kLocalStorage:
+      if (!local_storage_helper_.get())
+        return;
+      fetching_[type] = true;
+      local_storage_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnLocalStorageModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kIndexedDB:
+      if (!indexed_db_helper_.get())
+        return;
+      fetching_[type] = true;
+      indexed_db_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnIndexedDBModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kFileSystems:
+      if (!file_system_helper_.get())
+        return;
+      fetching_[type] = true;
+      file_system_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnFileSystemModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kServiceWorkers:
+      if (!service_worker_helper_.get())
+        return;
+      fetching_[type] = true;
+      service_worker_helper_->StartFetching(base::BindOnce(
+          &SiteDataSizeCollector::OnServiceWorkerModelInfoLoaded,
+          weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kCacheStorage:
+      if (!cache_storage_helper_.get())
+        return;
+      fetching_[type] = true;
+      cache_storage_helper_->StartFetching(
+          base::BindOnce(&SiteDataSizeCollector::OnCacheStorageModelInfoLoaded,
+                         weak_ptr_factory_.GetWeakPtr()));
+      return;
+    case kStorageTypeCount:
+      break;
   }
+  NOTREACHED();
+}
+
+void SiteDataSizeCollector::Refresh() {
+  for (int type = 0; type < kStorageTypeCount; ++type)
+    StartFetching(static_cast<StorageType>(type));
   // TODO(fukino): SITE_USAGE_DATA and WEB_APP_DATA should be counted too.
   // All data types included in REMOVE_SITE_USAGE_DATA should be counted.
 }
 
+bool SiteDataSizeCollector::IsFetching() const {
+  return std::find(fetching_.begin(), fetching_.end(), true) !=
+         fetching_.end();
+}
+
 void SiteDataSizeCollector::OnAppCacheModelInfoLoaded(
     const std::list<content::StorageUsageInfo>& info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  int64_t total_size = 0;
+  std::map<url::Origin, int64_t> origin_sizes;
   for (const auto& info : info_list)
-    total_size += info.total_size_bytes;
-  OnStorageSizeFetched(total_size);
+    origin_sizes[info.origin] += info.total_size_bytes;
+  OnOriginSizesFetched(kAppCache, std::move(origin_sizes));
 }
 
 void SiteDataSizeCollector::OnCookiesModelInfoLoaded(
@@ -125,7 +248,7 @@ void SiteDataSizeCollector::OnCookiesModelInfoLoaded(
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
   if (cookie_list.empty()) {
-    OnStorageSizeFetched(0);
+    OnStorageSizeFetched(kCookies, 0);
     return;
   }
   base::FilePath cookie_file_path = default_storage_partition_path_
@@ -134,69 +257,108 @@ void SiteDataSizeCollector::OnCookiesModelInfoLoaded(
       FROM_HERE, {base::MayBlock(), base::TaskPriority::BEST_EFFORT},
       base::BindOnce(&GetFileSizeBlocking, cookie_file_path),
       base::BindOnce(&SiteDataSizeCollector::OnStorageSizeFetched,
-                     weak_ptr_factory_.GetWeakPtr()));
+                     weak_ptr_factory_.GetWeakPtr(), kCookies));
 }
 
 void SiteDataSizeCollector::OnDatabaseModelInfoLoaded(
     const DatabaseInfoList& database_info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  int64_t total_size = 0;
+  std::map<url::Origin, int64_t> origin_sizes;
   for (const auto& database_info : database_info_list)
-    total_size += database_info.total_size_bytes;
-  OnStorageSizeFetched(total_size);
+    origin_sizes[database_info.origin] += database_info.total_size_bytes;
+  OnOriginSizesFetched(kDatabases, std::move(origin_sizes));
 }
 
 void SiteDataSizeCollector::OnLocalStorageModelInfoLoaded(
       const LocalStorageInfoList& local_storage_info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  int64_t total_size = 0;
-  for (const auto& local_storage_info : local_storage_info_list)
-    total_size += local_storage_info.total_size_bytes;
-  OnStorageSizeFetched(total_size);
+  std::map<url::Origin, int64_t> origin_sizes;
+  for (const auto& local_storage_info : local_storage_info_list) {
+    origin_sizes[local_storage_info.origin] +=
+        local_storage_info.total_size_bytes;
+  }
+  OnOriginSizesFetched(kLocalStorage, std::move(origin_sizes));
 }
 
 void SiteDataSizeCollector::OnIndexedDBModelInfoLoaded(
     const std::list<content::StorageUsageInfo>& indexed_db_info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  int64_t total_size = 0;
+  std::map<url::Origin, int64_t> origin_sizes;
   for (const auto& indexed_db_info : indexed_db_info_list)
-    total_size += indexed_db_info.total_size_bytes;
-  OnStorageSizeFetched(total_size);
+    origin_sizes[indexed_db_info.origin] += indexed_db_info.total_size_bytes;
+  OnOriginSizesFetched(kIndexedDB, std::move(origin_sizes));
 }
 
 void SiteDataSizeCollector::OnFileSystemModelInfoLoaded(
     const FileSystemInfoList& file_system_info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  int64_t total_size = 0;
+  std::map<url::Origin, int64_t> origin_sizes;
   for (const auto& file_system_info : file_system_info_list) {
     for (const auto& usage : file_system_info.usage_map)
-      total_size += usage.second;
+      origin_sizes[file_system_info.origin] += usage.second;
   }
-  OnStorageSizeFetched(total_size);
+  OnOriginSizesFetched(kFileSystems, std::move(origin_sizes));
 }
 
 void SiteDataSizeCollector::OnServiceWorkerModelInfoLoaded(
     const ServiceWorkerUsageInfoList& service_worker_info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  int64_t total_size = 0;
-  for (const auto& service_worker_info : service_worker_info_list)
-    total_size += service_worker_info.total_size_bytes;
-  OnStorageSizeFetched(total_size);
+  std::map<url::Origin, int64_t> origin_sizes;
+  for (const auto& service_worker_info : service_worker_info_list) {
+    origin_sizes[service_worker_info.origin] +=
+        service_worker_info.total_size_bytes;
+  }
+  OnOriginSizesFetched(kServiceWorkers, std::move(origin_sizes));
 }
 
 void SiteDataSizeCollector::OnCacheStorageModelInfoLoaded(
       const CacheStorageUsageInfoList& cache_storage_info_list) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  std::map<url::Origin, int64_t> origin_sizes;
+  for (const auto& cache_storage_info : cache_storage_info_list) {
+    origin_sizes[cache_storage_info.origin] +=
+        cache_storage_info.total_size_bytes;
+  }
+  OnOriginSizesFetched(kCacheStorage, std::move(origin_sizes));
+}
+
+void SiteDataSizeCollector::OnOriginSizesFetched(
+    StorageType type,
+    std::map<url::Origin, int64_t> origin_sizes) {
+  for (const url::Origin& origin : deleted_origins_[type])
+    origin_sizes.erase(origin);
+  deleted_origins_[type].clear();
+
   int64_t total_size = 0;
-  for (const auto& cache_storage_info : cache_storage_info_list)
-    total_size += cache_storage_info.total_size_bytes;
-  OnStorageSizeFetched(total_size);
+  for (const auto& origin_size : origin_sizes)
+    total_size += origin_size.second;
+  origin_sizes_[type] = std::move(origin_sizes);
+  OnStorageSizeFetched(type, total_size);
 }
 
-void SiteDataSizeCollector::OnStorageSizeFetched(int64_t size) {
+void SiteDataSizeCollector::OnStorageSizeFetched(StorageType type,
+                                                 int64_t size) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  if (size > 0)
-    total_bytes_ += size;
-  if (--in_flight_operations_ == 0)
-    std::move(fetch_callback_).Run(total_bytes_);
+  sizes_[type] = size;
+  fetching_[type] = false;
+  if (IsFetching())
+    return;
+
+  has_snapshot_ = true;
+  const int64_t total_bytes = GetTotalBytes();
+  std::vector<std::pair<FetchCallback, int64_t>> callbacks;
+  callbacks.swap(pending_callbacks_);
+  for (auto& callback : callbacks) {
+    if (callback.second != total_bytes)
+      callback.first.Run(total_bytes);
+  }
+}
+
+int64_t SiteDataSizeCollector::GetTotalBytes() const {
+  int64_t total_bytes = 0;
+  for (int64_t size : sizes_) {
+    if (size > 0)
+      total_bytes += size;
+  }
+  return total_bytes;
 }
@@ -5,11 +5,18 @@
 #ifndef CHROME_BROWSER_BROWSING_DATA_SITE_DATA_SIZE_COLLECTOR_H_
 #define CHROME_BROWSER_BROWSING_DATA_SITE_DATA_SIZE_COLLECTOR_H_
 
+#include <stdint.h>
+
+#include <array>
 #include <list>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/memory/weak_ptr.h"
+#include "base/supports_user_data.h"
 #include "chrome/browser/profiles/profile.h"
 #include "components/browsing_data/content/appcache_helper.h"
 #include "components/browsing_data/content/cache_storage_helper.h"
@@ -20,9 +27,32 @@
 #include "components/browsing_data/content/local_storage_helper.h"
 #include "components/browsing_data/content/service_worker_helper.h"
 #include "content/public/browser/storage_partition.h"
-
-class SiteDataSizeCollector {
+#include "url/origin.h"
+
+// Computes the storage space used by site data, for the storage settings.
+//
+// The size of each storage type is kept between fetches, so that a fetch
+// returns the last snapshot at once and refreshes it in the background,
+// instead of waiting for every helper to list its data again. The snapshot of
+// a profile is kept as long as the profile, across settings page visits. It is
+// dropped when site data is removed through the browsing data remover, and
+// updated for the deleted origins only when site data is deleted through the
+// cookies tree model.
+class SiteDataSizeCollector : public base::SupportsUserData::Data {
  public:
+  // The storage types whose sizes are fetched, indices of |sizes_|.
+  enum StorageType {
+    kAppCache,
+    kCookies,
+    kDatabases,
+    kLocalStorage,
+    kIndexedDB,
+    kFileSystems,
+    kServiceWorkers,
+    kCacheStorage,
+    kStorageTypeCount,
+  };
+
   using CookieList = std::list<net::CanonicalCookie>;
   using DatabaseInfoList = std::list<content::StorageUsageInfo>;
   using LocalStorageInfoList = std::list<content::StorageUsageInfo>;
@@ -42,14 +72,47 @@ class SiteDataSizeCollector {
       browsing_data::FileSystemHelper* file_system_helper,
       browsing_data::ServiceWorkerHelper* service_worker_helper,
       browsing_data::CacheStorageHelper* cache_storage_helper);
-  virtual ~SiteDataSizeCollector();
+  ~SiteDataSizeCollector() override;
+
+  // Returns the collector of the default storage partition of |profile|,
+  // creating it if needed.
+  static SiteDataSizeCollector* GetForProfile(Profile* profile);
 
-  using FetchCallback = base::OnceCallback<void(int64_t)>;
+  // Drops the snapshot of the collector of |profile|, if there is one.
+  static void InvalidateForProfile(Profile* profile);
 
-  // Requests to fetch the total storage space used by site data.
+  using FetchCallback = base::RepeatingCallback<void(int64_t)>;
+
+  // Requests to fetch the total storage space used by site data. If there is a
+  // snapshot, |callback| is run at once with its total, the snapshot is
+  // refreshed, and |callback| is run again with the refreshed total if it
+  // differs. Otherwise |callback| is run once all the sizes are fetched.
   void Fetch(FetchCallback callback);
 
+  // Drops the snapshot, as site data was deleted, so that the next fetch waits
+  // for fresh sizes. Fetches in progress are restarted.
+  void Invalidate();
+
+  // Updates the snapshot after the data of |type| stored by |origin| was
+  // deleted, without listing the data of the other origins again. Cookies are
+  // measured by the size of the cookie file, so deleting cookies refreshes that
+  // size whatever |origin| is.
+  void OnStorageDeleted(StorageType type, const url::Origin& origin);
+
  private:
+  // Starts fetching the size of |type|, unless it is in progress or there is
+  // no helper for it.
+  void StartFetching(StorageType type);
+
+  // Starts fetching the sizes of all storage types.
+  void Refresh();
+
+  // Returns true if the size of any storage type is being fetched.
+  bool IsFetching() const;
+
+  // Returns the sum of the fetched sizes.
+  int64_t GetTotalBytes() const;
+
   // Callback methods to be invoked when fetching the data is complete.
   void OnAppCacheModelInfoLoaded(
       const std::list<content::StorageUsageInfo>& info_list);
@@ -66,8 +129,13 @@ class SiteDataSizeCollector {
   void OnCacheStorageModelInfoLoaded(
       const CacheStorageUsageInfoList& cache_storage_info_list);
 
+  // Callback for when the size of each origin is fetched from a storage
+  // backend which lists its data per origin.
+  void OnOriginSizesFetched(StorageType type,
+                            std::map<url::Origin, int64_t> origin_sizes);
+
   // Callback for when the size is fetched from each storage backend.
-  void OnStorageSizeFetched(int64_t size);
+  void OnStorageSizeFetched(StorageType type, int64_t size);
 
   // Path of the default storage partition of this profile.
   base::FilePath default_storage_partition_path_;
@@ -83,14 +151,26 @@ class SiteDataSizeCollector {
   scoped_refptr<browsing_data::ServiceWorkerHelper> service_worker_helper_;
   scoped_refptr<browsing_data::CacheStorageHelper> cache_storage_helper_;
 
-  // Callback called when sizes of all site data are fetched and accumulated.
-  FetchCallback fetch_callback_;
+  // Callbacks to run when sizes of all site data are fetched, along with the
+  // total each was last run with, or -1 if it was not run yet.
+  std::vector<std::pair<FetchCallback, int64_t>> pending_callbacks_;
+
+  // Whether the size of each storage type is being fetched.
+  std::array<bool, kStorageTypeCount> fetching_;
+
+  // The last fetched size of each storage type, or -1 if it is unknown. Each
+  // size is updated as soon as it is fetched.
+  std::array<int64_t, kStorageTypeCount> sizes_;
+
+  // The size of each origin, for the storage types listed per origin.
+  std::array<std::map<url::Origin, int64_t>, kStorageTypeCount> origin_sizes_;
 
-  // Keeps track of how many fetch operations are ongoing.
-  int in_flight_operations_;
+  // Origins deleted while their storage type was being fetched, which are left
+  // out of the fetched sizes as they may have been listed before the deletion.
+  std::array<std::set<url::Origin>, kStorageTypeCount> deleted_origins_;
 
-  // Keeps track of the sum of all fetched size.
-  int64_t total_bytes_;
+  // True if all the sizes were fetched since the last invalidation.
+  bool has_snapshot_ = false;
 
   base::WeakPtrFactory<SiteDataSizeCollector> weak_ptr_factory_{this};
 
@@ -24,6 +24,8 @@
 #include "content/public/common/content_constants.h"
 #include "content/public/test/browser_task_environment.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+#include "url/origin.h"
 
 namespace {
 
@@ -71,10 +73,10 @@ class SiteDataSizeCollectorTest : public testing::Test {
     mock_browsing_data_database_helper_ = nullptr;
   }
 
-  void FetchCallback(base::OnceClosure done, int64_t size) {
+  void FetchCallback(base::RepeatingClosure done, int64_t size) {
     fetched_size_ = size;
     if (done)
-      std::move(done).Run();
+      done.Run();
   }
 
  protected:
@@ -107,9 +109,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchCookie) {
       nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
 
   base::RunLoop run_loop;
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this),
-                                 run_loop.QuitClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      run_loop.QuitClosure()));
   // AddCookieSample() actually doesn't write the cookie to the file, only
   // triggers the condition to take the file into account.
   mock_browsing_data_cookie_helper_->AddCookieSamples(
@@ -126,8 +128,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchCookieWithoutEntry) {
       nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
 
   // Fetched size should be 0 if there are no cookies.
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_cookie_helper_->Notify();
   EXPECT_EQ(0, fetched_size_);
 }
@@ -137,8 +140,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchDatabase) {
       profile_->GetPath(), nullptr, mock_browsing_data_database_helper_.get(),
       nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_database_helper_->AddDatabaseSamples();
   mock_browsing_data_database_helper_->Notify();
   EXPECT_EQ(3, fetched_size_);
@@ -150,8 +154,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchLocalStorage) {
       mock_browsing_data_local_storage_helper_.get(), nullptr, nullptr, nullptr,
       nullptr, nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_local_storage_helper_->AddLocalStorageSamples();
   mock_browsing_data_local_storage_helper_->Notify();
   EXPECT_EQ(3, fetched_size_);
@@ -163,8 +168,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchAppCache) {
                                   mock_browsing_data_appcache_helper_.get(),
                                   nullptr, nullptr, nullptr, nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_appcache_helper_->AddAppCacheSamples();
   mock_browsing_data_appcache_helper_->Notify();
   EXPECT_EQ(6, fetched_size_);
@@ -175,8 +181,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchIndexedDB) {
       profile_->GetPath(), nullptr, nullptr, nullptr, nullptr,
       mock_browsing_data_indexed_db_helper_.get(), nullptr, nullptr, nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_indexed_db_helper_->AddIndexedDBSamples();
   mock_browsing_data_indexed_db_helper_->Notify();
   EXPECT_EQ(3, fetched_size_);
@@ -187,8 +194,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchFileSystem) {
       profile_->GetPath(), nullptr, nullptr, nullptr, nullptr, nullptr,
       mock_browsing_data_file_system_helper_.get(), nullptr, nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_file_system_helper_->AddFileSystemSamples();
   mock_browsing_data_file_system_helper_->Notify();
   EXPECT_EQ(14, fetched_size_);
@@ -199,8 +207,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchServiceWorker) {
       profile_->GetPath(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
       mock_browsing_data_service_worker_helper_.get(), nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_service_worker_helper_->AddServiceWorkerSamples();
   mock_browsing_data_service_worker_helper_->Notify();
   EXPECT_EQ(3, fetched_size_);
@@ -211,8 +220,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchCacheStorage) {
       profile_->GetPath(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
       nullptr, mock_browsing_data_cache_storage_helper_.get());
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
   mock_browsing_data_cache_storage_helper_->AddCacheStorageSamples();
   mock_browsing_data_cache_storage_helper_->Notify();
   EXPECT_EQ(3, fetched_size_);
@@ -224,8 +234,9 @@ TEST_F(SiteDataSizeCollectorTest, FetchMultiple) {
       mock_browsing_data_indexed_db_helper_.get(), nullptr,
       mock_browsing_data_service_worker_helper_.get(), nullptr);
 
-  collector.Fetch(base::BindOnce(&SiteDataSizeCollectorTest::FetchCallback,
-                                 base::Unretained(this), base::OnceClosure()));
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
 
   mock_browsing_data_indexed_db_helper_->AddIndexedDBSamples();
   mock_browsing_data_indexed_db_helper_->Notify();
@@ -237,4 +248,82 @@ TEST_F(SiteDataSizeCollectorTest, FetchMultiple) {
   EXPECT_EQ(3 + 3, fetched_size_);
 }
 
+TEST_F(SiteDataSizeCollectorTest, FetchReturnsSnapshot) {
+  SiteDataSizeCollector collector(
+      profile_->GetPath(), nullptr, mock_browsing_data_database_helper_.get(),
+      nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  mock_browsing_data_database_helper_->AddDatabaseSamples();
+  mock_browsing_data_database_helper_->Notify();
+  EXPECT_EQ(3, fetched_size_);
+
+  // Later fetches get the sizes of the previous one right away, and refresh
+  // them in the background.
+  fetched_size_ = -1;
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  EXPECT_EQ(3, fetched_size_);
+
+  // The refreshed total is not reported again if it is unchanged.
+  fetched_size_ = -1;
+  mock_browsing_data_database_helper_->Notify();
+  EXPECT_EQ(-1, fetched_size_);
+
+  // Otherwise the caller gets the refreshed total.
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  EXPECT_EQ(3, fetched_size_);
+  mock_browsing_data_database_helper_->AddDatabaseSamples();
+  mock_browsing_data_database_helper_->Notify();
+  EXPECT_EQ(3 + 3, fetched_size_);
+
+  // Once invalidated, fetches wait for fresh sizes.
+  collector.Invalidate();
+  fetched_size_ = -1;
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  EXPECT_EQ(-1, fetched_size_);
+  mock_browsing_data_database_helper_->Notify();
+  EXPECT_EQ(3 + 3, fetched_size_);
+}
+
+TEST_F(SiteDataSizeCollectorTest, StorageDeletedUpdatesSnapshot) {
+  SiteDataSizeCollector collector(
+      profile_->GetPath(), nullptr, mock_browsing_data_database_helper_.get(),
+      nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  mock_browsing_data_database_helper_->AddDatabaseSamples();
+  mock_browsing_data_database_helper_->Notify();
+  EXPECT_EQ(1 + 2, fetched_size_);
+
+  // Deleting the data of an origin while a refresh is in progress updates the
+  // snapshot at once.
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  collector.OnStorageDeleted(
+      SiteDataSizeCollector::kDatabases,
+      url::Origin::Create(GURL("http://gdbhost1:1")));
+
+  // The origin is left out of the refreshed sizes, which may have been listed
+  // before the deletion.
+  mock_browsing_data_database_helper_->Notify();
+  EXPECT_EQ(2, fetched_size_);
+
+  fetched_size_ = -1;
+  collector.Fetch(base::BindRepeating(&SiteDataSizeCollectorTest::FetchCallback,
+                                      base::Unretained(this),
+                                      base::RepeatingClosure()));
+  EXPECT_EQ(2, fetched_size_);
+}
+
 }  // namespace
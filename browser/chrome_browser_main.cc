@@ -69,6 +69,7 @@
 #include "chrome/browser/metrics/chrome_feature_list_creator.h"
 #include "chrome/browser/metrics/chrome_metrics_service_accessor.h"
 #include "chrome/browser/metrics/expired_histograms_array.h"
+#include "chrome/browser/metrics/local_profile_dumper.h"
 #include "chrome/browser/metrics/renderer_uptime_tracker.h"
 #include "chrome/browser/metrics/thread_watcher.h"
 #include "chrome/browser/nacl_host/nacl_browser_delegate_impl.h"
@@ -744,6 +745,7 @@ void ChromeBrowserMainParts::PostMainMessageLoopStart() {
 #endif
 
   ThreadProfiler::SetMainThreadTaskRunner(base::ThreadTaskRunnerHandle::Get());
+  local_profile_dumper_ = LocalProfileDumper::CreateIfEnabled();
 
   // TODO(sebmarchand): Allow this to be created earlier if startup tracing is
   // enabled.
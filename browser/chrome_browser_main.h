@@ -26,6 +26,7 @@
 
 class BrowserProcessImpl;
 class ChromeBrowserMainExtraParts;
+class LocalProfileDumper;
 class StartupData;
 class PrefService;
 class Profile;
@@ -158,6 +159,9 @@ class ChromeBrowserMainParts : public content::BrowserMainParts {
   std::unique_ptr<tracing::TraceEventSystemStatsMonitor>
       trace_event_system_stats_monitor_;
 
+  // Writes the local stack profiles to a file, if enabled by switches.
+  std::unique_ptr<LocalProfileDumper> local_profile_dumper_;
+
   // Whether PerformPreMainMessageLoopStartup() is called on VariationsService.
   // Initialized to true if |MainFunctionParams::ui_task| is null (meaning not
   // running browser_tests), but may be forced to true for tests.
@@ -15,9 +15,10 @@
 #include "chrome/browser/media/webrtc/media_stream_capture_indicator.h"
 #include "chrome/browser/permissions/permission_decision_auto_blocker_factory.h"
 #include "chrome/browser/profiles/profile.h"
+#include "chrome/browser/profiles/renderer_updater.h"
+#include "chrome/browser/profiles/renderer_updater_factory.h"
 #include "chrome/common/chrome_switches.h"
 #include "chrome/common/pref_names.h"
-#include "chrome/common/renderer_configuration.mojom.h"
 #include "components/content_settings/browser/page_specific_content_settings.h"
 #include "components/permissions/permission_decision_auto_blocker.h"
 #include "components/permissions/permission_uma_util.h"
@@ -76,13 +77,12 @@ void PageSpecificContentSettingsDelegate::SetContentSettingRules(
     content::RenderProcessHost* process,
     const RendererContentSettingRules& rules) {
   // |channel| may be null in tests.
-  IPC::ChannelProxy* channel = process->GetChannel();
-  if (!channel)
+  if (!process->GetChannel())
     return;
 
-  mojo::AssociatedRemote<chrome::mojom::RendererConfiguration> rc_interface;
-  channel->GetRemoteAssociatedInterface(&rc_interface);
-  rc_interface->SetContentSettingRules(rules);
+  Profile* profile = Profile::FromBrowserContext(process->GetBrowserContext());
+  RendererUpdaterFactory::GetForProfile(profile->GetOriginalProfile())
+      ->SetContentSettingRules(process, rules);
 }
 
 PrefService* PageSpecificContentSettingsDelegate::GetPrefs() {
@@ -0,0 +1,237 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/content_settings/renderer_content_setting_rules_publisher.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/metrics/histogram_functions.h"
+#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
+#include "chrome/browser/profiles/profile.h"
+#include "components/content_settings/core/browser/content_settings_utils.h"
+#include "components/content_settings/core/common/content_settings.mojom.h"
+#include "content/public/browser/render_process_host.h"
+#include "ipc/ipc_channel_proxy.h"
+#include "mojo/public/cpp/bindings/associated_remote.h"
+
+namespace {
+
+using RulesList = std::vector<ContentSettingPatternSource>;
+
+bool RulesEqual(const ContentSettingPatternSource& a,
+                const ContentSettingPatternSource& b) {
+  return a.primary_pattern == b.primary_pattern &&
+         a.secondary_pattern == b.secondary_pattern &&
+         a.setting_value == b.setting_value && a.source == b.source &&
+         a.incognito == b.incognito;
+}
+
+const RulesList& GetRulesList(const RendererContentSettingRules& rules,
+                              chrome::mojom::ContentSettingRulesList list) {
+  switch (list) {
+    case chrome::mojom::ContentSettingRulesList::kImage:
+      return rules.image_rules;
+    case chrome::mojom::ContentSettingRulesList::kScript:
+      return rules.script_rules;
+    case chrome::mojom::ContentSettingRulesList::kMixedContent:
+      return rules.mixed_content_rules;
+  }
+}
+
+// Serializes the rules which are not sent as splices, by temporarily moving
+// the spliceable lists out of |rules|.
+std::vector<uint8_t> SerializeOtherRules(RendererContentSettingRules* rules) {
+  RulesList image_rules = std::move(rules->image_rules);
+  RulesList script_rules = std::move(rules->script_rules);
+  RulesList mixed_content_rules = std::move(rules->mixed_content_rules);
+  rules->image_rules.clear();
+  rules->script_rules.clear();
+  rules->mixed_content_rules.clear();
+  std::vector<uint8_t> data =
+      content_settings::mojom::RendererContentSettingRules::Serialize(rules);
+  rules->image_rules = std::move(image_rules);
+  rules->script_rules = std::move(script_rules);
+  rules->mixed_content_rules = std::move(mixed_content_rules);
+  return data;
+}
+
+}  // namespace
+
+// static
+constexpr size_t RendererContentSettingRulesPublisher::kMaxSplicedRules;
+
+RendererContentSettingRulesPublisher::RendererContentSettingRulesPublisher(
+    Profile* profile)
+    : profile_(profile),
+      host_content_settings_map_(
+          HostContentSettingsMapFactory::GetForProfile(profile)) {
+  observer_.Add(host_content_settings_map_);
+}
+
+RendererContentSettingRulesPublisher::~RendererContentSettingRulesPublisher() =
+    default;
+
+void RendererContentSettingRulesPublisher::InitializeRenderer(
+    chrome::mojom::RendererConfiguration* renderer_configuration) {
+  EnsureRules();
+  SendRules(renderer_configuration);
+}
+
+void RendererContentSettingRulesPublisher::PublishRules(
+    RendererContentSettingRules rules) {
+  // No renderer has rules yet, so the new rules are sent when the first one
+  // is initialized.
+  if (version_ == 0)
+    return;
+
+  std::vector<chrome::mojom::ContentSettingRulesSplicePtr> splices;
+  std::vector<uint8_t> other_rules_data = SerializeOtherRules(&rules);
+  const bool can_splice = other_rules_data == other_rules_data_ &&
+                          ComputeSplices(rules_, rules, &splices);
+  if (can_splice && splices.empty())
+    return;
+
+  const uint64_t base_version = version_++;
+  rules_ = std::move(rules);
+  other_rules_data_ = std::move(other_rules_data);
+  snapshot_ = base::ReadOnlySharedMemoryRegion();
+
+  const bool send_splices = can_splice && !sent_unversioned_rules_;
+  base::UmaHistogramBoolean("ContentSettings.RendererRules.SentAsSplices",
+                            send_splices);
+  bool sent_unversioned_rules = false;
+  for (content::RenderProcessHost::iterator it(
+           content::RenderProcessHost::AllHostsIterator());
+       !it.IsAtEnd(); it.Advance()) {
+    content::RenderProcessHost* host = it.GetCurrentValue();
+    if (host->GetBrowserContext() != profile_ || host->IsForGuestsOnly())
+      continue;
+    IPC::ChannelProxy* channel = host->GetChannel();
+    if (!channel)
+      continue;
+
+    mojo::AssociatedRemote<chrome::mojom::RendererConfiguration>
+        renderer_configuration;
+    channel->GetRemoteAssociatedInterface(&renderer_configuration);
+    if (!send_splices) {
+      sent_unversioned_rules |= !SendRules(renderer_configuration.get());
+      continue;
+    }
+
+    std::vector<chrome::mojom::ContentSettingRulesSplicePtr> renderer_splices;
+    renderer_splices.reserve(splices.size());
+    for (const auto& splice : splices)
+      renderer_splices.push_back(splice.Clone());
+    renderer_configuration->UpdateContentSettingRules(
+        base_version, version_, std::move(renderer_splices));
+  }
+  if (!send_splices)
+    sent_unversioned_rules_ = sent_unversioned_rules;
+}
+
+// static
+bool RendererContentSettingRulesPublisher::ComputeSplices(
+    const RendererContentSettingRules& from,
+    const RendererContentSettingRules& to,
+    std::vector<chrome::mojom::ContentSettingRulesSplicePtr>* splices) {
+  size_t spliced_rules = 0;
+  for (auto list : {chrome::mojom::ContentSettingRulesList::kImage,
+                    chrome::mojom::ContentSettingRulesList::kScript,
+                    chrome::mojom::ContentSettingRulesList::kMixedContent}) {
+    const RulesList& from_list = GetRulesList(from, list);
+    const RulesList& to_list = GetRulesList(to, list);
+
+    // Rules are sorted by precedence, so adding, removing or changing one
+    // rule leaves the rules before and after it in place.
+    const size_t max_common = std::min(from_list.size(), to_list.size());
+    size_t prefix = 0;
+    while (prefix < max_common &&
+           RulesEqual(from_list[prefix], to_list[prefix])) {
+      ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < max_common - prefix &&
+           RulesEqual(from_list[from_list.size() - 1 - suffix],
+                      to_list[to_list.size() - 1 - suffix])) {
+      ++suffix;
+    }
+
+    const size_t remove_count = from_list.size() - prefix - suffix;
+    const size_t insert_count = to_list.size() - prefix - suffix;
+    if (remove_count == 0 && insert_count == 0)
+      continue;
+    spliced_rules += std::max(remove_count, insert_count);
+    if (spliced_rules > kMaxSplicedRules)
+      return false;
+
+    splices->push_back(chrome::mojom::ContentSettingRulesSplice::New(
+        list, prefix, remove_count,
+        RulesList(to_list.begin() + prefix,
+                  to_list.begin() + prefix + insert_count)));
+  }
+  return true;
+}
+
+void RendererContentSettingRulesPublisher::OnContentSettingChanged(
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern,
+    ContentSettingsType content_type) {
+  if (content_type != ContentSettingsType::DEFAULT &&
+      content_type != ContentSettingsType::IMAGES &&
+      content_type != ContentSettingsType::JAVASCRIPT &&
+      content_type != ContentSettingsType::MIXEDSCRIPT &&
+      content_type != ContentSettingsType::POPUPS) {
+    return;
+  }
+  if (version_ == 0)
+    return;
+
+  RendererContentSettingRules rules;
+  content_settings::GetRendererContentSettingRules(host_content_settings_map_,
+                                                   &rules);
+  PublishRules(std::move(rules));
+}
+
+void RendererContentSettingRulesPublisher::EnsureRules() {
+  if (version_ != 0)
+    return;
+  content_settings::GetRendererContentSettingRules(host_content_settings_map_,
+                                                   &rules_);
+  other_rules_data_ = SerializeOtherRules(&rules_);
+  version_ = 1;
+}
+
+bool RendererContentSettingRulesPublisher::SendRules(
+    chrome::mojom::RendererConfiguration* renderer_configuration) {
+  const base::ReadOnlySharedMemoryRegion& snapshot = GetSnapshot();
+  if (!snapshot.IsValid()) {
+    renderer_configuration->SetContentSettingRules(rules_);
+    sent_unversioned_rules_ = true;
+    return false;
+  }
+  renderer_configuration->SetContentSettingRulesSnapshot(version_,
+                                                         snapshot.Duplicate());
+  return true;
+}
+
+const base::ReadOnlySharedMemoryRegion&
+RendererContentSettingRulesPublisher::GetSnapshot() {
+  if (snapshot_.IsValid())
+    return snapshot_;
+
+  std::vector<uint8_t> data =
+      content_settings::mojom::RendererContentSettingRules::Serialize(&rules_);
+  base::MappedReadOnlyRegion region =
+      base::ReadOnlySharedMemoryRegion::Create(data.size());
+  if (!region.IsValid())
+    return snapshot_;
+  memcpy(region.mapping.memory(), data.data(), data.size());
+  base::UmaHistogramCounts1M("ContentSettings.RendererRules.SnapshotSize",
+                             data.size());
+  snapshot_ = std::move(region.region);
+  return snapshot_;
+}
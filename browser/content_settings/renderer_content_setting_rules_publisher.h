@@ -0,0 +1,99 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_CONTENT_SETTINGS_RENDERER_CONTENT_SETTING_RULES_PUBLISHER_H_
+#define CHROME_BROWSER_CONTENT_SETTINGS_RENDERER_CONTENT_SETTING_RULES_PUBLISHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/memory/read_only_shared_memory_region.h"
+#include "base/scoped_observer.h"
+#include "chrome/common/renderer_configuration.mojom.h"
+#include "components/content_settings/core/browser/content_settings_observer.h"
+#include "components/content_settings/core/browser/host_content_settings_map.h"
+#include "components/content_settings/core/common/content_settings.h"
+
+class Profile;
+
+// Publishes the RendererContentSettingRules of one profile to the renderers
+// of that profile. Each version of the rules is serialized once, into a
+// read-only shared memory region which every renderer maps, and changes to
+// individual rules are sent as splices of the changed rule lists instead of
+// the whole set.
+class RendererContentSettingRulesPublisher : public content_settings::Observer {
+ public:
+  // The largest number of rules sent as splices for one change. Bigger
+  // changes publish a new snapshot.
+  static constexpr size_t kMaxSplicedRules = 64;
+
+  explicit RendererContentSettingRulesPublisher(Profile* profile);
+  RendererContentSettingRulesPublisher(
+      const RendererContentSettingRulesPublisher&) = delete;
+  RendererContentSettingRulesPublisher& operator=(
+      const RendererContentSettingRulesPublisher&) = delete;
+  ~RendererContentSettingRulesPublisher() override;
+
+  // Sends the current rules to a newly started renderer of the profile.
+  void InitializeRenderer(
+      chrome::mojom::RendererConfiguration* renderer_configuration);
+
+  // Makes |rules| the current rules of the profile, and sends what changed to
+  // all of its renderers. Does nothing if |rules| are the current rules.
+  void PublishRules(RendererContentSettingRules rules);
+
+  // Computes the splices which turn the image, script and mixed content rules
+  // of |from| into those of |to|. Returns false if more than
+  // |kMaxSplicedRules| rules changed.
+  static bool ComputeSplices(
+      const RendererContentSettingRules& from,
+      const RendererContentSettingRules& to,
+      std::vector<chrome::mojom::ContentSettingRulesSplicePtr>* splices);
+
+  uint64_t version() const { return version_; }
+
+ private:
+  // content_settings::Observer:
+  void OnContentSettingChanged(const ContentSettingsPattern& primary_pattern,
+                               const ContentSettingsPattern& secondary_pattern,
+                               ContentSettingsType content_type) override;
+
+  // Computes the initial rules the first time they are needed.
+  void EnsureRules();
+
+  // Sends the whole current rules to |renderer_configuration|. Returns false
+  // if they could not be sent as a shared snapshot.
+  bool SendRules(chrome::mojom::RendererConfiguration* renderer_configuration);
+
+  // Returns the snapshot of the current version, creating it if needed. The
+  // returned region is invalid if the shared memory could not be created.
+  const base::ReadOnlySharedMemoryRegion& GetSnapshot();
+
+  Profile* const profile_;
+  HostContentSettingsMap* const host_content_settings_map_;
+
+  // The current rules, and their version. Version 0 means the rules have not
+  // been computed yet.
+  RendererContentSettingRules rules_;
+  uint64_t version_ = 0;
+
+  // The serialized rules which can't be sent as splices, used to detect when
+  // they change.
+  std::vector<uint8_t> other_rules_data_;
+
+  // The serialized |rules_|, created lazily.
+  base::ReadOnlySharedMemoryRegion snapshot_;
+
+  // Whether some renderers were sent rules without a version, because the
+  // snapshot could not be created. Those renderers ignore splices, so the
+  // next change is sent to every renderer in full.
+  bool sent_unversioned_rules_ = false;
+
+  ScopedObserver<HostContentSettingsMap, content_settings::Observer> observer_{
+      this};
+};
+
+#endif  // CHROME_BROWSER_CONTENT_SETTINGS_RENDERER_CONTENT_SETTING_RULES_PUBLISHER_H_
@@ -0,0 +1,145 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/content_settings/renderer_content_setting_rules_publisher.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "components/content_settings/core/common/content_settings_pattern.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+using Splices = std::vector<chrome::mojom::ContentSettingRulesSplicePtr>;
+
+ContentSettingPatternSource CreateRule(const std::string& primary_pattern,
+                                       ContentSetting setting) {
+  return ContentSettingPatternSource(
+      ContentSettingsPattern::FromString(primary_pattern),
+      ContentSettingsPattern::Wildcard(), base::Value(setting), std::string(),
+      false);
+}
+
+std::vector<ContentSettingPatternSource> CreateRules(int count) {
+  std::vector<ContentSettingPatternSource> rules;
+  for (int i = 0; i < count; ++i) {
+    rules.push_back(CreateRule(base::StringPrintf("[*.]site%d.test", i),
+                               CONTENT_SETTING_BLOCK));
+  }
+  return rules;
+}
+
+// Applies |splices| the way the renderer does.
+void ApplySplices(Splices splices, RendererContentSettingRules* rules) {
+  for (auto& splice : splices) {
+    std::vector<ContentSettingPatternSource>* list = nullptr;
+    switch (splice->list) {
+      case chrome::mojom::ContentSettingRulesList::kImage:
+        list = &rules->image_rules;
+        break;
+      case chrome::mojom::ContentSettingRulesList::kScript:
+        list = &rules->script_rules;
+        break;
+      case chrome::mojom::ContentSettingRulesList::kMixedContent:
+        list = &rules->mixed_content_rules;
+        break;
+    }
+    ASSERT_LE(splice->start + splice->remove_count, list->size());
+    list->erase(list->begin() + splice->start,
+                list->begin() + splice->start + splice->remove_count);
+    list->insert(list->begin() + splice->start, splice->insert.begin(),
+                 splice->insert.end());
+  }
+}
+
+void ExpectSameRules(const std::vector<ContentSettingPatternSource>& expected,
+                     const std::vector<ContentSettingPatternSource>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].primary_pattern, actual[i].primary_pattern);
+    EXPECT_EQ(expected[i].GetContentSetting(), actual[i].GetContentSetting());
+  }
+}
+
+}  // namespace
+
+TEST(RendererContentSettingRulesPublisherTest, NoChange) {
+  RendererContentSettingRules rules;
+  rules.script_rules = CreateRules(10);
+  rules.image_rules = CreateRules(3);
+  Splices splices;
+  EXPECT_TRUE(RendererContentSettingRulesPublisher::ComputeSplices(
+      rules, rules, &splices));
+  EXPECT_TRUE(splices.empty());
+}
+
+TEST(RendererContentSettingRulesPublisherTest, SingleRuleChanges) {
+  RendererContentSettingRules from;
+  from.script_rules = CreateRules(1000);
+  from.mixed_content_rules = CreateRules(2);
+
+  // Added in the middle.
+  RendererContentSettingRules added = from;
+  added.script_rules.insert(
+      added.script_rules.begin() + 500,
+      CreateRule("https://new.test", CONTENT_SETTING_ALLOW));
+  // Removed at the front.
+  RendererContentSettingRules removed = from;
+  removed.script_rules.erase(removed.script_rules.begin());
+  // Changed at the end of another list.
+  RendererContentSettingRules changed = from;
+  changed.mixed_content_rules.back() =
+      CreateRule("[*.]site1.test", CONTENT_SETTING_ALLOW);
+
+  for (const RendererContentSettingRules* to : {&added, &removed, &changed}) {
+    Splices splices;
+    ASSERT_TRUE(RendererContentSettingRulesPublisher::ComputeSplices(
+        from, *to, &splices));
+    ASSERT_EQ(1u, splices.size());
+    EXPECT_LE(splices[0]->remove_count, 1u);
+    EXPECT_LE(splices[0]->insert.size(), 1u);
+
+    RendererContentSettingRules result = from;
+    ApplySplices(std::move(splices), &result);
+    ExpectSameRules(to->script_rules, result.script_rules);
+    ExpectSameRules(to->mixed_content_rules, result.mixed_content_rules);
+    ExpectSameRules(to->image_rules, result.image_rules);
+  }
+}
+
+TEST(RendererContentSettingRulesPublisherTest, ChangesInSeveralLists) {
+  RendererContentSettingRules from;
+  from.image_rules = CreateRules(5);
+  from.script_rules = CreateRules(5);
+
+  RendererContentSettingRules to;
+  to.image_rules = CreateRules(7);
+  to.script_rules = CreateRules(2);
+  to.mixed_content_rules = CreateRules(1);
+
+  Splices splices;
+  ASSERT_TRUE(
+      RendererContentSettingRulesPublisher::ComputeSplices(from, to, &splices));
+  EXPECT_EQ(3u, splices.size());
+
+  ApplySplices(std::move(splices), &from);
+  ExpectSameRules(to.image_rules, from.image_rules);
+  ExpectSameRules(to.script_rules, from.script_rules);
+  ExpectSameRules(to.mixed_content_rules, from.mixed_content_rules);
+}
+
+TEST(RendererContentSettingRulesPublisherTest, LargeChangesNeedSnapshot) {
+  RendererContentSettingRules from;
+  RendererContentSettingRules to;
+  to.script_rules = CreateRules(
+      RendererContentSettingRulesPublisher::kMaxSplicedRules + 1);
+
+  Splices splices;
+  EXPECT_FALSE(
+      RendererContentSettingRulesPublisher::ComputeSplices(from, to, &splices));
+}
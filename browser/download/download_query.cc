@@ -7,20 +7,26 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <array>
 #include <limits>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/check_op.h"
+#include "base/containers/contains.h"
 #include "base/files/file_path.h"
 #include "base/i18n/case_conversion.h"
 #include "base/i18n/string_search.h"
 #include "base/notreached.h"
+#include "base/strings/string_piece.h"
 #include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/supports_user_data.h"
 #include "base/time/time.h"
 #include "base/time/time_to_iso8601.h"
 #include "base/values.h"
@@ -189,6 +195,12 @@ DownloadQuery::FilterCallback BuildRegexFilter(
                              base::BindRepeating(accessor));
 }
 
+// Filter for FILTER_QUERY, which prepares the terms once for all the items.
+bool MatchesSearchTerms(const DownloadQuery::SearchTerms* query_terms,
+                        const DownloadItem& item) {
+  return DownloadQuery::MatchesQuery(*query_terms, item);
+}
+
 // Returns a ComparisonType to indicate whether a field in |left| is less than,
 // greater than or equal to the same field in |right|.
 template <typename ValueType>
@@ -204,45 +216,233 @@ ComparisonType Compare(
   return EQ;
 }
 
+// A Bloom filter of the trigrams of ASCII text. A term can only be found in
+// a text if all of its trigram bits are set in the text's filter.
+using TrigramBits = std::array<uint64_t, 4>;
+
+void AddTrigrams(base::StringPiece text, TrigramBits* bits) {
+  for (size_t i = 0; i + 3 <= text.size(); ++i) {
+    uint32_t hash = static_cast<uint8_t>(text[i]) << 16 |
+                    static_cast<uint8_t>(text[i + 1]) << 8 |
+                    static_cast<uint8_t>(text[i + 2]);
+    // The top 8 bits of a multiplicative hash pick one of the 256 bits.
+    hash = (hash * 2654435761u) >> 24;
+    (*bits)[hash / 64] |= uint64_t{1} << (hash % 64);
+  }
+}
+
+bool ContainsAllTrigrams(const TrigramBits& text_bits,
+                         const TrigramBits& term_bits) {
+  for (size_t i = 0; i < text_bits.size(); ++i) {
+    if ((text_bits[i] & term_bits[i]) != term_bits[i])
+      return false;
+  }
+  return true;
+}
+
+// Returns true if |text| is made of printable ASCII characters only. Matching
+// such text ignoring case and accents is an ASCII case-insensitive substring
+// search, which needs no collator.
+bool IsPrintableASCII(const std::u16string& text) {
+  return std::all_of(text.begin(), text.end(),
+                     [](char16_t c) { return c >= 0x20 && c < 0x7f; });
+}
+
+// The texts of a DownloadItem that query terms are searched in, cached on the
+// item along with the URLs and path they were computed from.
+class SearchKeys : public base::SupportsUserData::Data {
+ public:
+  // Returns the keys of |item|, computing them if they are not cached or if
+  // the URLs or target path of |item| changed since.
+  static const SearchKeys& Get(const DownloadItem& item);
+
+  explicit SearchKeys(const DownloadItem& item);
+  SearchKeys(const SearchKeys&) = delete;
+  SearchKeys& operator=(const SearchKeys&) = delete;
+  ~SearchKeys() override;
+
+  // Returns true if the keys were computed from the current URLs and target
+  // path of |item|. Comparing them is much cheaper than computing the keys,
+  // which formats the URLs.
+  bool IsUpToDate(const DownloadItem& item) const;
+
+  // Returns true if |term| is found in one of the keys.
+  bool Matches(const DownloadQuery::SearchTerms::Term& term) const;
+
+ private:
+  static const char kUserDataKey;
+
+  void AddKey(std::u16string key);
+
+  // The inputs of the keys.
+  const std::string original_url_spec_;
+  const std::string url_spec_;
+  const base::FilePath target_file_path_;
+
+  // The printable ASCII keys, in lowercase, separated by newlines, which can't
+  // be part of a term matched against them.
+  std::string ascii_keys_;
+  TrigramBits ascii_trigrams_ = {};
+
+  // The other keys, which are matched using ICU.
+  std::vector<std::u16string> other_keys_;
+};
+
 }  // anonymous namespace
 
+struct DownloadQuery::SearchTerms::Term {
+  explicit Term(const std::u16string& query_term)
+      : text(base::i18n::ToLower(query_term)),
+        is_ascii(!text.empty() && IsPrintableASCII(text)) {
+    if (!is_ascii)
+      return;
+    ascii_text = base::UTF16ToASCII(text);
+    AddTrigrams(ascii_text, &trigrams);
+  }
+
+  // The term, in lowercase.
+  std::u16string text;
+  bool is_ascii;
+  std::string ascii_text;
+  TrigramBits trigrams = {};
+};
+
+namespace {
+
 // static
-bool DownloadQuery::MatchesQuery(const std::vector<std::u16string>& query_terms,
-                                 const DownloadItem& item) {
-  if (query_terms.empty())
-    return true;
+const char SearchKeys::kUserDataKey = 0;
 
-  std::u16string original_url_raw(
-      base::UTF8ToUTF16(item.GetOriginalUrl().spec()));
-  std::u16string url_raw(base::UTF8ToUTF16(item.GetURL().spec()));
+// static
+const SearchKeys& SearchKeys::Get(const DownloadItem& item) {
+  auto* keys = static_cast<SearchKeys*>(item.GetUserData(&kUserDataKey));
+  if (keys && keys->IsUpToDate(item))
+    return *keys;
+
+  auto new_keys = std::make_unique<SearchKeys>(item);
+  keys = new_keys.get();
+  const_cast<DownloadItem&>(item).SetUserData(&kUserDataKey,
+                                              std::move(new_keys));
+  return *keys;
+}
+
+SearchKeys::SearchKeys(const DownloadItem& item)
+    : original_url_spec_(item.GetOriginalUrl().spec()),
+      url_spec_(item.GetURL().spec()),
+      target_file_path_(item.GetTargetFilePath()) {
+  AddKey(base::UTF8ToUTF16(original_url_spec_));
+  AddKey(base::UTF8ToUTF16(url_spec_));
   // Try to also match query with above URLs formatted in user display friendly
   // way. This will unescape characters (including spaces) and trim all extra
   // data (like username and password) from raw url so that for example raw url
   // "http://some.server.org/example%20download/file.zip" will be matched with
   // search term "example download".
-  std::u16string original_url_formatted(
-      url_formatter::FormatUrl(item.GetOriginalUrl()));
-  std::u16string url_formatted(url_formatter::FormatUrl(item.GetURL()));
-  std::u16string path(item.GetTargetFilePath().LossyDisplayName());
-
-  for (auto it = query_terms.begin(); it != query_terms.end(); ++it) {
-    std::u16string term = base::i18n::ToLower(*it);
-    if (!base::i18n::StringSearchIgnoringCaseAndAccents(
-            term, original_url_raw, NULL, NULL) &&
-        !base::i18n::StringSearchIgnoringCaseAndAccents(
-            term, original_url_formatted, NULL, NULL) &&
-        !base::i18n::StringSearchIgnoringCaseAndAccents(
-            term, url_raw, NULL, NULL) &&
-        !base::i18n::StringSearchIgnoringCaseAndAccents(
-            term, url_formatted, NULL, NULL) &&
-        !base::i18n::StringSearchIgnoringCaseAndAccents(
-            term, path, NULL, NULL)) {
-      return false;
+  AddKey(url_formatter::FormatUrl(item.GetOriginalUrl()));
+  AddKey(url_formatter::FormatUrl(item.GetURL()));
+  AddKey(target_file_path_.LossyDisplayName());
+  AddTrigrams(ascii_keys_, &ascii_trigrams_);
+}
+
+SearchKeys::~SearchKeys() = default;
+
+bool SearchKeys::IsUpToDate(const DownloadItem& item) const {
+  return item.GetTargetFilePath() == target_file_path_ &&
+         item.GetURL().spec() == url_spec_ &&
+         item.GetOriginalUrl().spec() == original_url_spec_;
+}
+
+void SearchKeys::AddKey(std::u16string key) {
+  if (!IsPrintableASCII(key)) {
+    if (!base::Contains(other_keys_, key))
+      other_keys_.push_back(std::move(key));
+    return;
+  }
+
+  std::string ascii_key = base::ToLowerASCII(base::UTF16ToASCII(key));
+  // The URL is usually the original URL, and formatting often leaves it as
+  // is, so many keys are repeated.
+  for (base::StringPiece existing_key :
+       base::SplitStringPiece(ascii_keys_, "\n", base::KEEP_WHITESPACE,
+                              base::SPLIT_WANT_ALL)) {
+    if (existing_key == ascii_key)
+      return;
+  }
+  if (!ascii_keys_.empty())
+    ascii_keys_.push_back('\n');
+  ascii_keys_.append(ascii_key);
+}
+
+bool SearchKeys::Matches(const DownloadQuery::SearchTerms::Term& term) const {
+  std::unique_ptr<base::i18n::FixedPatternStringSearchIgnoringCaseAndAccents>
+      searcher;
+  if (term.is_ascii) {
+    // An ASCII term can only be found in non-ASCII keys through ICU's
+    // equivalences, e.g. "a" in "\u00e1", so the trigram filter only rules
+    // out items without such keys.
+    if (ContainsAllTrigrams(ascii_trigrams_, term.trigrams) &&
+        ascii_keys_.find(term.ascii_text) != std::string::npos) {
+      return true;
+    }
+  } else if (!ascii_keys_.empty()) {
+    // Case doesn't matter to the search, so the lowercase keys can be used.
+    searcher = std::make_unique<
+        base::i18n::FixedPatternStringSearchIgnoringCaseAndAccents>(term.text);
+    for (base::StringPiece key :
+         base::SplitStringPiece(ascii_keys_, "\n", base::KEEP_WHITESPACE,
+                                base::SPLIT_WANT_ALL)) {
+      if (searcher->Search(base::ASCIIToUTF16(key), nullptr, nullptr))
+        return true;
     }
   }
+
+  for (const std::u16string& key : other_keys_) {
+    if (!searcher) {
+      searcher = std::make_unique<
+          base::i18n::FixedPatternStringSearchIgnoringCaseAndAccents>(
+          term.text);
+    }
+    if (searcher->Search(key, nullptr, nullptr))
+      return true;
+  }
+  return false;
+}
+
+}  // anonymous namespace
+
+DownloadQuery::SearchTerms::SearchTerms(
+    const std::vector<std::u16string>& query_terms) {
+  terms_.reserve(query_terms.size());
+  for (const std::u16string& query_term : query_terms)
+    terms_.emplace_back(query_term);
+}
+
+DownloadQuery::SearchTerms::~SearchTerms() = default;
+
+bool DownloadQuery::SearchTerms::empty() const {
+  return terms_.empty();
+}
+
+// static
+bool DownloadQuery::MatchesQuery(const SearchTerms& query_terms,
+                                 const DownloadItem& item) {
+  if (query_terms.empty())
+    return true;
+
+  const SearchKeys& keys = SearchKeys::Get(item);
+  for (const SearchTerms::Term& term : query_terms.terms_) {
+    if (!keys.Matches(term))
+      return false;
+  }
   return true;
 }
 
+// static
+bool DownloadQuery::MatchesQuery(const std::vector<std::u16string>& query_terms,
+                                 const DownloadItem& item) {
+  if (query_terms.empty())
+    return true;
+  return MatchesQuery(SearchTerms(query_terms), item);
+}
+
 DownloadQuery::DownloadQuery() : limit_(std::numeric_limits<uint32_t>::max()) {}
 DownloadQuery::~DownloadQuery() {}
 
@@ -286,9 +486,13 @@ bool DownloadQuery::AddFilter(DownloadQuery::FilterType type,
       return AddFilter(BuildFilter<bool>(value, EQ, &IsPaused));
     case FILTER_QUERY: {
       std::vector<std::u16string> query_terms;
-      return GetAs(value, &query_terms) &&
-             (query_terms.empty() ||
-              AddFilter(base::BindRepeating(&MatchesQuery, query_terms)));
+      if (!GetAs(value, &query_terms))
+        return false;
+      if (query_terms.empty())
+        return true;
+      return AddFilter(base::BindRepeating(
+          &MatchesSearchTerms,
+          base::Owned(std::make_unique<SearchTerms>(query_terms))));
     }
     case FILTER_ENDED_AFTER:
       return AddFilter(BuildFilter<std::string>(value, GT, &GetEndTime));
@@ -439,11 +643,14 @@ void DownloadQuery::AddSorter(DownloadQuery::SortType type,
 }
 
 void DownloadQuery::FinishSearch(DownloadQuery::DownloadVector* results) const {
- if (!sorters_.empty()) {
-    std::partial_sort(results->begin(),
-                      results->begin() + std::min(limit_, results->size()),
-                      results->end(),
-                      DownloadComparator(sorters_));
+  if (!sorters_.empty()) {
+    // Only the first |limit_| results need to be in order.
+    if (limit_ < results->size()) {
+      std::partial_sort(results->begin(), results->begin() + limit_,
+                        results->end(), DownloadComparator(sorters_));
+    } else {
+      std::sort(results->begin(), results->end(), DownloadComparator(sorters_));
+    }
   }
 
   if (results->size() > limit_)
@@ -96,6 +96,30 @@ class DownloadQuery {
     DESCENDING,
   };
 
+  // Query terms prepared once for matching them against many items.
+  class SearchTerms {
+   public:
+    explicit SearchTerms(const std::vector<std::u16string>& query_terms);
+    SearchTerms(const SearchTerms&) = delete;
+    SearchTerms& operator=(const SearchTerms&) = delete;
+    ~SearchTerms();
+
+    bool empty() const;
+
+    // A term prepared for matching. Defined in the .cc file.
+    struct Term;
+
+   private:
+    friend class DownloadQuery;
+
+    std::vector<Term> terms_;
+  };
+
+  // Returns true if each of |query_terms| is found, ignoring case and accents,
+  // in the original URL, the URL or the target file name of |item|. The search
+  // keys of |item| are cached on it until it is updated.
+  static bool MatchesQuery(const SearchTerms& query_terms,
+                           const download::DownloadItem& item);
   static bool MatchesQuery(const std::vector<std::u16string>& query_terms,
                            const download::DownloadItem& item);
 
@@ -138,6 +162,9 @@ class DownloadQuery {
     results->clear();
     for (; iter != last; ++iter) {
       if (Matches(**iter)) results->push_back(*iter);
+      // Without sorters, the first matching items are the results.
+      if (sorters_.empty() && results->size() >= limit_)
+        break;
     }
     FinishSearch(results);
   }
@@ -10,11 +10,17 @@
 #include <limits>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/check.h"
 #include "base/files/file_path.h"
+#include "base/i18n/case_conversion.h"
+#include "base/i18n/string_search.h"
 #include "base/macros.h"
+#include "base/stl_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversions.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "build/build_config.h"
@@ -50,6 +56,10 @@ bool AlwaysReturn(bool result, const DownloadItem& item) {
   return result;
 }
 
+bool MatchesTerm(const std::u16string& term, const DownloadItem& item) {
+  return DownloadQuery::MatchesQuery(std::vector<std::u16string>{term}, item);
+}
+
 }  // anonymous namespace
 
 class DownloadQueryTest : public testing::Test {
@@ -306,6 +316,104 @@ TEST_F(DownloadQueryTest, DownloadQueryTest_FilterGenericQueryFilenameI18N) {
   ExpectStandardFilterResults();
 }
 
+TEST_F(DownloadQueryTest, DownloadQueryTest_FilterGenericQueryAccents) {
+  CreateMocks(2);
+  base::FilePath match_filename =
+      base::FilePath::FromUTF8Unsafe("/Caf\xc3\xa9 Menu.pdf");
+  EXPECT_CALL(mock(0), GetTargetFilePath())
+      .WillRepeatedly(ReturnRef(match_filename));
+  base::FilePath fail_filename(FILE_PATH_LITERAL("fail"));
+  EXPECT_CALL(mock(1), GetTargetFilePath())
+      .WillRepeatedly(ReturnRef(fail_filename));
+  GURL fail_url("http://example.com/fail");
+  EXPECT_CALL(mock(0), GetOriginalUrl()).WillRepeatedly(ReturnRef(fail_url));
+  EXPECT_CALL(mock(1), GetOriginalUrl()).WillRepeatedly(ReturnRef(fail_url));
+  EXPECT_CALL(mock(0), GetURL()).WillRepeatedly(ReturnRef(fail_url));
+  EXPECT_CALL(mock(1), GetURL()).WillRepeatedly(ReturnRef(fail_url));
+  std::vector<std::string> query_terms;
+  query_terms.push_back("CAFE");
+  query_terms.push_back("menu");
+  AddFilter(DownloadQuery::FILTER_QUERY, query_terms);
+  ExpectStandardFilterResults();
+}
+
+// Checks that printable ASCII terms, which are matched without ICU, match the
+// same items as they would through ICU.
+TEST_F(DownloadQueryTest, DownloadQueryTest_FilterGenericQueryMatchesICU) {
+  const char* const kFilenames[] = {
+      "Report-2021_Final.PDF", "a~b{c}|d.txt", "  spaced  out .zip",
+      "r\xc3\xa9sum\xc3\xa9.docx", "Stra\xc3\x9f" "e.png"};
+  const char* const kTerms[] = {"report", "2021_f", "final.pdf", "~B{",
+                                "|d.", "  out", "resume", "strasse",
+                                "e.p", "q", "-2", "x"};
+  CreateMocks(base::size(kFilenames));
+  std::vector<base::FilePath> filenames;
+  for (const char* filename : kFilenames)
+    filenames.push_back(base::FilePath::FromUTF8Unsafe(filename));
+  GURL url("http://example.com/download");
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    EXPECT_CALL(mock(i), GetTargetFilePath())
+        .WillRepeatedly(ReturnRef(filenames[i]));
+    EXPECT_CALL(mock(i), GetOriginalUrl()).WillRepeatedly(ReturnRef(url));
+    EXPECT_CALL(mock(i), GetURL()).WillRepeatedly(ReturnRef(url));
+  }
+
+  for (const char* term : kTerms) {
+    const std::u16string term16 = base::UTF8ToUTF16(term);
+    for (size_t i = 0; i < filenames.size(); ++i) {
+      SCOPED_TRACE(std::string(term) + " in " + kFilenames[i]);
+      const bool expected =
+          base::i18n::StringSearchIgnoringCaseAndAccents(
+              base::i18n::ToLower(term16), filenames[i].LossyDisplayName(),
+              nullptr, nullptr) ||
+          base::i18n::StringSearchIgnoringCaseAndAccents(
+              base::i18n::ToLower(term16), base::UTF8ToUTF16(url.spec()),
+              nullptr, nullptr);
+      EXPECT_EQ(expected, MatchesTerm(term16, mock(i)));
+    }
+  }
+}
+
+TEST_F(DownloadQueryTest, DownloadQueryTest_FilterGenericQueryUpdatedItem) {
+  CreateMocks(1);
+  base::FilePath filename(FILE_PATH_LITERAL("before"));
+  EXPECT_CALL(mock(0), GetTargetFilePath())
+      .WillRepeatedly(ReturnRef(filename));
+  GURL url("http://example.com/download");
+  EXPECT_CALL(mock(0), GetOriginalUrl()).WillRepeatedly(ReturnRef(url));
+  EXPECT_CALL(mock(0), GetURL()).WillRepeatedly(ReturnRef(url));
+  EXPECT_TRUE(MatchesTerm(u"before", mock(0)));
+  EXPECT_FALSE(MatchesTerm(u"after", mock(0)));
+
+  // The cached search keys are recomputed once the target path changes, even
+  // before observers of the item are notified.
+  base::FilePath new_filename(FILE_PATH_LITERAL("after"));
+  EXPECT_CALL(mock(0), GetTargetFilePath())
+      .WillRepeatedly(ReturnRef(new_filename));
+  EXPECT_FALSE(MatchesTerm(u"before", mock(0)));
+  EXPECT_TRUE(MatchesTerm(u"after", mock(0)));
+
+  // So are they when the URL changes, e.g. on a redirect.
+  GURL new_url("http://example.com/redirected");
+  EXPECT_CALL(mock(0), GetURL()).WillRepeatedly(ReturnRef(new_url));
+  EXPECT_TRUE(MatchesTerm(u"redirected", mock(0)));
+}
+
+TEST_F(DownloadQueryTest, DownloadQueryTest_LimitSorted) {
+  CreateMocks(5);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_CALL(mock(i), GetReceivedBytes())
+        .WillRepeatedly(Return((i * 3) % 5));
+  }
+  query()->AddSorter(DownloadQuery::SORT_BYTES_RECEIVED,
+                     DownloadQuery::DESCENDING);
+  query()->Limit(2);
+  Search();
+  ASSERT_EQ(2U, results()->size());
+  EXPECT_EQ(3U, results()->at(0)->GetId());
+  EXPECT_EQ(1U, results()->at(1)->GetId());
+}
+
 TEST_F(DownloadQueryTest, DownloadQueryTest_FilterFilenameRegex) {
   CreateMocks(2);
   base::FilePath match_filename(FILE_PATH_LITERAL("query"));
@@ -766,3 +874,39 @@ TEST_F(DownloadQueryTest, DownloadQueryFilterPerformance) {
   std::cout << "Search took " << nanos_per_item_per_filter
             << " nanoseconds per item per filter.\n";
 }
+
+TEST_F(DownloadQueryTest, DownloadQueryQueryPerformance) {
+  static const int kNumItems = 10000;
+  CreateMocks(kNumItems);
+  std::vector<base::FilePath> filenames;
+  std::vector<GURL> urls;
+  filenames.reserve(kNumItems);
+  urls.reserve(kNumItems);
+  for (int i = 0; i < kNumItems; ++i) {
+    filenames.push_back(base::FilePath::FromUTF8Unsafe(
+        base::StringPrintf("/downloads/file%d.zip", i)));
+    urls.push_back(GURL(base::StringPrintf(
+        "https://cdn%d.example.com/releases/%d/file%d.zip", i % 50, i, i)));
+    EXPECT_CALL(mock(i), GetTargetFilePath())
+        .WillRepeatedly(ReturnRef(filenames.back()));
+    EXPECT_CALL(mock(i), GetOriginalUrl())
+        .WillRepeatedly(ReturnRef(urls.back()));
+    EXPECT_CALL(mock(i), GetURL()).WillRepeatedly(ReturnRef(urls.back()));
+  }
+  std::vector<std::string> query_terms;
+  query_terms.push_back("file9999.zip");
+  AddFilter(DownloadQuery::FILTER_QUERY, query_terms);
+
+  // The first search computes the search keys of the items, the second one
+  // uses the cached ones.
+  base::Time start = base::Time::Now();
+  Search();
+  base::Time middle = base::Time::Now();
+  Search();
+  base::Time end = base::Time::Now();
+  ASSERT_EQ(1U, results()->size());
+  EXPECT_EQ(9999U, results()->at(0)->GetId());
+  std::cout << "First query took " << (middle - start).InMillisecondsF()
+            << " ms, cached query took " << (end - middle).InMillisecondsF()
+            << " ms for " << kNumItems << " items.\n";
+}
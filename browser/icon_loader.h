@@ -57,6 +57,18 @@ class IconLoader {
   // IconLoader will delete itself.
   void Start();
 
+  // Given a file path, get the group for the given file. This may block, so it
+  // must be called on a sequence that allows blocking, with traits().
+  static IconGroup GroupForFilepath(const base::FilePath& file_path);
+
+  // The traits of the tasks posted to base::ThreadPool by this class. These
+  // operations may block, because they are fetching icons from the disk, yet
+  // the result will be seen by the user so they should be prioritized
+  // accordingly.
+  static constexpr base::TaskTraits traits() {
+    return {base::MayBlock(), base::TaskPriority::USER_VISIBLE};
+  }
+
  private:
   IconLoader(const base::FilePath& file_path,
              IconSize size,
@@ -64,9 +76,6 @@ class IconLoader {
 
   ~IconLoader();
 
-  // Given a file path, get the group for the given file.
-  static IconGroup GroupForFilepath(const base::FilePath& file_path);
-
   // The TaskRunner that ReadIcon() must be called on.
   static scoped_refptr<base::TaskRunner> GetReadIconTaskRunner();
 
@@ -78,14 +87,6 @@ class IconLoader {
   void ReadIconInSandbox();
 #endif
 
-  // The traits of the tasks posted to base::ThreadPool by this class. These
-  // operations may block, because they are fetching icons from the disk, yet
-  // the result will be seen by the user so they should be prioritized
-  // accordingly.
-  static constexpr base::TaskTraits traits() {
-    return {base::MayBlock(), base::TaskPriority::USER_VISIBLE};
-  }
-
   // The task runner object of the thread in which we notify the delegate.
   scoped_refptr<base::SingleThreadTaskRunner> target_task_runner_;
 
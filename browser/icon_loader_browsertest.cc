@@ -2,12 +2,18 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <map>
+
+#include "base/barrier_closure.h"
 #include "base/files/file_path.h"
 #include "base/macros.h"
 #include "base/path_service.h"
 #include "base/run_loop.h"
+#include "base/stl_util.h"
+#include "base/task/cancelable_task_tracker.h"
 #include "build/build_config.h"
 #include "chrome/browser/icon_loader.h"
+#include "chrome/browser/icon_manager.h"
 #include "chrome/test/base/in_process_browser_test.h"
 #include "content/public/test/browser_test.h"
 #include "mojo/public/cpp/bindings/remote.h"
@@ -74,6 +80,76 @@ IN_PROC_BROWSER_TEST_F(IconLoaderBrowserTest, LoadGroup) {
   runner.Run();
   EXPECT_TRUE(test_loader.load_succeeded());
 }
+
+// Files of the same type share one icon load, and the icons end up in the
+// cache.
+IN_PROC_BROWSER_TEST_F(IconLoaderBrowserTest, IconManagerLoadIcons) {
+  const base::FilePath visible_path(FILE_PATH_LITERAL("unlikely-1.txt"));
+  const base::FilePath offscreen_path_1(FILE_PATH_LITERAL("unlikely-2.txt"));
+  const base::FilePath offscreen_path_2(FILE_PATH_LITERAL("unlikely-3.txt"));
+
+  IconManager icon_manager;
+  base::CancelableTaskTracker tracker;
+  base::RunLoop runner;
+  std::map<base::FilePath, gfx::Image> icons;
+  auto done = base::BarrierClosure(3, runner.QuitClosure());
+  icon_manager.LoadIcons(
+      {visible_path}, {offscreen_path_1, offscreen_path_2}, IconLoader::NORMAL,
+      base::BindRepeating(
+          [](std::map<base::FilePath, gfx::Image>* icons,
+             base::RepeatingClosure done, const base::FilePath& file_path,
+             gfx::Image image) {
+            (*icons)[file_path] = std::move(image);
+            done.Run();
+          },
+          &icons, done),
+      &tracker);
+  runner.Run();
+
+  ASSERT_EQ(3u, icons.size());
+  EXPECT_EQ(1u, icon_manager.load_count());
+  EXPECT_FALSE(icons[visible_path].IsEmpty());
+  EXPECT_FALSE(icons[offscreen_path_1].IsEmpty());
+  EXPECT_FALSE(icons[offscreen_path_2].IsEmpty());
+
+  const size_t hit_count = icon_manager.hit_count();
+  EXPECT_TRUE(icon_manager.LookupIconFromFilepath(offscreen_path_2,
+                                                  IconLoader::NORMAL));
+  EXPECT_EQ(hit_count + 1, icon_manager.hit_count());
+  EXPECT_FALSE(
+      icon_manager.LookupIconFromFilepath(visible_path, IconLoader::SMALL));
+}
+
+// Requests for the same icon group from separate LoadIcons() calls, like the
+// ones of FileIconSource, share a single icon load.
+IN_PROC_BROWSER_TEST_F(IconLoaderBrowserTest, IconManagerMergesLoadIcons) {
+  const base::FilePath file_paths[] = {
+      base::FilePath(FILE_PATH_LITERAL("unlikely-1.txt")),
+      base::FilePath(FILE_PATH_LITERAL("unlikely-2.txt")),
+      base::FilePath(FILE_PATH_LITERAL("unlikely-3.txt")),
+  };
+
+  IconManager icon_manager;
+  base::CancelableTaskTracker tracker;
+  base::RunLoop runner;
+  auto done =
+      base::BarrierClosure(base::size(file_paths), runner.QuitClosure());
+  for (const base::FilePath& file_path : file_paths) {
+    icon_manager.LoadIcons(
+        {file_path}, {}, IconLoader::NORMAL,
+        base::BindRepeating(
+            [](base::RepeatingClosure done, const base::FilePath& file_path,
+               gfx::Image image) {
+              EXPECT_FALSE(image.IsEmpty());
+              done.Run();
+            },
+            done),
+        &tracker);
+  }
+  runner.Run();
+
+  EXPECT_EQ(1u, icon_manager.load_count());
+}
 #endif  // !((defined(OS_LINUX) || defined(OS_CHROMEOS)) &&
         // defined(MEMORY_SANITIZER))
 
@@ -6,9 +6,14 @@
 
 #include <memory>
 #include <tuple>
+#include <utility>
 
 #include "base/bind.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/stl_util.h"
+#include "base/task/thread_pool.h"
 #include "base/task_runner.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkCanvas.h"
 
@@ -23,25 +28,48 @@ void RunCallbackIfNotCanceled(
   std::move(callback).Run(std::move(image));
 }
 
+void RunIconsCallbackIfNotCanceled(
+    const base::CancelableTaskTracker::IsCanceledCallback& is_canceled,
+    const IconManager::IconsRequestCallback& callback,
+    const base::FilePath& file_path,
+    gfx::Image image) {
+  if (is_canceled.Run())
+    return;
+  callback.Run(file_path, std::move(image));
+}
+
+std::vector<IconLoader::IconGroup> ReadGroupsBlocking(
+    const std::vector<base::FilePath>& file_paths) {
+  std::vector<IconLoader::IconGroup> groups;
+  groups.reserve(file_paths.size());
+  for (const base::FilePath& file_path : file_paths)
+    groups.push_back(IconLoader::GroupForFilepath(file_path));
+  return groups;
+}
+
 }  // namespace
 
-IconManager::IconManager() {}
+constexpr size_t IconManager::kMaxCachedIcons;
+constexpr size_t IconManager::kMaxCachedGroups;
+constexpr size_t IconManager::kMaxConcurrentIconLoads;
+constexpr char IconManager::kHistogramCacheHit[];
+
+IconManager::IconManager()
+    : group_cache_(kMaxCachedGroups), icon_cache_(kMaxCachedIcons) {}
 
 IconManager::~IconManager() {
 }
 
 gfx::Image* IconManager::LookupIconFromFilepath(const base::FilePath& file_path,
                                                 IconLoader::IconSize size) {
-  auto group_it = group_cache_.find(file_path);
-  if (group_it == group_cache_.end())
-    return nullptr;
-
-  CacheKey key(group_it->second, size);
-  auto icon_it = icon_cache_.find(key);
-  if (icon_it == icon_cache_.end())
+  auto group_it = group_cache_.Get(file_path);
+  if (group_it == group_cache_.end()) {
+    ++miss_count_;
+    base::UmaHistogramBoolean(kHistogramCacheHit, false);
     return nullptr;
+  }
 
-  return &icon_it->second;
+  return GetCachedIcon(CacheKey(group_it->second, size));
 }
 
 base::CancelableTaskTracker::TaskId IconManager::LoadIcon(
@@ -55,6 +83,7 @@ base::CancelableTaskTracker::TaskId IconManager::LoadIcon(
   IconRequestCallback callback_runner = base::BindOnce(
       &RunCallbackIfNotCanceled, is_canceled, std::move(callback));
 
+  ++load_count_;
   IconLoader* loader = IconLoader::Create(
       file_path, size,
       base::BindOnce(&IconManager::OnIconLoaded, weak_factory_.GetWeakPtr(),
@@ -72,14 +101,177 @@ void IconManager::OnIconLoaded(IconRequestCallback callback,
   // Cache the bitmap. Watch out: |result| may be null, which indicates a
   // failure. We assume that if we have an entry in |icon_cache_| it must not be
   // null.
-  CacheKey key(group, size);
   std::move(callback).Run(result);
-  if (!result.IsEmpty())
-    icon_cache_[key] = std::move(result);
-  else
-    icon_cache_.erase(key);
+  CacheIcon(CacheKey(group, size), std::move(result));
+  CacheGroup(file_path, group);
+}
+
+base::CancelableTaskTracker::TaskId IconManager::LoadIcons(
+    std::vector<base::FilePath> visible_file_paths,
+    std::vector<base::FilePath> offscreen_file_paths,
+    IconLoader::IconSize size,
+    IconsRequestCallback callback,
+    base::CancelableTaskTracker* tracker) {
+  base::CancelableTaskTracker::IsCanceledCallback is_canceled;
+  base::CancelableTaskTracker::TaskId id =
+      tracker->NewTrackedTaskId(&is_canceled);
+
+  // Files whose group is unknown have their groups read in a single task.
+  std::vector<IconWaiter> unknown_group_waiters;
+  std::vector<base::FilePath> unknown_group_file_paths;
+  auto add_waiters = [&](std::vector<base::FilePath> file_paths, bool visible) {
+    for (base::FilePath& file_path : file_paths) {
+      IconWaiter waiter(std::move(file_path), callback, is_canceled);
+      waiter.visible = visible;
+      auto group_it = group_cache_.Get(waiter.file_path);
+      if (group_it != group_cache_.end()) {
+        const IconLoader::IconGroup group = group_it->second;
+        AddIconWaiter(std::move(waiter), group, size);
+      } else {
+        unknown_group_file_paths.push_back(waiter.file_path);
+        unknown_group_waiters.push_back(std::move(waiter));
+      }
+    }
+  };
+  add_waiters(std::move(visible_file_paths), /*visible=*/true);
+  add_waiters(std::move(offscreen_file_paths), /*visible=*/false);
+
+  if (!unknown_group_waiters.empty()) {
+    base::ThreadPool::PostTaskAndReplyWithResult(
+        FROM_HERE, IconLoader::traits(),
+        base::BindOnce(&ReadGroupsBlocking,
+                       std::move(unknown_group_file_paths)),
+        base::BindOnce(&IconManager::OnGroupsRead, weak_factory_.GetWeakPtr(),
+                       size, std::move(unknown_group_waiters)));
+  }
+
+  StartQueuedGroupLoads();
+  return id;
+}
+
+gfx::Image* IconManager::GetCachedIcon(const CacheKey& key) {
+  auto icon_it = icon_cache_.Get(key);
+  const bool hit = icon_it != icon_cache_.end();
+  base::UmaHistogramBoolean(kHistogramCacheHit, hit);
+  if (!hit) {
+    ++miss_count_;
+    return nullptr;
+  }
+  ++hit_count_;
+  return &icon_it->second;
+}
+
+void IconManager::CacheIcon(const CacheKey& key, gfx::Image image) {
+  // We assume that if we have an entry in |icon_cache_| it must not be null.
+  if (!image.IsEmpty()) {
+    icon_cache_.Put(key, std::move(image));
+    return;
+  }
+  auto icon_it = icon_cache_.Peek(key);
+  if (icon_it != icon_cache_.end())
+    icon_cache_.Erase(icon_it);
+}
 
-  group_cache_[file_path] = group;
+void IconManager::CacheGroup(const base::FilePath& file_path,
+                             const IconLoader::IconGroup& group) {
+  group_cache_.Put(file_path, group);
+}
+
+void IconManager::OnGroupsRead(IconLoader::IconSize size,
+                               std::vector<IconWaiter> waiters,
+                               std::vector<IconLoader::IconGroup> groups) {
+  DCHECK_EQ(waiters.size(), groups.size());
+  for (size_t i = 0; i < waiters.size(); ++i) {
+    CacheGroup(waiters[i].file_path, groups[i]);
+    AddIconWaiter(std::move(waiters[i]), groups[i], size);
+  }
+  StartQueuedGroupLoads();
+}
+
+void IconManager::AddIconWaiter(IconWaiter waiter,
+                                const IconLoader::IconGroup& group,
+                                IconLoader::IconSize size) {
+  CacheKey key(group, size);
+  if (gfx::Image* image = GetCachedIcon(key)) {
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&RunIconsCallbackIfNotCanceled, waiter.is_canceled,
+                       waiter.callback, waiter.file_path, *image));
+    return;
+  }
+
+  GroupLoad& load = group_loads_[key];
+  if (load.file_path.empty())
+    load.file_path = waiter.file_path;
+  if (!load.started) {
+    // A group wanted by a visible item moves ahead of offscreen ones, even if
+    // it was first requested offscreen.
+    if (waiter.visible && !load.queued_visible) {
+      load.queued_visible = true;
+      visible_load_queue_.push_back(key);
+    } else if (!waiter.visible && !load.queued_visible &&
+               !load.queued_offscreen) {
+      load.queued_offscreen = true;
+      offscreen_load_queue_.push_back(key);
+    }
+  }
+  load.waiters.push_back(std::move(waiter));
+}
+
+void IconManager::StartQueuedGroupLoads() {
+  while (group_loads_in_flight_ < kMaxConcurrentIconLoads) {
+    base::circular_deque<CacheKey>& queue = !visible_load_queue_.empty()
+                                                ? visible_load_queue_
+                                                : offscreen_load_queue_;
+    if (queue.empty())
+      return;
+    CacheKey key = std::move(queue.front());
+    queue.pop_front();
+
+    auto load_it = group_loads_.find(key);
+    if (load_it == group_loads_.end() || load_it->second.started)
+      continue;
+
+    // Don't load icons which nobody is waiting for anymore, e.g. because the
+    // items scrolled out of view and their LoadIcons() call was cancelled.
+    GroupLoad& load = load_it->second;
+    base::EraseIf(load.waiters, [](const IconWaiter& waiter) {
+      return waiter.is_canceled.Run();
+    });
+    if (load.waiters.empty()) {
+      group_loads_.erase(load_it);
+      continue;
+    }
+
+    load.started = true;
+    ++group_loads_in_flight_;
+    ++load_count_;
+    IconLoader* loader = IconLoader::Create(
+        load.file_path, key.size,
+        base::BindOnce(&IconManager::OnGroupIconLoaded,
+                       weak_factory_.GetWeakPtr(), key));
+    loader->Start();
+  }
+}
+
+void IconManager::OnGroupIconLoaded(const CacheKey& key,
+                                    gfx::Image result,
+                                    const IconLoader::IconGroup& group) {
+  DCHECK_GT(group_loads_in_flight_, 0u);
+  --group_loads_in_flight_;
+
+  auto load_it = group_loads_.find(key);
+  DCHECK(load_it != group_loads_.end());
+  std::vector<IconWaiter> waiters = std::move(load_it->second.waiters);
+  group_loads_.erase(load_it);
+
+  CacheIcon(key, result);
+  for (const IconWaiter& waiter : waiters) {
+    if (!waiter.is_canceled.Run())
+      waiter.callback.Run(waiter.file_path, result);
+  }
+
+  StartQueuedGroupLoads();
 }
 
 IconManager::CacheKey::CacheKey(const IconLoader::IconGroup& group,
@@ -89,3 +281,27 @@ IconManager::CacheKey::CacheKey(const IconLoader::IconGroup& group,
 bool IconManager::CacheKey::operator<(const CacheKey &other) const {
   return std::tie(group, size) < std::tie(other.group, other.size);
 }
+
+IconManager::IconWaiter::IconWaiter(
+    base::FilePath file_path,
+    IconsRequestCallback callback,
+    base::CancelableTaskTracker::IsCanceledCallback is_canceled)
+    : file_path(std::move(file_path)),
+      callback(std::move(callback)),
+      is_canceled(std::move(is_canceled)) {}
+
+IconManager::IconWaiter::IconWaiter(IconWaiter&& other) = default;
+
+IconManager::IconWaiter& IconManager::IconWaiter::operator=(
+    IconWaiter&& other) = default;
+
+IconManager::IconWaiter::~IconWaiter() = default;
+
+IconManager::GroupLoad::GroupLoad() = default;
+
+IconManager::GroupLoad::GroupLoad(GroupLoad&& other) = default;
+
+IconManager::GroupLoad& IconManager::GroupLoad::operator=(GroupLoad&& other) =
+    default;
+
+IconManager::GroupLoad::~GroupLoad() = default;
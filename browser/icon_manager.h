@@ -28,16 +28,19 @@
 // POSIX files don't have associated icons. We query the OS by the file's
 // mime type.
 //
-// The IconManager can be queried in two ways:
+// The IconManager can be queried in three ways:
 //   1. A quick, synchronous check of its caches which does not touch the disk:
 //      IconManager::LookupIcon()
 //   2. An asynchronous icon load from a file on the file thread:
 //      IconManager::LoadIcon()
+//   3. An asynchronous load of the icons of many files at once, which loads
+//      each icon group only once and loads visible items first:
+//      IconManager::LoadIcons()
 //
-// When using the second (asynchronous) method, callers must supply a callback
-// which will be run once the icon has been extracted. The icon manager will
-// cache the results of the icon extraction so that subsequent lookups will be
-// fast.
+// When using the asynchronous methods, callers must supply a callback which
+// will be run once the icon has been extracted. The icon manager will cache
+// the results of the icon extraction so that subsequent lookups will be fast.
+// Both caches are bounded; the least recently used entries are evicted first.
 //
 // Icon bitmaps returned should be treated as const since they may be referenced
 // by other clients. Make a copy of the icon if you need to modify it.
@@ -45,9 +48,14 @@
 #ifndef CHROME_BROWSER_ICON_MANAGER_H_
 #define CHROME_BROWSER_ICON_MANAGER_H_
 
+#include <stddef.h>
+
 #include <map>
 #include <memory>
+#include <vector>
 
+#include "base/containers/circular_deque.h"
+#include "base/containers/mru_cache.h"
 #include "base/files/file_path.h"
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
@@ -57,14 +65,27 @@
 
 class IconManager {
  public:
+  // The maximum number of icons and of file path to icon group mappings kept
+  // in the caches.
+  static constexpr size_t kMaxCachedIcons = 256;
+  static constexpr size_t kMaxCachedGroups = 4096;
+
+  // The maximum number of icon loads started by LoadIcons() which may be
+  // running at the same time. The rest wait in a queue, visible items first.
+  static constexpr size_t kMaxConcurrentIconLoads = 4;
+
+  // Reports whether a cache lookup found the icon.
+  static constexpr char kHistogramCacheHit[] = "IconManager.CacheHit";
+
   IconManager();
   ~IconManager();
 
   // Synchronous call to examine the internal caches for the icon. Returns the
   // icon if we have already loaded it, or null if we don't have it and must
   // load it via LoadIcon(). The returned bitmap is owned by the IconManager and
-  // must not be free'd by the caller. If the caller needs to modify the icon,
-  // it must make a copy and modify the copy.
+  // must not be free'd by the caller; it is only valid until the next call into
+  // the IconManager, which may evict it. If the caller needs to keep or modify
+  // the icon, it must make a copy.
   gfx::Image* LookupIconFromFilepath(const base::FilePath& file_path,
                                      IconLoader::IconSize size);
 
@@ -86,6 +107,31 @@ class IconManager {
       IconRequestCallback callback,
       base::CancelableTaskTracker* tracker);
 
+  // Run once for each file passed to LoadIcons(). The image is empty if the
+  // icon could not be loaded.
+  using IconsRequestCallback =
+      base::RepeatingCallback<void(const base::FilePath&, gfx::Image)>;
+
+  // Asynchronous call to return the icons of many files, e.g. every item of the
+  // download shelf or of a directory listing. Unlike LoadIcon(), this checks
+  // the caches first, and files which share an icon group share a single icon
+  // load. The icons of |visible_file_paths| are loaded before those of
+  // |offscreen_file_paths|, including those of earlier LoadIcons() calls.
+  // |callback| runs on the calling thread as each icon becomes available, in
+  // no particular order. Cancelling the returned task skips the loads which
+  // have not started yet and are only wanted by this call.
+  base::CancelableTaskTracker::TaskId LoadIcons(
+      std::vector<base::FilePath> visible_file_paths,
+      std::vector<base::FilePath> offscreen_file_paths,
+      IconLoader::IconSize size,
+      IconsRequestCallback callback,
+      base::CancelableTaskTracker* tracker);
+
+  size_t hit_count() const { return hit_count_; }
+  size_t miss_count() const { return miss_count_; }
+  // The number of icon loads started by LoadIcon() and LoadIcons().
+  size_t load_count() const { return load_count_; }
+
  private:
   void OnIconLoaded(IconRequestCallback callback,
                     base::FilePath file_path,
@@ -103,8 +149,69 @@ class IconManager {
     IconLoader::IconSize size;
   };
 
-  std::map<base::FilePath, IconLoader::IconGroup> group_cache_;
-  std::map<CacheKey, gfx::Image> icon_cache_;
+  // A file waiting for the icon load of its group.
+  struct IconWaiter {
+    IconWaiter(base::FilePath file_path,
+               IconsRequestCallback callback,
+               base::CancelableTaskTracker::IsCanceledCallback is_canceled);
+    IconWaiter(IconWaiter&& other);
+    IconWaiter& operator=(IconWaiter&& other);
+    ~IconWaiter();
+
+    base::FilePath file_path;
+    IconsRequestCallback callback;
+    base::CancelableTaskTracker::IsCanceledCallback is_canceled;
+    bool visible = false;
+  };
+
+  // An icon load for a group, started by LoadIcons().
+  struct GroupLoad {
+    GroupLoad();
+    GroupLoad(GroupLoad&& other);
+    GroupLoad& operator=(GroupLoad&& other);
+    ~GroupLoad();
+
+    // Any file of the group, to load the icon from.
+    base::FilePath file_path;
+    std::vector<IconWaiter> waiters;
+    bool queued_visible = false;
+    bool queued_offscreen = false;
+    bool started = false;
+  };
+
+  // Returns the cached icon of |key| and counts the lookup, or null.
+  gfx::Image* GetCachedIcon(const CacheKey& key);
+  void CacheIcon(const CacheKey& key, gfx::Image image);
+  void CacheGroup(const base::FilePath& file_path,
+                  const IconLoader::IconGroup& group);
+
+  // Called with the groups of the files of a LoadIcons() call which weren't in
+  // |group_cache_|.
+  void OnGroupsRead(IconLoader::IconSize size,
+                    std::vector<IconWaiter> waiters,
+                    std::vector<IconLoader::IconGroup> groups);
+  // Answers |waiter| from the cache or attaches it to the load of |group|.
+  void AddIconWaiter(IconWaiter waiter,
+                     const IconLoader::IconGroup& group,
+                     IconLoader::IconSize size);
+  void StartQueuedGroupLoads();
+  void OnGroupIconLoaded(const CacheKey& key,
+                         gfx::Image result,
+                         const IconLoader::IconGroup& group);
+
+  base::MRUCache<base::FilePath, IconLoader::IconGroup> group_cache_;
+  base::MRUCache<CacheKey, gfx::Image> icon_cache_;
+
+  size_t hit_count_ = 0;
+  size_t miss_count_ = 0;
+  size_t load_count_ = 0;
+
+  // Loads requested by LoadIcons(), and the queues of those not yet started.
+  // A group may be in both queues if it was first requested offscreen.
+  std::map<CacheKey, GroupLoad> group_loads_;
+  base::circular_deque<CacheKey> visible_load_queue_;
+  base::circular_deque<CacheKey> offscreen_load_queue_;
+  size_t group_loads_in_flight_ = 0;
 
   base::WeakPtrFactory<IconManager> weak_factory_{this};
 
@@ -4,6 +4,7 @@
 
 #include "chrome/browser/image_decoder/image_decoder.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
@@ -24,6 +25,21 @@ namespace {
 const int64_t kMaxImageSizeInBytes =
     static_cast<int64_t>(IPC::Channel::kMaximumMessageSize);
 
+// The number of batch images sent to a decoder and not yet answered.
+// Bounding this keeps the encoded and decoded data of huge batches from piling
+// up in the pipe, and lets higher priority batches overtake lower priority
+// ones which were started earlier.
+constexpr size_t kMaxBatchImagesInFlight = 16;
+
+data_decoder::mojom::ImageCodec ToMojoImageCodec(
+    ImageDecoder::ImageCodec image_codec) {
+#if BUILDFLAG(IS_CHROMEOS_ASH) || BUILDFLAG(IS_CHROMEOS_LACROS)
+  if (image_codec == ImageDecoder::PNG_CODEC)
+    return data_decoder::mojom::ImageCodec::kPng;
+#endif  // BUILDFLAG(IS_CHROMEOS_ASH) || BUILDFLAG(IS_CHROMEOS_LACROS)
+  return data_decoder::mojom::ImageCodec::kDefault;
+}
+
 // Note that this is always called on the thread which initiated the
 // corresponding data_decoder::DecodeImage request.
 void OnDecodeImageDone(
@@ -71,6 +87,26 @@ void DecodeImage(
 
 }  // namespace
 
+struct ImageDecoder::PendingBatch {
+  int batch_id = 0;
+  base::TaskPriority priority = base::TaskPriority::USER_VISIBLE;
+  data_decoder::mojom::ImageCodec codec =
+      data_decoder::mojom::ImageCodec::kDefault;
+  bool shrink_to_fit = false;
+  gfx::Size desired_image_frame_size;
+  scoped_refptr<base::SequencedTaskRunner> task_runner;
+
+  // The decoder of the BatchRequest, or |own_data_decoder| if it has none.
+  data_decoder::DataDecoder* data_decoder = nullptr;
+  std::unique_ptr<data_decoder::DataDecoder> own_data_decoder;
+
+  // Encoded images are released as soon as they are sent to the decoder.
+  std::vector<std::vector<uint8_t>> images;
+  std::vector<SkBitmap> decoded_images;
+  size_t next_image = 0;
+  size_t images_in_flight = 0;
+};
+
 ImageDecoder::ImageRequest::ImageRequest()
     : task_runner_(base::ThreadTaskRunnerHandle::Get()) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
@@ -94,6 +130,29 @@ ImageDecoder::ImageRequest::~ImageRequest() {
   ImageDecoder::Cancel(this);
 }
 
+ImageDecoder::BatchRequest::BatchRequest()
+    : task_runner_(base::ThreadTaskRunnerHandle::Get()) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+ImageDecoder::BatchRequest::BatchRequest(
+    const scoped_refptr<base::SequencedTaskRunner>& task_runner)
+    : task_runner_(task_runner) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+ImageDecoder::BatchRequest::BatchRequest(
+    data_decoder::DataDecoder* data_decoder)
+    : task_runner_(base::ThreadTaskRunnerHandle::Get()),
+      data_decoder_(data_decoder) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+ImageDecoder::BatchRequest::~BatchRequest() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  ImageDecoder::CancelBatch(this);
+}
+
 // static
 ImageDecoder* ImageDecoder::GetInstance() {
   static auto* image_decoder = new ImageDecoder();
@@ -135,6 +194,18 @@ void ImageDecoder::StartWithOptions(ImageRequest* image_request,
                    image_codec, shrink_to_fit, gfx::Size());
 }
 
+// static
+void ImageDecoder::StartBatch(BatchRequest* batch_request,
+                              std::vector<std::vector<uint8_t>> images,
+                              ImageCodec image_codec,
+                              bool shrink_to_fit,
+                              const gfx::Size& desired_image_frame_size,
+                              base::TaskPriority priority) {
+  ImageDecoder::GetInstance()->StartBatchImpl(
+      batch_request, std::move(images), image_codec, shrink_to_fit,
+      desired_image_frame_size, priority);
+}
+
 ImageDecoder::ImageDecoder() : image_request_id_counter_(0) {}
 
 void ImageDecoder::StartWithOptionsImpl(
@@ -153,12 +224,7 @@ void ImageDecoder::StartWithOptionsImpl(
     image_request_id_map_.insert(std::make_pair(request_id, image_request));
   }
 
-  data_decoder::mojom::ImageCodec codec =
-      data_decoder::mojom::ImageCodec::kDefault;
-#if BUILDFLAG(IS_CHROMEOS_ASH) || BUILDFLAG(IS_CHROMEOS_LACROS)
-  if (image_codec == PNG_CODEC)
-    codec = data_decoder::mojom::ImageCodec::kPng;
-#endif  // BUILDFLAG(IS_CHROMEOS_ASH) || BUILDFLAG(IS_CHROMEOS_LACROS)
+  data_decoder::mojom::ImageCodec codec = ToMojoImageCodec(image_codec);
 
   auto callback =
       base::BindOnce(&OnDecodeImageDone,
@@ -180,6 +246,36 @@ void ImageDecoder::StartWithOptionsImpl(
                      image_request->data_decoder()));
 }
 
+void ImageDecoder::StartBatchImpl(BatchRequest* batch_request,
+                                  std::vector<std::vector<uint8_t>> images,
+                                  ImageCodec image_codec,
+                                  bool shrink_to_fit,
+                                  const gfx::Size& desired_image_frame_size,
+                                  base::TaskPriority priority) {
+  DCHECK(batch_request);
+  DCHECK(batch_request->task_runner());
+
+  auto batch = std::make_unique<PendingBatch>();
+  {
+    base::AutoLock lock(map_lock_);
+    batch->batch_id = batch_request_id_counter_++;
+    batch_request_id_map_.insert(
+        std::make_pair(batch->batch_id, batch_request));
+  }
+  batch->priority = priority;
+  batch->codec = ToMojoImageCodec(image_codec);
+  batch->shrink_to_fit = shrink_to_fit;
+  batch->desired_image_frame_size = desired_image_frame_size;
+  batch->task_runner = base::WrapRefCounted(batch_request->task_runner());
+  batch->data_decoder = batch_request->data_decoder();
+  batch->decoded_images.resize(images.size());
+  batch->images = std::move(images);
+
+  content::GetIOThreadTaskRunner({})->PostTask(
+      FROM_HERE, base::BindOnce(&ImageDecoder::EnqueueBatchOnIOThread,
+                                base::Unretained(this), std::move(batch)));
+}
+
 // static
 void ImageDecoder::Cancel(ImageRequest* image_request) {
   DCHECK(image_request);
@@ -198,6 +294,24 @@ void ImageDecoder::CancelImpl(ImageRequest* image_request) {
   }
 }
 
+// static
+void ImageDecoder::CancelBatch(BatchRequest* batch_request) {
+  DCHECK(batch_request);
+  ImageDecoder::GetInstance()->CancelBatchImpl(batch_request);
+}
+
+void ImageDecoder::CancelBatchImpl(BatchRequest* batch_request) {
+  base::AutoLock lock(map_lock_);
+  for (auto it = batch_request_id_map_.begin();
+       it != batch_request_id_map_.end();) {
+    if (it->second == batch_request) {
+      batch_request_id_map_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void ImageDecoder::OnDecodeImageSucceeded(const SkBitmap& decoded_image,
                                           int request_id) {
   ImageRequest* image_request;
@@ -228,3 +342,117 @@ void ImageDecoder::OnDecodeImageFailed(int request_id) {
   DCHECK(image_request->task_runner()->RunsTasksInCurrentSequence());
   image_request->OnDecodeImageFailed();
 }
+
+void ImageDecoder::EnqueueBatchOnIOThread(std::unique_ptr<PendingBatch> batch) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::IO);
+  pending_batches_.push_back(std::move(batch));
+  PumpBatchesOnIOThread();
+}
+
+void ImageDecoder::PumpBatchesOnIOThread() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::IO);
+
+  while (batch_images_in_flight_ < kMaxBatchImagesInFlight) {
+    // Pick the highest priority batch with images left to send. Ties go to the
+    // batch started first, which comes first in |pending_batches_|.
+    PendingBatch* next_batch = nullptr;
+    for (const auto& batch : pending_batches_) {
+      if (batch->next_image == batch->images.size())
+        continue;
+      if (!next_batch || batch->priority > next_batch->priority)
+        next_batch = batch.get();
+    }
+    if (!next_batch)
+      break;
+
+    if (!IsBatchAlive(next_batch->batch_id)) {
+      // Don't decode the rest of a cancelled batch.
+      next_batch->images.clear();
+      next_batch->next_image = 0;
+      continue;
+    }
+
+    if (!next_batch->data_decoder) {
+      next_batch->own_data_decoder =
+          std::make_unique<data_decoder::DataDecoder>();
+      next_batch->data_decoder = next_batch->own_data_decoder.get();
+    }
+
+    const size_t index = next_batch->next_image++;
+    std::vector<uint8_t> image_data = std::move(next_batch->images[index]);
+    ++next_batch->images_in_flight;
+    ++batch_images_in_flight_;
+    data_decoder::DecodeImage(
+        next_batch->data_decoder, image_data, next_batch->codec,
+        next_batch->shrink_to_fit, kMaxImageSizeInBytes,
+        next_batch->desired_image_frame_size,
+        base::BindOnce(&ImageDecoder::OnBatchImageDecodedOnIOThread,
+                       base::Unretained(this), next_batch->batch_id, index));
+  }
+
+  // Drop batches which were cancelled and have nothing left in flight, and
+  // deliver the ones which are complete (including empty batches).
+  for (auto it = pending_batches_.begin(); it != pending_batches_.end();) {
+    PendingBatch* batch = it->get();
+    if (batch->images_in_flight > 0) {
+      ++it;
+      continue;
+    }
+    if (!IsBatchAlive(batch->batch_id)) {
+      it = pending_batches_.erase(it);
+      continue;
+    }
+    if (batch->next_image == batch->images.size()) {
+      batch->task_runner->PostTask(
+          FROM_HERE,
+          base::BindOnce(&ImageDecoder::OnBatchDecoded, base::Unretained(this),
+                         batch->batch_id, std::move(batch->decoded_images)));
+      it = pending_batches_.erase(it);
+      continue;
+    }
+    ++it;
+  }
+}
+
+void ImageDecoder::OnBatchImageDecodedOnIOThread(int batch_id,
+                                                 size_t index,
+                                                 const SkBitmap& image) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::IO);
+  DCHECK_GT(batch_images_in_flight_, 0u);
+  --batch_images_in_flight_;
+
+  auto it = std::find_if(
+      pending_batches_.begin(), pending_batches_.end(),
+      [batch_id](const std::unique_ptr<PendingBatch>& batch) {
+        return batch->batch_id == batch_id;
+      });
+  DCHECK(it != pending_batches_.end());
+  PendingBatch* batch = it->get();
+  DCHECK_GT(batch->images_in_flight, 0u);
+  --batch->images_in_flight;
+  if (!image.isNull() && !image.empty())
+    batch->decoded_images[index] = image;
+
+  PumpBatchesOnIOThread();
+}
+
+bool ImageDecoder::IsBatchAlive(int batch_id) {
+  base::AutoLock lock(map_lock_);
+  return batch_request_id_map_.find(batch_id) != batch_request_id_map_.end();
+}
+
+void ImageDecoder::OnBatchDecoded(int batch_id,
+                                  std::vector<SkBitmap> decoded_images) {
+  BatchRequest* batch_request;
+  {
+    base::AutoLock lock(map_lock_);
+    auto it = batch_request_id_map_.find(batch_id);
+    if (it == batch_request_id_map_.end())
+      return;
+    batch_request = it->second;
+    batch_request_id_map_.erase(it);
+  }
+
+  DCHECK(batch_request->task_runner()->RunsTasksInCurrentSequence());
+  batch_request->OnBatchDecoded(std::move(decoded_images));
+}
@@ -5,7 +5,10 @@
 #ifndef CHROME_BROWSER_IMAGE_DECODER_IMAGE_DECODER_H_
 #define CHROME_BROWSER_IMAGE_DECODER_IMAGE_DECODER_H_
 
+#include <stddef.h>
+
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,6 +17,7 @@
 #include "base/sequence_checker.h"
 #include "base/sequenced_task_runner.h"
 #include "base/synchronization/lock.h"
+#include "base/task/task_traits.h"
 #include "build/chromeos_buildflags.h"
 
 namespace data_decoder {
@@ -79,6 +83,45 @@ class ImageDecoder {
     SEQUENCE_CHECKER(sequence_checker_);
   };
 
+  // Receives the result of a batch started with StartBatch(). Like
+  // ImageRequest, BatchRequest objects need to be created and destroyed on the
+  // same SequencedTaskRunner, and destroying one cancels its batches.
+  class BatchRequest {
+   public:
+    // Called once per batch with one bitmap per input image, in input order.
+    // Images which failed to decode are null bitmaps.
+    virtual void OnBatchDecoded(std::vector<SkBitmap> decoded_images) = 0;
+
+    base::SequencedTaskRunner* task_runner() const {
+      return task_runner_.get();
+    }
+
+    data_decoder::DataDecoder* data_decoder() { return data_decoder_; }
+
+   protected:
+    // Creates a BatchRequest that runs on the thread which created it.
+    BatchRequest();
+    // Explicitly pass in |task_runner| if the current thread is part of a
+    // thread pool.
+    explicit BatchRequest(
+        const scoped_refptr<base::SequencedTaskRunner>& task_runner);
+    // Explicitly pass in |data_decoder| to decode the batches of this request
+    // with a decoder shared by the caller; a long-lived |data_decoder| keeps
+    // its process warm across the caller's batches. Otherwise, each batch uses
+    // an isolated decoder of its own.
+    explicit BatchRequest(data_decoder::DataDecoder* data_decoder);
+    virtual ~BatchRequest();
+
+   private:
+    // The thread to post OnBatchDecoded() to.
+    const scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+    // If null, each batch creates its own decoder.
+    data_decoder::DataDecoder* const data_decoder_ = nullptr;
+
+    SEQUENCE_CHECKER(sequence_checker_);
+  };
+
   enum ImageCodec {
     DEFAULT_CODEC = 0,  // Uses WebKit image decoding (via WebImage).
 #if BUILDFLAG(IS_CHROMEOS_ASH) || BUILDFLAG(IS_CHROMEOS_LACROS)
@@ -113,12 +156,38 @@ class ImageDecoder {
                                ImageCodec image_codec,
                                bool shrink_to_fit);
 
+  // Starts asynchronous decoding of all of |images| with the same options as
+  // StartWithOptions(). Once every image is decoded, the results are posted
+  // back to batch_request's |task_runner_|.
+  //
+  // Unlike StartWithOptions(), which launches an isolated decoder process per
+  // image unless the request brings its own DataDecoder, all the images of a
+  // batch go to one decoder process: the DataDecoder of |batch_request| if it
+  // has one, or else one created for the batch. Batches only hop to the IO
+  // thread once. A bounded number of images are decoded at a time; images of
+  // batches with a higher |priority| are sent to the decoder first.
+  static void StartBatch(BatchRequest* batch_request,
+                         std::vector<std::vector<uint8_t>> images,
+                         ImageCodec image_codec,
+                         bool shrink_to_fit,
+                         const gfx::Size& desired_image_frame_size,
+                         base::TaskPriority priority);
+
   // Removes all instances of |image_request| from |image_request_id_map_|,
   // ensuring callbacks are not made to the image_request after it is destroyed.
   static void Cancel(ImageRequest* image_request);
 
+  // Cancels every batch of |batch_request|. Images of those batches which were
+  // not yet sent to the decoder are dropped.
+  static void CancelBatch(BatchRequest* batch_request);
+
  private:
   using RequestMap = std::map<int, ImageRequest*>;
+  using BatchRequestMap = std::map<int, BatchRequest*>;
+
+  // A batch waiting for, or in the middle of, decoding. Only used on the IO
+  // thread.
+  struct PendingBatch;
 
   ImageDecoder();
   ~ImageDecoder() = delete;
@@ -129,21 +198,51 @@ class ImageDecoder {
                             bool shrink_to_fit,
                             const gfx::Size& desired_image_frame_size);
 
+  void StartBatchImpl(BatchRequest* batch_request,
+                      std::vector<std::vector<uint8_t>> images,
+                      ImageCodec image_codec,
+                      bool shrink_to_fit,
+                      const gfx::Size& desired_image_frame_size,
+                      base::TaskPriority priority);
+
   void CancelImpl(ImageRequest* image_request);
+  void CancelBatchImpl(BatchRequest* batch_request);
 
   // IPC message handlers.
   void OnDecodeImageSucceeded(const SkBitmap& decoded_image, int request_id);
   void OnDecodeImageFailed(int request_id);
 
+  // Batch decoding, on the IO thread.
+  void EnqueueBatchOnIOThread(std::unique_ptr<PendingBatch> batch);
+  void PumpBatchesOnIOThread();
+  void OnBatchImageDecodedOnIOThread(int batch_id,
+                                     size_t index,
+                                     const SkBitmap& image);
+  bool IsBatchAlive(int batch_id);
+
+  // Delivers the results of |batch_id|, on its request's task runner.
+  void OnBatchDecoded(int batch_id, std::vector<SkBitmap> decoded_images);
+
   // id to use for the next Start() request that comes in.
   int image_request_id_counter_;
 
   // Map of request id's to ImageRequests.
   RequestMap image_request_id_map_;
 
-  // Protects |image_request_id_map_| and |image_request_id_counter_|.
+  // id to use for the next StartBatch() request that comes in.
+  int batch_request_id_counter_ = 0;
+
+  // Map of batch id's to BatchRequests.
+  BatchRequestMap batch_request_id_map_;
+
+  // Protects the request maps and id counters above.
   base::Lock map_lock_;
 
+  // The batches which still have images to send to or receive from the
+  // decoder. Only accessed on the IO thread.
+  std::vector<std::unique_ptr<PendingBatch>> pending_batches_;
+  size_t batch_images_in_flight_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(ImageDecoder);
 };
 
@@ -4,8 +4,10 @@
 
 #include "chrome/browser/image_decoder/image_decoder.h"
 
+#include "base/barrier_closure.h"
 #include "base/macros.h"
 #include "base/run_loop.h"
+#include "base/timer/elapsed_timer.h"
 #include "build/build_config.h"
 #include "build/chromeos_buildflags.h"
 #include "chrome/grit/generated_resources.h"
@@ -15,7 +17,10 @@
 #include "content/public/browser/child_process_data.h"
 #include "content/public/test/browser_test.h"
 #include "content/public/test/test_utils.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/base/l10n/l10n_util.h"
+#include "ui/gfx/codec/png_codec.h"
 
 using content::BrowserThread;
 
@@ -99,6 +104,64 @@ class TestImageRequest : public ImageDecoder::ImageRequest {
   DISALLOW_COPY_AND_ASSIGN(TestImageRequest);
 };
 
+// Counts decoded images and runs |done_closure| once per image.
+class CountingImageRequest : public ImageDecoder::ImageRequest {
+ public:
+  explicit CountingImageRequest(base::RepeatingClosure done_closure)
+      : done_closure_(std::move(done_closure)) {}
+
+  size_t decoded_count() const { return decoded_count_; }
+
+ private:
+  void OnImageDecoded(const SkBitmap& decoded_image) override {
+    ++decoded_count_;
+    done_closure_.Run();
+  }
+
+  void OnDecodeImageFailed() override { done_closure_.Run(); }
+
+  base::RepeatingClosure done_closure_;
+  size_t decoded_count_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingImageRequest);
+};
+
+class TestBatchRequest : public ImageDecoder::BatchRequest {
+ public:
+  TestBatchRequest() = default;
+
+  // Waits for the next OnBatchDecoded() call and returns its result.
+  std::vector<SkBitmap> Wait() {
+    run_loop_.Run();
+    return std::move(decoded_images_);
+  }
+
+ private:
+  void OnBatchDecoded(std::vector<SkBitmap> decoded_images) override {
+    decoded_images_ = std::move(decoded_images);
+    run_loop_.Quit();
+  }
+
+  base::RunLoop run_loop_;
+  std::vector<SkBitmap> decoded_images_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestBatchRequest);
+};
+
+// Returns |count| distinct 16x16 PNGs.
+std::vector<std::vector<uint8_t>> CreateSmallPngs(size_t count) {
+  std::vector<std::vector<uint8_t>> pngs;
+  for (size_t i = 0; i < count; ++i) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(16, 16);
+    bitmap.eraseARGB(0xff, i & 0xff, (i >> 8) & 0xff, 0x80);
+    std::vector<uint8_t> png;
+    CHECK(gfx::PNGCodec::EncodeBGRASkBitmap(bitmap, false, &png));
+    pngs.push_back(std::move(png));
+  }
+  return pngs;
+}
+
 }  // namespace
 
 class ImageDecoderBrowserTest : public InProcessBrowserTest {};
@@ -198,3 +261,90 @@ IN_PROC_BROWSER_TEST_F(ImageDecoderBrowserTest, StartAndDestroy) {
   test_request.reset();
   run_loop.Run();
 }
+
+IN_PROC_BROWSER_TEST_F(ImageDecoderBrowserTest, BatchDecode) {
+  std::vector<std::vector<uint8_t>> images;
+  images.push_back(GetValidPngData());
+  images.push_back(std::vector<uint8_t>());
+  images.push_back(GetValidJpgData());
+
+  TestBatchRequest batch_request;
+  ImageDecoder::StartBatch(&batch_request, std::move(images),
+                           ImageDecoder::DEFAULT_CODEC,
+                           /*shrink_to_fit=*/false,
+                           /*desired_image_frame_size=*/gfx::Size(),
+                           base::TaskPriority::USER_VISIBLE);
+  std::vector<SkBitmap> decoded_images = batch_request.Wait();
+
+  ASSERT_EQ(3u, decoded_images.size());
+  EXPECT_EQ(1, decoded_images[0].width());
+  EXPECT_EQ(decoded_images[0].getColor(0, 0), 0xffffffffUL);
+  // Failures leave a null bitmap without affecting the rest of the batch.
+  EXPECT_TRUE(decoded_images[1].isNull());
+  EXPECT_EQ(1, decoded_images[2].width());
+}
+
+IN_PROC_BROWSER_TEST_F(ImageDecoderBrowserTest, BatchDecodeEmpty) {
+  TestBatchRequest batch_request;
+  ImageDecoder::StartBatch(&batch_request, {}, ImageDecoder::DEFAULT_CODEC,
+                           /*shrink_to_fit=*/false,
+                           /*desired_image_frame_size=*/gfx::Size(),
+                           base::TaskPriority::USER_VISIBLE);
+  EXPECT_TRUE(batch_request.Wait().empty());
+}
+
+IN_PROC_BROWSER_TEST_F(ImageDecoderBrowserTest, BatchStartAndDestroy) {
+  auto cancelled_request = std::make_unique<TestBatchRequest>();
+  ImageDecoder::StartBatch(cancelled_request.get(), CreateSmallPngs(100),
+                           ImageDecoder::DEFAULT_CODEC,
+                           /*shrink_to_fit=*/false,
+                           /*desired_image_frame_size=*/gfx::Size(),
+                           base::TaskPriority::BEST_EFFORT);
+  cancelled_request.reset();
+
+  // A later batch still completes, and the cancelled one never calls back.
+  TestBatchRequest batch_request;
+  ImageDecoder::StartBatch(&batch_request, CreateSmallPngs(10),
+                           ImageDecoder::DEFAULT_CODEC,
+                           /*shrink_to_fit=*/false,
+                           /*desired_image_frame_size=*/gfx::Size(),
+                           base::TaskPriority::USER_BLOCKING);
+  EXPECT_EQ(10u, batch_request.Wait().size());
+}
+
+// Compares decoding many small images one request at a time with decoding them
+// as one batch.
+IN_PROC_BROWSER_TEST_F(ImageDecoderBrowserTest, DecodeManySmallPngs) {
+  constexpr size_t kImageCount = 1000;
+  const std::vector<std::vector<uint8_t>> pngs = CreateSmallPngs(kImageCount);
+
+  perf_test::PerfResultReporter reporter("ImageDecoder.", "1000_small_pngs");
+  reporter.RegisterImportantMetric("single_decode_time", "ms");
+  reporter.RegisterImportantMetric("batch_decode_time", "ms");
+
+  {
+    base::RunLoop run_loop;
+    CountingImageRequest request(
+        base::BarrierClosure(kImageCount, run_loop.QuitClosure()));
+    base::ElapsedTimer timer;
+    for (const auto& png : pngs)
+      ImageDecoder::Start(&request, png);
+    run_loop.Run();
+    reporter.AddResult("single_decode_time", timer.Elapsed());
+    EXPECT_EQ(kImageCount, request.decoded_count());
+  }
+
+  {
+    TestBatchRequest batch_request;
+    base::ElapsedTimer timer;
+    ImageDecoder::StartBatch(&batch_request, pngs, ImageDecoder::DEFAULT_CODEC,
+                             /*shrink_to_fit=*/false,
+                             /*desired_image_frame_size=*/gfx::Size(),
+                             base::TaskPriority::USER_VISIBLE);
+    std::vector<SkBitmap> decoded_images = batch_request.Wait();
+    reporter.AddResult("batch_decode_time", timer.Elapsed());
+    ASSERT_EQ(kImageCount, decoded_images.size());
+    for (const SkBitmap& bitmap : decoded_images)
+      EXPECT_EQ(16, bitmap.width());
+  }
+}
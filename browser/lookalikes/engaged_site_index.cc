@@ -0,0 +1,175 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/lookalikes/engaged_site_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/strings/strcat.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/strings/utf_string_conversions.h"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+
+namespace {
+
+// GetMatchingDomain() flags engaged sites at an edit distance of at most one.
+constexpr size_t kMaxEditDistance = 1;
+
+bool IsRegistry(base::StringPiece token) {
+  return net::registry_controlled_domains::HostHasRegistryControlledDomain(
+      base::StrCat({"a.", token}),
+      net::registry_controlled_domains::EXCLUDE_UNKNOWN_REGISTRIES,
+      net::registry_controlled_domains::INCLUDE_PRIVATE_REGISTRIES);
+}
+
+}  // namespace
+
+EngagedSiteIndex::Node::Node(std::u16string key) : key(std::move(key)) {}
+
+EngagedSiteIndex::Node::Node(Node&&) = default;
+
+EngagedSiteIndex::Node::~Node() = default;
+
+EngagedSiteIndex::EngagedSiteIndex(std::vector<DomainInfo> sites)
+    : sites_(std::move(sites)) {
+  for (size_t i = 0; i < sites_.size(); ++i) {
+    const DomainInfo& site = sites_[i];
+    domains_.insert(site.domain_and_registry);
+    for (const std::string& skeleton : site.skeletons)
+      sites_by_skeleton_[skeleton].push_back(i);
+    for (const std::u16string& key : GetNearMatchKeys(site))
+      InsertIntoTree(key, i);
+  }
+}
+
+EngagedSiteIndex::~EngagedSiteIndex() = default;
+
+bool EngagedSiteIndex::IsEngaged(const DomainInfo& domain) const {
+  return domains_.count(domain.domain_and_registry) > 0;
+}
+
+const std::vector<DomainInfo>& EngagedSiteIndex::GetMatchCandidates(
+    const DomainInfo& navigated_domain,
+    std::vector<DomainInfo>* candidates) const {
+  if (MayEmbedTarget(navigated_domain))
+    return sites_;
+
+  // Indices are kept sorted so that the candidates keep the order of the
+  // engaged sites, which GetMatchingDomain() returns the first match of.
+  std::set<size_t> site_indices;
+  for (const std::string& skeleton : navigated_domain.skeletons) {
+    auto it = sites_by_skeleton_.find(skeleton);
+    if (it != sites_by_skeleton_.end())
+      site_indices.insert(it->second.begin(), it->second.end());
+  }
+  for (const std::u16string& key : GetNearMatchKeys(navigated_domain))
+    FindInTree(key, kMaxEditDistance, &site_indices);
+
+  candidates->clear();
+  for (size_t site_index : site_indices)
+    candidates->push_back(sites_[site_index]);
+  return *candidates;
+}
+
+// static
+bool EngagedSiteIndex::MayEmbedTarget(const DomainInfo& domain) {
+  // Be conservative when the hostname can't be split at its registry.
+  const std::string& hostname = domain.hostname;
+  const std::string& domain_and_registry = domain.domain_and_registry;
+  if (domain_and_registry.size() <=
+          domain.domain_without_registry.size() + 1 ||
+      !base::EndsWith(hostname, domain_and_registry)) {
+    return true;
+  }
+  const size_t registry_length =
+      domain_and_registry.size() - domain.domain_without_registry.size() - 1;
+  base::StringPiece host_without_registry(hostname);
+  host_without_registry.remove_suffix(registry_length + 1);
+
+  const std::vector<base::StringPiece> tokens = base::SplitStringPiece(
+      host_without_registry, ".-", base::TRIM_WHITESPACE,
+      base::SPLIT_WANT_NONEMPTY);
+  return std::any_of(tokens.begin() + std::min<size_t>(1, tokens.size()),
+                     tokens.end(), &IsRegistry);
+}
+
+// static
+size_t EngagedSiteIndex::EditDistance(const std::u16string& a,
+                                      const std::u16string& b) {
+  std::vector<size_t> previous(b.size() + 1);
+  std::vector<size_t> current(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j)
+    previous[j] = j;
+  for (size_t i = 1; i <= a.size(); ++i) {
+    current[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      current[j] = std::min({previous[j] + 1, current[j - 1] + 1,
+                             previous[j - 1] + (a[i - 1] != b[j - 1])});
+    }
+    std::swap(previous, current);
+  }
+  return previous[b.size()];
+}
+
+// static
+std::set<std::u16string> EngagedSiteIndex::GetNearMatchKeys(
+    const DomainInfo& domain) {
+  std::set<std::u16string> keys;
+  for (const std::string& skeleton : domain.skeletons)
+    keys.insert(base::UTF8ToUTF16(skeleton));
+  keys.insert(base::UTF8ToUTF16(domain.domain_without_registry));
+  keys.insert(domain.idn_result.result);
+  return keys;
+}
+
+void EngagedSiteIndex::InsertIntoTree(const std::u16string& key,
+                                      size_t site_index) {
+  if (tree_.empty()) {
+    tree_.emplace_back(key);
+    tree_.back().site_indices.push_back(site_index);
+    return;
+  }
+  size_t node_index = 0;
+  while (true) {
+    const size_t distance = EditDistance(key, tree_[node_index].key);
+    if (distance == 0) {
+      tree_[node_index].site_indices.push_back(site_index);
+      return;
+    }
+    auto child = tree_[node_index].children.find(distance);
+    if (child == tree_[node_index].children.end()) {
+      tree_[node_index].children[distance] = tree_.size();
+      tree_.emplace_back(key);
+      tree_.back().site_indices.push_back(site_index);
+      return;
+    }
+    node_index = child->second;
+  }
+}
+
+void EngagedSiteIndex::FindInTree(const std::u16string& key,
+                                  size_t max_distance,
+                                  std::set<size_t>* site_indices) const {
+  if (tree_.empty())
+    return;
+  std::vector<size_t> pending = {0};
+  while (!pending.empty()) {
+    const Node& node = tree_[pending.back()];
+    pending.pop_back();
+    const size_t distance = EditDistance(key, node.key);
+    if (distance <= max_distance)
+      site_indices->insert(node.site_indices.begin(), node.site_indices.end());
+    // By the triangle inequality, only the children at a distance within
+    // |max_distance| of |distance| may hold keys close enough to |key|.
+    for (auto it = node.children.lower_bound(
+             distance > max_distance ? distance - max_distance : 0);
+         it != node.children.end() && it->first <= distance + max_distance;
+         ++it) {
+      pending.push_back(it->second);
+    }
+  }
+}
@@ -0,0 +1,92 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_LOOKALIKES_ENGAGED_SITE_INDEX_H_
+#define CHROME_BROWSER_LOOKALIKES_ENGAGED_SITE_INDEX_H_
+
+#include <stddef.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "components/lookalikes/core/lookalike_url_util.h"
+
+// An immutable snapshot of the sites the user is engaged with, indexed for the
+// lookalike checks of every main frame navigation. LookalikeUrlService builds
+// one per update on a worker thread, and navigations share it by reference
+// instead of copying the list.
+//
+// GetMatchingDomain() compares a navigated domain against every engaged site.
+// GetMatchCandidates() narrows the engaged sites down to those it can match:
+// sites with a skeleton equal to one of the navigated domain, found in a hash
+// index, and sites within an edit distance of one, found in a BK-tree. Only
+// hostnames which may embed another domain, e.g. google.com-login.test, are
+// still checked against every engaged site.
+class EngagedSiteIndex : public base::RefCountedThreadSafe<EngagedSiteIndex> {
+ public:
+  explicit EngagedSiteIndex(std::vector<DomainInfo> sites);
+
+  EngagedSiteIndex(const EngagedSiteIndex&) = delete;
+  EngagedSiteIndex& operator=(const EngagedSiteIndex&) = delete;
+
+  const std::vector<DomainInfo>& sites() const { return sites_; }
+
+  // Returns true if the user is engaged with the eTLD+1 of |domain|.
+  bool IsEngaged(const DomainInfo& domain) const;
+
+  // Returns the engaged sites to pass to GetMatchingDomain() for
+  // |navigated_domain|. Either fills and returns |candidates|, or returns
+  // sites() when every engaged site is a candidate.
+  const std::vector<DomainInfo>& GetMatchCandidates(
+      const DomainInfo& navigated_domain,
+      std::vector<DomainInfo>* candidates) const;
+
+  // Returns true if target embedding checks may match |domain| against an
+  // engaged site: the part of its hostname before the registry has a token
+  // which is itself a registry, after another token. Exposed for testing.
+  static bool MayEmbedTarget(const DomainInfo& domain);
+
+  // Returns the Levenshtein distance between |a| and |b|. Exposed for testing.
+  static size_t EditDistance(const std::u16string& a, const std::u16string& b);
+
+ private:
+  friend class base::RefCountedThreadSafe<EngagedSiteIndex>;
+
+  // A node of the BK-tree. The key of a child is at distance |first| of the
+  // key of its parent.
+  struct Node {
+    explicit Node(std::u16string key);
+    Node(Node&&);
+    ~Node();
+
+    std::u16string key;
+    std::vector<size_t> site_indices;
+    std::map<size_t, size_t> children;
+  };
+
+  ~EngagedSiteIndex();
+
+  // Returns the keys under which |domain| is stored in the BK-tree, and looked
+  // up: all the strings GetMatchingDomain() computes edit distances of.
+  static std::set<std::u16string> GetNearMatchKeys(const DomainInfo& domain);
+
+  void InsertIntoTree(const std::u16string& key, size_t site_index);
+  void FindInTree(const std::u16string& key,
+                  size_t max_distance,
+                  std::set<size_t>* site_indices) const;
+
+  const std::vector<DomainInfo> sites_;
+  std::unordered_set<std::string> domains_;
+  std::unordered_map<std::string, std::vector<size_t>> sites_by_skeleton_;
+
+  // The BK-tree, rooted at the first node.
+  std::vector<Node> tree_;
+};
+
+#endif  // CHROME_BROWSER_LOOKALIKES_ENGAGED_SITE_INDEX_H_
@@ -0,0 +1,163 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/browser/lookalikes/engaged_site_index.h"
+#include "components/lookalikes/core/lookalike_url_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace {
+
+constexpr char kMetricPrefix[] = "EngagedSiteIndex.";
+constexpr char kMetricLinearTime[] = "linear_time_per_navigation";
+constexpr char kMetricIndexedTime[] = "indexed_time_per_navigation";
+constexpr char kMetricBuildTime[] = "build_time";
+
+constexpr size_t kNavigationCount = 500;
+
+struct MatchResult {
+  bool is_lookalike = false;
+  std::string matched_domain;
+  LookalikeUrlMatchType match_type = LookalikeUrlMatchType::kNone;
+
+  bool operator==(const MatchResult& other) const {
+    return is_lookalike == other.is_lookalike &&
+           matched_domain == other.matched_domain &&
+           match_type == other.match_type;
+  }
+};
+
+std::string GetSiteName(size_t i) {
+  static const char* const kWords[] = {"shop", "news", "mail", "bank",
+                                       "photo", "travel", "cloud", "play"};
+  return base::StringPrintf("%s%s%zu", kWords[i % 8], kWords[(i / 8) % 8], i);
+}
+
+std::vector<DomainInfo> CreateEngagedSites(size_t count) {
+  std::vector<DomainInfo> sites;
+  for (size_t i = 0; i < count; ++i) {
+    sites.push_back(GetDomainInfo(
+        GURL(base::StringPrintf("https://%s.com", GetSiteName(i).c_str()))));
+  }
+  return sites;
+}
+
+// Navigations in the shape of browsing: mostly unrelated sites with a
+// subdomain, some lookalikes of engaged sites, and a few hostnames embedding
+// an engaged site.
+std::vector<DomainInfo> CreateNavigations(size_t engaged_site_count) {
+  std::vector<DomainInfo> navigations;
+  for (size_t i = 0; i < kNavigationCount; ++i) {
+    const std::string engaged = GetSiteName(i % engaged_site_count);
+    std::string host;
+    switch (i % 10) {
+      case 0:
+        host = engaged + "x.com";
+        break;
+      case 1:
+        host = engaged + "-com-login.net";
+        break;
+      default:
+        host = base::StringPrintf("www.unrelated%zu.org", i);
+        break;
+    }
+    navigations.push_back(GetDomainInfo(GURL("https://" + host)));
+  }
+  return navigations;
+}
+
+// What a navigation used to cost: a copy of the engaged sites, a scan for the
+// navigated domain, and a match against every engaged site.
+MatchResult CheckLinearly(std::vector<DomainInfo> engaged_sites,
+                          const DomainInfo& navigated_domain,
+                          const LookalikeTargetAllowlistChecker& allowlist) {
+  MatchResult result;
+  if (std::any_of(engaged_sites.begin(), engaged_sites.end(),
+                  [&navigated_domain](const DomainInfo& site) {
+                    return site.domain_and_registry ==
+                           navigated_domain.domain_and_registry;
+                  })) {
+    return result;
+  }
+  result.is_lookalike =
+      GetMatchingDomain(navigated_domain, engaged_sites, allowlist,
+                        &result.matched_domain, &result.match_type);
+  return result;
+}
+
+MatchResult CheckIndexed(scoped_refptr<const EngagedSiteIndex> engaged_sites,
+                         const DomainInfo& navigated_domain,
+                         const LookalikeTargetAllowlistChecker& allowlist) {
+  MatchResult result;
+  if (engaged_sites->IsEngaged(navigated_domain))
+    return result;
+  std::vector<DomainInfo> near_matches;
+  result.is_lookalike = GetMatchingDomain(
+      navigated_domain,
+      engaged_sites->GetMatchCandidates(navigated_domain, &near_matches),
+      allowlist, &result.matched_domain, &result.match_type);
+  return result;
+}
+
+void RunBenchmark(size_t engaged_site_count) {
+  perf_test::PerfResultReporter reporter(
+      kMetricPrefix,
+      base::StringPrintf("engaged_sites_%zu", engaged_site_count));
+  reporter.RegisterImportantMetric(kMetricLinearTime, "us");
+  reporter.RegisterImportantMetric(kMetricIndexedTime, "us");
+  reporter.RegisterImportantMetric(kMetricBuildTime, "ms");
+
+  const std::vector<DomainInfo> engaged_sites =
+      CreateEngagedSites(engaged_site_count);
+  const std::vector<DomainInfo> navigations =
+      CreateNavigations(engaged_site_count);
+  const LookalikeTargetAllowlistChecker allowlist =
+      base::BindRepeating([](const std::string&) { return false; });
+
+  std::vector<MatchResult> linear_results;
+  base::ElapsedTimer linear_timer;
+  for (const DomainInfo& navigation : navigations) {
+    linear_results.push_back(
+        CheckLinearly(engaged_sites, navigation, allowlist));
+  }
+  reporter.AddResult(kMetricLinearTime,
+                     linear_timer.Elapsed().InMicrosecondsF() /
+                         navigations.size());
+
+  base::ElapsedTimer build_timer;
+  scoped_refptr<const EngagedSiteIndex> index =
+      base::MakeRefCounted<EngagedSiteIndex>(engaged_sites);
+  reporter.AddResult(kMetricBuildTime, build_timer.Elapsed());
+
+  std::vector<MatchResult> indexed_results;
+  base::ElapsedTimer indexed_timer;
+  for (const DomainInfo& navigation : navigations)
+    indexed_results.push_back(CheckIndexed(index, navigation, allowlist));
+  reporter.AddResult(kMetricIndexedTime,
+                     indexed_timer.Elapsed().InMicrosecondsF() /
+                         navigations.size());
+
+  EXPECT_TRUE(linear_results == indexed_results);
+}
+
+}  // namespace
+
+// Measures the engaged site checks of a main frame navigation against the
+// number of engaged sites.
+TEST(EngagedSiteIndexPerfTest, NavigationLatency) {
+  for (size_t engaged_site_count : {10u, 100u, 1000u, 5000u})
+    RunBenchmark(engaged_site_count);
+}
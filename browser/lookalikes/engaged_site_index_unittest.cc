@@ -0,0 +1,127 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/lookalikes/engaged_site_index.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/scoped_refptr.h"
+#include "components/lookalikes/core/lookalike_url_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace {
+
+scoped_refptr<EngagedSiteIndex> CreateIndex(
+    const std::vector<std::string>& urls) {
+  std::vector<DomainInfo> sites;
+  for (const std::string& url : urls)
+    sites.push_back(GetDomainInfo(GURL(url)));
+  return base::MakeRefCounted<EngagedSiteIndex>(std::move(sites));
+}
+
+std::vector<std::string> GetCandidateDomains(const EngagedSiteIndex& index,
+                                             const std::string& url) {
+  std::vector<DomainInfo> near_matches;
+  std::vector<std::string> domains;
+  for (const DomainInfo& candidate :
+       index.GetMatchCandidates(GetDomainInfo(GURL(url)), &near_matches)) {
+    domains.push_back(candidate.domain_and_registry);
+  }
+  return domains;
+}
+
+}  // namespace
+
+TEST(EngagedSiteIndexTest, IsEngaged) {
+  scoped_refptr<EngagedSiteIndex> index =
+      CreateIndex({"https://www.example.com", "http://test.net"});
+  EXPECT_TRUE(index->IsEngaged(GetDomainInfo(GURL("https://example.com"))));
+  EXPECT_TRUE(index->IsEngaged(GetDomainInfo(GURL("https://a.test.net"))));
+  EXPECT_FALSE(index->IsEngaged(GetDomainInfo(GURL("https://example.net"))));
+}
+
+TEST(EngagedSiteIndexTest, EditDistance) {
+  EXPECT_EQ(0u, EngagedSiteIndex::EditDistance(u"", u""));
+  EXPECT_EQ(3u, EngagedSiteIndex::EditDistance(u"abc", u""));
+  EXPECT_EQ(1u, EngagedSiteIndex::EditDistance(u"google", u"gooogle"));
+  EXPECT_EQ(1u, EngagedSiteIndex::EditDistance(u"google", u"goog1e"));
+  EXPECT_EQ(2u, EngagedSiteIndex::EditDistance(u"google", u"gogole"));
+  EXPECT_EQ(1u, EngagedSiteIndex::EditDistance(u"café", u"cafe"));
+}
+
+TEST(EngagedSiteIndexTest, MayEmbedTarget) {
+  EXPECT_FALSE(EngagedSiteIndex::MayEmbedTarget(
+      GetDomainInfo(GURL("https://example.com"))));
+  EXPECT_FALSE(EngagedSiteIndex::MayEmbedTarget(
+      GetDomainInfo(GURL("https://www.example.co.uk"))));
+  EXPECT_FALSE(EngagedSiteIndex::MayEmbedTarget(
+      GetDomainInfo(GURL("https://login-example.com"))));
+  EXPECT_TRUE(EngagedSiteIndex::MayEmbedTarget(
+      GetDomainInfo(GURL("https://example.com.evil.net"))));
+  EXPECT_TRUE(EngagedSiteIndex::MayEmbedTarget(
+      GetDomainInfo(GURL("https://example-com-login.net"))));
+  EXPECT_TRUE(EngagedSiteIndex::MayEmbedTarget(
+      GetDomainInfo(GURL("https://www.example-co.uk.test.net"))));
+}
+
+TEST(EngagedSiteIndexTest, GetMatchCandidates) {
+  scoped_refptr<EngagedSiteIndex> index = CreateIndex(
+      {"https://testsite.com", "https://example.com", "https://other.net"});
+
+  // Edit distance and skeleton matches.
+  EXPECT_EQ(std::vector<std::string>({"testsite.com"}),
+            GetCandidateDomains(*index, "https://teestsite.com"));
+  EXPECT_EQ(std::vector<std::string>({"testsite.com"}),
+            GetCandidateDomains(*index, "https://tesţsite.com"));
+  EXPECT_EQ(std::vector<std::string>({"example.com"}),
+            GetCandidateDomains(*index, "https://www.examp1e.org"));
+  EXPECT_TRUE(GetCandidateDomains(*index, "https://unrelated.com").empty());
+
+  // Hostnames which may embed a domain are checked against every site.
+  std::vector<DomainInfo> near_matches;
+  EXPECT_EQ(&index->sites(),
+            &index->GetMatchCandidates(
+                GetDomainInfo(GURL("https://example.com-login.net")),
+                &near_matches));
+}
+
+// The candidates lead GetMatchingDomain() to the same result as the whole list.
+TEST(EngagedSiteIndexTest, MatchesLikeFullList) {
+  scoped_refptr<EngagedSiteIndex> index =
+      CreateIndex({"https://testsite.com", "https://example.com",
+                   "https://docs.example.net", "https://other.org"});
+  const LookalikeTargetAllowlistChecker in_target_allowlist =
+      base::BindRepeating([](const std::string&) { return false; });
+
+  for (const char* url :
+       {"https://teestsite.com", "https://tesţsite.com", "https://examp1e.com",
+        "https://example.org", "https://docs.examp1e.net", "https://0ther.org",
+        "https://testsite.com-login.net", "https://gooogle.com",
+        "https://unrelated.com"}) {
+    SCOPED_TRACE(url);
+    const DomainInfo navigated_domain = GetDomainInfo(GURL(url));
+
+    std::string expected_domain;
+    LookalikeUrlMatchType expected_type = LookalikeUrlMatchType::kNone;
+    const bool expected_match =
+        GetMatchingDomain(navigated_domain, index->sites(),
+                          in_target_allowlist, &expected_domain,
+                          &expected_type);
+
+    std::vector<DomainInfo> near_matches;
+    std::string domain;
+    LookalikeUrlMatchType type = LookalikeUrlMatchType::kNone;
+    EXPECT_EQ(expected_match,
+              GetMatchingDomain(
+                  navigated_domain,
+                  index->GetMatchCandidates(navigated_domain, &near_matches),
+                  in_target_allowlist, &domain, &type));
+    EXPECT_EQ(expected_domain, domain);
+    EXPECT_EQ(expected_type, type);
+  }
+}
@@ -124,7 +124,7 @@ ThrottleCheckResult LookalikeUrlNavigationThrottle::WillProcessResponse() {
                        weak_factory_.GetWeakPtr()));
     return content::NavigationThrottle::DEFER;
   }
-  return PerformChecks(service->GetLatestEngagedSites());
+  return PerformChecks(*service->GetLatestEngagedSites());
 }
 
 const char* LookalikeUrlNavigationThrottle::GetNameForLogging() {
@@ -246,8 +246,8 @@ void LookalikeUrlNavigationThrottle::OnManifestValidationResult(
 }
 
 void LookalikeUrlNavigationThrottle::PerformChecksDeferred(
-    const std::vector<DomainInfo>& engaged_sites) {
-  ThrottleCheckResult result = PerformChecks(engaged_sites);
+    scoped_refptr<const EngagedSiteIndex> engaged_sites) {
+  ThrottleCheckResult result = PerformChecks(*engaged_sites);
   if (result.action() == NavigationThrottle::DEFER) {
     // Already deferred by PerformChecks(), don't defer again. PerformChecks()
     // is responsible for scheduling the cancellation/resumption of the
@@ -262,7 +262,7 @@ void LookalikeUrlNavigationThrottle::PerformChecksDeferred(
 }
 
 ThrottleCheckResult LookalikeUrlNavigationThrottle::PerformChecks(
-    const std::vector<DomainInfo>& engaged_sites) {
+    const EngagedSiteIndex& engaged_sites) {
   // The last URL in the redirect chain must be the same as the commit URL,
   // or the navigation is a loadData navigation (where the base URL is saved in
   // the redirect chain, instead of the commit URL).
@@ -356,7 +356,7 @@ ThrottleCheckResult LookalikeUrlNavigationThrottle::PerformChecks(
 
 bool LookalikeUrlNavigationThrottle::IsLookalikeUrl(
     const GURL& url,
-    const std::vector<DomainInfo>& engaged_sites,
+    const EngagedSiteIndex& engaged_sites,
     LookalikeUrlMatchType* match_type,
     GURL* suggested_url) {
   if (!url.SchemeIsHTTPOrHTTPS()) {
@@ -406,21 +406,18 @@ bool LookalikeUrlNavigationThrottle::IsLookalikeUrl(
   // ignores the scheme which is okay since it's more conservative: If the user
   // is engaged with http://domain.test, not showing the warning on
   // https://domain.test is acceptable.
-  const auto already_engaged =
-      std::find_if(engaged_sites.begin(), engaged_sites.end(),
-                   [navigated_domain](const DomainInfo& engaged_domain) {
-                     return (navigated_domain.domain_and_registry ==
-                             engaged_domain.domain_and_registry);
-                   });
-  if (already_engaged != engaged_sites.end()) {
+  if (engaged_sites.IsEngaged(navigated_domain)) {
     return false;
   }
 
   const LookalikeTargetAllowlistChecker in_target_allowlist =
       base::BindRepeating(
           &reputation::IsTargetHostAllowlistedBySafetyTipsComponent, proto);
+  std::vector<DomainInfo> near_matches;
+  const std::vector<DomainInfo>& candidates =
+      engaged_sites.GetMatchCandidates(navigated_domain, &near_matches);
   std::string matched_domain;
-  if (GetMatchingDomain(navigated_domain, engaged_sites, in_target_allowlist,
+  if (GetMatchingDomain(navigated_domain, candidates, in_target_allowlist,
                         &matched_domain, match_type)) {
     DCHECK(!matched_domain.empty());
 
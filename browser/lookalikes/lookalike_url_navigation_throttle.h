@@ -10,10 +10,12 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/timer/elapsed_timer.h"
 #include "base/timer/timer.h"
 #include "chrome/browser/lookalikes/digital_asset_links_cross_validator.h"
+#include "chrome/browser/lookalikes/engaged_site_index.h"
 #include "chrome/browser/lookalikes/lookalike_url_blocking_page.h"
 #include "components/digital_asset_links/digital_asset_links_handler.h"
 #include "components/site_engagement/core/mojom/site_engagement_details.mojom.h"
@@ -66,17 +68,17 @@ class LookalikeUrlNavigationThrottle : public content::NavigationThrottle {
   // This function can also defer the check and schedule a
   // cancellation/resumption if additional checks need to be done such as
   // validating Digital Asset Links manifests.
-  ThrottleCheckResult PerformChecks(
-      const std::vector<DomainInfo>& engaged_sites);
+  ThrottleCheckResult PerformChecks(const EngagedSiteIndex& engaged_sites);
 
   // A void-returning variant, only used with deferred throttle results (e.g.
   // when we need to fetch engaged sites list or digital asset link manifests).
-  void PerformChecksDeferred(const std::vector<DomainInfo>& engaged_sites);
+  void PerformChecksDeferred(
+      scoped_refptr<const EngagedSiteIndex> engaged_sites);
 
   // Returns whether |url| is a lookalike, setting |match_type| and
   // |suggested_url| appropriately. Used in PerformChecks() on a per-URL basis.
   bool IsLookalikeUrl(const GURL& url,
-                      const std::vector<DomainInfo>& engaged_sites,
+                      const EngagedSiteIndex& engaged_sites,
                       LookalikeUrlMatchType* match_type,
                       GURL* suggested_url);
 
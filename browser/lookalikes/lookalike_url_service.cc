@@ -74,7 +74,7 @@ class LookalikeUrlServiceFactory : public BrowserContextKeyedServiceFactory {
 };
 
 // static
-std::vector<DomainInfo> UpdateEngagedSitesOnWorkerThread(
+scoped_refptr<const EngagedSiteIndex> UpdateEngagedSitesOnWorkerThread(
     base::Time now,
     scoped_refptr<HostContentSettingsMap> map) {
   TRACE_EVENT0("navigation",
@@ -102,7 +102,7 @@ std::vector<DomainInfo> UpdateEngagedSitesOnWorkerThread(
     new_engaged_sites.push_back(domain_info);
   }
 
-  return new_engaged_sites;
+  return base::MakeRefCounted<EngagedSiteIndex>(std::move(new_engaged_sites));
 }
 
 }  // namespace
@@ -115,7 +115,10 @@ const base::FeatureParam<base::TimeDelta>
         base::TimeDelta::FromSeconds(5)};
 
 LookalikeUrlService::LookalikeUrlService(Profile* profile)
-    : profile_(profile), clock_(base::DefaultClock::GetInstance()) {}
+    : profile_(profile),
+      clock_(base::DefaultClock::GetInstance()),
+      engaged_sites_(
+          base::MakeRefCounted<EngagedSiteIndex>(std::vector<DomainInfo>())) {}
 
 LookalikeUrlService::~LookalikeUrlService() = default;
 
@@ -157,8 +160,8 @@ void LookalikeUrlService::ForceUpdateEngagedSites(
   pending_update_complete_callbacks_.push_back(std::move(callback));
 }
 
-const std::vector<DomainInfo> LookalikeUrlService::GetLatestEngagedSites()
-    const {
+scoped_refptr<const EngagedSiteIndex>
+LookalikeUrlService::GetLatestEngagedSites() const {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   return engaged_sites_;
 }
@@ -168,12 +171,12 @@ void LookalikeUrlService::SetClockForTesting(base::Clock* clock) {
 }
 
 void LookalikeUrlService::OnUpdateEngagedSitesCompleted(
-    std::vector<DomainInfo> new_engaged_sites) {
+    scoped_refptr<const EngagedSiteIndex> new_engaged_sites) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   DCHECK(update_in_progress_);
   TRACE_EVENT0("navigation",
                "LookalikeUrlService::OnUpdateEngagedSitesCompleted");
-  engaged_sites_.swap(new_engaged_sites);
+  engaged_sites_ = std::move(new_engaged_sites);
   last_engagement_fetch_time_ = clock_->Now();
   update_in_progress_ = false;
 
@@ -10,11 +10,13 @@
 
 #include "base/callback_forward.h"
 #include "base/macros.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/metrics/field_trial_params.h"
 #include "base/sequence_checker.h"
 #include "base/task/thread_pool.h"
 #include "base/time/time.h"
+#include "chrome/browser/lookalikes/engaged_site_index.h"
 #include "components/content_settings/core/browser/host_content_settings_map.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/lookalikes/core/lookalike_url_util.h"
@@ -28,14 +30,15 @@ class Clock;
 // A service that handles operations on lookalike URLs. It can fetch the list of
 // engaged sites in a background thread and cache the results until the next
 // update. This is more efficient than fetching the list on each navigation for
-// each tab separately.
+// each tab separately. The list is published as an immutable EngagedSiteIndex,
+// shared by all the navigations checked until the next update.
 class LookalikeUrlService : public KeyedService {
  public:
   explicit LookalikeUrlService(Profile* profile);
   ~LookalikeUrlService() override;
 
   using EngagedSitesCallback =
-      base::OnceCallback<void(const std::vector<DomainInfo>&)>;
+      base::OnceCallback<void(scoped_refptr<const EngagedSiteIndex>)>;
 
   static LookalikeUrlService* Get(Profile* profile);
 
@@ -47,9 +50,9 @@ class LookalikeUrlService : public KeyedService {
   // then schedules |callback| to be called with the new list once available.
   void ForceUpdateEngagedSites(EngagedSitesCallback callback);
 
-  // Returns the _current_ list of engaged sites, without updating them if
-  // they're out of date.
-  const std::vector<DomainInfo> GetLatestEngagedSites() const;
+  // Returns the _current_ engaged sites, without updating them if they're out
+  // of date.
+  scoped_refptr<const EngagedSiteIndex> GetLatestEngagedSites() const;
 
   void SetClockForTesting(base::Clock* clock);
   base::Clock* clock() const { return clock_; }
@@ -57,12 +60,14 @@ class LookalikeUrlService : public KeyedService {
   static const base::FeatureParam<base::TimeDelta> kManifestFetchDelay;
 
  private:
-  void OnUpdateEngagedSitesCompleted(std::vector<DomainInfo> new_engaged_sites);
+  void OnUpdateEngagedSitesCompleted(
+      scoped_refptr<const EngagedSiteIndex> new_engaged_sites);
 
   Profile* profile_;
   base::Clock* clock_;
   base::Time last_engagement_fetch_time_;
-  std::vector<DomainInfo> engaged_sites_ GUARDED_BY_CONTEXT(sequence_checker_);
+  scoped_refptr<const EngagedSiteIndex> engaged_sites_
+      GUARDED_BY_CONTEXT(sequence_checker_);
 
   // Indicates that an update to the engaged sites list has been queued. Serves
   // to prevent enqueuing excessive updates.
@@ -0,0 +1,37 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/metrics/local_call_stack_profile_collector.h"
+
+#include <memory>
+#include <utility>
+
+#include "chrome/common/profiler/local_profile_sink.h"
+#include "components/metrics/call_stack_profile_collector.h"
+#include "mojo/public/cpp/bindings/self_owned_receiver.h"
+
+LocalCallStackProfileCollector::LocalCallStackProfileCollector() = default;
+
+LocalCallStackProfileCollector::~LocalCallStackProfileCollector() = default;
+
+// static
+void LocalCallStackProfileCollector::Create(
+    mojo::PendingReceiver<metrics::mojom::CallStackProfileCollector>
+        receiver) {
+  if (!LocalProfileSink::Get()) {
+    metrics::CallStackProfileCollector::Create(std::move(receiver));
+    return;
+  }
+  mojo::MakeSelfOwnedReceiver(
+      std::make_unique<LocalCallStackProfileCollector>(), std::move(receiver));
+}
+
+void LocalCallStackProfileCollector::Collect(
+    base::TimeTicks start_timestamp,
+    metrics::mojom::SampledProfilePtr profile) {
+  // Profiles are only kept locally: local profiling samples far more than
+  // the metrics pipeline expects.
+  LocalProfileSink::Get()->AddSerializedProfile(start_timestamp,
+                                                profile->contents);
+}
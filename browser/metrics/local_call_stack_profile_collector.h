@@ -0,0 +1,36 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_METRICS_LOCAL_CALL_STACK_PROFILE_COLLECTOR_H_
+#define CHROME_BROWSER_METRICS_LOCAL_CALL_STACK_PROFILE_COLLECTOR_H_
+
+#include "components/metrics/public/mojom/call_stack_profile_collector.mojom.h"
+#include "mojo/public/cpp/bindings/pending_receiver.h"
+
+// Collects the stack sampling profiles of child processes in the
+// LocalProfileSink when local profiling is enabled, instead of passing them to
+// the metrics provider as metrics::CallStackProfileCollector does.
+class LocalCallStackProfileCollector
+    : public metrics::mojom::CallStackProfileCollector {
+ public:
+  LocalCallStackProfileCollector();
+  ~LocalCallStackProfileCollector() override;
+
+  LocalCallStackProfileCollector(const LocalCallStackProfileCollector&) =
+      delete;
+  LocalCallStackProfileCollector& operator=(
+      const LocalCallStackProfileCollector&) = delete;
+
+  // Binds |receiver| to a LocalCallStackProfileCollector if local profiling
+  // is enabled, otherwise to a metrics::CallStackProfileCollector.
+  static void Create(
+      mojo::PendingReceiver<metrics::mojom::CallStackProfileCollector>
+          receiver);
+
+  // metrics::mojom::CallStackProfileCollector:
+  void Collect(base::TimeTicks start_timestamp,
+               metrics::mojom::SampledProfilePtr profile) override;
+};
+
+#endif  // CHROME_BROWSER_METRICS_LOCAL_CALL_STACK_PROFILE_COLLECTOR_H_
@@ -0,0 +1,56 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/metrics/local_profile_dumper.h"
+
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/location.h"
+#include "base/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "chrome/common/chrome_switches.h"
+#include "chrome/common/profiler/local_profile_sink.h"
+
+namespace {
+
+void WriteProfiles(const LocalProfileSink* sink, const base::FilePath& path) {
+  if (!sink->WriteToFile(path))
+    DLOG(ERROR) << "Failed to write local stack profiles to " << path;
+}
+
+}  // namespace
+
+// static
+constexpr base::TimeDelta LocalProfileDumper::kDumpInterval;
+
+LocalProfileDumper::LocalProfileDumper(LocalProfileSink* sink,
+                                       const base::FilePath& path)
+    : sink_(sink),
+      path_(path),
+      file_task_runner_(base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::BEST_EFFORT,
+           base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN})) {
+  timer_.Start(FROM_HERE, kDumpInterval, this, &LocalProfileDumper::Dump);
+}
+
+LocalProfileDumper::~LocalProfileDumper() = default;
+
+// static
+std::unique_ptr<LocalProfileDumper> LocalProfileDumper::CreateIfEnabled() {
+  LocalProfileSink* sink = LocalProfileSink::Get();
+  if (!sink)
+    return nullptr;
+  const base::FilePath path =
+      base::CommandLine::ForCurrentProcess()->GetSwitchValuePath(
+          switches::kLocalStackProfilesFile);
+  if (path.empty())
+    return nullptr;
+  return std::make_unique<LocalProfileDumper>(sink, path);
+}
+
+void LocalProfileDumper::Dump() {
+  // The sink is never destroyed.
+  file_task_runner_->PostTask(FROM_HERE,
+                              base::BindOnce(&WriteProfiles, sink_, path_));
+}
@@ -0,0 +1,52 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_METRICS_LOCAL_PROFILE_DUMPER_H_
+#define CHROME_BROWSER_METRICS_LOCAL_PROFILE_DUMPER_H_
+
+#include <memory>
+
+#include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+class LocalProfileSink;
+
+// Periodically writes the profiles of the LocalProfileSink to the file given
+// by the --local-stack-profiles-file switch, as a pprof profile. The file is
+// replaced atomically, so it can be read at any time, including after the
+// browser was killed on a slow machine.
+class LocalProfileDumper {
+ public:
+  // The time between two dumps.
+  static constexpr base::TimeDelta kDumpInterval =
+      base::TimeDelta::FromMinutes(1);
+
+  LocalProfileDumper(LocalProfileSink* sink, const base::FilePath& path);
+  ~LocalProfileDumper();
+
+  LocalProfileDumper(const LocalProfileDumper&) = delete;
+  LocalProfileDumper& operator=(const LocalProfileDumper&) = delete;
+
+  // Returns a dumper if local profiling is enabled and a file is set, or null.
+  static std::unique_ptr<LocalProfileDumper> CreateIfEnabled();
+
+ private:
+  void Dump();
+
+  LocalProfileSink* const sink_;
+  const base::FilePath path_;
+
+  // Serializes the profiles and writes the file, which blocks.
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+
+  base::RepeatingTimer timer_;
+};
+
+#endif  // CHROME_BROWSER_METRICS_LOCAL_PROFILE_DUMPER_H_
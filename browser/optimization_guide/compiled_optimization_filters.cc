@@ -0,0 +1,281 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/optimization_guide/compiled_optimization_filters.h"
+
+#include <utility>
+
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/hash/hash.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/no_destructor.h"
+#include "base/pickle.h"
+#include "base/strings/strcat.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/version.h"
+#include "components/optimization_guide/core/hints_component_util.h"
+#include "components/optimization_guide/core/optimization_filter.h"
+
+namespace {
+
+// Identifies a file of compiled optimization filters.
+constexpr uint32_t kMagic = 0x4643474f;  // "OGCF"
+
+// The current version of the file format. Must be incremented every time the
+// format changes.
+constexpr int kFormatVersion = 1;
+
+// The size of an entry with empty data: its optimization type, allowlist flag,
+// hash and data length, each padded to 4 bytes by the Pickle.
+constexpr size_t kMinEntrySize = 4 * sizeof(uint32_t);
+
+// The result of loading compiled filters. Recorded in the
+// "OptimizationGuide.CompiledOptimizationFilters.LoadResult" histogram, so
+// entries should not be renumbered and numeric values should never be reused.
+enum class LoadResult {
+  kSuccess = 0,
+  kFailedReadFile = 1,
+  kFailedOtherComponent = 2,
+  kMaxValue = kFailedOtherComponent,
+};
+
+// The filters last compiled or loaded in this process.
+struct SharedFilters {
+  base::Lock lock;
+  scoped_refptr<CompiledOptimizationFilters> filters;
+};
+
+SharedFilters& GetSharedFilters() {
+  static base::NoDestructor<SharedFilters> shared_filters;
+  return *shared_filters;
+}
+
+void WriteFilterSet(
+    const google::protobuf::RepeatedPtrField<
+        optimization_guide::proto::OptimizationFilter>& filters,
+    bool is_allowlist,
+    base::Pickle* pickle) {
+  std::string data;
+  for (const auto& filter : filters) {
+    filter.SerializeToString(&data);
+    pickle->WriteInt(filter.optimization_type());
+    pickle->WriteBool(is_allowlist);
+    pickle->WriteUInt32(base::PersistentHash(data));
+    pickle->WriteData(data.data(), data.size());
+  }
+}
+
+}  // namespace
+
+CompiledOptimizationFilters::CompiledOptimizationFilters() {
+  DETACH_FROM_SEQUENCE(sequence_checker_);
+}
+
+CompiledOptimizationFilters::~CompiledOptimizationFilters() = default;
+
+// static
+std::string CompiledOptimizationFilters::GetComponentId(
+    const base::Version& component_version,
+    const base::FilePath& component_path) {
+  base::File::Info info;
+  if (!base::GetFileInfo(component_path, &info))
+    return std::string();
+  const int64_t last_modified =
+      info.last_modified.ToDeltaSinceWindowsEpoch().InMicroseconds();
+  return base::StrCat({component_version.GetString(), ":",
+                       component_path.AsUTF8Unsafe(), ":",
+                       base::NumberToString(info.size), ":",
+                       base::NumberToString(last_modified)});
+}
+
+// static
+scoped_refptr<CompiledOptimizationFilters>
+CompiledOptimizationFilters::Compile(
+    const std::string& component_id,
+    const optimization_guide::proto::Configuration& config,
+    const base::FilePath& path) {
+  DCHECK(!component_id.empty());
+  base::ElapsedTimer timer;
+
+  base::Pickle pickle;
+  pickle.WriteUInt32(kMagic);
+  pickle.WriteInt(kFormatVersion);
+  pickle.WriteString(component_id);
+  pickle.WriteInt(config.optimization_allowlists_size() +
+                  config.optimization_blacklists_size());
+  WriteFilterSet(config.optimization_allowlists(), /*is_allowlist=*/true,
+                 &pickle);
+  WriteFilterSet(config.optimization_blacklists(), /*is_allowlist=*/false,
+                 &pickle);
+  const base::StringPiece data(static_cast<const char*>(pickle.data()),
+                               pickle.size());
+
+  scoped_refptr<CompiledOptimizationFilters> filters;
+  if (!path.empty()) {
+    // On Windows, the file can't be replaced while it is still mapped, e.g. by
+    // the filters of a previous component used by another profile. The filters
+    // are then kept in memory until the next startup.
+    const bool written =
+        base::ImportantFileWriter::WriteFileAtomically(path, data);
+    base::UmaHistogramBoolean(
+        "OptimizationGuide.CompiledOptimizationFilters.WriteSucceeded",
+        written);
+    if (written)
+      filters = Load(component_id, path);
+  }
+  if (!filters) {
+    filters = base::WrapRefCounted(new CompiledOptimizationFilters());
+    filters->buffer_.assign(data.data(), data.size());
+    bool parsed = filters->Parse(filters->buffer_, component_id);
+    DCHECK(parsed);
+    if (!path.empty())
+      SetShared(filters);
+  }
+
+  base::UmaHistogramTimes(
+      "OptimizationGuide.CompiledOptimizationFilters.CompileDuration",
+      timer.Elapsed());
+  return filters;
+}
+
+// static
+scoped_refptr<CompiledOptimizationFilters> CompiledOptimizationFilters::Load(
+    const std::string& component_id,
+    const base::FilePath& path) {
+  base::ElapsedTimer timer;
+
+  auto file = std::make_unique<base::MemoryMappedFile>();
+  if (!file->Initialize(path)) {
+    base::UmaHistogramEnumeration(
+        "OptimizationGuide.CompiledOptimizationFilters.LoadResult",
+        LoadResult::kFailedReadFile);
+    return nullptr;
+  }
+
+  scoped_refptr<CompiledOptimizationFilters> filters =
+      base::WrapRefCounted(new CompiledOptimizationFilters());
+  const base::StringPiece data(reinterpret_cast<const char*>(file->data()),
+                               file->length());
+  filters->file_ = std::move(file);
+  if (!filters->Parse(data, component_id)) {
+    base::UmaHistogramEnumeration(
+        "OptimizationGuide.CompiledOptimizationFilters.LoadResult",
+        LoadResult::kFailedOtherComponent);
+    return nullptr;
+  }
+
+  base::UmaHistogramEnumeration(
+      "OptimizationGuide.CompiledOptimizationFilters.LoadResult",
+      LoadResult::kSuccess);
+  base::UmaHistogramTimes(
+      "OptimizationGuide.CompiledOptimizationFilters.LoadDuration",
+      timer.Elapsed());
+  base::UmaHistogramCounts10M(
+      "OptimizationGuide.CompiledOptimizationFilters.FileSize",
+      filters->file_->length());
+  SetShared(filters);
+  return filters;
+}
+
+// static
+scoped_refptr<CompiledOptimizationFilters>
+CompiledOptimizationFilters::GetShared(const std::string& component_id) {
+  SharedFilters& shared_filters = GetSharedFilters();
+  base::AutoLock lock(shared_filters.lock);
+  if (!shared_filters.filters ||
+      shared_filters.filters->component_id() != component_id) {
+    return nullptr;
+  }
+  return shared_filters.filters;
+}
+
+// static
+void CompiledOptimizationFilters::ResetSharedForTesting() {
+  SetShared(nullptr);
+}
+
+optimization_guide::OptimizationFilter* CompiledOptimizationFilters::GetFilter(
+    size_t index,
+    optimization_guide::OptimizationFilterStatus* out_status) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK_LT(index, entries_.size());
+
+  if (!filter_statuses_[index]) {
+    const Entry& entry = entries_[index];
+    optimization_guide::proto::OptimizationFilter filter;
+    if (base::PersistentHash(entry.data) != entry.data_hash ||
+        !filter.ParseFromArray(entry.data.data(), entry.data.size())) {
+      filter_statuses_[index] = optimization_guide::OptimizationFilterStatus::
+          kFailedServerFilterBadConfig;
+    } else {
+      optimization_guide::OptimizationFilterStatus status;
+      filters_[index] =
+          optimization_guide::ProcessOptimizationFilter(filter, &status);
+      filter_statuses_[index] = status;
+    }
+  }
+
+  *out_status = *filter_statuses_[index];
+  return filters_[index].get();
+}
+
+bool CompiledOptimizationFilters::Parse(base::StringPiece data,
+                                        const std::string& component_id) {
+  base::Pickle pickle(data.data(), data.size());
+  base::PickleIterator iterator(pickle);
+
+  uint32_t magic = 0;
+  int format_version = 0;
+  std::string file_component_id;
+  int entry_count = 0;
+  if (!iterator.ReadUInt32(&magic) || magic != kMagic ||
+      !iterator.ReadInt(&format_version) || format_version != kFormatVersion ||
+      !iterator.ReadString(&file_component_id) ||
+      file_component_id != component_id || !iterator.ReadInt(&entry_count) ||
+      entry_count < 0) {
+    return false;
+  }
+  // A corrupt count must not reserve more entries than the file can hold.
+  if (static_cast<size_t>(entry_count) > pickle.payload_size() / kMinEntrySize)
+    return false;
+
+  std::vector<Entry> entries;
+  entries.reserve(entry_count);
+  for (int i = 0; i < entry_count; ++i) {
+    int optimization_type = 0;
+    Entry entry;
+    const char* entry_data = nullptr;
+    int entry_length = 0;
+    if (!iterator.ReadInt(&optimization_type) ||
+        !optimization_guide::proto::OptimizationType_IsValid(
+            optimization_type) ||
+        !iterator.ReadBool(&entry.is_allowlist) ||
+        !iterator.ReadUInt32(&entry.data_hash) ||
+        !iterator.ReadData(&entry_data, &entry_length)) {
+      return false;
+    }
+    entry.optimization_type =
+        static_cast<optimization_guide::proto::OptimizationType>(
+            optimization_type);
+    entry.data = base::StringPiece(entry_data, entry_length);
+    entries.push_back(entry);
+  }
+
+  component_id_ = component_id;
+  entries_ = std::move(entries);
+  filters_.resize(entries_.size());
+  filter_statuses_.resize(entries_.size());
+  return true;
+}
+
+// static
+void CompiledOptimizationFilters::SetShared(
+    scoped_refptr<CompiledOptimizationFilters> filters) {
+  SharedFilters& shared_filters = GetSharedFilters();
+  base::AutoLock lock(shared_filters.lock);
+  shared_filters.filters = std::move(filters);
+}
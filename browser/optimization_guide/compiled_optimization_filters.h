@@ -0,0 +1,131 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_OPTIMIZATION_GUIDE_COMPILED_OPTIMIZATION_FILTERS_H_
+#define CHROME_BROWSER_OPTIMIZATION_GUIDE_COMPILED_OPTIMIZATION_FILTERS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/memory/ref_counted.h"
+#include "base/optional.h"
+#include "base/sequence_checker.h"
+#include "base/strings/string_piece.h"
+#include "components/optimization_guide/core/optimization_guide_enums.h"
+#include "components/optimization_guide/proto/hints.pb.h"
+
+namespace base {
+class Version;
+}  // namespace base
+
+namespace optimization_guide {
+class OptimizationFilter;
+}  // namespace optimization_guide
+
+// The optimization filters of a hints component, compiled into a file which
+// is memory-mapped on the next startups instead of decoding the component
+// again.
+//
+// The file indexes the filters by optimization type, and holds each of them
+// as a separate record, so that only the records of the filters which are
+// used are read and decoded, instead of the whole component with its hints.
+// Filters are built when first asked for, once per process: the instance is
+// shared by the hints managers of all profiles. Each record is checked
+// against a hash before it is decoded.
+//
+// A compiled file is only used for the component it was compiled from, as
+// identified by GetComponentId().
+class CompiledOptimizationFilters
+    : public base::RefCountedThreadSafe<CompiledOptimizationFilters> {
+ public:
+  // A filter of the component, in the order of the component.
+  struct Entry {
+    optimization_guide::proto::OptimizationType optimization_type;
+    bool is_allowlist;
+    // The serialized proto::OptimizationFilter.
+    base::StringPiece data;
+    uint32_t data_hash;
+  };
+
+  CompiledOptimizationFilters(const CompiledOptimizationFilters&) = delete;
+  CompiledOptimizationFilters& operator=(const CompiledOptimizationFilters&) =
+      delete;
+
+  // Returns a string identifying the hints component of |component_version|
+  // at |component_path| by its version, path, size and modification time, or
+  // an empty string if the file is missing. Blocking.
+  static std::string GetComponentId(const base::Version& component_version,
+                                    const base::FilePath& component_path);
+
+  // Compiles the filters of |config|, from the component |component_id|. If
+  // |path| isn't empty, writes them to it and returns them mapped from it, or
+  // in memory if writing fails. Otherwise returns them in memory without
+  // sharing them. Blocking.
+  static scoped_refptr<CompiledOptimizationFilters> Compile(
+      const std::string& component_id,
+      const optimization_guide::proto::Configuration& config,
+      const base::FilePath& path);
+
+  // Maps the filters compiled at |path|. Returns nullptr if the file is
+  // missing, was compiled from another component than |component_id| or with
+  // another format, or is truncated. Blocking.
+  static scoped_refptr<CompiledOptimizationFilters> Load(
+      const std::string& component_id,
+      const base::FilePath& path);
+
+  // Returns the filters of the component |component_id| last compiled or
+  // loaded in this process, if any, so that profiles share them.
+  static scoped_refptr<CompiledOptimizationFilters> GetShared(
+      const std::string& component_id);
+
+  static void ResetSharedForTesting();
+
+  const std::string& component_id() const { return component_id_; }
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  // Returns the filter of the entry at |index|, building it on first use, and
+  // sets |out_status| to the result of building it. Returns nullptr if the
+  // filter is invalid or its record doesn't match its hash. Must be called on
+  // a single sequence.
+  optimization_guide::OptimizationFilter* GetFilter(
+      size_t index,
+      optimization_guide::OptimizationFilterStatus* out_status);
+
+ private:
+  friend class base::RefCountedThreadSafe<CompiledOptimizationFilters>;
+
+  CompiledOptimizationFilters();
+  ~CompiledOptimizationFilters();
+
+  // Indexes the compiled filters in |data|, which is owned by |this|. Returns
+  // false if |data| isn't a compilation of |component_id| in the current
+  // format.
+  bool Parse(base::StringPiece data, const std::string& component_id);
+
+  static void SetShared(scoped_refptr<CompiledOptimizationFilters> filters);
+
+  // The compiled filters, either mapped from a file or in memory.
+  std::unique_ptr<base::MemoryMappedFile> file_;
+  std::string buffer_;
+
+  std::string component_id_;
+  std::vector<Entry> entries_;
+
+  // The filters built from |entries_|, and the results of building them, at
+  // the same indices.
+  std::vector<std::unique_ptr<optimization_guide::OptimizationFilter>>
+      filters_;
+  std::vector<base::Optional<optimization_guide::OptimizationFilterStatus>>
+      filter_statuses_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+};
+
+#endif  // CHROME_BROWSER_OPTIMIZATION_GUIDE_COMPILED_OPTIMIZATION_FILTERS_H_
@@ -0,0 +1,190 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/optimization_guide/compiled_optimization_filters.h"
+
+#include <limits>
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/pickle.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "base/version.h"
+#include "components/optimization_guide/core/bloom_filter.h"
+#include "components/optimization_guide/core/optimization_filter.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace {
+
+constexpr char kComponentId[] = "1.0.0:component:1234:5678";
+
+void AddBloomFilterToConfig(
+    optimization_guide::proto::OptimizationType optimization_type,
+    bool is_allowlist,
+    optimization_guide::proto::Configuration* config) {
+  optimization_guide::BloomFilter bloom_filter(7, 511);
+  bloom_filter.Add("host.com");
+  optimization_guide::proto::OptimizationFilter* filter =
+      is_allowlist ? config->add_optimization_allowlists()
+                   : config->add_optimization_blacklists();
+  filter->set_optimization_type(optimization_type);
+  filter->mutable_bloom_filter()->set_num_hash_functions(7);
+  filter->mutable_bloom_filter()->set_num_bits(511);
+  filter->mutable_bloom_filter()->set_data(
+      reinterpret_cast<const char*>(&bloom_filter.bytes()[0]),
+      bloom_filter.bytes().size());
+}
+
+class CompiledOptimizationFiltersTest : public testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    AddBloomFilterToConfig(optimization_guide::proto::NOSCRIPT,
+                           /*is_allowlist=*/true, &config_);
+    AddBloomFilterToConfig(optimization_guide::proto::LITE_PAGE_REDIRECT,
+                           /*is_allowlist=*/false, &config_);
+  }
+
+  void TearDown() override {
+    CompiledOptimizationFilters::ResetSharedForTesting();
+  }
+
+  base::FilePath path() const {
+    return temp_dir_.GetPath().AppendASCII("filters");
+  }
+
+  const optimization_guide::proto::Configuration& config() const {
+    return config_;
+  }
+
+ private:
+  base::ScopedTempDir temp_dir_;
+  optimization_guide::proto::Configuration config_;
+};
+
+}  // namespace
+
+TEST_F(CompiledOptimizationFiltersTest, CompileAndLoad) {
+  ASSERT_TRUE(
+      CompiledOptimizationFilters::Compile(kComponentId, config(), path()));
+  CompiledOptimizationFilters::ResetSharedForTesting();
+
+  scoped_refptr<CompiledOptimizationFilters> filters =
+      CompiledOptimizationFilters::Load(kComponentId, path());
+  ASSERT_TRUE(filters);
+  EXPECT_EQ(filters, CompiledOptimizationFilters::GetShared(kComponentId));
+  EXPECT_FALSE(CompiledOptimizationFilters::GetShared("2.0.0"));
+
+  ASSERT_EQ(2u, filters->entries().size());
+  EXPECT_EQ(optimization_guide::proto::NOSCRIPT,
+            filters->entries()[0].optimization_type);
+  EXPECT_TRUE(filters->entries()[0].is_allowlist);
+  EXPECT_EQ(optimization_guide::proto::LITE_PAGE_REDIRECT,
+            filters->entries()[1].optimization_type);
+  EXPECT_FALSE(filters->entries()[1].is_allowlist);
+
+  optimization_guide::OptimizationFilterStatus status;
+  optimization_guide::OptimizationFilter* filter =
+      filters->GetFilter(1, &status);
+  ASSERT_TRUE(filter);
+  EXPECT_EQ(optimization_guide::OptimizationFilterStatus::kCreatedServerFilter,
+            status);
+  EXPECT_TRUE(filter->Matches(GURL("https://host.com/page")));
+  EXPECT_FALSE(filter->Matches(GURL("https://otherhost.com/page")));
+
+  // The filter is only built once.
+  EXPECT_EQ(filter, filters->GetFilter(1, &status));
+}
+
+TEST_F(CompiledOptimizationFiltersTest, CompileInMemory) {
+  scoped_refptr<CompiledOptimizationFilters> filters =
+      CompiledOptimizationFilters::Compile(kComponentId, config(),
+                                           base::FilePath());
+  ASSERT_TRUE(filters);
+  EXPECT_EQ(2u, filters->entries().size());
+  EXPECT_FALSE(base::PathExists(path()));
+  EXPECT_FALSE(CompiledOptimizationFilters::GetShared(kComponentId));
+}
+
+TEST_F(CompiledOptimizationFiltersTest, LoadRejectsStaleOrTruncatedFiles) {
+  EXPECT_FALSE(CompiledOptimizationFilters::Load(kComponentId, path()));
+
+  ASSERT_TRUE(
+      CompiledOptimizationFilters::Compile(kComponentId, config(), path()));
+  EXPECT_FALSE(
+      CompiledOptimizationFilters::Load("2.0.0:component:1234:5678", path()));
+  // Unmap the file before rewriting it, which Windows doesn't allow otherwise.
+  CompiledOptimizationFilters::ResetSharedForTesting();
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(path(), &contents));
+  contents.resize(contents.size() / 2);
+  ASSERT_TRUE(base::WriteFile(path(), contents));
+  EXPECT_FALSE(CompiledOptimizationFilters::Load(kComponentId, path()));
+}
+
+TEST_F(CompiledOptimizationFiltersTest, LoadRejectsOversizedEntryCount) {
+  // A file of the current format whose entry count exceeds what it holds.
+  base::Pickle pickle;
+  pickle.WriteUInt32(0x4643474f);
+  pickle.WriteInt(1);
+  pickle.WriteString(kComponentId);
+  pickle.WriteInt(std::numeric_limits<int>::max());
+  ASSERT_TRUE(base::WriteFile(
+      path(), base::StringPiece(static_cast<const char*>(pickle.data()),
+                                pickle.size())));
+  EXPECT_FALSE(CompiledOptimizationFilters::Load(kComponentId, path()));
+}
+
+TEST_F(CompiledOptimizationFiltersTest, CompileInMemoryIfWriteFails) {
+  base::HistogramTester histogram_tester;
+  scoped_refptr<CompiledOptimizationFilters> filters =
+      CompiledOptimizationFilters::Compile(
+          kComponentId, config(),
+          path().AppendASCII("missing_dir").AppendASCII("filters"));
+  ASSERT_TRUE(filters);
+  EXPECT_EQ(2u, filters->entries().size());
+  EXPECT_EQ(filters, CompiledOptimizationFilters::GetShared(kComponentId));
+  histogram_tester.ExpectUniqueSample(
+      "OptimizationGuide.CompiledOptimizationFilters.WriteSucceeded", false, 1);
+}
+
+TEST_F(CompiledOptimizationFiltersTest, CorruptRecord) {
+  ASSERT_TRUE(
+      CompiledOptimizationFilters::Compile(kComponentId, config(), path()));
+  CompiledOptimizationFilters::ResetSharedForTesting();
+
+  // Flip a byte of the bloom filter of the last entry, past the padding of the
+  // file.
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(path(), &contents));
+  contents[contents.size() - 8] ^= 0xff;
+  ASSERT_TRUE(base::WriteFile(path(), contents));
+
+  scoped_refptr<CompiledOptimizationFilters> filters =
+      CompiledOptimizationFilters::Load(kComponentId, path());
+  ASSERT_TRUE(filters);
+  optimization_guide::OptimizationFilterStatus status;
+  EXPECT_TRUE(filters->GetFilter(0, &status));
+  EXPECT_FALSE(filters->GetFilter(1, &status));
+  EXPECT_EQ(optimization_guide::OptimizationFilterStatus::
+                kFailedServerFilterBadConfig,
+            status);
+}
+
+TEST_F(CompiledOptimizationFiltersTest, GetComponentId) {
+  const base::FilePath component_path =
+      path().DirName().AppendASCII("component.pb");
+  EXPECT_EQ("", CompiledOptimizationFilters::GetComponentId(
+                    base::Version("1.0.0"), component_path));
+
+  ASSERT_TRUE(base::WriteFile(component_path, "config"));
+  const std::string component_id = CompiledOptimizationFilters::GetComponentId(
+      base::Version("1.0.0"), component_path);
+  EXPECT_FALSE(component_id.empty());
+  EXPECT_NE(component_id, CompiledOptimizationFilters::GetComponentId(
+                              base::Version("2.0.0"), component_path));
+}
@@ -15,6 +15,7 @@
 #include "base/metrics/histogram_macros.h"
 #include "base/metrics/histogram_macros_local.h"
 #include "base/notreached.h"
+#include "base/path_service.h"
 #include "base/rand_util.h"
 #include "base/sequenced_task_runner.h"
 #include "base/task/post_task.h"
@@ -26,6 +27,7 @@
 #include "chrome/browser/navigation_predictor/navigation_predictor_keyed_service_factory.h"
 #include "chrome/browser/optimization_guide/optimization_guide_navigation_data.h"
 #include "chrome/browser/profiles/profile.h"
+#include "chrome/common/chrome_paths.h"
 #include "components/google/core/common/google_util.h"
 #include "components/optimization_guide/content/browser/optimization_guide_decider.h"
 #include "components/optimization_guide/core/bloom_filter.h"
@@ -65,6 +67,11 @@ namespace {
 // startup will have a newer version than it.
 constexpr char kManualConfigComponentVersion[] = "0.0.0";
 
+// The name of the file the optimization filters of the hints component are
+// compiled to, in the user data directory.
+constexpr base::FilePath::CharType kCompiledOptimizationFiltersFileName[] =
+    FILE_PATH_LITERAL("OptimizationGuideFilters");
+
 // Provides a random time delta in seconds between |kFetchRandomMinDelay| and
 // |kFetchRandomMaxDelay|.
 base::TimeDelta RandomFetchDelay() {
@@ -262,6 +269,14 @@ std::unique_ptr<optimization_guide::proto::Configuration> ReadComponentFile(
 
 }  // namespace
 
+struct OptimizationGuideHintsManager::HintsComponentContents {
+  // The configuration of the component, unless its hints weren't needed and
+  // its optimization filters were already compiled.
+  std::unique_ptr<optimization_guide::proto::Configuration> config;
+
+  scoped_refptr<CompiledOptimizationFilters> optimization_filters;
+};
+
 OptimizationGuideHintsManager::OptimizationGuideHintsManager(
     Profile* profile,
     PrefService* pref_service,
@@ -294,6 +309,12 @@ OptimizationGuideHintsManager::OptimizationGuideHintsManager(
   g_browser_process->network_quality_tracker()
       ->AddEffectiveConnectionTypeObserver(this);
 
+  base::FilePath user_data_dir;
+  if (base::PathService::Get(chrome::DIR_USER_DATA, &user_data_dir)) {
+    compiled_optimization_filters_path_ =
+        user_data_dir.Append(kCompiledOptimizationFiltersFileName);
+  }
+
   hint_cache_->Initialize(
       optimization_guide::switches::
           ShouldPurgeOptimizationGuideStoreOnStartup(),
@@ -381,11 +402,15 @@ void OptimizationGuideHintsManager::OnHintsComponentAvailable(
   // cache, so that each hint within the component can be moved into it. In the
   // case where the component's version is not newer than the optimization guide
   // store's component version, StoreUpdateData will be a nullptr and hint
-  // processing will be skipped.
+  // processing will be skipped. The component is then only decoded if its
+  // optimization filters aren't compiled yet.
   // base::Unretained(this) is safe since |this| owns |background_task_runner_|
   // and the callback will be canceled if destroyed.
+  const bool needs_hints = !!update_data;
   background_task_runner_->PostTaskAndReplyWithResult(
-      FROM_HERE, base::BindOnce(&ReadComponentFile, info),
+      FROM_HERE,
+      base::BindOnce(&OptimizationGuideHintsManager::ReadHintsComponent, info,
+                     compiled_optimization_filters_path_, needs_hints),
       base::BindOnce(&OptimizationGuideHintsManager::UpdateComponentHints,
                      ui_weak_ptr_factory_.GetWeakPtr(),
                      std::move(next_update_closure_), std::move(update_data)));
@@ -398,70 +423,90 @@ void OptimizationGuideHintsManager::OnHintsComponentAvailable(
   }
 }
 
+// static
+std::unique_ptr<OptimizationGuideHintsManager::HintsComponentContents>
+OptimizationGuideHintsManager::ReadHintsComponent(
+    const optimization_guide::HintsComponentInfo& info,
+    const base::FilePath& compiled_filters_path,
+    bool needs_hints) {
+  auto contents = std::make_unique<HintsComponentContents>();
+  const std::string component_id =
+      CompiledOptimizationFilters::GetComponentId(info.version, info.path);
+  if (!needs_hints && !component_id.empty()) {
+    // Another profile may have loaded the filters of this component already.
+    contents->optimization_filters =
+        CompiledOptimizationFilters::GetShared(component_id);
+    if (!contents->optimization_filters && !compiled_filters_path.empty()) {
+      contents->optimization_filters = CompiledOptimizationFilters::Load(
+          component_id, compiled_filters_path);
+    }
+    if (contents->optimization_filters)
+      return contents;
+  }
+
+  contents->config = ReadComponentFile(info);
+  if (contents->config && !component_id.empty()) {
+    contents->optimization_filters = CompiledOptimizationFilters::Compile(
+        component_id, *contents->config, compiled_filters_path);
+  }
+  return contents;
+}
+
 void OptimizationGuideHintsManager::ProcessOptimizationFilters(
-    const google::protobuf::RepeatedPtrField<
-        optimization_guide::proto::OptimizationFilter>&
-        allowlist_optimization_filters,
-    const google::protobuf::RepeatedPtrField<
-        optimization_guide::proto::OptimizationFilter>&
-        blocklist_optimization_filters) {
+    scoped_refptr<CompiledOptimizationFilters> filters) {
   optimization_types_with_filter_.clear();
   allowlist_optimization_filters_.clear();
   blocklist_optimization_filters_.clear();
-  ProcessOptimizationFilterSet(allowlist_optimization_filters,
-                               /*is_allowlist=*/true);
-  ProcessOptimizationFilterSet(blocklist_optimization_filters,
-                               /*is_allowlist=*/false);
-}
+  optimization_filters_ = std::move(filters);
+  if (!optimization_filters_)
+    return;
 
-void OptimizationGuideHintsManager::ProcessOptimizationFilterSet(
-    const google::protobuf::RepeatedPtrField<
-        optimization_guide::proto::OptimizationFilter>& filters,
-    bool is_allowlist) {
-  for (const auto& filter : filters) {
-    if (filter.optimization_type() !=
+  const std::vector<CompiledOptimizationFilters::Entry>& entries =
+      optimization_filters_->entries();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const CompiledOptimizationFilters::Entry& entry = entries[i];
+    if (entry.optimization_type !=
         optimization_guide::proto::TYPE_UNSPECIFIED) {
-      optimization_types_with_filter_.insert(filter.optimization_type());
+      optimization_types_with_filter_.insert(entry.optimization_type);
     }
 
     // Do not put anything in memory that we don't have registered.
-    if (registered_optimization_types_.find(filter.optimization_type()) ==
+    if (registered_optimization_types_.find(entry.optimization_type) ==
         registered_optimization_types_.end()) {
       continue;
     }
 
     optimization_guide::RecordOptimizationFilterStatus(
-        filter.optimization_type(),
+        entry.optimization_type,
         optimization_guide::OptimizationFilterStatus::kFoundServerFilterConfig);
 
     // Do not parse duplicate optimization filters.
-    if (allowlist_optimization_filters_.find(filter.optimization_type()) !=
+    if (allowlist_optimization_filters_.find(entry.optimization_type) !=
             allowlist_optimization_filters_.end() ||
-        blocklist_optimization_filters_.find(filter.optimization_type()) !=
+        blocklist_optimization_filters_.find(entry.optimization_type) !=
             blocklist_optimization_filters_.end()) {
       optimization_guide::RecordOptimizationFilterStatus(
-          filter.optimization_type(),
+          entry.optimization_type,
           optimization_guide::OptimizationFilterStatus::
               kFailedServerFilterDuplicateConfig);
       continue;
     }
 
-    // Parse optimization filter.
+    // Parse optimization filter, unless another profile already did.
     optimization_guide::OptimizationFilterStatus status;
-    std::unique_ptr<optimization_guide::OptimizationFilter>
-        optimization_filter =
-            optimization_guide::ProcessOptimizationFilter(filter, &status);
+    optimization_guide::OptimizationFilter* optimization_filter =
+        optimization_filters_->GetFilter(i, &status);
     if (optimization_filter) {
-      if (is_allowlist) {
+      if (entry.is_allowlist) {
         allowlist_optimization_filters_.insert(
-            {filter.optimization_type(), std::move(optimization_filter)});
+            {entry.optimization_type, optimization_filter});
       } else {
         blocklist_optimization_filters_.insert(
-            {filter.optimization_type(), std::move(optimization_filter)});
+            {entry.optimization_type, optimization_filter});
       }
     }
-    optimization_guide::RecordOptimizationFilterStatus(
-        filter.optimization_type(), status);
+    optimization_guide::RecordOptimizationFilterStatus(entry.optimization_type,
+                                                       status);
   }
 }
 
@@ -479,10 +524,14 @@ void OptimizationGuideHintsManager::OnHintCacheInitialized() {
             ? nullptr
             : hint_cache_->MaybeCreateUpdateDataForComponentHints(
                   base::Version(kManualConfigComponentVersion));
+    auto contents = std::make_unique<HintsComponentContents>();
+    contents->optimization_filters = CompiledOptimizationFilters::Compile(
+        kManualConfigComponentVersion, *manual_config, base::FilePath());
+    contents->config = std::move(manual_config);
     // Allow |UpdateComponentHints| to block startup so that the first
     // navigation gets the hints when a command line hint proto is provided.
     UpdateComponentHints(base::DoNothing(), std::move(update_data),
-                         std::move(manual_config));
+                         std::move(contents));
   }
 
   // If the store is available, clear all hint state so newly registered types
@@ -501,7 +550,7 @@ void OptimizationGuideHintsManager::OnHintCacheInitialized() {
 void OptimizationGuideHintsManager::UpdateComponentHints(
     base::OnceClosure update_closure,
     std::unique_ptr<optimization_guide::StoreUpdateData> update_data,
-    std::unique_ptr<optimization_guide::proto::Configuration> config) {
+    std::unique_ptr<HintsComponentContents> contents) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
   // If we get here, the component file has been processed correctly and did not
@@ -509,18 +558,18 @@ void OptimizationGuideHintsManager::UpdateComponentHints(
   pref_service_->ClearPref(
       optimization_guide::prefs::kPendingHintsProcessingVersion);
 
-  if (!config) {
+  if (!contents->config && !contents->optimization_filters) {
     MaybeRunUpdateClosure(std::move(update_closure));
     return;
   }
 
-  ProcessOptimizationFilters(config->optimization_allowlists(),
-                             config->optimization_blacklists());
+  ProcessOptimizationFilters(std::move(contents->optimization_filters));
 
-  // Don't store hints in the store if it's off the record.
-  if (update_data && !profile_->IsOffTheRecord()) {
+  // Don't store hints in the store if it's off the record. The configuration
+  // is only missing if the hints were not needed.
+  if (update_data && contents->config && !profile_->IsOffTheRecord()) {
     bool did_process_hints = hint_cache_->ProcessAndCacheHints(
-        config->mutable_hints(), update_data.get());
+        contents->config->mutable_hints(), update_data.get());
     optimization_guide::RecordProcessHintsComponentResult(
         did_process_hints
             ? optimization_guide::ProcessHintsComponentResult::kSuccess
@@ -988,9 +1037,14 @@ void OptimizationGuideHintsManager::RegisterOptimizationTypes(
           optimization_guide::switches::ParseComponentConfigFromCommandLine();
       if (manual_config->optimization_allowlists_size() > 0 ||
           manual_config->optimization_blacklists_size() > 0) {
-        ProcessOptimizationFilters(manual_config->optimization_allowlists(),
-                                   manual_config->optimization_blacklists());
+        ProcessOptimizationFilters(CompiledOptimizationFilters::Compile(
+            kManualConfigComponentVersion, *manual_config, base::FilePath()));
       }
+    } else if (optimization_filters_) {
+      // The filters of the component are compiled already: only the filters
+      // of the newly registered types need to be built.
+      ProcessOptimizationFilters(optimization_filters_);
+      MaybeRunUpdateClosure(std::move(next_update_closure_));
     } else {
       DCHECK(hints_component_info_);
       OnHintsComponentAvailable(*hints_component_info_);
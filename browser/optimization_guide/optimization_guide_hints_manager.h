@@ -13,6 +13,7 @@
 #include "base/containers/flat_map.h"
 #include "base/containers/flat_set.h"
 #include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/optional.h"
@@ -20,6 +21,7 @@
 #include "base/time/clock.h"
 #include "base/timer/timer.h"
 #include "chrome/browser/navigation_predictor/navigation_predictor_keyed_service.h"
+#include "chrome/browser/optimization_guide/compiled_optimization_filters.h"
 #include "components/optimization_guide/content/browser/optimization_guide_decider.h"
 #include "components/optimization_guide/core/hints_component_info.h"
 #include "components/optimization_guide/core/hints_fetcher.h"
@@ -193,23 +195,21 @@ class OptimizationGuideHintsManager
       OptimizationGuideHintsManagerFetchingTest,
       HintsFetched_ExternalAndroidApp_ECT_SLOW_2G_NonHTTPOrHTTPSHostsRemovedAppNotWhitelisted);
 
-  // Processes the optimization filters contained in the hints component.
+  // The contents of a hints component, read on a background thread.
+  struct HintsComponentContents;
+
+  // Reads the hints component described by |info|. Only decodes the
+  // configuration of the component if |needs_hints| or if its optimization
+  // filters aren't compiled at |compiled_filters_path| yet. Blocking.
+  static std::unique_ptr<HintsComponentContents> ReadHintsComponent(
+      const optimization_guide::HintsComponentInfo& info,
+      const base::FilePath& compiled_filters_path,
+      bool needs_hints);
+
+  // Processes the optimization filters contained in the hints component, and
+  // keeps |filters| alive as long as they are used.
   void ProcessOptimizationFilters(
-      const google::protobuf::RepeatedPtrField<
-          optimization_guide::proto::OptimizationFilter>&
-          allowlist_optimization_filters,
-      const google::protobuf::RepeatedPtrField<
-          optimization_guide::proto::OptimizationFilter>&
-          blocklist_optimization_filters);
-
-  // Process a set of optimization filters.
-  //
-  // |is_allowlist| will be used to ensure that the filters are either uses as
-  // allowlists or blocklists.
-  void ProcessOptimizationFilterSet(
-      const google::protobuf::RepeatedPtrField<
-          optimization_guide::proto::OptimizationFilter>& filters,
-      bool is_allowlist);
+      scoped_refptr<CompiledOptimizationFilters> filters);
 
   // Callback run after the hint cache is fully initialized. At this point,
   // the OptimizationGuideHintsManager is ready to process hints.
@@ -219,7 +219,7 @@ class OptimizationGuideHintsManager
   void UpdateComponentHints(
       base::OnceClosure update_closure,
       std::unique_ptr<optimization_guide::StoreUpdateData> update_data,
-      std::unique_ptr<optimization_guide::proto::Configuration> config);
+      std::unique_ptr<HintsComponentContents> contents);
 
   // Called when the hints have been fully updated with the latest hints from
   // the Component Updater. This is used as a signal during tests.
@@ -355,6 +355,10 @@ class OptimizationGuideHintsManager
   // |optimization_guide_service_|.
   base::Optional<optimization_guide::HintsComponentInfo> hints_component_info_;
 
+  // The file the optimization filters of the component are compiled to, shared
+  // by all profiles. Empty if the user data directory is unknown.
+  base::FilePath compiled_optimization_filters_path_;
+
   // The set of optimization types that have been registered with the hints
   // manager.
   //
@@ -367,16 +371,20 @@ class OptimizationGuideHintsManager
   base::flat_set<optimization_guide::proto::OptimizationType>
       optimization_types_with_filter_;
 
+  // The optimization filters of the component specified by |component_info_|,
+  // which own the filters below.
+  scoped_refptr<CompiledOptimizationFilters> optimization_filters_;
+
   // A map from optimization type to the host filter that holds the allowlist
   // for that type.
   base::flat_map<optimization_guide::proto::OptimizationType,
-                 std::unique_ptr<optimization_guide::OptimizationFilter>>
+                 optimization_guide::OptimizationFilter*>
       allowlist_optimization_filters_;
 
   // A map from optimization type to the host filter that holds the blocklist
   // for that type.
   base::flat_map<optimization_guide::proto::OptimizationType,
-                 std::unique_ptr<optimization_guide::OptimizationFilter>>
+                 optimization_guide::OptimizationFilter*>
       blocklist_optimization_filters_;
 
   // A map from URL to a map of callbacks (along with the navigation IDs that
@@ -14,10 +14,13 @@
 #include "base/test/gtest_util.h"
 #include "base/test/metrics/histogram_tester.h"
 #include "base/test/scoped_feature_list.h"
+#include "base/test/scoped_path_override.h"
 #include "chrome/browser/browser_process.h"
+#include "chrome/browser/optimization_guide/compiled_optimization_filters.h"
 #include "chrome/browser/optimization_guide/optimization_guide_navigation_data.h"
 #include "chrome/browser/optimization_guide/optimization_guide_tab_url_provider.h"
 #include "chrome/browser/optimization_guide/optimization_guide_web_contents_observer.h"
+#include "chrome/common/chrome_paths.h"
 #include "chrome/test/base/testing_profile.h"
 #include "components/data_reduction_proxy/core/common/data_reduction_proxy_pref_names.h"
 #include "components/optimization_guide/content/browser/optimization_guide_decider.h"
@@ -284,6 +287,7 @@ class OptimizationGuideHintsManagerTest
 
   void TearDown() override {
     ResetHintsManager();
+    CompiledOptimizationFilters::ResetSharedForTesting();
     optimization_guide::ProtoDatabaseProviderTestBase::TearDown();
   }
 
@@ -458,6 +462,7 @@ class OptimizationGuideHintsManagerTest
       base::test::TaskEnvironment::MainThreadType::UI,
       base::test::TaskEnvironment::TimeSource::MOCK_TIME};
   base::test::ScopedFeatureList scoped_feature_list_;
+  base::ScopedPathOverride user_data_dir_override_{chrome::DIR_USER_DATA};
   TestingProfile testing_profile_;
   std::unique_ptr<content::TestWebContentsFactory> web_contents_factory_;
   std::unique_ptr<optimization_guide::OptimizationGuideStore> hint_store_;
@@ -846,6 +851,55 @@ TEST_F(OptimizationGuideHintsManagerTest, OnNavigationStartOrRedirectNoHost) {
   histogram_tester.ExpectTotalCount("OptimizationGuide.LoadedHint.Result", 0);
 }
 
+// On a startup where the store already holds the hints of the component, the
+// optimization filters are loaded from their compiled file, and the component
+// isn't read.
+TEST_F(OptimizationGuideHintsManagerTest,
+       UpToDateStoreLoadsCompiledFiltersWithoutReadingComponent) {
+  optimization_guide::proto::Configuration config;
+  optimization_guide::BloomFilter bloom_filter(
+      kDefaultHostBloomFilterNumHashFunctions, kDefaultHostBloomFilterNumBits);
+  PopulateBloomFilterWithDefaultHost(&bloom_filter);
+  AddBloomFilterToConfig(optimization_guide::proto::LITE_PAGE_REDIRECT,
+                         bloom_filter, kDefaultHostBloomFilterNumHashFunctions,
+                         kDefaultHostBloomFilterNumBits,
+                         /*is_allowlist=*/false, &config);
+  hints_manager()->RegisterOptimizationTypes(
+      {optimization_guide::proto::LITE_PAGE_REDIRECT});
+  ProcessHints(config, "1.0.0.0");
+  EXPECT_TRUE(hints_manager()->HasLoadedOptimizationBlocklist(
+      optimization_guide::proto::LITE_PAGE_REDIRECT));
+
+  // Restart with the same store, and nothing loaded in the process.
+  CreateHintsManager(/*top_host_provider=*/nullptr);
+  CompiledOptimizationFilters::ResetSharedForTesting();
+  hints_manager()->RegisterOptimizationTypes(
+      {optimization_guide::proto::LITE_PAGE_REDIRECT});
+
+  // Make the component unreadable, keeping the size and modification time
+  // which identify it.
+  optimization_guide::HintsComponentInfo info(
+      base::Version("1.0.0.0"),
+      temp_dir().Append(FILE_PATH_LITERAL("somefile.pb")));
+  base::File::Info file_info;
+  ASSERT_TRUE(base::GetFileInfo(info.path, &file_info));
+  ASSERT_TRUE(base::WriteFile(
+      info.path, std::string(static_cast<size_t>(file_info.size), 'x')));
+  ASSERT_TRUE(base::TouchFile(info.path, file_info.last_accessed,
+                              file_info.last_modified));
+
+  base::HistogramTester histogram_tester;
+  base::RunLoop run_loop;
+  hints_manager()->ListenForNextUpdateForTesting(run_loop.QuitClosure());
+  hints_manager()->OnHintsComponentAvailable(info);
+  run_loop.Run();
+
+  histogram_tester.ExpectUniqueSample(
+      "OptimizationGuide.CompiledOptimizationFilters.LoadResult", 0, 1);
+  EXPECT_TRUE(hints_manager()->HasLoadedOptimizationBlocklist(
+      optimization_guide::proto::LITE_PAGE_REDIRECT));
+}
+
 TEST_F(OptimizationGuideHintsManagerTest,
        OptimizationFiltersAreOnlyLoadedIfTypeIsRegistered) {
   optimization_guide::proto::Configuration config;
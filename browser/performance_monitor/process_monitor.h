@@ -7,6 +7,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
@@ -99,6 +100,15 @@ class ProcessMonitor {
   void AddObserver(Observer* observer);
   void RemoveObserver(Observer* observer);
 
+  // Returns the ProcessMetadata for every Chrome processes accessible from the
+  // UI thread.
+  static std::vector<ProcessMetadata> GatherProcessesOnUIThread();
+
+  // Returns the ProcessMetadata for every Chrome processes accessible from the
+  // process thread, which is the UI thread if features::kProcessHostOnUI is
+  // enabled and the IO thread otherwise.
+  static std::vector<ProcessMetadata> GatherProcessesOnProcessThread();
+
  protected:
   ProcessMonitor();
 
@@ -113,14 +123,6 @@ class ProcessMonitor {
   void MarkProcessAsAlive(const ProcessMetadata& process_data,
                           int current_update_sequence);
 
-  // Returns the ProcessMetadata for every Chrome processes accessible from the
-  // UI thread.
-  static std::vector<ProcessMetadata> GatherProcessesOnUIThread();
-
-  // Returns the ProcessMetadata for every Chrome processes accessible from the
-  // process thread.
-  static std::vector<ProcessMetadata> GatherProcessesOnProcessThread();
-
   // Gather all the processes from both threads and then invokes GatherMetrics()
   // back on the calling thread.
   void GatherProcesses();
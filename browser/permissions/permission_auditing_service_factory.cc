@@ -52,10 +52,11 @@ KeyedService* PermissionAuditingServiceFactory::BuildServiceInstanceFor(
   base::FilePath database_path =
       context->GetPath().Append(FILE_PATH_LITERAL("Permission Auditing Logs"));
   instance->Init(database_path);
-  AfterStartupTaskUtils::PostTask(
+  AfterStartupTaskUtils::PostTaskWithPriority(
       FROM_HERE, backend_task_runner,
       base::BindOnce(&permissions::PermissionAuditingService::
                          StartPeriodicCullingOfExpiredSessions,
-                     instance->AsWeakPtr()));
+                     instance->AsWeakPtr()),
+      AfterStartupTaskUtils::Priority::kBestEffort);
   return instance;
 }
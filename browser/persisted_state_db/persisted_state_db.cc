@@ -4,12 +4,14 @@
 
 #include "chrome/browser/persisted_state_db/persisted_state_db.h"
 
+#include "base/android/application_status_listener.h"
 #include "base/android/callback_android.h"
 #include "base/android/jni_android.h"
 #include "base/android/jni_array.h"
 #include "base/android/jni_string.h"
 #include "base/bind.h"
 #include "base/callback_helpers.h"
+#include "base/time/time.h"
 #include "chrome/browser/persisted_state_db/persisted_state_db_content.pb.h"
 #include "chrome/browser/persisted_state_db/profile_proto_db_factory.h"
 #include "chrome/browser/tab/jni_headers/LevelDBPersistedDataStorage_jni.h"
@@ -17,6 +19,11 @@
 
 namespace {
 
+// Tab state is saved on every change of a tab, so saves are batched. Batches
+// are written early when the app goes to the background.
+constexpr base::TimeDelta kWriteBatchingInterval =
+    base::TimeDelta::FromMilliseconds(500);
+
 void OnUpdateCallback(
     const base::android::JavaRef<jobject>& joncomplete_for_testing,
     bool success) {
@@ -46,7 +53,12 @@ PersistedStateDB::PersistedStateDB(content::BrowserContext* browser_context)
     : proto_db_(
           ProfileProtoDBFactory<
               persisted_state_db::PersistedStateContentProto>::GetInstance()
-              ->GetForProfile(browser_context)) {}
+              ->GetForProfile(browser_context)) {
+  proto_db_->SetWriteBatchingInterval(kWriteBatchingInterval);
+  app_status_listener_ = base::android::ApplicationStatusListener::New(
+      base::BindRepeating(&PersistedStateDB::OnApplicationStateChange,
+                          weak_ptr_factory_.GetWeakPtr()));
+}
 
 PersistedStateDB::~PersistedStateDB() = default;
 
@@ -92,6 +104,14 @@ void PersistedStateDB::Destroy(JNIEnv* env) {
   proto_db_->Destroy();
 }
 
+void PersistedStateDB::OnApplicationStateChange(
+    base::android::ApplicationState state) {
+  if (state == base::android::APPLICATION_STATE_HAS_PAUSED_ACTIVITIES ||
+      state == base::android::APPLICATION_STATE_HAS_STOPPED_ACTIVITIES) {
+    proto_db_->FlushPendingWrites();
+  }
+}
+
 static void JNI_LevelDBPersistedDataStorage_Init(
     JNIEnv* env,
     const base::android::JavaParamRef<jobject>& obj,
@@ -5,10 +5,12 @@
 #ifndef CHROME_BROWSER_PERSISTED_STATE_DB_PERSISTED_STATE_DB_H_
 #define CHROME_BROWSER_PERSISTED_STATE_DB_PERSISTED_STATE_DB_H_
 
+#include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "base/android/application_status_listener.h"
 #include "base/android/scoped_java_ref.h"
 #include "base/memory/weak_ptr.h"
 #include "base/optional.h"
@@ -59,8 +61,15 @@ class PersistedStateDB {
   void Destroy(JNIEnv* env);
 
  private:
+  // Writes the batched saves before the app goes to the background, where it
+  // may be killed without notice.
+  void OnApplicationStateChange(base::android::ApplicationState state);
+
   ProfileProtoDB<persisted_state_db::PersistedStateContentProto>* proto_db_;
 
+  std::unique_ptr<base::android::ApplicationStatusListener>
+      app_status_listener_;
+
   base::WeakPtrFactory<PersistedStateDB> weak_ptr_factory_{this};
 };
 
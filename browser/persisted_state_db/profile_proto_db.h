@@ -5,6 +5,8 @@
 #ifndef CHROME_BROWSER_PERSISTED_STATE_DB_PROFILE_PROTO_DB_H_
 #define CHROME_BROWSER_PERSISTED_STATE_DB_PROFILE_PROTO_DB_H_
 
+#include <algorithm>
+#include <map>
 #include <queue>
 #include <string>
 #include <vector>
@@ -17,6 +19,8 @@
 #include "base/task/post_task.h"
 #include "base/task/thread_pool.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "chrome/browser/persisted_state_db/persisted_state_db_content.pb.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/leveldb_proto/public/proto_database.h"
@@ -24,6 +28,7 @@
 #include "content/public/browser/browser_context.h"
 #include "third_party/leveldatabase/src/include/leveldb/options.h"
 
+class ProfileProtoDBPerfTest;
 class ProfileProtoDBTest;
 
 template <typename T>
@@ -40,6 +45,11 @@ class ProfileProtoDBFactory;
 //   more generic API in
 //   leveldb_proto which requires a filter to be passed in.
 // - Is a KeyedService to support the per profile nature of the database.
+//
+// Prefix loads seek to the first key of the prefix and stop at the last one,
+// instead of filtering every key of the database. Writes may be batched with
+// SetWriteBatchingInterval() so that frequent savers cost one leveldb write
+// per interval instead of one per call.
 template <typename T>
 class ProfileProtoDB : public KeyedService {
  public:
@@ -53,6 +63,10 @@ class ProfileProtoDB : public KeyedService {
   // to ProfileProtoDB.
   using OperationCallback = base::OnceCallback<void(bool)>;
 
+  // Callback which is used when keys are acquired.
+  using KeysCallback =
+      base::OnceCallback<void(bool, std::vector<std::string>)>;
+
   // Represents an entry in the database.
   using ContentEntry = typename leveldb_proto::ProtoDatabase<T>::KeyEntryVector;
 
@@ -71,6 +85,14 @@ class ProfileProtoDB : public KeyedService {
   void LoadContentWithPrefix(const std::string& key_prefix,
                              LoadCallback callback);
 
+  // Loads the keys matching a prefix, in order, and passes them to the
+  // callback. Values are neither passed nor parsed, which makes it much cheaper
+  // than LoadContentWithPrefix() to list or count entries. Unlike
+  // LoadContentWithPrefix() this doesn't seek: every key of the database is
+  // still read, and filtered by prefix.
+  void LoadKeysWithPrefix(const std::string& key_prefix,
+                          KeysCallback callback);
+
   // Inserts a value for a given key and passes the result (success/failure) to
   // OperationCallback.
   void InsertContent(const std::string& key,
@@ -92,7 +114,19 @@ class ProfileProtoDB : public KeyedService {
   // profile).
   void Destroy() const;
 
+  // Coalesces the inserts and single entry deletions of every |interval| into
+  // one leveldb write, in which only the last operation on each key is kept.
+  // Their callbacks run once the write is committed. Loads and other deletions
+  // write pending operations first, so they see every operation issued before
+  // them. A zero |interval|, the default, writes each operation immediately.
+  void SetWriteBatchingInterval(base::TimeDelta interval);
+
+  // Writes the pending operations of the current batch, if any, without
+  // waiting for the end of the interval.
+  void FlushPendingWrites();
+
  private:
+  friend class ::ProfileProtoDBPerfTest;
   friend class ::ProfileProtoDBTest;
   template <typename U>
   friend class ::ProfileProtoDBFactory;
@@ -121,9 +155,25 @@ class ProfileProtoDB : public KeyedService {
                      bool success,
                      std::unique_ptr<std::vector<T>> content);
 
+  // Callback when keys are loaded.
+  void OnLoadKeys(const std::string& key_prefix,
+                  KeysCallback callback,
+                  bool success,
+                  std::unique_ptr<std::vector<std::string>> keys);
+
   // Callback when an operation (e.g. insert or delete) is called.
   void OnOperationCommitted(OperationCallback callback, bool success);
 
+  // Queues the insertion of |value|, or the deletion of |key| if it is null,
+  // for the next batched write.
+  void AddPendingWrite(const std::string& key,
+                       base::Optional<T> value,
+                       OperationCallback callback);
+
+  // Callback when a batch of operations is committed.
+  void OnPendingWritesCommitted(std::vector<OperationCallback> callbacks,
+                                bool success);
+
   // Returns true if initialization status of database is not yet known.
   bool InitStatusUnknown() const;
 
@@ -144,6 +194,14 @@ class ProfileProtoDB : public KeyedService {
   // |deferred_operations_| is flushed and all operations are executed.
   std::vector<base::OnceClosure> deferred_operations_;
 
+  // Batching of writes, see SetWriteBatchingInterval(). |pending_writes_| maps
+  // the keys written since the last flush to their value, or to null if they
+  // were deleted.
+  base::TimeDelta write_batching_interval_;
+  std::map<std::string, base::Optional<T>> pending_writes_;
+  std::vector<OperationCallback> pending_write_callbacks_;
+  base::OneShotTimer flush_timer_;
+
   base::WeakPtrFactory<ProfileProtoDB> weak_ptr_factory_{this};
 };
 
@@ -163,7 +221,11 @@ bool DatabasePrefixFilter(const std::string& key_prefix,
 }  // namespace
 
 template <typename T>
-ProfileProtoDB<T>::~ProfileProtoDB() = default;
+ProfileProtoDB<T>::~ProfileProtoDB() {
+  // Batched operations are still written, though their callbacks can't run.
+  if (!InitStatusUnknown() && !FailedToInit())
+    FlushPendingWrites();
+}
 
 template <typename T>
 void ProfileProtoDB<T>::LoadOneEntry(const std::string& key,
@@ -177,6 +239,7 @@ void ProfileProtoDB<T>::LoadOneEntry(const std::string& key,
         FROM_HERE,
         base::BindOnce(std::move(callback), false, std::vector<KeyAndValue>()));
   } else {
+    FlushPendingWrites();
     storage_database_->GetEntry(
         key,
         base::BindOnce(&ProfileProtoDB::OnLoadOneEntry,
@@ -195,6 +258,7 @@ void ProfileProtoDB<T>::LoadAllEntries(LoadCallback callback) {
         FROM_HERE,
         base::BindOnce(std::move(callback), false, std::vector<KeyAndValue>()));
   } else {
+    FlushPendingWrites();
     storage_database_->LoadEntries(
         base::BindOnce(&ProfileProtoDB::OnLoadContent,
                        weak_ptr_factory_.GetWeakPtr(), std::move(callback)));
@@ -213,15 +277,36 @@ void ProfileProtoDB<T>::LoadContentWithPrefix(const std::string& key_prefix,
         FROM_HERE,
         base::BindOnce(std::move(callback), false, std::vector<KeyAndValue>()));
   } else {
+    FlushPendingWrites();
+    // Passing |key_prefix| as the target prefix seeks to its first key and
+    // stops the iteration at the first key past it.
     storage_database_->LoadEntriesWithFilter(
         base::BindRepeating(&DatabasePrefixFilter, key_prefix),
-        CreateReadOptions(),
-        /* target_prefix */ "",
+        CreateReadOptions(), key_prefix,
         base::BindOnce(&ProfileProtoDB::OnLoadContent,
                        weak_ptr_factory_.GetWeakPtr(), std::move(callback)));
   }
 }
 
+template <typename T>
+void ProfileProtoDB<T>::LoadKeysWithPrefix(const std::string& key_prefix,
+                                           KeysCallback callback) {
+  if (InitStatusUnknown()) {
+    deferred_operations_.push_back(base::BindOnce(
+        &ProfileProtoDB::LoadKeysWithPrefix, weak_ptr_factory_.GetWeakPtr(),
+        key_prefix, std::move(callback)));
+  } else if (FailedToInit()) {
+    base::ThreadPool::PostTask(
+        FROM_HERE,
+        base::BindOnce(std::move(callback), false, std::vector<std::string>()));
+  } else {
+    FlushPendingWrites();
+    storage_database_->LoadKeys(base::BindOnce(
+        &ProfileProtoDB::OnLoadKeys, weak_ptr_factory_.GetWeakPtr(),
+        key_prefix, std::move(callback)));
+  }
+}
+
 // Inserts a value for a given key and passes the result (success/failure) to
 // OperationCallback.
 template <typename T>
@@ -235,6 +320,8 @@ void ProfileProtoDB<T>::InsertContent(const std::string& key,
   } else if (FailedToInit()) {
     base::ThreadPool::PostTask(FROM_HERE,
                                base::BindOnce(std::move(callback), false));
+  } else if (!write_batching_interval_.is_zero()) {
+    AddPendingWrite(key, value, std::move(callback));
   } else {
     auto contents_to_save = std::make_unique<ContentEntry>();
     contents_to_save->emplace_back(key, value);
@@ -256,6 +343,8 @@ void ProfileProtoDB<T>::DeleteOneEntry(const std::string& key,
   } else if (FailedToInit()) {
     base::ThreadPool::PostTask(FROM_HERE,
                                base::BindOnce(std::move(callback), false));
+  } else if (!write_batching_interval_.is_zero()) {
+    AddPendingWrite(key, base::nullopt, std::move(callback));
   } else {
     auto keys = std::make_unique<std::vector<std::string>>();
     keys->push_back(key);
@@ -279,6 +368,7 @@ void ProfileProtoDB<T>::DeleteContentWithPrefix(const std::string& key_prefix,
     base::ThreadPool::PostTask(FROM_HERE,
                                base::BindOnce(std::move(callback), false));
   } else {
+    FlushPendingWrites();
     storage_database_->UpdateEntriesWithRemoveFilter(
         std::make_unique<ContentEntry>(),
         std::move(base::BindRepeating(&DatabasePrefixFilter, key_prefix)),
@@ -298,6 +388,7 @@ void ProfileProtoDB<T>::DeleteAllContent(OperationCallback callback) {
     base::ThreadPool::PostTask(FROM_HERE,
                                base::BindOnce(std::move(callback), false));
   } else {
+    FlushPendingWrites();
     storage_database_->Destroy(std::move(callback));
   }
 }
@@ -307,6 +398,13 @@ void ProfileProtoDB<T>::Destroy() const {
   ProfileProtoDBFactory<T>::GetInstance()->Disassociate(browser_context_);
 }
 
+template <typename T>
+void ProfileProtoDB<T>::SetWriteBatchingInterval(base::TimeDelta interval) {
+  write_batching_interval_ = interval;
+  if (write_batching_interval_.is_zero())
+    FlushPendingWrites();
+}
+
 template <typename T>
 ProfileProtoDB<T>::ProfileProtoDB(
     content::BrowserContext* browser_context,
@@ -379,6 +477,23 @@ void ProfileProtoDB<T>::OnLoadContent(LoadCallback callback,
   std::move(callback).Run(success, std::move(results));
 }
 
+// Callback when keys are loaded.
+template <typename T>
+void ProfileProtoDB<T>::OnLoadKeys(
+    const std::string& key_prefix,
+    KeysCallback callback,
+    bool success,
+    std::unique_ptr<std::vector<std::string>> keys) {
+  std::vector<std::string> results;
+  if (success && keys) {
+    // Keys are loaded in order, so the matching ones are contiguous.
+    auto it = std::lower_bound(keys->begin(), keys->end(), key_prefix);
+    for (; it != keys->end() && DatabasePrefixFilter(key_prefix, *it); ++it)
+      results.push_back(std::move(*it));
+  }
+  std::move(callback).Run(success, std::move(results));
+}
+
 // Callback when an operation (e.g. insert or delete) is called.
 template <typename T>
 void ProfileProtoDB<T>::OnOperationCommitted(OperationCallback callback,
@@ -386,6 +501,52 @@ void ProfileProtoDB<T>::OnOperationCommitted(OperationCallback callback,
   std::move(callback).Run(success);
 }
 
+template <typename T>
+void ProfileProtoDB<T>::AddPendingWrite(const std::string& key,
+                                        base::Optional<T> value,
+                                        OperationCallback callback) {
+  pending_writes_[key] = std::move(value);
+  pending_write_callbacks_.push_back(std::move(callback));
+  if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(FROM_HERE, write_batching_interval_,
+                       base::BindOnce(&ProfileProtoDB::FlushPendingWrites,
+                                      base::Unretained(this)));
+  }
+}
+
+template <typename T>
+void ProfileProtoDB<T>::FlushPendingWrites() {
+  flush_timer_.Stop();
+  if (pending_writes_.empty())
+    return;
+
+  auto contents_to_save = std::make_unique<ContentEntry>();
+  auto keys_to_remove = std::make_unique<std::vector<std::string>>();
+  for (auto& pending_write : pending_writes_) {
+    if (pending_write.second) {
+      contents_to_save->emplace_back(pending_write.first,
+                                     std::move(*pending_write.second));
+    } else {
+      keys_to_remove->push_back(pending_write.first);
+    }
+  }
+  pending_writes_.clear();
+  std::vector<OperationCallback> callbacks;
+  callbacks.swap(pending_write_callbacks_);
+  storage_database_->UpdateEntries(
+      std::move(contents_to_save), std::move(keys_to_remove),
+      base::BindOnce(&ProfileProtoDB::OnPendingWritesCommitted,
+                     weak_ptr_factory_.GetWeakPtr(), std::move(callbacks)));
+}
+
+template <typename T>
+void ProfileProtoDB<T>::OnPendingWritesCommitted(
+    std::vector<OperationCallback> callbacks,
+    bool success) {
+  for (auto& callback : callbacks)
+    std::move(callback).Run(success);
+}
+
 // Returns true if initialization status of database is not yet known.
 template <typename T>
 bool ProfileProtoDB<T>::InitStatusUnknown() const {
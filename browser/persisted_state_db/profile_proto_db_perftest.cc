@@ -0,0 +1,217 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/barrier_closure.h"
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ptr_util.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/task/thread_pool.h"
+#include "base/test/task_environment.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/browser/persisted_state_db/persisted_state_db_content.pb.h"
+#include "chrome/browser/persisted_state_db/profile_proto_db.h"
+#include "components/leveldb_proto/public/proto_database_provider.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace {
+
+using ContentProto = persisted_state_db::PersistedStateContentProto;
+
+constexpr char kMetricPrefix[] = "ProfileProtoDB.";
+constexpr char kMetricFullScanTime[] = "full_scan_time_per_prefix_load";
+constexpr char kMetricSeekTime[] = "seek_time_per_prefix_load";
+constexpr char kMetricKeysOnlyTime[] = "keys_only_time_per_prefix_listing";
+constexpr char kMetricUnbatchedTime[] = "unbatched_time_per_write";
+constexpr char kMetricBatchedTime[] = "batched_time_per_write";
+
+// 100k entries, in as many prefixes as the tabs of a heavy user.
+constexpr size_t kPrefixCount = 1000;
+constexpr size_t kEntriesPerPrefix = 100;
+constexpr size_t kLoadCount = 20;
+constexpr size_t kWriteCount = 1000;
+
+std::string GetPrefix(size_t prefix_index) {
+  return base::StringPrintf("tab%04zu_", prefix_index);
+}
+
+std::string GetKey(size_t prefix_index, size_t entry_index) {
+  return base::StringPrintf("%sentry%03zu", GetPrefix(prefix_index).c_str(),
+                            entry_index);
+}
+
+ContentProto BuildProto(const std::string& key) {
+  ContentProto proto;
+  proto.set_key(key);
+  proto.set_content_data(std::string(256, 'x'));
+  return proto;
+}
+
+}  // namespace
+
+class ProfileProtoDBPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    db_ = base::WrapUnique(new ProfileProtoDB<ContentProto>(
+        leveldb_proto::ProtoDatabaseProvider::GetUniqueDB<ContentProto>(
+            leveldb_proto::ProtoDbType::PERSISTED_STATE_DATABASE,
+            temp_dir_.GetPath(),
+            base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock()})),
+        base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock()})));
+    // Operations wait for the initialization of the database.
+    CountKeys("");
+
+    auto entries =
+        std::make_unique<ProfileProtoDB<ContentProto>::ContentEntry>();
+    for (size_t i = 0; i < kPrefixCount; ++i) {
+      for (size_t j = 0; j < kEntriesPerPrefix; ++j) {
+        const std::string key = GetKey(i, j);
+        entries->emplace_back(key, BuildProto(key));
+      }
+    }
+    base::RunLoop run_loop;
+    db_->storage_database_->UpdateEntries(
+        std::move(entries), std::make_unique<std::vector<std::string>>(),
+        base::BindOnce(
+            [](base::OnceClosure closure, bool success) {
+              EXPECT_TRUE(success);
+              std::move(closure).Run();
+            },
+            run_loop.QuitClosure()));
+    run_loop.Run();
+  }
+
+  // Loads a prefix the way LoadContentWithPrefix() used to, by filtering all
+  // the entries of the database.
+  size_t LoadWithFullScan(const std::string& key_prefix) {
+    size_t count = 0;
+    base::RunLoop run_loop;
+    db_->storage_database_->LoadEntriesWithFilter(
+        base::BindRepeating(&DatabasePrefixFilter, key_prefix),
+        CreateReadOptions(), /* target_prefix */ "",
+        base::BindOnce(
+            [](base::OnceClosure closure, size_t* count, bool success,
+               std::unique_ptr<std::vector<ContentProto>> entries) {
+              *count = entries->size();
+              std::move(closure).Run();
+            },
+            run_loop.QuitClosure(), &count));
+    run_loop.Run();
+    return count;
+  }
+
+  size_t LoadWithSeek(const std::string& key_prefix) {
+    size_t count = 0;
+    base::RunLoop run_loop;
+    db_->LoadContentWithPrefix(
+        key_prefix,
+        base::BindOnce(
+            [](base::OnceClosure closure, size_t* count, bool success,
+               std::vector<ProfileProtoDB<ContentProto>::KeyAndValue> entries) {
+              *count = entries.size();
+              std::move(closure).Run();
+            },
+            run_loop.QuitClosure(), &count));
+    run_loop.Run();
+    return count;
+  }
+
+  size_t CountKeys(const std::string& key_prefix) {
+    size_t count = 0;
+    base::RunLoop run_loop;
+    db_->LoadKeysWithPrefix(
+        key_prefix, base::BindOnce(
+                        [](base::OnceClosure closure, size_t* count,
+                           bool success, std::vector<std::string> keys) {
+                          *count = keys.size();
+                          std::move(closure).Run();
+                        },
+                        run_loop.QuitClosure(), &count));
+    run_loop.Run();
+    return count;
+  }
+
+  // Rewrites the first entry of |kWriteCount| prefixes, as tabs being saved,
+  // and waits for all the writes to be committed.
+  void Write() {
+    base::RunLoop run_loop;
+    base::RepeatingClosure barrier =
+        base::BarrierClosure(kWriteCount, run_loop.QuitClosure());
+    for (size_t i = 0; i < kWriteCount; ++i) {
+      const std::string key = GetKey(i % kPrefixCount, 0);
+      db_->InsertContent(key, BuildProto(key),
+                         base::BindOnce(
+                             [](base::RepeatingClosure barrier, bool success) {
+                               EXPECT_TRUE(success);
+                               barrier.Run();
+                             },
+                             barrier));
+    }
+    // Flushes the batch, if any.
+    db_->SetWriteBatchingInterval(base::TimeDelta());
+    run_loop.Run();
+  }
+
+  ProfileProtoDB<ContentProto>* db() { return db_.get(); }
+
+ private:
+  base::test::TaskEnvironment task_environment_;
+  base::ScopedTempDir temp_dir_;
+  std::unique_ptr<ProfileProtoDB<ContentProto>> db_;
+};
+
+// Measures prefix loads and listings of a database of 100k entries, and
+// writes with and without batching.
+TEST_F(ProfileProtoDBPerfTest, PrefixScansAndWrites) {
+  perf_test::PerfResultReporter reporter(
+      kMetricPrefix,
+      base::StringPrintf("entries_%zu", kPrefixCount * kEntriesPerPrefix));
+  reporter.RegisterImportantMetric(kMetricFullScanTime, "ms");
+  reporter.RegisterImportantMetric(kMetricSeekTime, "ms");
+  reporter.RegisterImportantMetric(kMetricKeysOnlyTime, "ms");
+  reporter.RegisterImportantMetric(kMetricUnbatchedTime, "us");
+  reporter.RegisterImportantMetric(kMetricBatchedTime, "us");
+
+  base::ElapsedTimer full_scan_timer;
+  for (size_t i = 0; i < kLoadCount; ++i)
+    EXPECT_EQ(kEntriesPerPrefix, LoadWithFullScan(GetPrefix(i * 37)));
+  reporter.AddResult(kMetricFullScanTime,
+                     full_scan_timer.Elapsed().InMillisecondsF() / kLoadCount);
+
+  base::ElapsedTimer seek_timer;
+  for (size_t i = 0; i < kLoadCount; ++i)
+    EXPECT_EQ(kEntriesPerPrefix, LoadWithSeek(GetPrefix(i * 37)));
+  reporter.AddResult(kMetricSeekTime,
+                     seek_timer.Elapsed().InMillisecondsF() / kLoadCount);
+
+  base::ElapsedTimer keys_only_timer;
+  for (size_t i = 0; i < kLoadCount; ++i)
+    EXPECT_EQ(kEntriesPerPrefix, CountKeys(GetPrefix(i * 37)));
+  reporter.AddResult(kMetricKeysOnlyTime,
+                     keys_only_timer.Elapsed().InMillisecondsF() / kLoadCount);
+
+  base::ElapsedTimer unbatched_timer;
+  Write();
+  reporter.AddResult(kMetricUnbatchedTime,
+                     unbatched_timer.Elapsed().InMicrosecondsF() / kWriteCount);
+
+  db()->SetWriteBatchingInterval(base::TimeDelta::FromHours(1));
+  base::ElapsedTimer batched_timer;
+  Write();
+  reporter.AddResult(kMetricBatchedTime,
+                     batched_timer.Elapsed().InMicrosecondsF() / kWriteCount);
+
+  EXPECT_EQ(kPrefixCount * kEntriesPerPrefix, CountKeys(""));
+}
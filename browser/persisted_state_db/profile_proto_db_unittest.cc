@@ -5,11 +5,14 @@
 #include "chrome/browser/persisted_state_db/profile_proto_db.h"
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/memory/ptr_util.h"
 #include "base/task/thread_pool.h"
 #include "base/test/task_environment.h"
+#include "base/time/time.h"
 #include "components/leveldb_proto/testing/fake_db.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -542,3 +545,76 @@ TEST_F(ProfileProtoDBTest, TestInitializationFailure) {
     run_loop[i].Run();
   }
 }
+
+TEST_F(ProfileProtoDBTest, TestLoadKeysWithPrefix) {
+  InitPersistedStateDB();
+  content_db_storage_[kMockKeyA] = kMockValueA;
+  content_db_storage_[kMockKeyB] = kMockValueB;
+  base::RunLoop run_loop;
+  persisted_state_db()->LoadKeysWithPrefix(
+      kMockKeyPrefixA,
+      base::BindOnce(
+          [](base::OnceClosure closure, bool success,
+             std::vector<std::string> keys) {
+            EXPECT_TRUE(success);
+            EXPECT_EQ(std::vector<std::string>({kMockKeyA}), keys);
+            std::move(closure).Run();
+          },
+          run_loop.QuitClosure()));
+  content_db()->LoadKeysCallback(true);
+  RunUntilIdle();
+  run_loop.Run();
+}
+
+TEST_F(ProfileProtoDBTest, TestWriteBatching) {
+  InitPersistedStateDB();
+  persisted_state_db()->SetWriteBatchingInterval(base::TimeDelta::FromHours(1));
+  base::RunLoop run_loop[4];
+  persisted_state_db()->InsertContent(
+      kMockKeyA, kMockValueA,
+      base::BindOnce(&ProfileProtoDBTest::OperationEvaluation,
+                     base::Unretained(this), run_loop[0].QuitClosure(), true));
+  persisted_state_db()->InsertContent(
+      kMockKeyB, kMockValueB,
+      base::BindOnce(&ProfileProtoDBTest::OperationEvaluation,
+                     base::Unretained(this), run_loop[1].QuitClosure(), true));
+  persisted_state_db()->DeleteOneEntry(
+      kMockKeyA,
+      base::BindOnce(&ProfileProtoDBTest::OperationEvaluation,
+                     base::Unretained(this), run_loop[2].QuitClosure(), true));
+  RunUntilIdle();
+  // Nothing is written until the batch is flushed.
+  EXPECT_TRUE(content_db_storage_.empty());
+
+  // Loading flushes the batch in a single write, in which the deletion of A
+  // wins over its insertion.
+  persisted_state_db()->LoadAllEntries(
+      base::BindOnce(&ProfileProtoDBTest::GetEvaluationPersistedStateDB,
+                     base::Unretained(this), run_loop[3].QuitClosure(),
+                     kExpectedB));
+  MockInsertCallbackPersistedStateDB(content_db(), true);
+  EXPECT_EQ(1u, content_db_storage_.size());
+  EXPECT_EQ(1u, content_db_storage_.count(kMockKeyB));
+  MockLoadCallbackPersistedStateDB(content_db(), true);
+  for (int i = 0; i < 4; i++) {
+    run_loop[i].Run();
+  }
+}
+
+TEST_F(ProfileProtoDBTest, TestFlushPendingWrites) {
+  InitPersistedStateDB();
+  persisted_state_db()->SetWriteBatchingInterval(base::TimeDelta::FromHours(1));
+  base::RunLoop run_loop;
+  persisted_state_db()->InsertContent(
+      kMockKeyA, kMockValueA,
+      base::BindOnce(&ProfileProtoDBTest::OperationEvaluation,
+                     base::Unretained(this), run_loop.QuitClosure(), true));
+  RunUntilIdle();
+  EXPECT_TRUE(content_db_storage_.empty());
+
+  // A flush writes the batch without waiting for the end of the interval.
+  persisted_state_db()->FlushPendingWrites();
+  MockInsertCallbackPersistedStateDB(content_db(), true);
+  EXPECT_EQ(1u, content_db_storage_.count(kMockKeyA));
+  run_loop.Run();
+}
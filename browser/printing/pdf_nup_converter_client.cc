@@ -45,6 +45,24 @@ void PdfNupConverterClient::DoNupPdfDocumentConvert(
                      std::move(callback)));
 }
 
+void PdfNupConverterClient::DoNupPdfSheetsConvert(
+    int document_cookie,
+    uint32_t pages_per_sheet,
+    const gfx::Size& page_size,
+    const gfx::Rect& printable_area,
+    std::vector<base::ReadOnlySharedMemoryRegion> pdf_page_regions,
+    mojom::PdfNupConverter::NupSheetsConvertCallback callback) {
+  // The sheets of a previous document won't be converted again.
+  if (!pdf_nup_sheets_converter_ ||
+      pdf_nup_sheets_converter_cookie_ != document_cookie) {
+    pdf_nup_sheets_converter_ = CreatePdfNupConverterRemote();
+    pdf_nup_sheets_converter_cookie_ = document_cookie;
+  }
+  pdf_nup_sheets_converter_->NupSheetsConvert(
+      pages_per_sheet, page_size, printable_area, std::move(pdf_page_regions),
+      std::move(callback));
+}
+
 void PdfNupConverterClient::OnDidNupPdfDocumentConvert(
     int document_cookie,
     mojom::PdfNupConverter::NupDocumentConvertCallback callback,
@@ -38,6 +38,17 @@ class PdfNupConverterClient
       const gfx::Rect& printable_area,
       base::ReadOnlySharedMemoryRegion src_pdf_document,
       mojom::PdfNupConverter::NupDocumentConvertCallback callback);
+  // Like DoNupPdfConvert(), but the converter for |document_cookie| keeps the
+  // converted sheets, so that repeated calls with updated settings only redo
+  // the sheets that changed. Only the converter of the latest document cookie
+  // is kept, and it outlives DoNupPdfDocumentConvert() for that cookie.
+  void DoNupPdfSheetsConvert(
+      int document_cookie,
+      uint32_t pages_per_sheet,
+      const gfx::Size& page_size,
+      const gfx::Rect& printable_area,
+      std::vector<base::ReadOnlySharedMemoryRegion> pdf_page_regions,
+      mojom::PdfNupConverter::NupSheetsConvertCallback callback);
 
  private:
   friend class content::WebContentsUserData<PdfNupConverterClient>;
@@ -59,6 +70,11 @@ class PdfNupConverterClient
   // mojo::Remote.
   std::map<int, mojo::Remote<mojom::PdfNupConverter>> pdf_nup_converter_map_;
 
+  // The converter used by DoNupPdfSheetsConvert(), which caches the sheets of
+  // the document |pdf_nup_sheets_converter_cookie_|.
+  mojo::Remote<mojom::PdfNupConverter> pdf_nup_sheets_converter_;
+  int pdf_nup_sheets_converter_cookie_ = 0;
+
   content::WebContents* web_contents_;
 
   WEB_CONTENTS_USER_DATA_KEY_DECL();
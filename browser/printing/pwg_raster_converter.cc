@@ -37,6 +37,10 @@ namespace {
 using content::BrowserThread;
 
 // Converts PDF into PWG raster. Class lives on the UI thread.
+//
+// Uses Convert() rather than ConvertStreaming(): ResultCallback takes the
+// whole document in one region, and gathering streamed pages into one would
+// need the memory of the document twice.
 class PwgRasterConverterHelper
     : public base::RefCounted<PwgRasterConverterHelper> {
  public:
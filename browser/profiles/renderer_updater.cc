@@ -4,16 +4,16 @@
 
 #include "chrome/browser/profiles/renderer_updater.h"
 
+#include <memory>
 #include <utility>
 
 #include "base/bind.h"
 #include "build/chromeos_buildflags.h"
-#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
+#include "chrome/browser/content_settings/renderer_content_setting_rules_publisher.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/browser/signin/identity_manager_factory.h"
 #include "chrome/common/pref_names.h"
 #include "chrome/common/renderer_configuration.mojom.h"
-#include "components/content_settings/core/browser/content_settings_utils.h"
 #include "components/content_settings/core/common/content_settings_utils.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_process_host.h"
@@ -102,6 +102,8 @@ void RendererUpdater::Shutdown() {
 #endif
   identity_manager_observer_.RemoveAll();
   identity_manager_ = nullptr;
+  profile_observations_.RemoveAllObservations();
+  content_setting_rules_publishers_.clear();
 }
 
 void RendererUpdater::InitializeRenderer(
@@ -126,18 +128,32 @@ void RendererUpdater::InitializeRenderer(
 
   UpdateRenderer(&renderer_configuration);
 
-  RendererContentSettingRules rules;
   if (render_process_host->IsForGuestsOnly()) {
 #if BUILDFLAG(ENABLE_EXTENSIONS)
+    RendererContentSettingRules rules;
     GetGuestViewDefaultContentSettingRules(is_incognito_process, &rules);
+    renderer_configuration->SetContentSettingRules(rules);
 #else
     NOTREACHED();
 #endif
-  } else {
-    content_settings::GetRendererContentSettingRules(
-        HostContentSettingsMapFactory::GetForProfile(profile), &rules);
+    return;
+  }
+  GetContentSettingRulesPublisher(profile)->InitializeRenderer(
+      renderer_configuration.get());
+}
+
+void RendererUpdater::SetContentSettingRules(
+    content::RenderProcessHost* render_process_host,
+    const RendererContentSettingRules& rules) {
+  if (render_process_host->IsForGuestsOnly()) {
+    auto renderer_configuration = GetRendererConfiguration(render_process_host);
+    if (renderer_configuration)
+      renderer_configuration->SetContentSettingRules(rules);
+    return;
   }
-  renderer_configuration->SetContentSettingRules(rules);
+  GetContentSettingRulesPublisher(
+      Profile::FromBrowserContext(render_process_host->GetBrowserContext()))
+      ->PublishRules(rules);
 }
 
 std::vector<mojo::AssociatedRemote<chrome::mojom::RendererConfiguration>>
@@ -196,6 +212,24 @@ void RendererUpdater::OnPrimaryAccountChanged(
   UpdateAllRenderers();
 }
 
+void RendererUpdater::OnProfileWillBeDestroyed(Profile* profile) {
+  profile_observations_.RemoveObservation(profile);
+  content_setting_rules_publishers_.erase(profile);
+}
+
+RendererContentSettingRulesPublisher*
+RendererUpdater::GetContentSettingRulesPublisher(Profile* profile) {
+  DCHECK_EQ(profile_, profile->GetOriginalProfile());
+  std::unique_ptr<RendererContentSettingRulesPublisher>& publisher =
+      content_setting_rules_publishers_[profile];
+  if (!publisher) {
+    publisher = std::make_unique<RendererContentSettingRulesPublisher>(profile);
+    if (profile != profile_)
+      profile_observations_.AddObservation(profile);
+  }
+  return publisher.get();
+}
+
 void RendererUpdater::UpdateAllRenderers() {
   auto renderer_configurations = GetRendererConfigurations();
   for (auto& renderer_configuration : renderer_configurations)
@@ -5,11 +5,15 @@
 #ifndef CHROME_BROWSER_PROFILES_RENDERER_UPDATER_H_
 #define CHROME_BROWSER_PROFILES_RENDERER_UPDATER_H_
 
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "base/scoped_multi_source_observation.h"
 #include "base/scoped_observer.h"
 #include "build/chromeos_buildflags.h"
+#include "chrome/browser/profiles/profile_observer.h"
 #include "chrome/common/renderer_configuration.mojom-forward.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/prefs/pref_change_registrar.h"
@@ -23,6 +27,8 @@
 #endif
 
 class Profile;
+class RendererContentSettingRulesPublisher;
+struct RendererContentSettingRules;
 
 namespace content {
 class RenderProcessHost;
@@ -33,7 +39,8 @@ class RendererUpdater : public KeyedService,
 #if BUILDFLAG(IS_CHROMEOS_ASH)
                         public chromeos::OAuth2LoginManager::Observer,
 #endif
-                        public signin::IdentityManager::Observer {
+                        public signin::IdentityManager::Observer,
+                        public ProfileObserver {
  public:
   explicit RendererUpdater(Profile* profile);
   RendererUpdater(const RendererUpdater&) = delete;
@@ -46,6 +53,12 @@ class RendererUpdater : public KeyedService,
   // Initialize a newly-started renderer process.
   void InitializeRenderer(content::RenderProcessHost* render_process_host);
 
+  // Sends |rules| to |render_process_host|. Renderers of the same profile
+  // share the rules, so this only sends what changed since the rules were
+  // last sent to them.
+  void SetContentSettingRules(content::RenderProcessHost* render_process_host,
+                              const RendererContentSettingRules& rules);
+
  private:
   std::vector<mojo::AssociatedRemote<chrome::mojom::RendererConfiguration>>
   GetRendererConfigurations();
@@ -64,6 +77,14 @@ class RendererUpdater : public KeyedService,
   void OnPrimaryAccountChanged(
       const signin::PrimaryAccountChangeEvent& event) override;
 
+  // ProfileObserver:
+  void OnProfileWillBeDestroyed(Profile* profile) override;
+
+  // Returns the publisher of the content setting rules of |profile|, which is
+  // |profile_| or one of its off the record profiles.
+  RendererContentSettingRulesPublisher* GetContentSettingRulesPublisher(
+      Profile* profile);
+
   // Update all renderers due to a configuration change.
   void UpdateAllRenderers();
 
@@ -89,6 +110,12 @@ class RendererUpdater : public KeyedService,
   ScopedObserver<signin::IdentityManager, signin::IdentityManager::Observer>
       identity_manager_observer_;
   signin::IdentityManager* identity_manager_;
+
+  std::map<Profile*, std::unique_ptr<RendererContentSettingRulesPublisher>>
+      content_setting_rules_publishers_;
+  // Observes the off the record profiles with a publisher.
+  base::ScopedMultiSourceObservation<Profile, ProfileObserver>
+      profile_observations_{this};
 };
 
 #endif  // CHROME_BROWSER_PROFILES_RENDERER_UPDATER_H_
@@ -4,6 +4,7 @@
 
 #include "chrome/browser/profiles/renderer_updater_factory.h"
 
+#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/browser/profiles/renderer_updater.h"
 #include "chrome/browser/signin/identity_manager_factory.h"
@@ -13,6 +14,7 @@ RendererUpdaterFactory::RendererUpdaterFactory()
     : BrowserContextKeyedServiceFactory(
           "RendererUpdater",
           BrowserContextDependencyManager::GetInstance()) {
+  DependsOn(HostContentSettingsMapFactory::GetInstance());
   DependsOn(IdentityManagerFactory::GetInstance());
 }
 
@@ -4,8 +4,13 @@
 
 #include "chrome/browser/profiling_host/background_profiling_triggers.h"
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 #include "base/bind.h"
 #include "base/containers/contains.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/rand_util.h"
 #include "base/task/post_task.h"
 #include "build/build_config.h"
@@ -35,6 +40,9 @@ const size_t kUtilityProcessMallocTriggerKb = 40 * 1024;     // 40 MB
 
 // If memory usage has increased by 50MB since the last report, send another.
 const uint32_t kHighWaterMarkThresholdKb = 50 * 1024;  // 50 MB
+
+// Minimal time between two reports of the same trigger.
+constexpr base::TimeDelta kReportCooldown = base::TimeDelta::FromHours(2);
 #else
 // Check memory usage every 15 minutes.
 const int kRepeatingCheckMemoryDelayInMinutes = 15;
@@ -46,8 +54,14 @@ const size_t kUtilityProcessMallocTriggerKb = 250 * 1024;    // 250 MB
 
 // If memory usage has increased by 500MB since the last report, send another.
 const uint32_t kHighWaterMarkThresholdKb = 500 * 1024;  // 500 MB
+
+// Minimal time between two reports of the same trigger.
+constexpr base::TimeDelta kReportCooldown = base::TimeDelta::FromHours(12);
 #endif  // OS_ANDROID
 
+const char kThresholdTriggerName[] = "MEMLOG_BACKGROUND_TRIGGER";
+const char kGrowthTriggerName[] = "MEMLOG_BACKGROUND_GROWTH_TRIGGER";
+
 int GetContentProcessType(
     const memory_instrumentation::mojom::ProcessType& type) {
   using memory_instrumentation::mojom::ProcessType;
@@ -81,7 +95,7 @@ int GetContentProcessType(
 
 BackgroundProfilingTriggers::BackgroundProfilingTriggers(
     ProfilingProcessHost* host)
-    : host_(host) {
+    : growth_detector_(MemoryGrowthDetector::GetDefaultParams()), host_(host) {
   DCHECK(host_);
 }
 
@@ -127,6 +141,15 @@ bool BackgroundProfilingTriggers::IsOverTriggerThreshold(
   }
 }
 
+bool BackgroundProfilingTriggers::ShouldReport(const std::string& trigger_name,
+                                               base::TimeTicks now) {
+  auto it = last_report_times_.find(trigger_name);
+  if (it != last_report_times_.end() && now - it->second < kReportCooldown)
+    return false;
+  last_report_times_[trigger_name] = now;
+  return true;
+}
+
 void BackgroundProfilingTriggers::PerformMemoryUsageChecks() {
   DCHECK(content::BrowserThread::CurrentlyOn(content::BrowserThread::UI));
 
@@ -158,43 +181,85 @@ void BackgroundProfilingTriggers::OnReceivedMemoryDump(
     return;
   }
 
-  // Detect whether memory footprint is too high and send a memlog report.
-  bool should_send_report = false;
+  // Detect whether memory footprint is too high or growing too fast, and send
+  // a memlog report.
+  const base::TimeTicks now = base::TimeTicks::Now();
+  // The footprints of the processes which crossed their watermark, or the
+  // trigger threshold. The watermarks only move once a report is sent, so that
+  // a crossing during the cooldown is reported after it.
+  std::map<base::ProcessId, uint32_t> crossed_pmfs;
+  // The processes growing too fast. Their series are only restarted once a
+  // report is sent, so that a growth during the cooldown is reported after it.
+  std::vector<base::ProcessId> growing_pids;
   for (const auto& proc : dump->process_dumps()) {
     if (!base::Contains(profiled_pids, proc.pid()))
       continue;
 
     uint32_t private_footprint_kb = proc.os_dump().private_footprint_kb;
+    const int content_process_type =
+        GetContentProcessType(proc.process_type());
+
+    MemoryGrowthDetector::Trend trend;
+    MemoryGrowthDetector::Decision decision = growth_detector_.AddSample(
+        proc.pid(), content_process_type, now, private_footprint_kb, &trend);
+    if (decision != MemoryGrowthDetector::Decision::kNotMonitored) {
+      UMA_HISTOGRAM_ENUMERATION("HeapProfiling.GrowthDetector.Decision",
+                                decision);
+    }
+    if (decision == MemoryGrowthDetector::Decision::kBelowLimit ||
+        decision == MemoryGrowthDetector::Decision::kNotSustained ||
+        decision == MemoryGrowthDetector::Decision::kGrowthDetected) {
+      UMA_HISTOGRAM_COUNTS_1M("HeapProfiling.GrowthDetector.GrowthKbPerHour",
+                              std::max(0.0, trend.growth_kb_per_hour));
+    }
+    if (decision == MemoryGrowthDetector::Decision::kGrowthDetected)
+      growing_pids.push_back(proc.pid());
+
     auto it = pmf_at_last_upload_.find(proc.pid());
     if (it != pmf_at_last_upload_.end()) {
-      if (private_footprint_kb > it->second + kHighWaterMarkThresholdKb) {
-        should_send_report = true;
-        it->second = private_footprint_kb;
-      }
+      if (private_footprint_kb > it->second + kHighWaterMarkThresholdKb)
+        crossed_pmfs[proc.pid()] = private_footprint_kb;
       continue;
     }
 
     // No high water mark exists yet, check the trigger threshold.
-    if (IsOverTriggerThreshold(GetContentProcessType(proc.process_type()),
-                               private_footprint_kb)) {
-      should_send_report = true;
-      pmf_at_last_upload_[proc.pid()] = private_footprint_kb;
-    }
+    if (IsOverTriggerThreshold(content_process_type, private_footprint_kb))
+      crossed_pmfs[proc.pid()] = private_footprint_kb;
   }
 
-  if (should_send_report) {
-    // Clear the watermark for all non-profiled pids.
-    for (auto it = pmf_at_last_upload_.begin();
-         it != pmf_at_last_upload_.end();) {
-      if (base::Contains(profiled_pids, it->first)) {
-        ++it;
-      } else {
-        it = pmf_at_last_upload_.erase(it);
-      }
-    }
+  growth_detector_.RemoveProcessesNotIn(profiled_pids);
+
+  // A report covers every process, so a growth detected along with a crossed
+  // threshold is covered by the threshold report.
+  const char* trigger_name = nullptr;
+  if (!crossed_pmfs.empty())
+    trigger_name = kThresholdTriggerName;
+  else if (!growing_pids.empty())
+    trigger_name = kGrowthTriggerName;
+  if (!trigger_name)
+    return;
 
-    TriggerMemoryReport("MEMLOG_BACKGROUND_TRIGGER");
+  const bool should_report = ShouldReport(trigger_name, now);
+  UMA_HISTOGRAM_BOOLEAN("HeapProfiling.BackgroundTrigger.SuppressedByCooldown",
+                        !should_report);
+  if (!should_report)
+    return;
+
+  // Clear the watermark for all non-profiled pids.
+  for (auto it = pmf_at_last_upload_.begin();
+       it != pmf_at_last_upload_.end();) {
+    if (base::Contains(profiled_pids, it->first)) {
+      ++it;
+    } else {
+      it = pmf_at_last_upload_.erase(it);
+    }
   }
+  for (const auto& crossed_pmf : crossed_pmfs)
+    pmf_at_last_upload_[crossed_pmf.first] = crossed_pmf.second;
+  for (base::ProcessId pid : growing_pids)
+    growth_detector_.Reset(pid);
+
+  TriggerMemoryReport(trigger_name);
 }
 
 void BackgroundProfilingTriggers::TriggerMemoryReport(
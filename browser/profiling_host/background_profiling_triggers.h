@@ -5,10 +5,15 @@
 #ifndef CHROME_BROWSER_PROFILING_HOST_BACKGROUND_PROFILING_TRIGGERS_H_
 #define CHROME_BROWSER_PROFILING_HOST_BACKGROUND_PROFILING_TRIGGERS_H_
 
+#include <map>
+#include <string>
+
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/process/process_handle.h"
+#include "base/time/time.h"
 #include "base/timer/timer.h"
+#include "chrome/browser/profiling_host/memory_growth_detector.h"
 #include "services/resource_coordinator/public/cpp/memory_instrumentation/global_memory_dump.h"
 
 namespace heap_profiling {
@@ -21,8 +26,9 @@ class ProfilingProcessHost;
 // interacts with ProfilingProcessHost to trigger and upload memory dumps.
 //
 // When started, memory information is collected every hour to check if any
-// process is over the trigger threshold. Once a report is uploaded, the
-// collection interval is changed to once every 12 hours.
+// process is over the trigger threshold, or has grown steadily for a while
+// (see MemoryGrowthDetector). A trigger doesn't fire again within a cooldown
+// of its last report, and one check sends at most one report.
 class BackgroundProfilingTriggers {
  public:
   explicit BackgroundProfilingTriggers(ProfilingProcessHost* host);
@@ -37,6 +43,12 @@ class BackgroundProfilingTriggers {
   // Exposed to subclasses for testing.
   std::map<base::ProcessId, uint32_t> pmf_at_last_upload_;
 
+  // Tracks the growth of the private footprint of each profiled pid.
+  MemoryGrowthDetector growth_detector_;
+
+  // Time of the last report of each trigger, for the cooldown.
+  std::map<std::string, base::TimeTicks> last_report_times_;
+
  private:
   friend class FakeBackgroundProfilingTriggers;
   FRIEND_TEST_ALL_PREFIXES(BackgroundProfilingTriggersTest,
@@ -52,6 +64,10 @@ class BackgroundProfilingTriggers {
   bool IsOverTriggerThreshold(int content_process_type,
                               uint32_t private_footprint_kb);
 
+  // Returns true if |trigger_name| has not reported within the cooldown, and
+  // if so starts a new cooldown from |now|.
+  bool ShouldReport(const std::string& trigger_name, base::TimeTicks now);
+
   // Check the current memory usage and send a slow-report if needed.
   void PerformMemoryUsageChecks();
 
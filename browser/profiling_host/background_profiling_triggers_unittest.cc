@@ -5,6 +5,7 @@
 #include "chrome/browser/profiling_host/background_profiling_triggers.h"
 
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -72,22 +73,32 @@ class FakeBackgroundProfilingTriggers : public BackgroundProfilingTriggers {
 
   void Reset() {
     was_report_triggered_ = false;
+    last_trigger_name_.clear();
     pmf_at_last_upload_.clear();
+    growth_detector_.Reset();
+    last_report_times_.clear();
   }
   bool WasReportTriggered() const { return was_report_triggered_; }
+  const std::string& last_trigger_name() const { return last_trigger_name_; }
+
+  // Clears the report state, but not the memory history.
+  void ResetReportTriggered() { was_report_triggered_ = false; }
 
  private:
   void TriggerMemoryReport(std::string trigger_name) override {
     was_report_triggered_ = true;
+    last_trigger_name_ = std::move(trigger_name);
   }
 
   bool was_report_triggered_;
+  std::string last_trigger_name_;
 };
 
 class BackgroundProfilingTriggersTest : public testing::Test {
  public:
   BackgroundProfilingTriggersTest()
-      : testing_profile_manager_(TestingBrowserProcess::GetGlobal()),
+      : task_environment_(base::test::TaskEnvironment::TimeSource::MOCK_TIME),
+        testing_profile_manager_(TestingBrowserProcess::GetGlobal()),
         triggers_(&host_),
         is_metrics_enabled_(true) {}
 
@@ -242,6 +253,100 @@ TEST_F(BackgroundProfilingTriggersTest, OnlyProfiledProcessesTrigger) {
   EXPECT_TRUE(triggers_.WasReportTriggered());
 }
 
+// A footprint which grows steadily under the trigger threshold triggers a
+// growth report once enough history is collected.
+TEST_F(BackgroundProfilingTriggersTest, SustainedGrowthTriggers) {
+  uint32_t footprint_kb = 10 * 1024;
+  bool was_report_triggered = false;
+  for (int i = 0; i < 40 && !was_report_triggered; ++i) {
+    GlobalMemoryDumpPtr dump(
+        memory_instrumentation::mojom::GlobalMemoryDump::New());
+    PopulateMetrics(&dump, 1, ProcessType::BROWSER, footprint_kb, footprint_kb,
+                    footprint_kb);
+    triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                   GlobalMemoryDump::MoveFrom(std::move(dump)));
+    was_report_triggered = triggers_.WasReportTriggered();
+    // 100 MB per hour.
+    footprint_kb += 25 * 1024;
+    task_environment_.FastForwardBy(base::TimeDelta::FromMinutes(15));
+  }
+  EXPECT_TRUE(was_report_triggered);
+  EXPECT_EQ("MEMLOG_BACKGROUND_GROWTH_TRIGGER", triggers_.last_trigger_name());
+}
+
+// A stable footprint doesn't trigger a growth report.
+TEST_F(BackgroundProfilingTriggersTest, StableFootprintDoesNotTrigger) {
+  for (int i = 0; i < 40; ++i) {
+    GlobalMemoryDumpPtr dump(
+        memory_instrumentation::mojom::GlobalMemoryDump::New());
+    PopulateMetrics(&dump, 1, ProcessType::BROWSER, 50 * 1024, 50 * 1024,
+                    50 * 1024);
+    triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                   GlobalMemoryDump::MoveFrom(std::move(dump)));
+    task_environment_.FastForwardBy(base::TimeDelta::FromMinutes(15));
+  }
+  EXPECT_FALSE(triggers_.WasReportTriggered());
+}
+
+// A trigger doesn't report again within its cooldown.
+TEST_F(BackgroundProfilingTriggersTest, Cooldown) {
+  GlobalMemoryDumpPtr dump(
+      memory_instrumentation::mojom::GlobalMemoryDump::New());
+  PopulateMetrics(&dump, 1, ProcessType::BROWSER, kProcessMallocTriggerKb,
+                  kProcessMallocTriggerKb, kProcessMallocTriggerKb);
+  triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                 GlobalMemoryDump::MoveFrom(std::move(dump)));
+  EXPECT_TRUE(triggers_.WasReportTriggered());
+  triggers_.ResetReportTriggered();
+
+  // A new process over the threshold is covered by the previous report.
+  dump = memory_instrumentation::mojom::GlobalMemoryDump::New();
+  PopulateMetrics(&dump, 2, ProcessType::RENDERER, kProcessMallocTriggerKb,
+                  kProcessMallocTriggerKb, kProcessMallocTriggerKb);
+  triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                 GlobalMemoryDump::MoveFrom(std::move(dump)));
+  EXPECT_FALSE(triggers_.WasReportTriggered());
+
+  // After the cooldown, a new process over the threshold reports again.
+  task_environment_.FastForwardBy(base::TimeDelta::FromHours(24));
+  dump = memory_instrumentation::mojom::GlobalMemoryDump::New();
+  PopulateMetrics(&dump, 3, ProcessType::GPU, kProcessMallocTriggerKb,
+                  kProcessMallocTriggerKb, kProcessMallocTriggerKb);
+  triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                 GlobalMemoryDump::MoveFrom(std::move(dump)));
+  EXPECT_TRUE(triggers_.WasReportTriggered());
+  EXPECT_EQ("MEMLOG_BACKGROUND_TRIGGER", triggers_.last_trigger_name());
+}
+
+// A threshold crossed during the cooldown is reported once it ends, even if
+// the footprint didn't grow since.
+TEST_F(BackgroundProfilingTriggersTest, CrossingDuringCooldownReportsLater) {
+  GlobalMemoryDumpPtr dump(
+      memory_instrumentation::mojom::GlobalMemoryDump::New());
+  PopulateMetrics(&dump, 1, ProcessType::BROWSER, kProcessMallocTriggerKb,
+                  kProcessMallocTriggerKb, kProcessMallocTriggerKb);
+  triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                 GlobalMemoryDump::MoveFrom(std::move(dump)));
+  EXPECT_TRUE(triggers_.WasReportTriggered());
+  triggers_.ResetReportTriggered();
+
+  dump = memory_instrumentation::mojom::GlobalMemoryDump::New();
+  PopulateMetrics(&dump, 2, ProcessType::RENDERER, kProcessMallocTriggerKb,
+                  kProcessMallocTriggerKb, kProcessMallocTriggerKb);
+  triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                 GlobalMemoryDump::MoveFrom(std::move(dump)));
+  EXPECT_FALSE(triggers_.WasReportTriggered());
+
+  task_environment_.FastForwardBy(base::TimeDelta::FromHours(24));
+  dump = memory_instrumentation::mojom::GlobalMemoryDump::New();
+  PopulateMetrics(&dump, 2, ProcessType::RENDERER, kProcessMallocTriggerKb,
+                  kProcessMallocTriggerKb, kProcessMallocTriggerKb);
+  triggers_.OnReceivedMemoryDump(profiled_pids_, true,
+                                 GlobalMemoryDump::MoveFrom(std::move(dump)));
+  EXPECT_TRUE(triggers_.WasReportTriggered());
+  EXPECT_EQ("MEMLOG_BACKGROUND_TRIGGER", triggers_.last_trigger_name());
+}
+
 // Ensure IsAllowedToUpload() respects metrics collection settings.
 TEST_F(BackgroundProfilingTriggersTest, IsAllowedToUpload_Metrics) {
   EXPECT_TRUE(triggers_.IsAllowedToUpload());
@@ -0,0 +1,125 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/profiling_host/memory_growth_detector.h"
+
+#include <utility>
+
+#include "base/check.h"
+#include "base/containers/contains.h"
+#include "build/build_config.h"
+#include "content/public/common/process_type.h"
+
+namespace heap_profiling {
+
+MemoryGrowthDetector::Params::Params() = default;
+
+MemoryGrowthDetector::MemoryGrowthDetector(Params params)
+    : params_(std::move(params)) {
+  DCHECK_LT(params_.min_window, params_.max_window);
+}
+
+MemoryGrowthDetector::~MemoryGrowthDetector() = default;
+
+// static
+MemoryGrowthDetector::Params MemoryGrowthDetector::GetDefaultParams() {
+  Params params;
+  params.min_r_squared = 0.8;
+#if defined(OS_ANDROID)
+  params.min_window = base::TimeDelta::FromMinutes(30);
+  params.max_window = base::TimeDelta::FromHours(2);
+  params.growth_limit_kb_per_hour = {
+      {content::PROCESS_TYPE_BROWSER, 20 * 1024},
+      {content::PROCESS_TYPE_GPU, 10 * 1024},
+      {content::PROCESS_TYPE_RENDERER, 30 * 1024},
+      {content::PROCESS_TYPE_UTILITY, 10 * 1024},
+  };
+#else
+  params.min_window = base::TimeDelta::FromHours(2);
+  params.max_window = base::TimeDelta::FromHours(8);
+  params.growth_limit_kb_per_hour = {
+      {content::PROCESS_TYPE_BROWSER, 50 * 1024},
+      {content::PROCESS_TYPE_GPU, 50 * 1024},
+      {content::PROCESS_TYPE_RENDERER, 75 * 1024},
+      {content::PROCESS_TYPE_UTILITY, 25 * 1024},
+  };
+#endif  // OS_ANDROID
+  return params;
+}
+
+MemoryGrowthDetector::Decision MemoryGrowthDetector::AddSample(
+    base::ProcessId pid,
+    int content_process_type,
+    base::TimeTicks time,
+    uint32_t private_footprint_kb,
+    Trend* trend) {
+  auto limit = params_.growth_limit_kb_per_hour.find(content_process_type);
+  if (limit == params_.growth_limit_kb_per_hour.end())
+    return Decision::kNotMonitored;
+
+  Series& series = series_[pid];
+  DCHECK(series.empty() || series.back().time <= time);
+  series.push_back({time, private_footprint_kb});
+  while (time - series.front().time > params_.max_window)
+    series.pop_front();
+
+  if (time - series.front().time < params_.min_window)
+    return Decision::kInsufficientData;
+
+  *trend = FitTrend(series);
+  if (trend->growth_kb_per_hour <= limit->second)
+    return Decision::kBelowLimit;
+  if (trend->r_squared < params_.min_r_squared)
+    return Decision::kNotSustained;
+  return Decision::kGrowthDetected;
+}
+
+void MemoryGrowthDetector::RemoveProcessesNotIn(
+    const std::vector<base::ProcessId>& pids) {
+  for (auto it = series_.begin(); it != series_.end();) {
+    if (base::Contains(pids, it->first)) {
+      ++it;
+    } else {
+      it = series_.erase(it);
+    }
+  }
+}
+
+// static
+MemoryGrowthDetector::Trend MemoryGrowthDetector::FitTrend(
+    const Series& series) {
+  // Ordinary least squares of the footprint against the time in hours, from
+  // the first sample to keep the sums small.
+  const base::TimeTicks origin = series.front().time;
+  const double n = series.size();
+  double mean_x = 0;
+  double mean_y = 0;
+  for (const Sample& sample : series) {
+    mean_x += (sample.time - origin).InSecondsF() / 3600;
+    mean_y += sample.private_footprint_kb;
+  }
+  mean_x /= n;
+  mean_y /= n;
+
+  double sxx = 0;
+  double sxy = 0;
+  double syy = 0;
+  for (const Sample& sample : series) {
+    const double dx = (sample.time - origin).InSecondsF() / 3600 - mean_x;
+    const double dy = sample.private_footprint_kb - mean_y;
+    sxx += dx * dx;
+    sxy += dx * dy;
+    syy += dy * dy;
+  }
+
+  Trend trend;
+  if (sxx == 0)
+    return trend;
+  trend.growth_kb_per_hour = sxy / sxx;
+  // A flat series is perfectly explained by its (null) trend.
+  trend.r_squared = syy == 0 ? 1 : (sxy * sxy) / (sxx * syy);
+  return trend;
+}
+
+}  // namespace heap_profiling
@@ -0,0 +1,118 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_PROFILING_HOST_MEMORY_GROWTH_DETECTOR_H_
+#define CHROME_BROWSER_PROFILING_HOST_MEMORY_GROWTH_DETECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include "base/containers/circular_deque.h"
+#include "base/process/process_handle.h"
+#include "base/time/time.h"
+
+namespace heap_profiling {
+
+// Detects slow, sustained growth of the private footprint of processes, which
+// the fixed thresholds of BackgroundProfilingTriggers miss in long-running
+// sessions.
+//
+// Keeps a time series of the private footprint of each process and fits a
+// line to it by least squares. A process is reported once its series spans
+// at least |min_window|, the slope of the line is over the growth limit of
+// its process type, and the line explains most of the variance of the
+// series, so that a one-off spike doesn't look like a leak. A process keeps
+// being reported while it grows. Once a report is actually sent, the caller
+// restarts its series with Reset(pid), so that it is only reported again after
+// growing for another |min_window|.
+class MemoryGrowthDetector {
+ public:
+  // The decision taken for a sample. Recorded in the
+  // "HeapProfiling.GrowthDetector.Decision" histogram, so entries should not
+  // be renumbered and numeric values should never be reused.
+  enum class Decision {
+    // The process type isn't monitored.
+    kNotMonitored = 0,
+    // The series doesn't span |min_window| yet.
+    kInsufficientData = 1,
+    // The growth rate is under the limit.
+    kBelowLimit = 2,
+    // The growth rate is over the limit, but the series isn't linear enough.
+    kNotSustained = 3,
+    // Sustained growth over the limit.
+    kGrowthDetected = 4,
+    kMaxValue = kGrowthDetected,
+  };
+
+  struct Params {
+    Params();
+
+    // The shortest span of a series for its trend to be trusted.
+    base::TimeDelta min_window;
+
+    // The longest span of a series. Older samples are dropped.
+    base::TimeDelta max_window;
+
+    // The minimal coefficient of determination of the fit, from 0 to 1, for
+    // the growth to be considered sustained.
+    double min_r_squared;
+
+    // Growth limits per content::ProcessType, in KB per hour. Processes of
+    // other types are not monitored.
+    std::map<int, double> growth_limit_kb_per_hour;
+  };
+
+  // The fit of a series, exposed for testing and metrics.
+  struct Trend {
+    double growth_kb_per_hour = 0;
+    double r_squared = 0;
+  };
+
+  explicit MemoryGrowthDetector(Params params);
+  ~MemoryGrowthDetector();
+
+  MemoryGrowthDetector(const MemoryGrowthDetector&) = delete;
+  MemoryGrowthDetector& operator=(const MemoryGrowthDetector&) = delete;
+
+  // Returns the default parameters of the platform.
+  static Params GetDefaultParams();
+
+  // Adds the |private_footprint_kb| of |pid| at |time| to its series, and
+  // returns whether it is growing too fast. |time| must not go backwards for a
+  // given process. Fills |trend| when the series is long enough to be fitted.
+  Decision AddSample(base::ProcessId pid,
+                     int content_process_type,
+                     base::TimeTicks time,
+                     uint32_t private_footprint_kb,
+                     Trend* trend);
+
+  // Drops the series of the processes not in |pids|, as they have exited.
+  void RemoveProcessesNotIn(const std::vector<base::ProcessId>& pids);
+
+  // Restarts the series of |pid|, e.g. after a report covered its growth.
+  void Reset(base::ProcessId pid) { series_.erase(pid); }
+
+  void Reset() { series_.clear(); }
+
+  size_t process_count_for_testing() const { return series_.size(); }
+
+ private:
+  struct Sample {
+    base::TimeTicks time;
+    uint32_t private_footprint_kb;
+  };
+  using Series = base::circular_deque<Sample>;
+
+  static Trend FitTrend(const Series& series);
+
+  const Params params_;
+  std::map<base::ProcessId, Series> series_;
+};
+
+}  // namespace heap_profiling
+
+#endif  // CHROME_BROWSER_PROFILING_HOST_MEMORY_GROWTH_DETECTOR_H_
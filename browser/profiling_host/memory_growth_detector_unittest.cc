@@ -0,0 +1,101 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/profiling_host/memory_growth_detector.h"
+
+#include "base/time/time.h"
+#include "content/public/common/process_type.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace heap_profiling {
+
+namespace {
+
+constexpr base::TimeDelta kInterval = base::TimeDelta::FromMinutes(15);
+
+MemoryGrowthDetector::Params GetTestParams() {
+  MemoryGrowthDetector::Params params;
+  params.min_window = base::TimeDelta::FromHours(1);
+  params.max_window = base::TimeDelta::FromHours(2);
+  params.min_r_squared = 0.8;
+  params.growth_limit_kb_per_hour = {{content::PROCESS_TYPE_BROWSER, 1000}};
+  return params;
+}
+
+}  // namespace
+
+TEST(MemoryGrowthDetectorTest, DetectsSustainedGrowth) {
+  MemoryGrowthDetector detector(GetTestParams());
+  const base::TimeTicks start = base::TimeTicks::Now();
+  MemoryGrowthDetector::Trend trend;
+
+  // 2000 KB per hour, so the limit is crossed once the series spans an hour.
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(MemoryGrowthDetector::Decision::kInsufficientData,
+              detector.AddSample(1, content::PROCESS_TYPE_BROWSER,
+                                 start + i * kInterval, 10000 + i * 500,
+                                 &trend));
+  }
+  EXPECT_EQ(MemoryGrowthDetector::Decision::kGrowthDetected,
+            detector.AddSample(1, content::PROCESS_TYPE_BROWSER,
+                               start + 4 * kInterval, 12000, &trend));
+  EXPECT_NEAR(2000, trend.growth_kb_per_hour, 1e-6);
+  EXPECT_NEAR(1, trend.r_squared, 1e-9);
+
+  // The growth is reported until the series is restarted, e.g. while reports
+  // are suppressed.
+  EXPECT_EQ(MemoryGrowthDetector::Decision::kGrowthDetected,
+            detector.AddSample(1, content::PROCESS_TYPE_BROWSER,
+                               start + 5 * kInterval, 12500, &trend));
+  detector.Reset(1);
+  EXPECT_EQ(MemoryGrowthDetector::Decision::kInsufficientData,
+            detector.AddSample(1, content::PROCESS_TYPE_BROWSER,
+                               start + 6 * kInterval, 13000, &trend));
+}
+
+TEST(MemoryGrowthDetectorTest, IgnoresSlowGrowthAndSpikes) {
+  MemoryGrowthDetector detector(GetTestParams());
+  const base::TimeTicks start = base::TimeTicks::Now();
+  MemoryGrowthDetector::Trend trend;
+
+  // 400 KB per hour.
+  for (int i = 0; i < 4; ++i) {
+    detector.AddSample(1, content::PROCESS_TYPE_BROWSER, start + i * kInterval,
+                       10000 + i * 100, &trend);
+  }
+  EXPECT_EQ(MemoryGrowthDetector::Decision::kBelowLimit,
+            detector.AddSample(1, content::PROCESS_TYPE_BROWSER,
+                               start + 4 * kInterval, 10400, &trend));
+
+  // A flat series with a spike has a steep trend, but a poor fit.
+  for (int i = 0; i < 8; ++i) {
+    detector.AddSample(2, content::PROCESS_TYPE_BROWSER, start + i * kInterval,
+                       10000, &trend);
+  }
+  EXPECT_EQ(MemoryGrowthDetector::Decision::kNotSustained,
+            detector.AddSample(2, content::PROCESS_TYPE_BROWSER,
+                               start + 8 * kInterval, 20000, &trend));
+  EXPECT_GT(trend.growth_kb_per_hour, 1000);
+  EXPECT_LT(trend.r_squared, 0.8);
+}
+
+TEST(MemoryGrowthDetectorTest, ProcessBookkeeping) {
+  MemoryGrowthDetector detector(GetTestParams());
+  const base::TimeTicks start = base::TimeTicks::Now();
+  MemoryGrowthDetector::Trend trend;
+
+  EXPECT_EQ(MemoryGrowthDetector::Decision::kNotMonitored,
+            detector.AddSample(1, content::PROCESS_TYPE_RENDERER, start, 10000,
+                               &trend));
+  EXPECT_EQ(0u, detector.process_count_for_testing());
+
+  detector.AddSample(1, content::PROCESS_TYPE_BROWSER, start, 10000, &trend);
+  detector.AddSample(2, content::PROCESS_TYPE_BROWSER, start, 10000, &trend);
+  EXPECT_EQ(2u, detector.process_count_for_testing());
+
+  detector.RemoveProcessesNotIn({2});
+  EXPECT_EQ(1u, detector.process_count_for_testing());
+}
+
+}  // namespace heap_profiling
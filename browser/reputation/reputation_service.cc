@@ -164,7 +164,7 @@ void ReputationService::GetReputationStatusWithEngagedSites(
     const GURL& url,
     bool has_delayed_warning,
     ReputationCheckCallback callback,
-    const std::vector<DomainInfo>& engaged_sites) {
+    scoped_refptr<const EngagedSiteIndex> engaged_sites) {
   const DomainInfo navigated_domain = GetDomainInfo(url);
 
   ReputationCheckResult result;
@@ -186,13 +186,8 @@ void ReputationService::GetReputationStatusWithEngagedSites(
   // Ensure that this URL is not already engaged. We can't use the synchronous
   // SiteEngagementService::IsEngagementAtLeast as it has side effects.  This
   // check intentionally ignores the scheme.
-  const auto already_engaged =
-      std::find_if(engaged_sites.begin(), engaged_sites.end(),
-                   [navigated_domain](const DomainInfo& engaged_domain) {
-                     return (navigated_domain.domain_and_registry ==
-                             engaged_domain.domain_and_registry);
-                   });
-  if (already_engaged != engaged_sites.end()) {
+  const bool already_engaged = engaged_sites->IsEngaged(navigated_domain);
+  if (already_engaged) {
     done_checking_reputation_status = true;
   }
 
@@ -216,9 +211,12 @@ void ReputationService::GetReputationStatusWithEngagedSites(
 
   // 4. Lookalike heuristics.
   GURL safe_url;
-  if (already_engaged == engaged_sites.end() &&
-      ShouldTriggerSafetyTipFromLookalike(url, navigated_domain, engaged_sites,
-                                          &safe_url)) {
+  std::vector<DomainInfo> near_matches;
+  if (!already_engaged &&
+      ShouldTriggerSafetyTipFromLookalike(
+          url, navigated_domain,
+          engaged_sites->GetMatchCandidates(navigated_domain, &near_matches),
+          &safe_url)) {
     if (!done_checking_reputation_status) {
       result.suggested_url = safe_url;
       result.safety_tip_status = SafetyTipStatus::kLookalike;
@@ -9,7 +9,9 @@
 #include <vector>
 
 #include "base/callback.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
+#include "chrome/browser/lookalikes/engaged_site_index.h"
 #include "chrome/browser/reputation/safety_tip_ui.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/security_state/core/security_state.h"
@@ -99,7 +101,7 @@ class ReputationService : public KeyedService {
       const GURL& url,
       bool has_delayed_warning,
       ReputationCheckCallback callback,
-      const std::vector<DomainInfo>& engaged_sites);
+      scoped_refptr<const EngagedSiteIndex> engaged_sites);
 
   // Set of eTLD+1s that we've warned about, and the user has explicitly
   // ignored.  Used to avoid re-warning the user.
@@ -19,12 +19,12 @@ import {assert} from 'chrome://resources/js/assert.m.js';
 import {loadTimeData} from 'chrome://resources/js/load_time_data.m.js';
 import {PromiseResolver} from 'chrome://resources/js/promise_resolver.m.js';
 import {queryRequiredElement} from 'chrome://resources/js/util.m.js';
-import {html, Polymer} from 'chrome://resources/polymer/v3_0/polymer/polymer_bundled.min.js';
+import {afterNextRender, html, Polymer} from 'chrome://resources/polymer/v3_0/polymer/polymer_bundled.min.js';
 
 import {BrowserProxy} from './browser_proxy.js';
 import {States} from './constants.js';
 import {Data} from './data.js';
-import {PageCallbackRouter, PageHandlerInterface} from './downloads.mojom-webui.js';
+import {PageCallbackRouter, PageHandlerInterface, ProgressUpdate} from './downloads.mojom-webui.js';
 import {SearchService} from './search_service.js';
 
 Polymer({
@@ -98,6 +98,9 @@ Polymer({
   /** @private {!PromiseResolver} */
   loaded_: new PromiseResolver,
 
+  /** @private {number} */
+  visibleRowCount_: 0,
+
   /** @private {Array<number>} */
   listenerIds_: null,
 
@@ -129,12 +132,17 @@ Polymer({
           this.insertItems_.bind(this)),
       this.mojoEventTarget_.removeItem.addListener(this.removeItem_.bind(this)),
       this.mojoEventTarget_.updateItem.addListener(this.updateItem_.bind(this)),
+      this.mojoEventTarget_.updateProgress.addListener(
+          this.updateProgress_.bind(this)),
     ];
 
     this.boundOnKeyDown_ = e => this.onKeyDown_(e);
     document.addEventListener('keydown', this.boundOnKeyDown_);
 
     this.loaded_.promise.then(() => {
+      // The first chunk was sized before the page knew how many rows it
+      // shows, so tell it once the list has rendered that chunk.
+      afterNextRender(this, () => this.updateVisibleRowCount_());
       requestIdleCallback(function() {
         chrome.send(
             'metricsHandler:recordTime',
@@ -286,6 +294,7 @@ Polymer({
         container.scrollHeight - container.scrollTop - container.offsetHeight;
     if (distanceToBottom <= 100) {
       // Approaching the end of the scrollback. Attempt to load more items.
+      this.updateVisibleRowCount_();
       this.searchService_.loadMore();
     }
     this.hasShadow_ = container.scrollTop > 0;
@@ -354,6 +363,39 @@ Polymer({
     });
   },
 
+  /**
+   * @param {!Array<!ProgressUpdate>} updates
+   * @private
+   */
+  updateProgress_(updates) {
+    for (const update of updates) {
+      const data = this.items_[update.index];
+      this.items_[update.index] = Object.assign({}, data, {
+        percent: update.percent,
+        total: update.total,
+        progressStatusText: update.progressStatusText,
+      });
+      this.notifyPath(`items_.${update.index}`);
+    }
+  },
+
+  /**
+   * Tells the browser how many items fit on the screen, so that it sends
+   * enough of them at a time.
+   * @private
+   */
+  updateVisibleRowCount_() {
+    const list = /** @type {!IronListElement} */ (this.$.downloadsList);
+    if (this.items_.length === 0) {
+      return;
+    }
+    const count = list.lastVisibleIndex - list.firstVisibleIndex + 1;
+    if (count > 0 && count !== this.visibleRowCount_) {
+      this.visibleRowCount_ = count;
+      this.mojoHandler_.setVisibleRowCount(count);
+    }
+  },
+
   // Override FindShortcutBehavior methods.
   handleFindShortcut(modalContextOpen) {
     if (modalContextOpen) {
@@ -49,6 +49,16 @@ export let HistoryEntry;
  */
 export let HistoryQuery;
 
+/**
+ * A page of the results of a query, sent after the first page when results are
+ * streamed. The definition is based on
+ * chrome/browser/ui/webui/history/browsing_history_handler.cc:
+ *     BrowsingHistoryHandler::OnResultsPageFormatted()
+ * @typedef {{finished: boolean,
+ *            value: !Array<!HistoryEntry>}}
+ */
+export let HistoryResultsPage;
+
 /**
  * The type of the foreign session tab object. This definition is based on
  * chrome/browser/ui/webui/foreign_session_handler.cc:
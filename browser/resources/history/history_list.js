@@ -18,7 +18,7 @@ import {html, Polymer} from 'chrome://resources/polymer/v3_0/polymer/polymer_bun
 
 import {BrowserService} from './browser_service.js';
 import {BROWSING_GAP_TIME, UMA_MAX_BUCKET_VALUE, UMA_MAX_SUBSET_BUCKET_VALUE} from './constants.js';
-import {HistoryEntry, HistoryQuery, QueryState} from './externs.js';
+import {HistoryEntry, HistoryQuery, HistoryResultsPage, QueryState} from './externs.js';
 import {searchResultsTitle} from './history_item.js';
 
 Polymer({
@@ -110,6 +110,8 @@ Polymer({
     this.setAttribute('aria-roledescription', this.i18n('ariaRoleDescription'));
 
     this.addWebUIListener('history-deleted', () => this.onHistoryDeleted_());
+    this.addWebUIListener(
+        'history-results-page', page => this.onHistoryResultsPage_(page));
   },
 
   /////////////////////////////////////////////////////////////////////////////
@@ -171,6 +173,15 @@ Polymer({
     this.resultLoadingDisabled_ = finished;
   },
 
+  /**
+   * Appends a page of the results of the current query.
+   * @param {!HistoryResultsPage} page
+   * @private
+   */
+  onHistoryResultsPage_(page) {
+    this.addNewResults(page.value, true, page.finished);
+  },
+
   /** @private */
   onHistoryDeleted_() {
     // Do not reload the list when there are items checked.
@@ -2,7 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-import {Polymer} from 'chrome://resources/polymer/v3_0/polymer/polymer_bundled.min.js';
+import {afterNextRender, Polymer} from 'chrome://resources/polymer/v3_0/polymer/polymer_bundled.min.js';
 
 import {BrowserService} from './browser_service.js';
 import {HistoryEntry, HistoryQuery, QueryResult} from './externs.js';
@@ -44,6 +44,13 @@ Polymer({
   /** @private {!Object<string, !function(!Event)>} */
   documentListeners_: {},
 
+  /**
+   * When the current non-incremental query was sent, or null once its results
+   * were shown.
+   * @private {?number}
+   */
+  queryStartTime_: null,
+
   /** @override */
   attached() {
     this.documentListeners_['change-query'] = this.onChangeQuery_.bind(this);
@@ -72,6 +79,9 @@ Polymer({
   queryHistory_(incremental) {
     this.set('queryState.querying', true);
     this.set('queryState.incremental', incremental);
+    if (!incremental) {
+      this.queryStartTime_ = window.performance.now();
+    }
 
     const browserService = BrowserService.getInstance();
     const promise = incremental ?
@@ -123,6 +133,16 @@ Polymer({
     this.set('queryResult.info', results.info);
     this.set('queryResult.results', results.value);
     this.fire('query-finished');
+
+    if (this.queryStartTime_ !== null) {
+      const queryStartTime = this.queryStartTime_;
+      this.queryStartTime_ = null;
+      afterNextRender(this, () => {
+        BrowserService.getInstance().recordTime(
+            'History.QueryToFirstRowsTime',
+            window.performance.now() - queryStartTime);
+      });
+    }
   },
 
   /** @private */
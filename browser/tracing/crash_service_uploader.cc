@@ -4,14 +4,17 @@
 
 #include "chrome/browser/tracing/crash_service_uploader.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/command_line.h"
+#include "base/containers/span.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/format_macros.h"
 #include "base/json/json_writer.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
@@ -24,16 +27,23 @@
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/common/content_switches.h"
+#include "mojo/public/cpp/bindings/receiver_set.h"
+#include "mojo/public/cpp/system/data_pipe_producer.h"
+#include "mojo/public/cpp/system/string_data_source.h"
 #include "net/base/load_flags.h"
 #include "net/base/mime_util.h"
+#include "net/base/net_errors.h"
 #include "net/base/network_delegate.h"
+#include "net/http/http_request_headers.h"
 #include "net/http/http_status_code.h"
 #include "net/proxy_resolution/proxy_config.h"
 #include "net/proxy_resolution/proxy_config_service.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 #include "services/network/public/cpp/resource_request.h"
+#include "services/network/public/cpp/resource_request_body.h"
 #include "services/network/public/cpp/shared_url_loader_factory.h"
 #include "services/network/public/cpp/simple_url_loader.h"
+#include "services/network/public/mojom/data_pipe_getter.mojom.h"
 #include "third_party/zlib/zlib.h"
 #include "url/gurl.h"
 
@@ -49,8 +59,60 @@ const char kCrashMultipartBoundary[] =
 // Allow up to 10MB for trace upload
 const size_t kMaxUploadBytes = 10000000;
 
+// The amount of trace data compressed at a time, and by which the compressed
+// output grows.
+const size_t kCompressionChunkBytes = 1 << 20;
+
 }  // namespace
 
+// Streams the upload body to the network service. The body is shared with the
+// pending writes, so that it's neither copied into the request nor freed while
+// being written. Clones, made for redirects and retries, stream it again.
+class TraceCrashServiceUploader::BodyDataPipeGetter
+    : public network::mojom::DataPipeGetter {
+ public:
+  explicit BodyDataPipeGetter(std::string body)
+      : body_(base::RefCountedString::TakeString(&body)) {}
+
+  BodyDataPipeGetter(const BodyDataPipeGetter&) = delete;
+  BodyDataPipeGetter& operator=(const BodyDataPipeGetter&) = delete;
+
+  ~BodyDataPipeGetter() override = default;
+
+  mojo::PendingRemote<network::mojom::DataPipeGetter> CreateRemote() {
+    mojo::PendingRemote<network::mojom::DataPipeGetter> remote;
+    receivers_.Add(this, remote.InitWithNewPipeAndPassReceiver());
+    return remote;
+  }
+
+  // network::mojom::DataPipeGetter:
+  void Read(mojo::ScopedDataPipeProducerHandle pipe,
+            ReadCallback callback) override {
+    std::move(callback).Run(net::OK, body_->size());
+    auto producer = std::make_unique<mojo::DataPipeProducer>(std::move(pipe));
+    mojo::DataPipeProducer* raw_producer = producer.get();
+    raw_producer->Write(
+        std::make_unique<mojo::StringDataSource>(
+            base::make_span(body_->front_as<char>(), body_->size()),
+            mojo::StringDataSource::AsyncWritingMode::
+                STRING_STAYS_VALID_UNTIL_COMPLETION),
+        base::BindOnce(
+            [](std::unique_ptr<mojo::DataPipeProducer> producer,
+               scoped_refptr<base::RefCountedString> body, MojoResult result) {
+            },
+            std::move(producer), body_));
+  }
+
+  void Clone(mojo::PendingReceiver<network::mojom::DataPipeGetter> receiver)
+      override {
+    receivers_.Add(this, std::move(receiver));
+  }
+
+ private:
+  const scoped_refptr<base::RefCountedString> body_;
+  mojo::ReceiverSet<network::mojom::DataPipeGetter> receivers_;
+};
+
 TraceCrashServiceUploader::TraceCrashServiceUploader(
     scoped_refptr<network::SharedURLLoaderFactory> factory)
     : shared_url_loader_factory_(std::move(factory)),
@@ -104,6 +166,7 @@ void TraceCrashServiceUploader::OnSimpleURLLoaderComplete(
   content::GetUIThreadTaskRunner({})->PostTask(
       FROM_HERE, base::BindOnce(std::move(done_callback_), success, feedback));
   simple_url_loader_.reset();
+  body_data_pipe_getter_.reset();
 }
 
 void TraceCrashServiceUploader::OnURLLoaderUploadProgress(uint64_t current,
@@ -183,33 +246,18 @@ void TraceCrashServiceUploader::DoCompressOnBackgroundThread(
     return;
   }
 
-  std::string compressed_contents;
-  if (upload_mode == COMPRESSED_UPLOAD) {
-    std::unique_ptr<char[]> compressed_buffer(new char[max_upload_bytes_]);
-    int compressed_bytes;
-    if (!Compress(file_contents, max_upload_bytes_, compressed_buffer.get(),
-                  &compressed_bytes)) {
-      OnUploadError("Compressing file failed.");
-      return;
-    }
-    compressed_contents =
-        std::string(compressed_buffer.get(), compressed_bytes);
-  } else {
-    compressed_contents = file_contents;
-  }
-  if (compressed_contents.size() > max_upload_bytes_) {
+  std::string post_data;
+  if (!SetupMultipart(product, version, std::move(metadata), "trace.json.gz",
+                      file_contents, upload_mode, &post_data)) {
     OnUploadError("File is too large to upload.");
     return;
   }
 
-  std::string post_data;
-  SetupMultipart(product, version, std::move(metadata), "trace.json.gz",
-                 compressed_contents, &post_data);
-
   content::GetUIThreadTaskRunner({})->PostTask(
       FROM_HERE,
       base::BindOnce(&TraceCrashServiceUploader::CreateAndStartURLLoader,
-                     base::Unretained(this), upload_url, post_data));
+                     base::Unretained(this), upload_url,
+                     std::move(post_data)));
 }
 
 void TraceCrashServiceUploader::OnUploadError(
@@ -220,12 +268,13 @@ void TraceCrashServiceUploader::OnUploadError(
       base::BindOnce(std::move(done_callback_), false, error_message));
 }
 
-void TraceCrashServiceUploader::SetupMultipart(
+bool TraceCrashServiceUploader::SetupMultipart(
     const std::string& product,
     const std::string& version,
     std::unique_ptr<const base::DictionaryValue> metadata,
     const std::string& trace_filename,
-    const std::string& trace_contents,
+    base::StringPiece trace_contents,
+    UploadMode upload_mode,
     std::string* post_data) {
   net::AddMultipartValueForUpload("prod", product, kCrashMultipartBoundary, "",
                                   post_data);
@@ -252,13 +301,16 @@ void TraceCrashServiceUploader::SetupMultipart(
     }
   }
 
-  AddTraceFile(trace_filename, trace_contents, post_data);
+  if (!AddTraceFile(trace_filename, trace_contents, upload_mode, post_data))
+    return false;
 
   net::AddMultipartFinalDelimiterForUpload(kCrashMultipartBoundary, post_data);
+  return true;
 }
 
-void TraceCrashServiceUploader::AddTraceFile(const std::string& trace_filename,
-                                             const std::string& trace_contents,
+bool TraceCrashServiceUploader::AddTraceFile(const std::string& trace_filename,
+                                             base::StringPiece trace_contents,
+                                             UploadMode upload_mode,
                                              std::string* post_data) {
   post_data->append("--");
   post_data->append(kCrashMultipartBoundary);
@@ -268,16 +320,23 @@ void TraceCrashServiceUploader::AddTraceFile(const std::string& trace_filename,
   post_data->append(trace_filename);
   post_data->append("\"\r\n");
   post_data->append("Content-Type: application/gzip\r\n\r\n");
-  post_data->append(trace_contents);
+  if (upload_mode == COMPRESSED_UPLOAD) {
+    if (!Compress(trace_contents, max_upload_bytes_, post_data))
+      return false;
+  } else {
+    if (trace_contents.size() > max_upload_bytes_)
+      return false;
+    post_data->append(trace_contents.data(), trace_contents.size());
+  }
   post_data->append("\r\n");
+  return true;
 }
 
-bool TraceCrashServiceUploader::Compress(std::string input,
-                                         int max_compressed_bytes,
-                                         char* compressed,
-                                         int* compressed_bytes) {
-  DCHECK(compressed);
-  DCHECK(compressed_bytes);
+// static
+bool TraceCrashServiceUploader::Compress(base::StringPiece input,
+                                         size_t max_compressed_bytes,
+                                         std::string* output) {
+  DCHECK(output);
   z_stream stream = {0};
   int result = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
                             // 16 is added to produce a gzip header + trailer.
@@ -285,28 +344,56 @@ bool TraceCrashServiceUploader::Compress(std::string input,
                             8,  // memLevel = 8 is default.
                             Z_DEFAULT_STRATEGY);
   DCHECK_EQ(Z_OK, result);
-  stream.next_in = reinterpret_cast<uint8_t*>(&input[0]);
-  stream.avail_in = input.size();
-  stream.next_out = reinterpret_cast<uint8_t*>(compressed);
-  stream.avail_out = max_compressed_bytes;
-  // Do a one-shot compression. This will return Z_STREAM_END only if |output|
-  // is large enough to hold all compressed data.
-  result = deflate(&stream, Z_FINISH);
-  bool success = (result == Z_STREAM_END);
+
+  // The compressed data is written straight after the existing contents of
+  // |output|, which grows a chunk at a time up to |output_limit|.
+  const size_t output_start = output->size();
+  const size_t output_limit = output_start + max_compressed_bytes;
+  size_t output_end = output_start;
+  size_t input_offset = 0;
+  bool success = true;
+  do {
+    const size_t input_bytes =
+        std::min(kCompressionChunkBytes, input.size() - input_offset);
+    stream.next_in = reinterpret_cast<Bytef*>(
+        const_cast<char*>(input.data() + input_offset));
+    stream.avail_in = input_bytes;
+    input_offset += input_bytes;
+    const int flush = input_offset == input.size() ? Z_FINISH : Z_NO_FLUSH;
+
+    do {
+      if (output_end == output->size()) {
+        const size_t new_size =
+            std::min(output->size() + kCompressionChunkBytes, output_limit);
+        if (new_size == output->size()) {
+          // The compressed data doesn't fit, so stop without compressing the
+          // rest of the input.
+          success = false;
+          break;
+        }
+        output->resize(new_size);
+      }
+      stream.next_out = reinterpret_cast<Bytef*>(&(*output)[output_end]);
+      stream.avail_out = output->size() - output_end;
+      result = deflate(&stream, flush);
+      DCHECK(result == Z_OK || result == Z_STREAM_END || result == Z_BUF_ERROR);
+      output_end = output->size() - stream.avail_out;
+    } while (flush == Z_FINISH ? result != Z_STREAM_END
+                               : stream.avail_in > 0 || stream.avail_out == 0);
+  } while (success && input_offset < input.size());
+
   result = deflateEnd(&stream);
   DCHECK(result == Z_OK || result == Z_DATA_ERROR);
 
-  if (success)
-    *compressed_bytes = max_compressed_bytes - stream.avail_out;
-
-  LOG(WARNING) << "input size: " << input.size()
-               << ", output size: " << *compressed_bytes;
+  output->resize(success ? output_end : output_start);
+  LOG(WARNING) << "input size: " << input.size() << ", output size: "
+               << (success ? output_end - output_start : 0);
   return success;
 }
 
 void TraceCrashServiceUploader::CreateAndStartURLLoader(
     const std::string& upload_url,
-    const std::string& post_data) {
+    std::string post_data) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   DCHECK(!simple_url_loader_);
 
@@ -356,10 +443,17 @@ void TraceCrashServiceUploader::CreateAndStartURLLoader(
   resource_request->method = "POST";
   resource_request->enable_upload_progress = true;
   resource_request->credentials_mode = network::mojom::CredentialsMode::kOmit;
+  resource_request->headers.SetHeader(net::HttpRequestHeaders::kContentType,
+                                      content_type);
+  body_data_pipe_getter_ =
+      std::make_unique<BodyDataPipeGetter>(std::move(post_data));
+  resource_request->request_body =
+      base::MakeRefCounted<network::ResourceRequestBody>();
+  resource_request->request_body->AppendDataPipe(
+      body_data_pipe_getter_->CreateRemote());
 
   simple_url_loader_ = network::SimpleURLLoader::Create(
       std::move(resource_request), traffic_annotation);
-  simple_url_loader_->AttachStringForUpload(post_data, content_type);
 
   simple_url_loader_->SetOnUploadProgressCallback(
       base::BindRepeating(&TraceCrashServiceUploader::OnURLLoaderUploadProgress,
@@ -14,6 +14,7 @@
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/strings/string_piece.h"
 #include "base/threading/thread_checker.h"
 #include "content/public/browser/trace_uploader.h"
 
@@ -22,7 +23,10 @@ class SharedURLLoaderFactory;
 class SimpleURLLoader;
 }  // namespace network
 
-// TraceCrashServiceUploader uploads traces to the Chrome crash service.
+// TraceCrashServiceUploader uploads traces to the Chrome crash service. The
+// trace is compressed in chunks straight into the multipart body, stopping as
+// soon as the body would exceed the upload limit, and the body is streamed to
+// the network service through a data pipe rather than copied into the request.
 class TraceCrashServiceUploader : public content::TraceUploader {
  public:
   explicit TraceCrashServiceUploader(
@@ -41,6 +45,10 @@ class TraceCrashServiceUploader : public content::TraceUploader {
                 UploadDoneCallback done_callback) override;
 
  private:
+  friend class TraceCrashServiceUploaderTest;
+
+  class BodyDataPipeGetter;
+
   void OnSimpleURLLoaderComplete(std::unique_ptr<std::string> response_body);
   void OnURLLoaderUploadProgress(uint64_t position, uint64_t size);
 
@@ -51,28 +59,33 @@ class TraceCrashServiceUploader : public content::TraceUploader {
       std::unique_ptr<const base::DictionaryValue> metadata);
 
   // Sets up a multipart body to be uploaded. The body is produced according
-  // to RFC 2046.
-  void SetupMultipart(const std::string& product,
+  // to RFC 2046. Returns false if the trace part would be larger than
+  // |max_upload_bytes_|.
+  bool SetupMultipart(const std::string& product,
                       const std::string& version,
                       std::unique_ptr<const base::DictionaryValue> metadata,
                       const std::string& trace_filename,
-                      const std::string& trace_contents,
+                      base::StringPiece trace_contents,
+                      UploadMode upload_mode,
                       std::string* post_data);
-  void AddTraceFile(const std::string& trace_filename,
-                    const std::string& trace_contents,
+  bool AddTraceFile(const std::string& trace_filename,
+                    base::StringPiece trace_contents,
+                    UploadMode upload_mode,
                     std::string* post_data);
-  // Compresses the input and returns whether compression was successful.
-  bool Compress(std::string input,
-                int max_compressed_bytes,
-                char* compressed_contents,
-                int* compressed_bytes);
+  // Appends the gzip compressed |input| to |output|, a chunk at a time.
+  // Returns false, leaving |output| unchanged, as soon as the compressed data
+  // would exceed |max_compressed_bytes|.
+  static bool Compress(base::StringPiece input,
+                       size_t max_compressed_bytes,
+                       std::string* output);
   void CreateAndStartURLLoader(const std::string& upload_url,
-                               const std::string& post_data);
+                               std::string post_data);
   void OnUploadError(const std::string& error_message);
 
   UploadProgressCallback progress_callback_;
   UploadDoneCallback done_callback_;
 
+  std::unique_ptr<BodyDataPipeGetter> body_data_pipe_getter_;
   std::unique_ptr<network::SimpleURLLoader> simple_url_loader_;
   scoped_refptr<network::SharedURLLoaderFactory> shared_url_loader_factory_;
 
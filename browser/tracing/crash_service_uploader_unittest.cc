@@ -0,0 +1,60 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/tracing/crash_service_uploader.h"
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/rand_util.h"
+#include "base/strings/string_piece.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/compression_utils.h"
+
+class TraceCrashServiceUploaderTest : public testing::Test {
+ protected:
+  static bool Compress(base::StringPiece input,
+                       size_t max_compressed_bytes,
+                       std::string* output) {
+    return TraceCrashServiceUploader::Compress(input, max_compressed_bytes,
+                                               output);
+  }
+};
+
+TEST_F(TraceCrashServiceUploaderTest, CompressRoundTrip) {
+  // Larger than a compression chunk, so that the input and output are
+  // processed in several steps.
+  std::string input;
+  for (int i = 0; input.size() < 3 * 1024 * 1024; ++i)
+    input += "{\"name\":\"Event" + std::to_string(i % 100) + "\"},";
+
+  std::string output = "prefix";
+  ASSERT_TRUE(Compress(input, input.size(), &output));
+  ASSERT_EQ("prefix", output.substr(0, 6));
+
+  std::string uncompressed;
+  ASSERT_TRUE(compression::GzipUncompress(base::StringPiece(output).substr(6),
+                                          &uncompressed));
+  EXPECT_EQ(input, uncompressed);
+}
+
+TEST_F(TraceCrashServiceUploaderTest, CompressOverBudget) {
+  // Random data doesn't compress.
+  const std::string input = base::RandBytesAsString(2 * 1024 * 1024);
+
+  std::string output = "prefix";
+  EXPECT_FALSE(Compress(input, input.size() / 2, &output));
+  EXPECT_EQ("prefix", output);
+}
+
+TEST_F(TraceCrashServiceUploaderTest, CompressEmptyInput) {
+  std::string output;
+  ASSERT_TRUE(Compress("", 1024, &output));
+  EXPECT_FALSE(output.empty());
+
+  std::string uncompressed = "not empty";
+  ASSERT_TRUE(compression::GzipUncompress(output, &uncompressed));
+  EXPECT_EQ("", uncompressed);
+}
@@ -8,9 +8,12 @@
 #include <string>
 #include <utility>
 
+#include "base/feature_list.h"
 #include "base/json/json_writer.h"
 #include "base/process/process_metrics.h"
 #include "base/trace_event/trace_event.h"
+#include "chrome/browser/tracing/trace_process_stats_sampler.h"
+#include "chrome/common/chrome_features.h"
 
 namespace tracing {
 
@@ -49,6 +52,8 @@ TraceEventSystemStatsMonitor::TraceEventSystemStatsMonitor() {
   // Force the "system_stats" category to show up in the trace viewer.
   base::trace_event::TraceLog::GetCategoryGroupEnabled(
       TRACE_DISABLED_BY_DEFAULT("system_stats"));
+  base::trace_event::TraceLog::GetCategoryGroupEnabled(
+      TRACE_DISABLED_BY_DEFAULT("system_stats.process"));
 
   // Allow this to be instantiated on unsupported platforms, but don't run.
   base::trace_event::TraceLog::GetInstance()->AddAsyncEnabledStateObserver(
@@ -62,10 +67,19 @@ TraceEventSystemStatsMonitor::~TraceEventSystemStatsMonitor() {
       this);
 }
 
+bool TraceEventSystemStatsMonitor::is_sampling_processes_for_testing() const {
+  return process_stats_sampler_ && process_stats_sampler_->is_sampling();
+}
+
 void TraceEventSystemStatsMonitor::OnTraceLogEnabled() {
-  // Check to see if system tracing is enabled.
+  // Check to see if per-process sampling is enabled.
   bool enabled;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(
+      TRACE_DISABLED_BY_DEFAULT("system_stats.process"), &enabled);
+  if (enabled)
+    StartProcessSampling();
 
+  // Check to see if system tracing is enabled.
   TRACE_EVENT_CATEGORY_GROUP_ENABLED(TRACE_DISABLED_BY_DEFAULT("system_stats"),
                                      &enabled);
   if (!enabled)
@@ -102,7 +116,21 @@ void TraceEventSystemStatsMonitor::OnSystemMetricsStruct(
       static_cast<void*>(this), std::move(dump_holder));
 }
 
+void TraceEventSystemStatsMonitor::StartProcessSampling() {
+  if (!base::FeatureList::IsEnabled(features::kTracePerProcessStats))
+    return;
+  if (!process_stats_sampler_) {
+    process_stats_sampler_ = std::make_unique<TraceProcessStatsSampler>(
+        base::TimeDelta::FromMilliseconds(
+            features::kTracePerProcessStatsIntervalMs.Get()));
+  }
+  process_stats_sampler_->Start();
+}
+
 void TraceEventSystemStatsMonitor::StopProfiling() {
+  if (process_stats_sampler_)
+    process_stats_sampler_->Stop();
+
   // Watch for the tracing framework sending disabling more than once.
   if (is_profiling_) {
     is_profiling_ = false;
@@ -5,6 +5,8 @@
 #ifndef CHROME_BROWSER_TRACING_TRACE_EVENT_SYSTEM_STATS_MONITOR_H_
 #define CHROME_BROWSER_TRACING_TRACE_EVENT_SYSTEM_STATS_MONITOR_H_
 
+#include <memory>
+
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/process/process_metrics.h"
@@ -13,9 +15,13 @@
 
 namespace tracing {
 
+class TraceProcessStatsSampler;
+
 // Watches for chrome://tracing to be enabled or disabled. When tracing is
 // enabled, also enables system events profiling. This class is the preferred
-// way to turn system tracing on and off.
+// way to turn system tracing on and off. Per-process stats are sampled by a
+// TraceProcessStatsSampler when the "system_stats.process" category is
+// enabled as well.
 class TraceEventSystemStatsMonitor
     : public base::trace_event::TraceLog::AsyncEnabledStateObserver,
       public performance_monitor::SystemMonitor::SystemObserver {
@@ -32,11 +38,16 @@ class TraceEventSystemStatsMonitor
   void StartProfilingForTesting() { StartProfiling(); }
   void StopProfilingForTesting() { StopProfiling(); }
 
+  bool is_sampling_processes_for_testing() const;
+  void StartProcessSamplingForTesting() { StartProcessSampling(); }
+
  private:
   void StartProfiling();
 
   void StopProfiling();
 
+  void StartProcessSampling();
+
   // performance_monitor::SystemMonitor::SystemObserver:
   void OnSystemMetricsStruct(
       const base::SystemMetrics& system_metrics) override;
@@ -44,6 +55,9 @@ class TraceEventSystemStatsMonitor
   // Indicates if profiling has started.
   bool is_profiling_ = false;
 
+  // Created the first time per-process sampling is enabled.
+  std::unique_ptr<TraceProcessStatsSampler> process_stats_sampler_;
+
   base::WeakPtrFactory<TraceEventSystemStatsMonitor> weak_factory_{this};
 
   DISALLOW_COPY_AND_ASSIGN(TraceEventSystemStatsMonitor);
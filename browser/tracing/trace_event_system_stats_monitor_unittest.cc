@@ -5,8 +5,11 @@
 #include "chrome/browser/tracing/trace_event_system_stats_monitor.h"
 
 #include "base/run_loop.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/task_environment.h"
 #include "chrome/browser/performance_monitor/system_monitor.h"
+#include "chrome/common/chrome_features.h"
+#include "content/public/test/browser_task_environment.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace tracing {
@@ -37,4 +40,33 @@ TEST_F(TraceSystemStatsMonitorTest, TraceEventSystemStatsMonitor) {
   EXPECT_FALSE(system_stats_monitor.is_profiling_for_testing());
 }
 
+TEST_F(TraceSystemStatsMonitorTest, ProcessSampling) {
+  base::test::ScopedFeatureList feature_list(features::kTracePerProcessStats);
+  content::BrowserTaskEnvironment task_environment;
+
+  auto system_monitor = performance_monitor::SystemMonitor::Create();
+  TraceEventSystemStatsMonitor system_stats_monitor;
+  EXPECT_FALSE(system_stats_monitor.is_sampling_processes_for_testing());
+
+  // Simulate enabling tracing with the "system_stats.process" category.
+  system_stats_monitor.StartProcessSamplingForTesting();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(system_stats_monitor.is_sampling_processes_for_testing());
+
+  // Disabling tracing stops the sampling too.
+  system_stats_monitor.StopProfilingForTesting();
+  EXPECT_FALSE(system_stats_monitor.is_sampling_processes_for_testing());
+}
+
+TEST_F(TraceSystemStatsMonitorTest, NoProcessSamplingWithoutFeature) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndDisableFeature(features::kTracePerProcessStats);
+  content::BrowserTaskEnvironment task_environment;
+
+  auto system_monitor = performance_monitor::SystemMonitor::Create();
+  TraceEventSystemStatsMonitor system_stats_monitor;
+  system_stats_monitor.StartProcessSamplingForTesting();
+  EXPECT_FALSE(system_stats_monitor.is_sampling_processes_for_testing());
+}
+
 }  // namespace tracing
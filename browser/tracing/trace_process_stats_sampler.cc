@@ -0,0 +1,349 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/tracing/trace_process_stats_sampler.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/feature_list.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/task/thread_pool.h"
+#include "base/trace_event/trace_event.h"
+#include "base/trace_event/trace_log.h"
+#include "content/public/browser/browser_task_traits.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/common/content_features.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+#include <unistd.h>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/stringprintf.h"
+#else
+#include "base/process/process.h"
+#include "base/process/process_metrics.h"
+#endif
+
+#if defined(OS_MAC)
+#include "content/public/browser/browser_child_process_host.h"
+#endif
+
+namespace tracing {
+
+namespace {
+
+constexpr char kCategory[] = TRACE_DISABLED_BY_DEFAULT("system_stats.process");
+
+// The fraction of the trace buffer above which sampling backs off, and below
+// which it may speed up again.
+constexpr double kBufferBackOffFullness = 0.75;
+constexpr double kBufferRecoverFullness = 0.5;
+
+// Returns how full the trace buffer is, from 0 to 1, or 0 if unknown.
+double GetTraceBufferFullness() {
+  const base::trace_event::TraceLogStatus status =
+      base::trace_event::TraceLog::GetInstance()->GetStatus();
+  if (!status.event_capacity)
+    return 0.0;
+  return static_cast<double>(status.event_count) / status.event_capacity;
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+// Returns the value of the "|key|:" line of a /proc status or io file.
+uint64_t GetProcfsValue(base::StringPiece contents, base::StringPiece key) {
+  for (base::StringPiece line : base::SplitStringPiece(
+           contents, "\n", base::KEEP_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+    if (!base::StartsWith(line, key, base::CompareCase::SENSITIVE) ||
+        line.size() <= key.size() || line[key.size()] != ':') {
+      continue;
+    }
+    uint64_t value = 0;
+    base::StringToUint64(
+        base::TrimWhitespaceASCII(line.substr(key.size() + 1), base::TRIM_ALL),
+        &value);
+    return value;
+  }
+  return 0;
+}
+#endif
+
+}  // namespace
+
+// Reads the counters of the sampled processes and emits them. Lives on a
+// sequence which may block.
+class TraceProcessStatsSampler::Reader {
+ public:
+  Reader() = default;
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Samples |pids| and emits the counters of the processes which were also
+  // sampled by the previous tick. Processes which are gone are forgotten.
+  // Returns the time spent.
+  base::TimeDelta Sample(std::vector<base::ProcessId> pids) {
+    const base::TimeTicks start = base::TimeTicks::Now();
+    std::map<base::ProcessId, ProcessState> states;
+    for (base::ProcessId pid : pids) {
+      auto it = states_.find(pid);
+      ProcessState state =
+          it != states_.end() ? std::move(it->second) : ProcessState();
+      ProcessCounters counters;
+      if (!ReadCounters(pid, &state, &counters))
+        continue;
+      if (!state.sample_time.is_null())
+        Emit(pid, state.counters, counters, start - state.sample_time);
+      state.counters = counters;
+      state.sample_time = start;
+      states.emplace(pid, std::move(state));
+    }
+    states_ = std::move(states);
+    return base::TimeTicks::Now() - start;
+  }
+
+ private:
+  struct ProcessState {
+    base::TimeTicks sample_time;
+    ProcessCounters counters;
+#if !defined(OS_LINUX) && !defined(OS_CHROMEOS) && !defined(OS_ANDROID)
+    base::Process process;
+    std::unique_ptr<base::ProcessMetrics> metrics;
+#endif
+  };
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  bool ReadCounters(base::ProcessId pid,
+                    ProcessState* state,
+                    ProcessCounters* counters) {
+    // The buffers are reused across processes and ticks, to avoid allocating
+    // while sampling.
+    const base::FilePath proc_dir(base::StringPrintf("/proc/%d", pid));
+    if (!base::ReadFileToString(proc_dir.Append("stat"), &stat_) ||
+        !base::ReadFileToString(proc_dir.Append("status"), &status_)) {
+      return false;
+    }
+    if (!base::ReadFileToString(proc_dir.Append("io"), &io_))
+      io_.clear();
+    return ParseProcfsCounters(stat_, status_, io_, clock_ticks_per_second_,
+                               page_size_, counters);
+  }
+#else
+  bool ReadCounters(base::ProcessId pid,
+                    ProcessState* state,
+                    ProcessCounters* counters) {
+    if (!state->metrics) {
+#if defined(OS_MAC)
+      state->metrics = base::ProcessMetrics::CreateProcessMetrics(
+          pid, content::BrowserChildProcessHost::GetPortProvider());
+#else
+      state->process = base::Process::Open(pid);
+      if (!state->process.IsValid())
+        return false;
+      state->metrics =
+          base::ProcessMetrics::CreateProcessMetrics(state->process.Handle());
+#endif
+    }
+    counters->cpu_time = state->metrics->GetCumulativeCPUUsage();
+    return true;
+  }
+#endif
+
+  static void Emit(base::ProcessId pid,
+                   const ProcessCounters& previous,
+                   const ProcessCounters& current,
+                   base::TimeDelta elapsed) {
+    if (elapsed <= base::TimeDelta())
+      return;
+    const double seconds = elapsed.InSecondsF();
+    auto rate = [seconds](uint64_t previous, uint64_t current) {
+      return static_cast<int64_t>(
+          (current > previous ? current - previous : 0) / seconds);
+    };
+
+    TRACE_COUNTER_ID1(kCategory, "ProcessCpuUsage", pid,
+                      static_cast<int64_t>(
+                          100 * (current.cpu_time - previous.cpu_time) /
+                          elapsed));
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+    TRACE_COUNTER_ID1(kCategory, "ProcessResidentKB", pid,
+                      current.resident_bytes / 1024);
+    TRACE_COUNTER_ID2(
+        kCategory, "ProcessPageFaultsPerSecond", pid, "minor",
+        rate(previous.minor_page_faults, current.minor_page_faults), "major",
+        rate(previous.major_page_faults, current.major_page_faults));
+    TRACE_COUNTER_ID1(
+        kCategory, "ProcessContextSwitchesPerSecond", pid,
+        rate(previous.context_switches, current.context_switches));
+    TRACE_COUNTER_ID2(kCategory, "ProcessIOBytesPerSecond", pid, "read",
+                      rate(previous.read_bytes, current.read_bytes), "write",
+                      rate(previous.write_bytes, current.write_bytes));
+#endif
+  }
+
+  std::map<base::ProcessId, ProcessState> states_;
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  const int64_t clock_ticks_per_second_ = sysconf(_SC_CLK_TCK);
+  const int64_t page_size_ = sysconf(_SC_PAGESIZE);
+  std::string stat_;
+  std::string status_;
+  std::string io_;
+#endif
+};
+
+// static
+constexpr double TraceProcessStatsSampler::kTickBudget;
+// static
+constexpr base::TimeDelta TraceProcessStatsSampler::kMaxInterval;
+
+TraceProcessStatsSampler::TraceProcessStatsSampler(base::TimeDelta interval)
+    : base_interval_(interval),
+      interval_(interval),
+      reader_(base::ThreadPool::CreateSequencedTaskRunner(
+          {base::MayBlock(), base::TaskPriority::USER_VISIBLE,
+           base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN})) {}
+
+TraceProcessStatsSampler::~TraceProcessStatsSampler() = default;
+
+void TraceProcessStatsSampler::Start() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (is_sampling_)
+    return;
+  is_sampling_ = true;
+  interval_ = base_interval_;
+  Tick();
+}
+
+void TraceProcessStatsSampler::Stop() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  is_sampling_ = false;
+  timer_.Stop();
+  weak_factory_.InvalidateWeakPtrs();
+}
+
+// static
+base::TimeDelta TraceProcessStatsSampler::AdaptInterval(
+    base::TimeDelta interval,
+    base::TimeDelta base_interval,
+    base::TimeDelta tick_cost,
+    double buffer_fullness) {
+  const base::TimeDelta budget = interval * kTickBudget;
+  if (tick_cost > budget || buffer_fullness > kBufferBackOffFullness)
+    return std::min(interval * 2, std::max(kMaxInterval, base_interval));
+  if (tick_cost < budget / 2 && buffer_fullness < kBufferRecoverFullness)
+    return std::max(interval / 2, base_interval);
+  return interval;
+}
+
+void TraceProcessStatsSampler::ScheduleTick() {
+  timer_.Start(FROM_HERE, interval_,
+               base::BindOnce(&TraceProcessStatsSampler::Tick,
+                              weak_factory_.GetWeakPtr()));
+}
+
+void TraceProcessStatsSampler::Tick() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  std::vector<performance_monitor::ProcessMetadata> ui_thread_processes =
+      performance_monitor::ProcessMonitor::GatherProcessesOnUIThread();
+
+  auto task_runner = base::FeatureList::IsEnabled(features::kProcessHostOnUI)
+                         ? content::GetUIThreadTaskRunner({})
+                         : content::GetIOThreadTaskRunner({});
+  task_runner->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      base::BindOnce(
+          &performance_monitor::ProcessMonitor::GatherProcessesOnProcessThread),
+      base::BindOnce(&TraceProcessStatsSampler::OnProcessesGathered,
+                     weak_factory_.GetWeakPtr(),
+                     std::move(ui_thread_processes)));
+}
+
+void TraceProcessStatsSampler::OnProcessesGathered(
+    std::vector<performance_monitor::ProcessMetadata> ui_thread_processes,
+    std::vector<performance_monitor::ProcessMetadata>
+        process_thread_processes) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  std::vector<base::ProcessId> pids;
+  pids.reserve(ui_thread_processes.size() + process_thread_processes.size());
+  for (const auto* processes :
+       {&ui_thread_processes, &process_thread_processes}) {
+    for (const auto& process : *processes) {
+      if (process.handle != base::kNullProcessHandle)
+        pids.push_back(base::GetProcId(process.handle));
+    }
+  }
+
+  reader_.AsyncCall(&Reader::Sample)
+      .WithArgs(std::move(pids))
+      .Then(base::BindOnce(&TraceProcessStatsSampler::OnTickDone,
+                           weak_factory_.GetWeakPtr()));
+}
+
+void TraceProcessStatsSampler::OnTickDone(base::TimeDelta tick_cost) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  interval_ = AdaptInterval(interval_, base_interval_, tick_cost,
+                            GetTraceBufferFullness());
+  ScheduleTick();
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+// static
+bool TraceProcessStatsSampler::ParseProcfsCounters(
+    base::StringPiece stat,
+    base::StringPiece status,
+    base::StringPiece io,
+    int64_t clock_ticks_per_second,
+    int64_t page_size,
+    ProcessCounters* counters) {
+  // The process name in the second field may contain spaces and parentheses,
+  // so the fields are counted from the last closing parenthesis. The first of
+  // them is the state, the third field of the file.
+  const size_t name_end = stat.rfind(')');
+  if (name_end == base::StringPiece::npos || clock_ticks_per_second <= 0)
+    return false;
+  const std::vector<base::StringPiece> fields =
+      base::SplitStringPiece(stat.substr(name_end + 1), " ",
+                             base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  // Indices of the fields, from proc(5), counted from the state.
+  constexpr size_t kMinorFaults = 10 - 3;
+  constexpr size_t kMajorFaults = 12 - 3;
+  constexpr size_t kUserTime = 14 - 3;
+  constexpr size_t kSystemTime = 15 - 3;
+  constexpr size_t kResidentPages = 24 - 3;
+  if (fields.size() <= kResidentPages)
+    return false;
+
+  uint64_t user_time;
+  uint64_t system_time;
+  uint64_t resident_pages;
+  if (!base::StringToUint64(fields[kMinorFaults],
+                            &counters->minor_page_faults) ||
+      !base::StringToUint64(fields[kMajorFaults],
+                            &counters->major_page_faults) ||
+      !base::StringToUint64(fields[kUserTime], &user_time) ||
+      !base::StringToUint64(fields[kSystemTime], &system_time) ||
+      !base::StringToUint64(fields[kResidentPages], &resident_pages)) {
+    return false;
+  }
+  counters->cpu_time = base::TimeDelta::FromSecondsD(
+      static_cast<double>(user_time + system_time) / clock_ticks_per_second);
+  counters->resident_bytes = resident_pages * page_size;
+
+  counters->context_switches =
+      GetProcfsValue(status, "voluntary_ctxt_switches") +
+      GetProcfsValue(status, "nonvoluntary_ctxt_switches");
+  counters->read_bytes = GetProcfsValue(io, "read_bytes");
+  counters->write_bytes = GetProcfsValue(io, "write_bytes");
+  return true;
+}
+#endif
+
+}  // namespace tracing
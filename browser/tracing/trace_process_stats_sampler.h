@@ -0,0 +1,109 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_TRACING_TRACE_PROCESS_STATS_SAMPLER_H_
+#define CHROME_BROWSER_TRACING_TRACE_PROCESS_STATS_SAMPLER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/process/process_handle.h"
+#include "base/strings/string_piece.h"
+#include "base/threading/sequence_bound.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "build/build_config.h"
+#include "chrome/browser/performance_monitor/process_monitor.h"
+
+namespace tracing {
+
+// Samples the CPU usage, resident memory, page faults, context switches and IO
+// bytes of every Chrome process, and emits them as counter tracks of the
+// "disabled-by-default-system_stats.process" category, one per process id.
+//
+// The processes are enumerated on the UI thread, and all their counters are
+// read in one batch per tick on a background sequence; on Linux, from /proc.
+// The time spent reading is kept under a fraction of the interval: the
+// interval backs off when a tick goes over budget or when the trace buffer
+// fills up, and recovers towards the configured interval otherwise.
+class TraceProcessStatsSampler {
+ public:
+  // Cumulative counters of a process, except |resident_bytes|. Counters which
+  // aren't available on the platform stay 0.
+  struct ProcessCounters {
+    base::TimeDelta cpu_time;
+    uint64_t resident_bytes = 0;
+    uint64_t minor_page_faults = 0;
+    uint64_t major_page_faults = 0;
+    uint64_t context_switches = 0;
+    uint64_t read_bytes = 0;
+    uint64_t write_bytes = 0;
+  };
+
+  // The fraction of the interval that a tick may spend reading counters.
+  static constexpr double kTickBudget = 0.01;
+
+  // The longest interval the sampler backs off to.
+  static constexpr base::TimeDelta kMaxInterval =
+      base::TimeDelta::FromSeconds(10);
+
+  explicit TraceProcessStatsSampler(base::TimeDelta interval);
+  ~TraceProcessStatsSampler();
+
+  TraceProcessStatsSampler(const TraceProcessStatsSampler&) = delete;
+  TraceProcessStatsSampler& operator=(const TraceProcessStatsSampler&) =
+      delete;
+
+  void Start();
+  void Stop();
+
+  bool is_sampling() const { return is_sampling_; }
+  base::TimeDelta interval() const { return interval_; }
+
+  // Returns the interval to use after a tick at |interval| which took
+  // |tick_cost|, with the trace buffer |buffer_fullness| full, from 0 to 1.
+  static base::TimeDelta AdaptInterval(base::TimeDelta interval,
+                                       base::TimeDelta base_interval,
+                                       base::TimeDelta tick_cost,
+                                       double buffer_fullness);
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+  // Parses the contents of /proc/<pid>/stat, /proc/<pid>/status and
+  // /proc/<pid>/io into |counters|. |io| may be empty, as it's not readable
+  // for every process. Exposed for testing.
+  static bool ParseProcfsCounters(base::StringPiece stat,
+                                  base::StringPiece status,
+                                  base::StringPiece io,
+                                  int64_t clock_ticks_per_second,
+                                  int64_t page_size,
+                                  ProcessCounters* counters);
+#endif
+
+ private:
+  class Reader;
+
+  void ScheduleTick();
+  void Tick();
+  void OnProcessesGathered(
+      std::vector<performance_monitor::ProcessMetadata> ui_thread_processes,
+      std::vector<performance_monitor::ProcessMetadata>
+          process_thread_processes);
+  void OnTickDone(base::TimeDelta tick_cost);
+
+  const base::TimeDelta base_interval_;
+  base::TimeDelta interval_;
+  bool is_sampling_ = false;
+
+  base::OneShotTimer timer_;
+  base::SequenceBound<Reader> reader_;
+
+  // Invalidated on Stop(), to drop the replies of pending ticks.
+  base::WeakPtrFactory<TraceProcessStatsSampler> weak_factory_{this};
+};
+
+}  // namespace tracing
+
+#endif  // CHROME_BROWSER_TRACING_TRACE_PROCESS_STATS_SAMPLER_H_
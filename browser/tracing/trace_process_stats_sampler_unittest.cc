@@ -0,0 +1,89 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/tracing/trace_process_stats_sampler.h"
+
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tracing {
+
+namespace {
+
+constexpr base::TimeDelta kInterval = base::TimeDelta::FromMilliseconds(100);
+
+}  // namespace
+
+TEST(TraceProcessStatsSamplerTest, AdaptInterval) {
+  // Ticks within budget keep the interval.
+  EXPECT_EQ(kInterval, TraceProcessStatsSampler::AdaptInterval(
+                           kInterval, kInterval,
+                           base::TimeDelta::FromMicroseconds(100), 0.0));
+
+  // Expensive ticks and a filling trace buffer back off.
+  EXPECT_EQ(2 * kInterval, TraceProcessStatsSampler::AdaptInterval(
+                               kInterval, kInterval,
+                               base::TimeDelta::FromMilliseconds(5), 0.0));
+  EXPECT_EQ(2 * kInterval, TraceProcessStatsSampler::AdaptInterval(
+                               kInterval, kInterval,
+                               base::TimeDelta::FromMicroseconds(100), 0.9));
+  EXPECT_EQ(TraceProcessStatsSampler::kMaxInterval,
+            TraceProcessStatsSampler::AdaptInterval(
+                TraceProcessStatsSampler::kMaxInterval, kInterval,
+                base::TimeDelta::FromSeconds(1), 0.9));
+
+  // Cheap ticks recover towards the configured interval.
+  EXPECT_EQ(2 * kInterval, TraceProcessStatsSampler::AdaptInterval(
+                               4 * kInterval, kInterval,
+                               base::TimeDelta::FromMicroseconds(100), 0.0));
+  EXPECT_EQ(kInterval, TraceProcessStatsSampler::AdaptInterval(
+                           kInterval, kInterval, base::TimeDelta(), 0.0));
+  EXPECT_EQ(4 * kInterval, TraceProcessStatsSampler::AdaptInterval(
+                               4 * kInterval, kInterval,
+                               base::TimeDelta::FromMicroseconds(100), 0.6));
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+TEST(TraceProcessStatsSamplerTest, ParseProcfsCounters) {
+  constexpr char kStat[] =
+      "1234 (a (strange) name) S 1 1234 1234 0 -1 4194560 500 0 7 0 250 50 0 "
+      "0 20 0 12 0 1000 123456789 2048 18446744073709551615 1 1 0 0 0 0 0 0 "
+      "0 0 0 0 17 3 0 0 0 0 0\n";
+  constexpr char kStatus[] =
+      "Name:\tchrome\n"
+      "VmRSS:\t8192 kB\n"
+      "voluntary_ctxt_switches:\t40\n"
+      "nonvoluntary_ctxt_switches:\t2\n";
+  constexpr char kIo[] =
+      "rchar: 100\n"
+      "read_bytes: 4096\n"
+      "write_bytes: 8192\n"
+      "cancelled_write_bytes: 0\n";
+
+  TraceProcessStatsSampler::ProcessCounters counters;
+  ASSERT_TRUE(TraceProcessStatsSampler::ParseProcfsCounters(
+      kStat, kStatus, kIo, 100, 4096, &counters));
+  EXPECT_EQ(base::TimeDelta::FromSeconds(3), counters.cpu_time);
+  EXPECT_EQ(2048u * 4096u, counters.resident_bytes);
+  EXPECT_EQ(500u, counters.minor_page_faults);
+  EXPECT_EQ(7u, counters.major_page_faults);
+  EXPECT_EQ(42u, counters.context_switches);
+  EXPECT_EQ(4096u, counters.read_bytes);
+  EXPECT_EQ(8192u, counters.write_bytes);
+
+  // The io file isn't readable for every process.
+  TraceProcessStatsSampler::ProcessCounters without_io;
+  ASSERT_TRUE(TraceProcessStatsSampler::ParseProcfsCounters(
+      kStat, kStatus, "", 100, 4096, &without_io));
+  EXPECT_EQ(0u, without_io.read_bytes);
+
+  EXPECT_FALSE(TraceProcessStatsSampler::ParseProcfsCounters(
+      "1234 (truncated", kStatus, kIo, 100, 4096, &counters));
+  EXPECT_FALSE(TraceProcessStatsSampler::ParseProcfsCounters(
+      "1234 (short) S 1 2 3", kStatus, kIo, 100, 4096, &counters));
+}
+#endif
+
+}  // namespace tracing
@@ -165,6 +165,27 @@ class ArcAppIcon::DecodeRequest : public ImageDecoder::ImageRequest {
   DISALLOW_COPY_AND_ASSIGN(DecodeRequest);
 };
 
+// Decodes the foreground and background images of an adaptive icon in one
+// ImageDecoder batch, and forwards each result to the DecodeRequest of the
+// image.
+class ArcAppIcon::AdaptiveDecodeRequest : public ImageDecoder::BatchRequest {
+ public:
+  AdaptiveDecodeRequest(ArcAppIcon& host,
+                        DecodeRequest* foreground_request,
+                        DecodeRequest* background_request);
+  AdaptiveDecodeRequest(const AdaptiveDecodeRequest&) = delete;
+  AdaptiveDecodeRequest& operator=(const AdaptiveDecodeRequest&) = delete;
+  ~AdaptiveDecodeRequest() override;
+
+  // ImageDecoder::BatchRequest
+  void OnBatchDecoded(std::vector<SkBitmap> decoded_images) override;
+
+ private:
+  ArcAppIcon& host_;
+  DecodeRequest* const foreground_request_;
+  DecodeRequest* const background_request_;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // ArcAppIcon::DecodeRequest
 
@@ -222,6 +243,38 @@ void ArcAppIcon::DecodeRequest::OnDecodeImageFailed() {
   host_.DiscardDecodeRequest(this, false /* bool is_decode_success*/);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// ArcAppIcon::AdaptiveDecodeRequest
+
+ArcAppIcon::AdaptiveDecodeRequest::AdaptiveDecodeRequest(
+    ArcAppIcon& host,
+    DecodeRequest* foreground_request,
+    DecodeRequest* background_request)
+    : BatchRequest(&GetDataDecoder()),
+      host_(host),
+      foreground_request_(foreground_request),
+      background_request_(background_request) {}
+
+ArcAppIcon::AdaptiveDecodeRequest::~AdaptiveDecodeRequest() = default;
+
+void ArcAppIcon::AdaptiveDecodeRequest::OnBatchDecoded(
+    std::vector<SkBitmap> decoded_images) {
+  DCHECK_EQ(2u, decoded_images.size());
+  // The observer notified by the requests may delete |host_|, and with it the
+  // requests, so this takes ownership of itself first and stops as soon as
+  // |host_| is gone.
+  base::WeakPtr<ArcAppIcon> host = host_.weak_ptr_factory_.GetWeakPtr();
+  std::unique_ptr<AdaptiveDecodeRequest> self =
+      host_.TakeAdaptiveDecodeRequest(this);
+  DecodeRequest* requests[] = {foreground_request_, background_request_};
+  for (size_t i = 0; i < 2 && host; ++i) {
+    if (decoded_images[i].isNull())
+      requests[i]->OnDecodeImageFailed();
+    else
+      requests[i]->OnImageDecoded(decoded_images[i]);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // ArcAppIcon
 
@@ -692,16 +745,11 @@ void ArcAppIcon::OnIconRead(
       }
 
       DCHECK_EQ(2u, read_result->unsafe_icon_data.size());
-      DecodeImage(read_result->unsafe_icon_data[0],
-                  ArcAppIconDescriptor(resource_size_in_dip_,
-                                       read_result->scale_factor),
-                  read_result->resize_allowed, true /* retain_padding */,
-                  foreground_image_skia_, foreground_incomplete_scale_factors_);
-      DecodeImage(read_result->unsafe_icon_data[1],
-                  ArcAppIconDescriptor(resource_size_in_dip_,
-                                       read_result->scale_factor),
-                  read_result->resize_allowed, true /* retain_padding */,
-                  background_image_skia_, background_incomplete_scale_factors_);
+      DecodeAdaptiveImages(read_result->unsafe_icon_data[0],
+                           read_result->unsafe_icon_data[1],
+                           ArcAppIconDescriptor(resource_size_in_dip_,
+                                                read_result->scale_factor),
+                           read_result->resize_allowed);
       return;
     }
   }
@@ -732,6 +780,44 @@ void ArcAppIcon::DecodeImage(
   }
 }
 
+void ArcAppIcon::DecodeAdaptiveImages(
+    const std::string& unsafe_foreground_icon_data,
+    const std::string& unsafe_background_icon_data,
+    const ArcAppIconDescriptor& descriptor,
+    bool resize_allowed) {
+  if (disable_safe_decoding_for_testing) {
+    DecodeImage(unsafe_foreground_icon_data, descriptor, resize_allowed,
+                true /* retain_padding */, foreground_image_skia_,
+                foreground_incomplete_scale_factors_);
+    DecodeImage(unsafe_background_icon_data, descriptor, resize_allowed,
+                true /* retain_padding */, background_image_skia_,
+                background_incomplete_scale_factors_);
+    return;
+  }
+
+  decode_requests_.emplace_back(std::make_unique<DecodeRequest>(
+      *this, descriptor, resize_allowed, true /* retain_padding */,
+      foreground_image_skia_, foreground_incomplete_scale_factors_));
+  DecodeRequest* foreground_request = decode_requests_.back().get();
+  decode_requests_.emplace_back(std::make_unique<DecodeRequest>(
+      *this, descriptor, resize_allowed, true /* retain_padding */,
+      background_image_skia_, background_incomplete_scale_factors_));
+  DecodeRequest* background_request = decode_requests_.back().get();
+
+  adaptive_decode_requests_.emplace_back(
+      std::make_unique<AdaptiveDecodeRequest>(*this, foreground_request,
+                                              background_request));
+  std::vector<std::vector<uint8_t>> images;
+  images.emplace_back(unsafe_foreground_icon_data.begin(),
+                      unsafe_foreground_icon_data.end());
+  images.emplace_back(unsafe_background_icon_data.begin(),
+                      unsafe_background_icon_data.end());
+  ImageDecoder::StartBatch(adaptive_decode_requests_.back().get(),
+                           std::move(images), ImageDecoder::DEFAULT_CODEC,
+                           false /* shrink_to_fit */, gfx::Size(),
+                           base::TaskPriority::USER_VISIBLE);
+}
+
 void ArcAppIcon::UpdateImageSkia(
     ui::ScaleFactor scale_factor,
     const SkBitmap& bitmap,
@@ -793,3 +879,18 @@ void ArcAppIcon::DiscardDecodeRequest(DecodeRequest* request,
   if (!is_decode_success)
     observer_->OnIconFailed(this);
 }
+
+std::unique_ptr<ArcAppIcon::AdaptiveDecodeRequest>
+ArcAppIcon::TakeAdaptiveDecodeRequest(AdaptiveDecodeRequest* request) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+  auto it = std::find_if(
+      adaptive_decode_requests_.begin(), adaptive_decode_requests_.end(),
+      [request](const std::unique_ptr<AdaptiveDecodeRequest>& ptr) {
+        return ptr.get() == request;
+      });
+  DCHECK(it != adaptive_decode_requests_.end());
+  std::unique_ptr<AdaptiveDecodeRequest> taken = std::move(*it);
+  adaptive_decode_requests_.erase(it);
+  return taken;
+}
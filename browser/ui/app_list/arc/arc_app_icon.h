@@ -165,6 +165,7 @@ class ArcAppIcon {
 
   class Source;
   class DecodeRequest;
+  class AdaptiveDecodeRequest;
 
   void MaybeRequestIcon(ui::ScaleFactor scale_factor);
   static std::unique_ptr<ArcAppIcon::ReadResult> ReadOnBackgroundThread(
@@ -232,6 +233,11 @@ class ArcAppIcon {
       bool retain_padding,
       gfx::ImageSkia& image_skia,
       std::map<ui::ScaleFactor, base::Time>& incomplete_scale_factors);
+  // Decodes both images of an adaptive icon in one ImageDecoder batch.
+  void DecodeAdaptiveImages(const std::string& unsafe_foreground_icon_data,
+                            const std::string& unsafe_background_icon_data,
+                            const ArcAppIconDescriptor& descriptor,
+                            bool resize_allowed);
   void UpdateImageSkia(
       ui::ScaleFactor scale_factor,
       const SkBitmap& bitmap,
@@ -239,6 +245,9 @@ class ArcAppIcon {
       std::map<ui::ScaleFactor, base::Time>& incomplete_scale_factors);
   void UpdateCompressed(ui::ScaleFactor scale_factor, std::string data);
   void DiscardDecodeRequest(DecodeRequest* request, bool is_decode_success);
+  // Removes |request| from |adaptive_decode_requests_| and returns it.
+  std::unique_ptr<AdaptiveDecodeRequest> TakeAdaptiveDecodeRequest(
+      AdaptiveDecodeRequest* request);
 
   content::BrowserContext* const context_;
   const std::string app_id_;
@@ -268,6 +277,9 @@ class ArcAppIcon {
 
   // Contains pending image decode requests.
   std::vector<std::unique_ptr<DecodeRequest>> decode_requests_;
+  // Contains pending batches of adaptive icon images. Their images are handled
+  // by requests of |decode_requests_|, so they are destroyed first.
+  std::vector<std::unique_ptr<AdaptiveDecodeRequest>> adaptive_decode_requests_;
 
   base::WeakPtrFactory<ArcAppIcon> weak_ptr_factory_{this};
 
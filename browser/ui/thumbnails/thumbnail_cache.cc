@@ -0,0 +1,113 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/ui/thumbnails/thumbnail_cache.h"
+
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/location.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+
+namespace {
+
+// Global instance. Only set once, except in tests which can reset the
+// instance and create a new one.
+ThumbnailCache* g_instance = nullptr;
+
+}  // namespace
+
+// static
+constexpr size_t ThumbnailCache::kDefaultMaxBytes;
+
+// static
+ThumbnailCache& ThumbnailCache::GetInstance() {
+  if (!g_instance)
+    g_instance = new ThumbnailCache(kDefaultMaxBytes);
+  return *g_instance;
+}
+
+// static
+void ThumbnailCache::ResetInstanceForTesting(size_t max_bytes) {
+  delete g_instance;
+  g_instance = new ThumbnailCache(max_bytes);
+}
+
+ThumbnailCache::ThumbnailCache(size_t max_bytes)
+    : max_bytes_(max_bytes), images_(decltype(images_)::NO_AUTO_EVICT) {
+  DETACH_FROM_SEQUENCE(sequence_checker_);
+  memory_pressure_listener_ = std::make_unique<base::MemoryPressureListener>(
+      FROM_HERE, base::BindRepeating(&ThumbnailCache::OnMemoryPressure,
+                                     base::Unretained(this)));
+}
+
+ThumbnailCache::~ThumbnailCache() = default;
+
+gfx::ImageSkia ThumbnailCache::Get(const base::Token& thumbnail_id,
+                                   Variant variant) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  auto it = images_.Get(std::make_pair(thumbnail_id, variant));
+  return it != images_.end() ? it->second : gfx::ImageSkia();
+}
+
+void ThumbnailCache::Put(const base::Token& thumbnail_id,
+                         Variant variant,
+                         gfx::ImageSkia image) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  const size_t bytes = GetSizeInBytes(image);
+  if (image.isNull() || bytes > max_bytes_)
+    return;
+
+  auto key = std::make_pair(thumbnail_id, variant);
+  auto existing = images_.Peek(key);
+  if (existing != images_.end()) {
+    total_bytes_ -= GetSizeInBytes(existing->second);
+    images_.Erase(existing);
+  }
+
+  EvictUntilBytesAtMost(max_bytes_ - bytes);
+  images_.Put(std::move(key), std::move(image));
+  total_bytes_ += bytes;
+}
+
+void ThumbnailCache::Remove(const base::Token& thumbnail_id) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  for (Variant variant : {Variant::kLarge, Variant::kSmall}) {
+    auto it = images_.Peek(std::make_pair(thumbnail_id, variant));
+    if (it != images_.end()) {
+      total_bytes_ -= GetSizeInBytes(it->second);
+      images_.Erase(it);
+    }
+  }
+}
+
+void ThumbnailCache::EvictUntilBytesAtMost(size_t max_bytes) {
+  while (total_bytes_ > max_bytes && !images_.empty()) {
+    auto lru = images_.rbegin();
+    DCHECK_GE(total_bytes_, GetSizeInBytes(lru->second));
+    total_bytes_ -= GetSizeInBytes(lru->second);
+    images_.Erase(lru);
+  }
+}
+
+void ThumbnailCache::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel level) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  switch (level) {
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+      return;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+      // Keep the thumbnails viewed last, such as the hover card being shown.
+      EvictUntilBytesAtMost(max_bytes_ / 4);
+      return;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+      images_.Clear();
+      total_bytes_ = 0;
+      return;
+  }
+}
+
+// static
+size_t ThumbnailCache::GetSizeInBytes(const gfx::ImageSkia& image) {
+  return image.isNull() ? 0 : image.bitmap()->computeByteSize();
+}
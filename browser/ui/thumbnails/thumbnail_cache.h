@@ -0,0 +1,92 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_UI_THUMBNAILS_THUMBNAIL_CACHE_H_
+#define CHROME_BROWSER_UI_THUMBNAILS_THUMBNAIL_CACHE_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <utility>
+
+#include "base/containers/mru_cache.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/sequence_checker.h"
+#include "base/token.h"
+#include "ui/gfx/image/image_skia.h"
+
+// Keeps the decoded images of the most recently viewed thumbnails across all
+// tabs of the browser process, within a byte budget, so that showing a hover
+// card or the tab search again doesn't decode the JPEG data of the thumbnail
+// again. Least recently used images are evicted first, and images are dropped
+// under memory pressure: they can always be decoded again from the JPEG data
+// each ThumbnailImage keeps.
+//
+// A thumbnail is decoded in one of two variants: the large one at the size of
+// the capture, and the small one, downscaled, for subscribers which only need
+// a small image.
+class ThumbnailCache {
+ public:
+  enum class Variant {
+    kLarge,
+    kSmall,
+  };
+
+  // The default budget of decoded images, in bytes.
+  static constexpr size_t kDefaultMaxBytes = 32 * 1024 * 1024;
+
+  ThumbnailCache(const ThumbnailCache&) = delete;
+  ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+  size_t total_bytes() const { return total_bytes_; }
+
+ private:
+  friend class ThumbnailImage;
+
+  friend class ThumbnailCacheTest;
+  friend class ThumbnailImageTest;
+
+  // Gets the global instance for this process.
+  static ThumbnailCache& GetInstance();
+
+  // Replaces the global instance with one of budget |max_bytes|.
+  static void ResetInstanceForTesting(size_t max_bytes = kDefaultMaxBytes);
+
+  explicit ThumbnailCache(size_t max_bytes);
+
+  // Exists only for ResetInstanceForTesting().
+  ~ThumbnailCache();
+
+  // Returns the decoded |variant| of the thumbnail |thumbnail_id| and marks it
+  // as the most recently used, or returns a null image if it isn't cached.
+  gfx::ImageSkia Get(const base::Token& thumbnail_id, Variant variant);
+
+  // Caches |image| as the decoded |variant| of the thumbnail |thumbnail_id|,
+  // evicting the least recently used images to stay within the budget.
+  void Put(const base::Token& thumbnail_id,
+           Variant variant,
+           gfx::ImageSkia image);
+
+  // Drops both variants of the thumbnail |thumbnail_id|, which was replaced or
+  // cleared.
+  void Remove(const base::Token& thumbnail_id);
+
+  void EvictUntilBytesAtMost(size_t max_bytes);
+
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level);
+
+  static size_t GetSizeInBytes(const gfx::ImageSkia& image);
+
+  const size_t max_bytes_;
+  size_t total_bytes_ = 0;
+
+  base::MRUCache<std::pair<base::Token, Variant>, gfx::ImageSkia> images_;
+
+  std::unique_ptr<base::MemoryPressureListener> memory_pressure_listener_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+};
+
+#endif  // CHROME_BROWSER_UI_THUMBNAILS_THUMBNAIL_CACHE_H_
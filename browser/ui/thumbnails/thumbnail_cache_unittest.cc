@@ -0,0 +1,112 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/ui/thumbnails/thumbnail_cache.h"
+
+#include "base/memory/memory_pressure_listener.h"
+#include "base/test/task_environment.h"
+#include "base/token.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/image/image_skia.h"
+
+namespace {
+
+// Each test image takes 10 * 10 * 4 bytes.
+constexpr size_t kImageBytes = 400;
+
+gfx::ImageSkia CreateImage() {
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(10, 10);
+  bitmap.eraseARGB(255, 0, 255, 0);
+  return gfx::ImageSkia::CreateFrom1xBitmap(bitmap);
+}
+
+}  // namespace
+
+class ThumbnailCacheTest : public testing::Test {
+ protected:
+  using Variant = ThumbnailCache::Variant;
+
+  void SetUp() override {
+    // Room for three images.
+    ThumbnailCache::ResetInstanceForTesting(3 * kImageBytes);
+  }
+
+  ThumbnailCache& cache() { return ThumbnailCache::GetInstance(); }
+
+  bool Contains(const base::Token& thumbnail_id, Variant variant) {
+    return !cache().Get(thumbnail_id, variant).isNull();
+  }
+
+  void SimulateMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level) {
+    cache().OnMemoryPressure(level);
+  }
+
+ private:
+  base::test::TaskEnvironment task_environment_;
+};
+
+TEST_F(ThumbnailCacheTest, PutGetRemove) {
+  const base::Token thumbnail_id = base::Token::CreateRandom();
+  EXPECT_FALSE(Contains(thumbnail_id, Variant::kLarge));
+
+  cache().Put(thumbnail_id, Variant::kLarge, CreateImage());
+  EXPECT_TRUE(Contains(thumbnail_id, Variant::kLarge));
+  EXPECT_FALSE(Contains(thumbnail_id, Variant::kSmall));
+
+  cache().Put(thumbnail_id, Variant::kSmall, CreateImage());
+  EXPECT_TRUE(Contains(thumbnail_id, Variant::kSmall));
+  EXPECT_EQ(2 * kImageBytes, cache().total_bytes());
+
+  // Putting an image again replaces it.
+  cache().Put(thumbnail_id, Variant::kSmall, CreateImage());
+  EXPECT_EQ(2 * kImageBytes, cache().total_bytes());
+
+  cache().Remove(thumbnail_id);
+  EXPECT_FALSE(Contains(thumbnail_id, Variant::kLarge));
+  EXPECT_FALSE(Contains(thumbnail_id, Variant::kSmall));
+  EXPECT_EQ(0u, cache().total_bytes());
+}
+
+TEST_F(ThumbnailCacheTest, EvictsLeastRecentlyUsed) {
+  const base::Token ids[] = {
+      base::Token::CreateRandom(), base::Token::CreateRandom(),
+      base::Token::CreateRandom(), base::Token::CreateRandom()};
+  for (int i = 0; i < 3; ++i)
+    cache().Put(ids[i], Variant::kLarge, CreateImage());
+
+  // Viewing the first thumbnail again makes the second one the least recently
+  // used.
+  EXPECT_TRUE(Contains(ids[0], Variant::kLarge));
+  cache().Put(ids[3], Variant::kLarge, CreateImage());
+
+  EXPECT_EQ(3 * kImageBytes, cache().total_bytes());
+  EXPECT_TRUE(Contains(ids[0], Variant::kLarge));
+  EXPECT_FALSE(Contains(ids[1], Variant::kLarge));
+  EXPECT_TRUE(Contains(ids[2], Variant::kLarge));
+  EXPECT_TRUE(Contains(ids[3], Variant::kLarge));
+}
+
+TEST_F(ThumbnailCacheTest, DropsImagesUnderMemoryPressure) {
+  ThumbnailCache::ResetInstanceForTesting(4 * kImageBytes);
+  const base::Token ids[] = {base::Token::CreateRandom(),
+                             base::Token::CreateRandom()};
+  cache().Put(ids[0], Variant::kLarge, CreateImage());
+  cache().Put(ids[1], Variant::kLarge, CreateImage());
+
+  // Moderate pressure keeps the most recently used images within a quarter of
+  // the budget, here one image.
+  SimulateMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  EXPECT_FALSE(Contains(ids[0], Variant::kLarge));
+  EXPECT_TRUE(Contains(ids[1], Variant::kLarge));
+  EXPECT_EQ(kImageBytes, cache().total_bytes());
+
+  SimulateMemoryPressure(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  EXPECT_FALSE(Contains(ids[1], Variant::kLarge));
+  EXPECT_EQ(0u, cache().total_bytes());
+}
@@ -12,12 +12,31 @@
 #include "base/task/post_task.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
 #include "chrome/browser/ui/thumbnails/thumbnail_stats_tracker.h"
+#include "skia/ext/image_operations.h"
 #include "ui/gfx/codec/jpeg_codec.h"
+#include "ui/gfx/geometry/size_conversions.h"
 #include "ui/gfx/skia_util.h"
 
+namespace {
+
+// The small variant of a thumbnail is only compressed if it has at most this
+// fraction of the pixels of the capture, so that decoding it saves more than
+// its extra downscale, encode and compressed data cost.
+constexpr float kMaxSmallVariantAreaRatio = 0.5f;
+
+}  // namespace
+
+ThumbnailImage::CompressedVariants::CompressedVariants() = default;
+
+ThumbnailImage::CompressedVariants::CompressedVariants(CompressedVariants&&) =
+    default;
+
+ThumbnailImage::CompressedVariants::~CompressedVariants() = default;
+
 ThumbnailImage::Subscription::Subscription(
     scoped_refptr<ThumbnailImage> thumbnail)
     : thumbnail_(std::move(thumbnail)) {}
@@ -47,6 +66,8 @@ ThumbnailImage::ThumbnailImage(Delegate* delegate) : delegate_(delegate) {
 ThumbnailImage::~ThumbnailImage() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   ThumbnailStatsTracker::GetInstance().RemoveThumbnail(this);
+  if (!data_id_.is_zero())
+    ThumbnailCache::GetInstance().Remove(data_id_);
   if (delegate_)
     delegate_->thumbnail_ = nullptr;
 }
@@ -72,13 +93,15 @@ std::unique_ptr<ThumbnailImage::Subscription> ThumbnailImage::Subscribe() {
 void ThumbnailImage::AssignSkBitmap(SkBitmap bitmap,
                                     base::Optional<uint64_t> frame_id) {
   thumbnail_id_ = base::Token::CreateRandom();
+  const gfx::Size small_size =
+      GetSmallVariantSize(gfx::Size(bitmap.width(), bitmap.height()));
 
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE,
       {base::TaskPriority::USER_VISIBLE,
        base::TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN},
-      base::BindOnce(&ThumbnailImage::CompressBitmap, std::move(bitmap),
-                     frame_id),
+      base::BindOnce(&ThumbnailImage::CompressBitmapVariants,
+                     std::move(bitmap), small_size, frame_id),
       base::BindOnce(&ThumbnailImage::AssignJPEGData,
                      weak_ptr_factory_.GetWeakPtr(), thumbnail_id_,
                      base::TimeTicks::Now(), frame_id));
@@ -95,13 +118,20 @@ void ThumbnailImage::ClearData() {
   // the observers still think the thumbnail is blank.
   const bool should_notify = !!data_;
 
+  if (!data_id_.is_zero())
+    ThumbnailCache::GetInstance().Remove(data_id_);
   data_.reset();
+  small_data_.reset();
+  small_size_ = gfx::Size();
   thumbnail_id_ = base::Token();
+  data_id_ = base::Token();
 
-  // Notify observers of the new, blank thumbnail.
+  // Notify observers of the new, blank thumbnail. Without data, every
+  // subscriber is passed the large variant.
   if (should_notify) {
     NotifyCompressedDataObservers(data_);
-    NotifyUncompressedDataObservers(thumbnail_id_, gfx::ImageSkia());
+    NotifyUncompressedDataObservers(data_id_, ThumbnailCache::Variant::kLarge,
+                                    gfx::ImageSkia());
   }
 }
 
@@ -118,13 +148,13 @@ void ThumbnailImage::RequestCompressedThumbnailData() {
 size_t ThumbnailImage::GetCompressedDataSizeInBytes() const {
   if (!data_)
     return 0;
-  return data_->data.size();
+  return data_->data.size() + (small_data_ ? small_data_->data.size() : 0);
 }
 
 void ThumbnailImage::AssignJPEGData(base::Token thumbnail_id,
                                     base::TimeTicks assign_sk_bitmap_time,
                                     base::Optional<uint64_t> frame_id_for_trace,
-                                    std::vector<uint8_t> data) {
+                                    CompressedVariants variants) {
   // If the image is stale (a new thumbnail was assigned or the
   // thumbnail was cleared after AssignSkBitmap), ignore it.
   if (thumbnail_id != thumbnail_id_) {
@@ -133,8 +163,19 @@ void ThumbnailImage::AssignJPEGData(base::Token thumbnail_id,
     return;
   }
 
+  if (!data_id_.is_zero())
+    ThumbnailCache::GetInstance().Remove(data_id_);
+  data_id_ = thumbnail_id;
   data_ = base::MakeRefCounted<base::RefCountedData<std::vector<uint8_t>>>(
-      std::move(data));
+      std::move(variants.large));
+  if (variants.small.empty()) {
+    small_data_.reset();
+  } else {
+    small_data_ =
+        base::MakeRefCounted<base::RefCountedData<std::vector<uint8_t>>>(
+            std::move(variants.small));
+  }
+  small_size_ = variants.small_size;
 
   UMA_HISTOGRAM_CUSTOM_MICROSECONDS_TIMES(
       "Tab.Preview.TimeToNotifyObserversAfterCaptureReceived",
@@ -164,34 +205,71 @@ void ThumbnailImage::AssignJPEGData(base::Token thumbnail_id,
 bool ThumbnailImage::ConvertJPEGDataToImageSkiaAndNotifyObservers() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-  if (!data_) {
-    if (async_operation_finished_callback_)
-      async_operation_finished_callback_.Run();
-    return false;
+  bool provided = false;
+  if (data_) {
+    // Provide each variant which subscribers need, once.
+    for (ThumbnailCache::Variant variant :
+         {ThumbnailCache::Variant::kLarge, ThumbnailCache::Variant::kSmall}) {
+      if (std::any_of(subscribers_.begin(), subscribers_.end(),
+                      [this, variant](const Subscription* subscription) {
+                        return subscription->uncompressed_image_callback_ &&
+                               GetVariantFor(subscription) == variant;
+                      })) {
+        ProvideUncompressedImage(variant);
+        provided = true;
+      }
+    }
   }
-  return base::ThreadPool::PostTaskAndReplyWithResult(
+  if (!provided && async_operation_finished_callback_)
+    async_operation_finished_callback_.Run();
+  return provided;
+}
+
+void ThumbnailImage::ProvideUncompressedImage(ThumbnailCache::Variant variant) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  gfx::ImageSkia image = ThumbnailCache::GetInstance().Get(data_id_, variant);
+  UMA_HISTOGRAM_BOOLEAN("Tab.Preview.DecodedImageCacheHit", !image.isNull());
+  if (!image.isNull()) {
+    // Subscribers are notified asynchronously either way.
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::BindOnce(&ThumbnailImage::NotifyUncompressedDataObservers,
+                       weak_ptr_factory_.GetWeakPtr(), data_id_, variant,
+                       std::move(image)));
+    return;
+  }
+
+  base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE,
       {base::TaskPriority::USER_VISIBLE,
        base::TaskShutdownBehavior::CONTINUE_ON_SHUTDOWN},
-      base::BindOnce(&ThumbnailImage::UncompressImage, data_),
+      base::BindOnce(&ThumbnailImage::UncompressImage,
+                     variant == ThumbnailCache::Variant::kSmall ? small_data_
+                                                                : data_),
       base::BindOnce(&ThumbnailImage::NotifyUncompressedDataObservers,
-                     weak_ptr_factory_.GetWeakPtr(), thumbnail_id_));
+                     weak_ptr_factory_.GetWeakPtr(), data_id_, variant));
 }
 
-void ThumbnailImage::NotifyUncompressedDataObservers(base::Token thumbnail_id,
-                                                     gfx::ImageSkia image) {
+void ThumbnailImage::NotifyUncompressedDataObservers(
+    base::Token data_id,
+    ThumbnailCache::Variant variant,
+    gfx::ImageSkia image) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   if (async_operation_finished_callback_)
     async_operation_finished_callback_.Run();
 
-  // If the image is stale (a new thumbnail was assigned or the
-  // thumbnail was cleared after AssignSkBitmap), ignore it.
-  if (thumbnail_id != thumbnail_id_)
+  // If the image is stale (new data was assigned or the thumbnail was
+  // cleared since it was requested), ignore it.
+  if (data_id != data_id_)
     return;
 
+  if (!image.isNull())
+    ThumbnailCache::GetInstance().Put(data_id, variant, image);
+
   for (Subscription* subscription : subscribers_) {
     auto size_hint = subscription->size_hint_;
-    if (subscription->uncompressed_image_callback_) {
+    if (subscription->uncompressed_image_callback_ &&
+        GetVariantFor(subscription) == variant) {
       auto cropped_image = size_hint && !image.isNull()
                                ? CropPreviewImage(image, *size_hint)
                                : image;
@@ -209,6 +287,69 @@ void ThumbnailImage::NotifyCompressedDataObservers(
   }
 }
 
+ThumbnailCache::Variant ThumbnailImage::GetVariantFor(
+    const Subscription* subscription) const {
+  const base::Optional<gfx::Size>& size_hint = subscription->size_hint_;
+  if (!small_data_ || !size_hint)
+    return ThumbnailCache::Variant::kLarge;
+
+  // Cropping the small variant to the size hint still yields an image at
+  // least as large as the hint, once the hint is converted from DIP to the
+  // pixels of the thumbnail.
+  const gfx::Size size_hint_in_pixels =
+      gfx::ScaleToCeiledSize(*size_hint, subscription->device_scale_factor_);
+  if (size_hint_in_pixels.width() <= small_size_.width() &&
+      size_hint_in_pixels.height() <= small_size_.height()) {
+    return ThumbnailCache::Variant::kSmall;
+  }
+  return ThumbnailCache::Variant::kLarge;
+}
+
+gfx::Size ThumbnailImage::GetSmallVariantSize(
+    const gfx::Size& capture_size) const {
+  // The size hints of the subscribers which decode the image, in pixels.
+  gfx::Size size_hints_in_pixels;
+  for (const Subscription* subscription : subscribers_) {
+    if (subscription->uncompressed_image_callback_ &&
+        subscription->size_hint_) {
+      size_hints_in_pixels.SetToMax(gfx::ScaleToCeiledSize(
+          *subscription->size_hint_, subscription->device_scale_factor_));
+    }
+  }
+  if (size_hints_in_pixels.IsEmpty() || capture_size.IsEmpty())
+    return gfx::Size();
+
+  // The smallest size with the aspect ratio of the capture which covers the
+  // size hints.
+  const float scale =
+      std::max(float{size_hints_in_pixels.width()} / capture_size.width(),
+               float{size_hints_in_pixels.height()} / capture_size.height());
+  const gfx::Size small_size = gfx::ScaleToCeiledSize(capture_size, scale);
+  if (small_size.GetArea() >
+      kMaxSmallVariantAreaRatio * capture_size.GetArea()) {
+    return gfx::Size();
+  }
+  return small_size;
+}
+
+// static
+ThumbnailImage::CompressedVariants ThumbnailImage::CompressBitmapVariants(
+    SkBitmap bitmap,
+    const gfx::Size& small_size,
+    base::Optional<uint64_t> frame_id) {
+  CompressedVariants variants;
+  if (!small_size.IsEmpty()) {
+    variants.small = CompressBitmap(
+        skia::ImageOperations::Resize(bitmap,
+                                      skia::ImageOperations::RESIZE_GOOD,
+                                      small_size.width(), small_size.height()),
+        base::nullopt);
+    variants.small_size = small_size;
+  }
+  variants.large = CompressBitmap(std::move(bitmap), frame_id);
+  return variants;
+}
+
 // static
 std::vector<uint8_t> ThumbnailImage::CompressBitmap(
     SkBitmap bitmap,
@@ -18,6 +18,8 @@
 #include "base/optional.h"
 #include "base/sequence_checker.h"
 #include "base/token.h"
+#include "chrome/browser/ui/thumbnails/thumbnail_cache.h"
+#include "ui/gfx/geometry/size.h"
 #include "ui/gfx/image/image_skia.h"
 
 namespace base {
@@ -25,7 +27,10 @@ class TimeTicks;
 }  // namespace base
 
 // Stores compressed thumbnail data for a tab and can vend that data as an
-// uncompressed image to observers.
+// uncompressed image to observers. The data is stored at the size of the
+// capture and, when the subscribers at the time of the capture only need a much
+// smaller image, downscaled to their size hints, so that they don't decode the
+// large one. Decoded images are kept in the ThumbnailCache of the process.
 class ThumbnailImage : public base::RefCounted<ThumbnailImage> {
  public:
   // Describes the readiness of the source page for thumbnail capture.
@@ -83,10 +88,20 @@ class ThumbnailImage : public base::RefCounted<ThumbnailImage> {
     // image passed to OnThumbnailImageAvailable fits the needs of the observer
     // for display purposes, without the observer having to further crop the
     // image. The default is unspecified.
+    //
+    // The size hint is in DIP, while thumbnails are captured in pixels; see
+    // SetDeviceScaleFactor().
     void SetSizeHint(const base::Optional<gfx::Size>& size_hint) {
       size_hint_ = size_hint;
     }
 
+    // Sets the device scale factor the observer displays the image at, used
+    // to convert the size hint to pixels when picking which variant of the
+    // thumbnail to decode. The default is 1.
+    void SetDeviceScaleFactor(float device_scale_factor) {
+      device_scale_factor_ = device_scale_factor;
+    }
+
    private:
     friend class ThumbnailImage;
 
@@ -94,6 +109,7 @@ class ThumbnailImage : public base::RefCounted<ThumbnailImage> {
 
     scoped_refptr<ThumbnailImage> thumbnail_;
     base::Optional<gfx::Size> size_hint_;
+    float device_scale_factor_ = 1.0f;
 
     UncompressedImageCallback uncompressed_image_callback_;
     CompressedImageCallback compressed_image_callback_;
@@ -153,7 +169,8 @@ class ThumbnailImage : public base::RefCounted<ThumbnailImage> {
   // Observer::OnCompressedThumbnailDataAvailable().
   void RequestCompressedThumbnailData();
 
-  // Returns the size of the compressed data backing this thumbnail.
+  // Returns the size of the compressed data backing this thumbnail, in both
+  // variants.
   // This size can be 0. Additionally, since this data is refcounted,
   // it's possible this returns 0 even if the data is still allocated. A
   // client can hold a reference to it after |this| drops its reference.
@@ -169,17 +186,50 @@ class ThumbnailImage : public base::RefCounted<ThumbnailImage> {
   friend class ThumbnailImageTest;
   friend class base::RefCounted<ThumbnailImage>;
 
+  // The JPEG data of a capture, at its size and, if GetSmallVariantSize()
+  // returned a size for it, downscaled to |small_size|.
+  struct CompressedVariants {
+    CompressedVariants();
+    CompressedVariants(CompressedVariants&&);
+    ~CompressedVariants();
+
+    std::vector<uint8_t> large;
+    std::vector<uint8_t> small;
+    gfx::Size small_size;
+  };
+
   virtual ~ThumbnailImage();
 
   void AssignJPEGData(base::Token thumbnail_id,
                       base::TimeTicks assign_sk_bitmap_time,
                       base::Optional<uint64_t> frame_id_for_trace,
-                      std::vector<uint8_t> data);
+                      CompressedVariants variants);
   bool ConvertJPEGDataToImageSkiaAndNotifyObservers();
-  void NotifyUncompressedDataObservers(base::Token thumbnail_id,
+
+  // Notifies the subscribers of |variant| with the decoded image, from the
+  // ThumbnailCache or decoded on a worker.
+  void ProvideUncompressedImage(ThumbnailCache::Variant variant);
+
+  void NotifyUncompressedDataObservers(base::Token data_id,
+                                       ThumbnailCache::Variant variant,
                                        gfx::ImageSkia image);
   void NotifyCompressedDataObservers(CompressedThumbnailData data);
 
+  // Returns the variant of the image passed to |subscription|: the small one
+  // if it covers the size hint of |subscription|.
+  ThumbnailCache::Variant GetVariantFor(const Subscription* subscription) const;
+
+  // Returns the size to downscale a capture of |capture_size| to for the
+  // current subscribers: the smallest size with the aspect ratio of the
+  // capture which covers their size hints in pixels. Returns an empty size if
+  // no subscriber has a size hint, or if the downscaled image wouldn't be much
+  // smaller than the capture.
+  gfx::Size GetSmallVariantSize(const gfx::Size& capture_size) const;
+
+  static CompressedVariants CompressBitmapVariants(
+      SkBitmap bitmap,
+      const gfx::Size& small_size,
+      base::Optional<uint64_t> frame_id);
   static std::vector<uint8_t> CompressBitmap(SkBitmap bitmap,
                                              base::Optional<uint64_t> frame_id);
   static gfx::ImageSkia UncompressImage(CompressedThumbnailData compressed);
@@ -199,10 +249,18 @@ class ThumbnailImage : public base::RefCounted<ThumbnailImage> {
   // the old data.
   CompressedThumbnailData data_;
 
+  // The downscaled variant of |data_|, if any, and its size.
+  CompressedThumbnailData small_data_;
+  gfx::Size small_size_;
+
   // A randomly generated ID associated with each image assigned by
   // AssignSkBitmap().
   base::Token thumbnail_id_;
 
+  // The ID of the image in |data_|, under which it is cached once decoded.
+  // Differs from |thumbnail_id_| while a newly assigned image is compressed.
+  base::Token data_id_;
+
   // Subscriptions are inserted on |Subscribe()| calls and removed when
   // they are destroyed via callback. The order of subscriber
   // notification doesn't matter, so don't maintain any ordering. Since
@@ -13,8 +13,13 @@
 #include "base/optional.h"
 #include "base/run_loop.h"
 #include "base/scoped_observer.h"
+#include "base/test/metrics/histogram_tester.h"
 #include "base/test/task_environment.h"
+#include "chrome/browser/ui/tabs/tab_style.h"
+#include "chrome/browser/ui/thumbnails/thumbnail_cache.h"
+#include "chrome/browser/ui/thumbnails/thumbnail_tab_helper.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/size_conversions.h"
 #include "ui/gfx/image/image_skia.h"
 
 namespace {
@@ -81,6 +86,8 @@ class ThumbnailImageTest : public testing::Test,
  public:
   ThumbnailImageTest() = default;
 
+  void SetUp() override { ThumbnailCache::ResetInstanceForTesting(); }
+
  protected:
   static SkBitmap CreateBitmap(int width, int height) {
     SkBitmap bitmap;
@@ -95,6 +102,14 @@ class ThumbnailImageTest : public testing::Test,
 
   bool is_being_observed() const { return is_being_observed_; }
 
+  size_t GetCachedBytes() const {
+    return ThumbnailCache::GetInstance().total_bytes();
+  }
+
+  static gfx::Size GetSmallVariantSize(const ThumbnailImage* image) {
+    return image->small_data_ ? image->small_size_ : gfx::Size();
+  }
+
  private:
   void ThumbnailImageBeingObservedChanged(bool is_being_observed) override {
     is_being_observed_ = is_being_observed;
@@ -394,3 +409,152 @@ TEST_F(ThumbnailImageTest, DoesNotCropBlankThumbnails) {
   uncompressed_image_waiter.Wait();
   EXPECT_TRUE(uncompressed_image_waiter.called());
 }
+
+TEST_F(ThumbnailImageTest, RequestThumbnailImageUsesDecodedImageCache) {
+  base::HistogramTester histogram_tester;
+  auto image = base::MakeRefCounted<ThumbnailImage>(this);
+
+  std::unique_ptr<Subscription> subscription = image->Subscribe();
+
+  CallbackWaiter waiter;
+  subscription->SetUncompressedImageCallback(
+      IgnoreArgs<gfx::ImageSkia>(waiter.callback()));
+
+  SkBitmap bitmap = CreateBitmap(kTestBitmapWidth, kTestBitmapHeight);
+  image->AssignSkBitmap(bitmap, base::nullopt);
+  waiter.Wait();
+  EXPECT_TRUE(waiter.called());
+  EXPECT_GT(GetCachedBytes(), 0u);
+  histogram_tester.ExpectUniqueSample("Tab.Preview.DecodedImageCacheHit", false,
+                                      1);
+  waiter.Reset();
+
+  image->RequestThumbnailImage();
+  waiter.Wait();
+  EXPECT_TRUE(waiter.called());
+  histogram_tester.ExpectBucketCount("Tab.Preview.DecodedImageCacheHit", true,
+                                     1);
+
+  // Clearing the thumbnail drops its decoded image.
+  image->ClearData();
+  EXPECT_EQ(0u, GetCachedBytes());
+}
+
+TEST_F(ThumbnailImageTest, SmallSubscribersGetSmallVariant) {
+  auto image = base::MakeRefCounted<ThumbnailImage>(this);
+
+  std::unique_ptr<Subscription> large_subscription = image->Subscribe();
+  gfx::ImageSkia large_image;
+  CallbackWaiter large_waiter;
+  large_subscription->SetUncompressedImageCallback(base::BindRepeating(
+      [](gfx::ImageSkia* out, base::RepeatingClosure callback,
+         gfx::ImageSkia image) {
+        *out = image;
+        callback.Run();
+      },
+      &large_image, large_waiter.callback()));
+
+  std::unique_ptr<Subscription> small_subscription = image->Subscribe();
+  small_subscription->SetSizeHint(
+      gfx::Size(kTestBitmapWidth / 4, kTestBitmapHeight / 4));
+  gfx::ImageSkia small_image;
+  CallbackWaiter small_waiter;
+  small_subscription->SetUncompressedImageCallback(base::BindRepeating(
+      [](gfx::ImageSkia* out, base::RepeatingClosure callback,
+         gfx::ImageSkia image) {
+        *out = image;
+        callback.Run();
+      },
+      &small_image, small_waiter.callback()));
+
+  SkBitmap bitmap = CreateBitmap(kTestBitmapWidth, kTestBitmapHeight);
+  image->AssignSkBitmap(bitmap, base::nullopt);
+  large_waiter.Wait();
+  small_waiter.Wait();
+  EXPECT_EQ(kTestBitmapWidth, large_image.width());
+  EXPECT_EQ(kTestBitmapHeight, large_image.height());
+  // The small variant covers the size hint, to whose aspect ratio it is
+  // cropped.
+  EXPECT_EQ(gfx::Size(kTestBitmapWidth / 4, (kTestBitmapHeight + 3) / 4),
+            GetSmallVariantSize(image.get()));
+  EXPECT_EQ(kTestBitmapWidth / 4, small_image.width());
+  EXPECT_LE(small_image.height(), (kTestBitmapHeight + 3) / 4);
+}
+
+TEST_F(ThumbnailImageTest, SizeHintIsScaledByDeviceScaleFactor) {
+  auto image = base::MakeRefCounted<ThumbnailImage>(this);
+
+  // At scale factor 2, a size hint of a quarter of the thumbnail is half of it
+  // in pixels, which the small variant is made to cover.
+  std::unique_ptr<Subscription> subscription = image->Subscribe();
+  subscription->SetSizeHint(
+      gfx::Size(kTestBitmapWidth / 4, kTestBitmapHeight / 4));
+  subscription->SetDeviceScaleFactor(2.0f);
+  gfx::ImageSkia small_image;
+  CallbackWaiter waiter;
+  subscription->SetUncompressedImageCallback(base::BindRepeating(
+      [](gfx::ImageSkia* out, base::RepeatingClosure callback,
+         gfx::ImageSkia image) {
+        *out = image;
+        callback.Run();
+      },
+      &small_image, waiter.callback()));
+
+  SkBitmap bitmap = CreateBitmap(kTestBitmapWidth, kTestBitmapHeight);
+  image->AssignSkBitmap(bitmap, base::nullopt);
+  waiter.Wait();
+  EXPECT_EQ(gfx::Size(kTestBitmapWidth / 2, (kTestBitmapHeight + 1) / 2),
+            GetSmallVariantSize(image.get()));
+  EXPECT_EQ(kTestBitmapWidth / 2, small_image.width());
+  EXPECT_LE(small_image.height(), (kTestBitmapHeight + 1) / 2);
+}
+
+// Uses the size of actual captures and of the hover card preview, at the scale
+// factors where a small variant is worth making and where it isn't.
+TEST_F(ThumbnailImageTest, SmallVariantForHoverCard) {
+  const gfx::Size preview_size = TabStyle::GetPreviewImageSize();
+  for (float scale_factor : {1.0f, 2.0f}) {
+    SCOPED_TRACE(scale_factor);
+    const gfx::Size capture_size =
+        ThumbnailTabHelper::GetInitialCaptureInfo(
+            gfx::Size(1920, 1080), scale_factor,
+            /*include_scrollbars_in_capture=*/false)
+            .target_size;
+
+    auto image = base::MakeRefCounted<ThumbnailImage>(this);
+    std::unique_ptr<Subscription> subscription = image->Subscribe();
+    subscription->SetSizeHint(preview_size);
+    subscription->SetDeviceScaleFactor(scale_factor);
+    gfx::ImageSkia preview_image;
+    CallbackWaiter waiter;
+    subscription->SetUncompressedImageCallback(base::BindRepeating(
+        [](gfx::ImageSkia* out, base::RepeatingClosure callback,
+           gfx::ImageSkia image) {
+          *out = image;
+          callback.Run();
+        },
+        &preview_image, waiter.callback()));
+
+    image->AssignSkBitmap(
+        CreateBitmap(capture_size.width(), capture_size.height()),
+        base::nullopt);
+    waiter.Wait();
+
+    const gfx::Size small_size = GetSmallVariantSize(image.get());
+    if (scale_factor == 1.0f) {
+      // Captures are oversampled at scale factor 1, so the hover card decodes
+      // a variant downscaled to cover its size in pixels.
+      const gfx::Size preview_size_in_pixels =
+          gfx::ScaleToCeiledSize(preview_size, scale_factor);
+      EXPECT_GE(small_size.width(), preview_size_in_pixels.width());
+      EXPECT_GE(small_size.height(), preview_size_in_pixels.height());
+      EXPECT_LE(small_size.GetArea(), capture_size.GetArea() / 2);
+      EXPECT_LE(preview_image.width(), small_size.width());
+    } else {
+      // Captures are at the scale factor of the display, close to the size of
+      // the hover card, so only the capture is compressed and decoded.
+      EXPECT_TRUE(small_size.IsEmpty());
+      EXPECT_GT(preview_image.width(), capture_size.width() * 2 / 3);
+    }
+  }
+}
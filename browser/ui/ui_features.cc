@@ -191,6 +191,11 @@ const base::Feature kWebUITabStrip{"WebUITabStrip",
 const base::Feature kWebUIFeedback{"WebUIFeedback",
                                    base::FEATURE_DISABLED_BY_DEFAULT};
 
+// Sends the results of chrome://history queries to the page in pages, which
+// are formatted off the UI thread.
+const base::Feature kWebUIHistoryResultsStreaming{
+    "WebUIHistoryResultsStreaming", base::FEATURE_DISABLED_BY_DEFAULT};
+
 #if BUILDFLAG(IS_CHROMEOS_ASH)
 // Enables a warning about connecting to hidden WiFi networks.
 // https://crbug.com/903908
@@ -129,6 +129,8 @@ extern const base::Feature kWebUITabStrip;
 
 extern const base::Feature kWebUIFeedback;
 
+extern const base::Feature kWebUIHistoryResultsStreaming;
+
 #if BUILDFLAG(IS_CHROMEOS_ASH)
 extern const base::Feature kHiddenNetworkWarning;
 #endif  // BUILDFLAG(IS_CHROMEOS_ASH)
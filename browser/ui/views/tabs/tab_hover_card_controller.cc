@@ -11,9 +11,11 @@
 #include "chrome/browser/metrics/tab_count_metrics.h"
 #include "chrome/browser/ui/tabs/tab_style.h"
 #include "chrome/browser/ui/ui_features.h"
+#include "chrome/browser/ui/views/tabs/tab.h"
 #include "chrome/browser/ui/views/tabs/tab_hover_card_bubble_view.h"
 #include "chrome/browser/ui/views/tabs/tab_hover_card_thumbnail_observer.h"
 #include "chrome/browser/ui/views/tabs/tab_strip.h"
+#include "ui/compositor/compositor.h"
 #include "ui/views/view.h"
 #include "ui/views/widget/widget.h"
 #include "ui/views/widget/widget_observer.h"
@@ -55,6 +57,15 @@ base::TimeDelta GetPreviewImageCaptureDelay(
   return base::TimeDelta::FromMilliseconds(ms);
 }
 
+// Returns the device scale factor of the widget hosting |tab|, which its hover
+// card is displayed at.
+float GetDeviceScaleFactor(const Tab* tab) {
+  const views::Widget* widget = tab->GetWidget();
+  return widget && widget->GetCompositor()
+             ? widget->GetCompositor()->device_scale_factor()
+             : 1.0f;
+}
+
 base::TimeDelta GetShowDelay(int tab_width) {
   // Delay is calculated as a logarithmic scale and bounded by a minimum width
   // based on the width of a pinned tab and a maximum of the standard width.
@@ -456,6 +467,7 @@ void TabHoverCardController::MaybeStartThumbnailObservation(
           ? base::TimeDelta()
           : GetPreviewImageCaptureDelay(thumbnail->GetCaptureReadiness());
   if (capture_delay.is_zero()) {
+    thumbnail_observer_->SetDeviceScaleFactor(GetDeviceScaleFactor(tab));
     thumbnail_observer_->Observe(thumbnail);
   } else if (!delayed_show_timer_.IsRunning()) {
     // Stop updating the preview image unless/until we re-enable capture.
@@ -480,6 +492,7 @@ void TabHoverCardController::StartThumbnailObservation(Tab* tab) {
   if (!thumbnail || thumbnail == thumbnail_observer_->current_image())
     return;
 
+  thumbnail_observer_->SetDeviceScaleFactor(GetDeviceScaleFactor(tab));
   thumbnail_observer_->Observe(thumbnail);
 }
 
@@ -19,6 +19,7 @@ void TabHoverCardThumbnailObserver::Observe(
 
   subscription_ = current_image_->Subscribe();
   subscription_->SetSizeHint(TabStyle::GetPreviewImageSize());
+  subscription_->SetDeviceScaleFactor(device_scale_factor_);
   subscription_->SetUncompressedImageCallback(base::BindRepeating(
       &TabHoverCardThumbnailObserver::ThumbnailImageCallback,
       base::Unretained(this), base::Unretained(current_image_.get())));
@@ -26,6 +27,13 @@ void TabHoverCardThumbnailObserver::Observe(
   current_image_->RequestThumbnailImage();
 }
 
+void TabHoverCardThumbnailObserver::SetDeviceScaleFactor(
+    float device_scale_factor) {
+  device_scale_factor_ = device_scale_factor;
+  if (subscription_)
+    subscription_->SetDeviceScaleFactor(device_scale_factor);
+}
+
 base::CallbackListSubscription TabHoverCardThumbnailObserver::AddCallback(
     Callback callback) {
   return callback_list_.Add(callback);
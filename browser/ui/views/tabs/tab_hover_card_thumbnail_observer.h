@@ -28,6 +28,10 @@ class TabHoverCardThumbnailObserver {
   // retrieve a valid thumbnail.
   void Observe(scoped_refptr<ThumbnailImage> thumbnail_image);
 
+  // Sets the device scale factor the hover card is displayed at, so that the
+  // thumbnail is decoded with enough pixels for the preview image size.
+  void SetDeviceScaleFactor(float device_scale_factor);
+
   // Returns the current (most recent) thumbnail being watched.
   const scoped_refptr<ThumbnailImage>& current_image() const {
     return current_image_;
@@ -40,6 +44,7 @@ class TabHoverCardThumbnailObserver {
                               gfx::ImageSkia preview_image);
 
   scoped_refptr<ThumbnailImage> current_image_;
+  float device_scale_factor_ = 1.0f;
   std::unique_ptr<ThumbnailImage::Subscription> subscription_;
   base::RepeatingCallbackList<CallbackSignature> callback_list_;
 };
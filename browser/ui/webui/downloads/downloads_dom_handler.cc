@@ -123,6 +123,11 @@ void DownloadsDOMHandler::GetDownloads(
   list_tracker_.StartAndSendChunk();
 }
 
+void DownloadsDOMHandler::SetVisibleRowCount(int32_t count) {
+  if (count > 0)
+    list_tracker_.SetVisibleRowCount(static_cast<size_t>(count));
+}
+
 void DownloadsDOMHandler::OpenFileRequiringGesture(const std::string& id) {
   if (!GetWebUIWebContents()->HasRecentInteractiveInputEvent()) {
     LOG(ERROR) << "OpenFileRequiringGesture received without recent "
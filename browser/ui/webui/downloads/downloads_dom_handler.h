@@ -48,6 +48,7 @@ class DownloadsDOMHandler : public content::WebContentsObserver,
 
   // downloads::mojom::PageHandler:
   void GetDownloads(const std::vector<std::string>& search_terms) override;
+  void SetVisibleRowCount(int32_t count) override;
   void OpenFileRequiringGesture(const std::string& id) override;
   void Drag(const std::string& id) override;
   void SaveDangerousRequiringGesture(const std::string& id) override;
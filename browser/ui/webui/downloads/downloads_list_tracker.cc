@@ -4,7 +4,7 @@
 
 #include "chrome/browser/ui/webui/downloads/downloads_list_tracker.h"
 
-#include <iterator>
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -45,6 +45,15 @@ namespace {
 // Max URL length to be sent to the download page.
 const int kMaxURLLength = 2 * 1024 * 1024;
 
+// How often updates of downloads are sent to the page, at most. Active
+// downloads report progress much more often than the page can show it.
+constexpr base::TimeDelta kUpdateInterval =
+    base::TimeDelta::FromMilliseconds(16);
+
+// Bounds of the number of items sent to the page at a time.
+constexpr size_t kMinChunkSize = 20u;
+constexpr size_t kMaxChunkSize = 200u;
+
 // Returns a string constant to be used as the |danger_type| value in
 // CreateDownloadData(). This can be the empty string, if the danger type is not
 // relevant for the UI.
@@ -101,6 +110,23 @@ std::string TimeFormatLongDate(const base::Time& time) {
   return base::UTF16ToUTF8(base::i18n::UnicodeStringToString16(date_string));
 }
 
+// Returns true if |data| only differs from |sent| in the fields which change as
+// a download makes progress, if at all. The progress fields of |data| are
+// swapped for those of |sent| while comparing, rather than comparing a copy, so
+// that long URLs aren't copied on every update.
+bool HasSameNonProgressFields(const downloads::mojom::Data& sent,
+                              downloads::mojom::Data* data) {
+  int32_t percent = std::exchange(data->percent, sent.percent);
+  int32_t total = std::exchange(data->total, sent.total);
+  std::string progress_status_text =
+      std::exchange(data->progress_status_text, sent.progress_status_text);
+  const bool same = sent.Equals(*data);
+  data->percent = percent;
+  data->total = total;
+  data->progress_status_text = std::move(progress_status_text);
+  return same;
+}
+
 }  // namespace
 
 DownloadsListTracker::DownloadsListTracker(
@@ -119,12 +145,13 @@ void DownloadsListTracker::Reset() {
   if (sending_updates_)
     page_->ClearAll();
   sent_to_page_ = 0u;
+  ClearSentState();
 }
 
 bool DownloadsListTracker::SetSearchTerms(
     const std::vector<std::string>& search_terms) {
   std::vector<std::u16string> new_terms;
-  new_terms.resize(search_terms.size());
+  new_terms.reserve(search_terms.size());
 
   for (const auto& t : search_terms)
     new_terms.push_back(base::UTF8ToUTF16(t));
@@ -133,6 +160,8 @@ bool DownloadsListTracker::SetSearchTerms(
     return false;
 
   search_terms_.swap(new_terms);
+  prepared_search_terms_ =
+      std::make_unique<DownloadQuery::SearchTerms>(search_terms_);
   RebuildSortedItems();
   return true;
 }
@@ -142,12 +171,11 @@ void DownloadsListTracker::StartAndSendChunk() {
 
   CHECK_LE(sent_to_page_, sorted_items_.size());
 
-  auto it = sorted_items_.begin();
-  std::advance(it, sent_to_page_);
+  auto it = sorted_items_.begin() + sent_to_page_;
 
   std::vector<downloads::mojom::DataPtr> list;
   while (it != sorted_items_.end() && list.size() < chunk_size_) {
-    list.push_back(CreateDownloadData(*it));
+    list.push_back(RecordSentData(*it, CreateDownloadData(*it)));
     ++it;
   }
 
@@ -159,6 +187,15 @@ void DownloadsListTracker::StartAndSendChunk() {
 
 void DownloadsListTracker::Stop() {
   sending_updates_ = false;
+  pending_updates_.clear();
+  update_timer_.Stop();
+}
+
+void DownloadsListTracker::SetVisibleRowCount(size_t visible_rows) {
+  // Send two screens of rows at a time, so that the next screen is ready by
+  // the time the user scrolls to it.
+  chunk_size_ =
+      std::min(std::max(2 * visible_rows, kMinChunkSize), kMaxChunkSize);
 }
 
 DownloadManager* DownloadsListTracker::GetMainNotifierManager() const {
@@ -197,6 +234,13 @@ void DownloadsListTracker::OnDownloadRemoved(DownloadManager* manager,
     RemoveItem(current_position);
 }
 
+void DownloadsListTracker::OnManagerGoingDown(DownloadManager* manager) {
+  // The items of |manager| are about to be destroyed, so don't hold on to
+  // updates of them.
+  pending_updates_.clear();
+  update_timer_.Stop();
+}
+
 DownloadsListTracker::DownloadsListTracker(
     DownloadManager* download_manager,
     mojo::PendingRemote<downloads::mojom::Page> page,
@@ -352,9 +396,7 @@ const DownloadItem* DownloadsListTracker::GetItemForTesting(size_t index)
   if (index >= sorted_items_.size())
     return nullptr;
 
-  auto it = sorted_items_.begin();
-  std::advance(it, index);
-  return *it;
+  return *(sorted_items_.begin() + index);
 }
 
 void DownloadsListTracker::SetChunkSizeForTesting(size_t chunk_size) {
@@ -362,6 +404,11 @@ void DownloadsListTracker::SetChunkSizeForTesting(size_t chunk_size) {
   chunk_size_ = chunk_size;
 }
 
+void DownloadsListTracker::FlushUpdatesForTesting() {
+  update_timer_.Stop();
+  SendPendingUpdates();
+}
+
 bool DownloadsListTracker::ShouldShow(const DownloadItem& item) const {
   return !download_crx_util::IsTrustedExtensionDownload(
              Profile::FromBrowserContext(
@@ -372,13 +419,15 @@ bool DownloadsListTracker::ShouldShow(const DownloadItem& item) const {
          !item.GetTargetFilePath().empty() && !item.GetURL().is_empty() &&
          DownloadItemModel(const_cast<DownloadItem*>(&item))
              .ShouldShowInShelf() &&
-         DownloadQuery::MatchesQuery(search_terms_, item);
+         DownloadQuery::MatchesQuery(*prepared_search_terms_, item);
 }
 
 bool DownloadsListTracker::StartTimeComparator::operator()(
     const download::DownloadItem* a,
     const download::DownloadItem* b) const {
-  return a->GetStartTime() > b->GetStartTime();
+  if (a->GetStartTime() != b->GetStartTime())
+    return a->GetStartTime() > b->GetStartTime();
+  return a->GetId() < b->GetId();
 }
 
 void DownloadsListTracker::Init() {
@@ -390,6 +439,8 @@ void DownloadsListTracker::Init() {
         BrowserContext::GetDownloadManager(original_profile), this);
   }
 
+  prepared_search_terms_ =
+      std::make_unique<DownloadQuery::SearchTerms>(search_terms_);
   RebuildSortedItems();
 }
 
@@ -418,7 +469,7 @@ void DownloadsListTracker::InsertItem(const SortedSet::iterator& insert) {
     return;
 
   std::vector<downloads::mojom::DataPtr> list;
-  list.push_back(CreateDownloadData(*insert));
+  list.push_back(RecordSentData(*insert, CreateDownloadData(*insert)));
 
   page_->InsertItems(static_cast<int>(index), std::move(list));
 
@@ -429,13 +480,15 @@ void DownloadsListTracker::UpdateItem(const SortedSet::iterator& update) {
   if (!sending_updates_ || GetIndex(update) >= sent_to_page_)
     return;
 
-  page_->UpdateItem(static_cast<int>(GetIndex(update)),
-                    CreateDownloadData(*update));
+  pending_updates_.insert(*update);
+  if (!update_timer_.IsRunning()) {
+    update_timer_.Start(FROM_HERE, kUpdateInterval, this,
+                        &DownloadsListTracker::SendPendingUpdates);
+  }
 }
 
 size_t DownloadsListTracker::GetIndex(const SortedSet::iterator& item) const {
-  // TODO(dbeam): this could be log(N) if |item| was random access.
-  return std::distance(sorted_items_.begin(), item);
+  return item - sorted_items_.begin();
 }
 
 void DownloadsListTracker::RemoveItem(const SortedSet::iterator& remove) {
@@ -447,5 +500,63 @@ void DownloadsListTracker::RemoveItem(const SortedSet::iterator& remove) {
       sent_to_page_--;
     }
   }
+  pending_updates_.erase(*remove);
+  sent_data_.erase(*remove);
   sorted_items_.erase(remove);
 }
+
+void DownloadsListTracker::SendPendingUpdates() {
+  base::flat_set<DownloadItem*> pending_updates;
+  pending_updates.swap(pending_updates_);
+  if (!sending_updates_)
+    return;
+
+  std::vector<downloads::mojom::ProgressUpdatePtr> progress_updates;
+  for (DownloadItem* item : pending_updates) {
+    auto position = sorted_items_.find(item);
+    if (position == sorted_items_.end())
+      continue;
+    size_t index = GetIndex(position);
+    if (index >= sent_to_page_)
+      continue;
+
+    downloads::mojom::DataPtr data = CreateDownloadData(item);
+    auto sent = sent_data_.find(item);
+    if (sent != sent_data_.end() &&
+        HasSameNonProgressFields(*sent->second, data.get())) {
+      // Only the progress changed, if anything.
+      downloads::mojom::Data& sent_data = *sent->second;
+      if (sent_data.percent == data->percent &&
+          sent_data.total == data->total &&
+          sent_data.progress_status_text == data->progress_status_text) {
+        continue;
+      }
+      sent_data.percent = data->percent;
+      sent_data.total = data->total;
+      sent_data.progress_status_text = data->progress_status_text;
+      progress_updates.push_back(downloads::mojom::ProgressUpdate::New(
+          static_cast<int>(index), data->percent, data->total,
+          std::move(data->progress_status_text)));
+      continue;
+    }
+
+    page_->UpdateItem(static_cast<int>(index),
+                      RecordSentData(item, std::move(data)));
+  }
+
+  if (!progress_updates.empty())
+    page_->UpdateProgress(std::move(progress_updates));
+}
+
+downloads::mojom::DataPtr DownloadsListTracker::RecordSentData(
+    const DownloadItem* item,
+    downloads::mojom::DataPtr data) {
+  sent_data_[item] = data.Clone();
+  return data;
+}
+
+void DownloadsListTracker::ClearSentState() {
+  sent_data_.clear();
+  pending_updates_.clear();
+  update_timer_.Stop();
+}
@@ -8,13 +8,17 @@
 #include <stddef.h>
 
 #include <memory>
-#include <set>
 #include <string>
+#include <vector>
 
 #include "base/callback_forward.h"
+#include "base/containers/flat_map.h"
+#include "base/containers/flat_set.h"
 #include "base/macros.h"
 #include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "base/values.h"
+#include "chrome/browser/download/download_query.h"
 #include "chrome/browser/ui/webui/downloads/downloads.mojom.h"
 #include "components/download/content/public/all_download_item_notifier.h"
 #include "components/download/public/common/download_item.h"
@@ -50,6 +54,10 @@ class DownloadsListTracker
   // Stops sending updates to the page.
   void Stop();
 
+  // Sizes the chunks sent by StartAndSendChunk() for a page which shows
+  // |visible_rows| downloads at a time.
+  void SetVisibleRowCount(size_t visible_rows);
+
   content::DownloadManager* GetMainNotifierManager() const;
   content::DownloadManager* GetOriginalNotifierManager() const;
 
@@ -60,6 +68,7 @@ class DownloadsListTracker
                          download::DownloadItem* download_item) override;
   void OnDownloadRemoved(content::DownloadManager* manager,
                          download::DownloadItem* download_item) override;
+  void OnManagerGoingDown(content::DownloadManager* manager) override;
 
  protected:
   // Testing constructor.
@@ -79,12 +88,23 @@ class DownloadsListTracker
 
   void SetChunkSizeForTesting(size_t chunk_size);
 
+  size_t chunk_size() const { return chunk_size_; }
+
+  // Sends the updates which are waiting for |update_timer_| right away.
+  void FlushUpdatesForTesting();
+
  private:
+  // Orders downloads by descending start time. Downloads which started at the
+  // same time are ordered by id, so that none of them is dropped.
   struct StartTimeComparator {
     bool operator()(const download::DownloadItem* a,
                     const download::DownloadItem* b) const;
   };
-  using SortedSet = std::set<download::DownloadItem*, StartTimeComparator>;
+  // A sorted vector: finding an item is O(log n), and both the index of an
+  // item and the item at an index are O(1). Inserting and removing move a
+  // range of pointers, which is cheap next to notifying the page.
+  using SortedSet =
+      base::flat_set<download::DownloadItem*, StartTimeComparator>;
 
   // Called by both constructors to initialize common state.
   void Init();
@@ -101,13 +121,28 @@ class DownloadsListTracker
   // Calls "insertItems" if sending updates and the page knows about |insert|.
   void InsertItem(const SortedSet::iterator& insert);
 
-  // Calls "updateItem" if sending updates and the page knows about |update|.
+  // Queues an update of |update| if sending updates and the page knows about
+  // it. Updates are sent in batches by SendPendingUpdates().
   void UpdateItem(const SortedSet::iterator& update);
 
   // Removes the item that corresponds to |remove| and sends "removeItems"
   // if sending updates.
   void RemoveItem(const SortedSet::iterator& remove);
 
+  // Sends the queued updates of the items which the page knows about. Items
+  // whose progress is all that changed since they were last sent go out
+  // together in one "updateProgress" call; others get an "updateItem" call.
+  void SendPendingUpdates();
+
+  // Records a copy of |data| as what the page shows for |item|, and returns
+  // |data| to send.
+  downloads::mojom::DataPtr RecordSentData(
+      const download::DownloadItem* item,
+      downloads::mojom::DataPtr data);
+
+  // Forgets the queued updates and what was sent to the page.
+  void ClearSentState();
+
   download::AllDownloadItemNotifier main_notifier_;
   std::unique_ptr<download::AllDownloadItemNotifier> original_notifier_;
 
@@ -129,8 +164,21 @@ class DownloadsListTracker
   // The maximum number of items sent to the page at a time.
   size_t chunk_size_ = 20u;
 
-  // Current search terms.
+  // Current search terms, and the same terms prepared for matching.
   std::vector<std::u16string> search_terms_;
+  std::unique_ptr<DownloadQuery::SearchTerms> prepared_search_terms_;
+
+  // The last data sent to the page for each item it knows about. Used to tell
+  // progress ticks from other changes. Progress ticks update the copy in
+  // place; only items sent whole are copied again.
+  base::flat_map<const download::DownloadItem*, downloads::mojom::DataPtr>
+      sent_data_;
+
+  // Items which changed since the last batch of updates was sent.
+  base::flat_set<download::DownloadItem*> pending_updates_;
+
+  // Sends |pending_updates_| at most once per |kUpdateInterval|.
+  base::OneShotTimer update_timer_;
 
   DISALLOW_COPY_AND_ASSIGN(DownloadsListTracker);
 };
@@ -56,12 +56,16 @@ class TestDownloadsListTracker : public DownloadsListTracker {
   using DownloadsListTracker::IsIncognito;
   using DownloadsListTracker::GetItemForTesting;
   using DownloadsListTracker::SetChunkSizeForTesting;
+  using DownloadsListTracker::chunk_size;
+  using DownloadsListTracker::FlushUpdatesForTesting;
 
  protected:
   downloads::mojom::DataPtr CreateDownloadData(
       download::DownloadItem* download_item) const override {
     auto file_value = downloads::mojom::Data::New();
     file_value->id = base::NumberToString(download_item->GetId());
+    file_value->percent = download_item->PercentComplete();
+    file_value->state = download_item->IsPaused() ? "PAUSED" : "IN_PROGRESS";
     return file_value;
   }
 };
@@ -104,6 +108,10 @@ class DownloadsListTrackerTest : public testing::Test {
         manager(), page_.BindAndGetRemote());
   }
 
+  void FastForwardBy(base::TimeDelta delta) {
+    task_environment_.FastForwardBy(delta);
+  }
+
   TestingProfile* profile() { return &profile_; }
   content::DownloadManager* manager() { return &manager_; }
   TestDownloadsListTracker* tracker() { return tracker_.get(); }
@@ -118,7 +126,8 @@ class DownloadsListTrackerTest : public testing::Test {
   }
 
   // NOTE: The initialization order of these members matters.
-  content::BrowserTaskEnvironment task_environment_;
+  content::BrowserTaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
   TestingProfile profile_;
 
   testing::NiceMock<content::MockDownloadManager> manager_;
@@ -314,3 +323,110 @@ TEST_F(DownloadsListTrackerTest, IgnoreTransientDownloads) {
   std::vector<uint64_t> expected;
   EXPECT_CALL(page_, InsertItems(0, MatchIds(expected)));
 }
+
+TEST_F(DownloadsListTrackerTest, ItemsWithTheSameStartTime) {
+  MockDownloadItem* first_item = CreateNextItem();
+  MockDownloadItem* second_item =
+      CreateMock(1, first_item->GetStartTime());
+
+  CreateTracker();
+  tracker()->StartAndSendChunk();
+
+  std::vector<uint64_t> expected = {0, 1};
+  EXPECT_CALL(page_, InsertItems(0, MatchIds(expected)));
+
+  tracker()->OnDownloadRemoved(manager(), second_item);
+  EXPECT_EQ(first_item, tracker()->GetItemForTesting(0));
+  EXPECT_FALSE(tracker()->GetItemForTesting(1));
+
+  EXPECT_CALL(page_, RemoveItem(1));
+}
+
+MATCHER_P2(IsProgressUpdate, index, percent, "") {
+  return arg->index == index && arg->percent == percent;
+}
+
+TEST_F(DownloadsListTrackerTest, CoalescesProgressUpdates) {
+  MockDownloadItem* first_item = CreateNextItem();
+  MockDownloadItem* second_item = CreateNextItem();
+
+  CreateTracker();
+  EXPECT_CALL(page_, InsertItems(_, _));
+  tracker()->StartAndSendChunk();
+
+  for (int percent : {10, 20, 30}) {
+    ON_CALL(*first_item, PercentComplete()).WillByDefault(Return(percent));
+    tracker()->OnDownloadUpdated(manager(), first_item);
+  }
+  ON_CALL(*second_item, PercentComplete()).WillByDefault(Return(50));
+  tracker()->OnDownloadUpdated(manager(), second_item);
+
+  // All the changes go to the page in one call, with the latest progress.
+  EXPECT_CALL(page_, UpdateProgress(testing::UnorderedElementsAre(
+                         IsProgressUpdate(0, 50), IsProgressUpdate(1, 30))));
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+}
+
+TEST_F(DownloadsListTrackerTest, SendsOnlyChangedItems) {
+  MockDownloadItem* item = CreateNextItem();
+
+  CreateTracker();
+  EXPECT_CALL(page_, InsertItems(_, _));
+  tracker()->StartAndSendChunk();
+
+  // Does not send an update. StrictMock ensures no methods called on |page_|.
+  tracker()->OnDownloadUpdated(manager(), item);
+  tracker()->FlushUpdatesForTesting();
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+
+  // A change other than progress sends the whole item.
+  ON_CALL(*item, IsPaused()).WillByDefault(Return(true));
+  ON_CALL(*item, PercentComplete()).WillByDefault(Return(40));
+  tracker()->OnDownloadUpdated(manager(), item);
+  tracker()->FlushUpdatesForTesting();
+  EXPECT_CALL(page_, UpdateItem(0, _));
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+}
+
+TEST_F(DownloadsListTrackerTest, ProgressUpdatesAreRecordedAsSent) {
+  MockDownloadItem* item = CreateNextItem();
+
+  CreateTracker();
+  EXPECT_CALL(page_, InsertItems(_, _));
+  tracker()->StartAndSendChunk();
+
+  ON_CALL(*item, PercentComplete()).WillByDefault(Return(30));
+  tracker()->OnDownloadUpdated(manager(), item);
+  tracker()->FlushUpdatesForTesting();
+  EXPECT_CALL(page_,
+              UpdateProgress(testing::ElementsAre(IsProgressUpdate(0, 30))));
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+  testing::Mock::VerifyAndClearExpectations(&page_);
+
+  // The page already shows 30%, so nothing is sent.
+  tracker()->OnDownloadUpdated(manager(), item);
+  tracker()->FlushUpdatesForTesting();
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+}
+
+TEST_F(DownloadsListTrackerTest, SetVisibleRowCount) {
+  for (int i = 0; i < 50; ++i)
+    CreateNextItem();
+
+  CreateTracker();
+  tracker()->SetVisibleRowCount(15);
+  EXPECT_EQ(30u, tracker()->chunk_size());
+
+  // Small and huge windows are clamped.
+  tracker()->SetVisibleRowCount(1);
+  EXPECT_EQ(20u, tracker()->chunk_size());
+  tracker()->SetVisibleRowCount(10000);
+  EXPECT_EQ(200u, tracker()->chunk_size());
+
+  tracker()->SetVisibleRowCount(20);
+  EXPECT_CALL(page_, InsertItems(0, testing::SizeIs(40)));
+  EXPECT_CALL(page_, InsertItems(40, testing::SizeIs(10)));
+  tracker()->StartAndSendChunk();
+  tracker()->StartAndSendChunk();
+  FastForwardBy(base::TimeDelta::FromSeconds(1));
+}
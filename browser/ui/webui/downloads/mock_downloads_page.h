@@ -21,6 +21,8 @@ class MockPage : public downloads::mojom::Page {
 
   MOCK_METHOD1(RemoveItem, void(int));
   MOCK_METHOD2(UpdateItem, void(int, downloads::mojom::DataPtr));
+  MOCK_METHOD1(UpdateProgress,
+               void(std::vector<downloads::mojom::ProgressUpdatePtr>));
   MOCK_METHOD2(InsertItems, void(int, std::vector<downloads::mojom::DataPtr>));
   MOCK_METHOD0(ClearAll, void());
 
@@ -6,6 +6,7 @@
 
 #include "base/bind.h"
 #include "base/callback.h"
+#include "base/callback_helpers.h"
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/strings/string_split.h"
@@ -80,28 +81,20 @@ void FileIconSource::FetchFileIcon(
     float scale_factor,
     IconLoader::IconSize icon_size,
     content::URLDataSource::GotDataCallback callback) {
-  IconManager* im = g_browser_process->icon_manager();
-  gfx::Image* icon = im->LookupIconFromFilepath(path, icon_size);
-
-  if (icon) {
-    scoped_refptr<base::RefCountedBytes> icon_data(new base::RefCountedBytes);
-    gfx::PNGCodec::EncodeBGRASkBitmap(
-        icon->ToImageSkia()->GetRepresentation(scale_factor).GetBitmap(), false,
-        &icon_data->data());
-
-    std::move(callback).Run(icon_data.get());
-  } else {
-    // Attach the ChromeURLDataManager request ID to the history request.
-    IconRequestDetails details;
-    details.callback = std::move(callback);
-    details.scale_factor = scale_factor;
-
-    // Icon was not in cache, go fetch it slowly.
-    im->LoadIcon(path, icon_size,
-                 base::BindOnce(&FileIconSource::OnFileIconDataAvailable,
-                                base::Unretained(this), std::move(details)),
-                 &cancelable_task_tracker_);
-  }
+  // Attach the ChromeURLDataManager request ID to the history request.
+  IconRequestDetails details;
+  details.callback = std::move(callback);
+  details.scale_factor = scale_factor;
+
+  // LoadIcons() answers from the cache if it can, and merges this request
+  // with pending loads of the same icon, e.g. while the downloads page fetches
+  // the icons of many files of the same type.
+  g_browser_process->icon_manager()->LoadIcons(
+      {path}, /*offscreen_file_paths=*/{}, icon_size,
+      base::AdaptCallbackForRepeating(
+          base::BindOnce(&FileIconSource::OnFileIconDataAvailable,
+                         base::Unretained(this), std::move(details))),
+      &cancelable_task_tracker_);
 }
 
 std::string FileIconSource::GetSource() {
@@ -131,6 +124,7 @@ bool FileIconSource::AllowCaching() {
 }
 
 void FileIconSource::OnFileIconDataAvailable(IconRequestDetails details,
+                                             const base::FilePath& path,
                                              gfx::Image icon) {
   if (!icon.IsEmpty()) {
     scoped_refptr<base::RefCountedBytes> icon_data(new base::RefCountedBytes);
@@ -60,7 +60,9 @@ class FileIconSource : public content::URLDataSource {
   };
 
   // Called when favicon data is available from the history backend.
-  void OnFileIconDataAvailable(IconRequestDetails details, gfx::Image icon);
+  void OnFileIconDataAvailable(IconRequestDetails details,
+                               const base::FilePath& path,
+                               gfx::Image icon);
 
   // Tracks tasks requesting file icons.
   base::CancelableTaskTracker cancelable_task_tracker_;
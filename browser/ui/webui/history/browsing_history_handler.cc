@@ -6,6 +6,8 @@
 
 #include <stddef.h>
 
+#include <algorithm>
+#include <map>
 #include <set>
 
 #include "base/bind.h"
@@ -14,9 +16,12 @@
 #include "base/feature_list.h"
 #include "base/i18n/rtl.h"
 #include "base/i18n/time_formatting.h"
+#include "base/memory/ref_counted.h"
 #include "base/notreached.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/task/thread_pool.h"
+#include "base/task_runner_util.h"
 #include "base/time/default_clock.h"
 #include "base/time/time.h"
 #include "chrome/browser/bookmarks/bookmark_model_factory.h"
@@ -29,11 +34,14 @@
 #include "chrome/browser/sync/profile_sync_service_factory.h"
 #include "chrome/browser/ui/browser_finder.h"
 #include "chrome/browser/ui/chrome_pages.h"
+#include "chrome/browser/ui/ui_features.h"
 #include "chrome/browser/ui/webui/favicon_source.h"
 #include "chrome/common/buildflags.h"
 #include "chrome/common/pref_names.h"
 #include "components/bookmarks/browser/bookmark_model.h"
 #include "components/bookmarks/browser/bookmark_utils.h"
+#include "components/bookmarks/browser/history_bookmark_model.h"
+#include "components/bookmarks/browser/model_loader.h"
 #include "components/favicon/core/fallback_url_util.h"
 #include "components/favicon/core/large_icon_service.h"
 #include "components/favicon_base/favicon_url_parser.h"
@@ -71,6 +79,9 @@ static const char kDeviceTypeLaptop[] = "laptop";
 static const char kDeviceTypePhone[] = "phone";
 static const char kDeviceTypeTablet[] = "tablet";
 
+// The number of entries sent to the page at a time when results are streamed.
+constexpr size_t kResultsPageSize = 25;
+
 // Gets the name and type of a device for the given sync client ID.
 // |name| and |type| are out parameters.
 void GetDeviceNameAndType(const syncer::DeviceInfoTracker* tracker,
@@ -166,13 +177,138 @@ bool IsEntryInRemoteUserData(
   return false;
 }
 
-// Converts |entry| to a base::Value to be owned by the caller.
+// The parts of an entry's value which come from services that live on the UI
+// thread.
+struct EntryServiceData {
+  bool starred = false;
+  std::string device_name;
+  std::string device_type;
+  int host_filtering_behavior = -1;
+  bool is_blocked_visit = false;
+};
+
+// Looks up the EntryServiceData of the entries of one query. Results often have
+// several entries for the same URL or device, so answers are remembered for the
+// rest of the query. Bookmarks are only looked up if |bookmark_model| is given.
+class EntryServiceDataLookup {
+ public:
+  EntryServiceDataLookup(Profile* profile,
+                         BookmarkModel* bookmark_model,
+                         const syncer::DeviceInfoTracker* tracker)
+      : bookmark_model_(bookmark_model), tracker_(tracker) {
+#if BUILDFLAG(ENABLE_SUPERVISED_USERS)
+    if (profile->IsSupervised()) {
+      SupervisedUserService* supervised_user_service =
+          SupervisedUserServiceFactory::GetForProfile(profile);
+      if (supervised_user_service)
+        url_filter_ = supervised_user_service->GetURLFilter();
+    }
+#endif
+  }
+
+  EntryServiceDataLookup(const EntryServiceDataLookup&) = delete;
+  EntryServiceDataLookup& operator=(const EntryServiceDataLookup&) = delete;
+
+  EntryServiceData Get(const BrowsingHistoryService::HistoryEntry& entry) {
+    EntryServiceData data;
+
+    if (bookmark_model_) {
+      auto starred = starred_.find(entry.url);
+      if (starred == starred_.end()) {
+        starred = starred_
+                      .emplace(entry.url,
+                               bookmark_model_->IsBookmarked(entry.url))
+                      .first;
+      }
+      data.starred = starred->second;
+    }
+
+    if (!entry.client_id.empty()) {
+      auto device = devices_.find(entry.client_id);
+      if (device == devices_.end()) {
+        std::pair<std::string, std::string> name_and_type;
+        GetDeviceNameAndType(tracker_, entry.client_id, &name_and_type.first,
+                             &name_and_type.second);
+        device = devices_.emplace(entry.client_id, std::move(name_and_type))
+                     .first;
+      }
+      data.device_name = device->second.first;
+      data.device_type = device->second.second;
+    }
+
+#if BUILDFLAG(ENABLE_SUPERVISED_USERS)
+    if (url_filter_) {
+      data.host_filtering_behavior = url_filter_->GetFilteringBehaviorForURL(
+          entry.url.GetWithEmptyPath());
+      data.is_blocked_visit = entry.blocked_visit;
+    }
+#endif
+
+    return data;
+  }
+
+ private:
+  BookmarkModel* const bookmark_model_;
+  const syncer::DeviceInfoTracker* const tracker_;
+
+  // Whether a URL is bookmarked.
+  std::map<GURL, bool> starred_;
+
+  // The name and type of a device, by sync client ID.
+  std::map<std::string, std::pair<std::string, std::string>> devices_;
+
+#if BUILDFLAG(ENABLE_SUPERVISED_USERS)
+  const SupervisedUserURLFilter* url_filter_ = nullptr;
+#endif
+};
+
+// Formats the dates of the entries of one query. The strings which only depend
+// on the day of an entry are formatted once per day. Not thread-safe, but may
+// be used on any sequence.
+class EntryDateFormatter {
+ public:
+  struct DayStrings {
+    std::u16string date_short;
+    std::u16string date_relative_day;
+  };
+
+  explicit EntryDateFormatter(base::Time now)
+      : midnight_(now.LocalMidnight()) {}
+
+  EntryDateFormatter(const EntryDateFormatter&) = delete;
+  EntryDateFormatter& operator=(const EntryDateFormatter&) = delete;
+
+  const DayStrings& GetDayStrings(base::Time time) {
+    const base::Time day = time.LocalMidnight();
+    auto it = days_.find(day);
+    if (it != days_.end())
+      return it->second;
+
+    DayStrings strings;
+    strings.date_short = base::TimeFormatShortDate(time);
+    std::u16string date_str = ui::TimeFormat::RelativeDate(time, &midnight_);
+    if (date_str.empty()) {
+      date_str = base::TimeFormatFriendlyDate(time);
+    } else {
+      date_str = l10n_util::GetStringFUTF16(
+          IDS_HISTORY_DATE_WITH_RELATIVE_TIME, date_str,
+          base::TimeFormatFriendlyDate(time));
+    }
+    strings.date_relative_day = std::move(date_str);
+    return days_.emplace(day, std::move(strings)).first->second;
+  }
+
+ private:
+  const base::Time midnight_;
+  std::map<base::Time, DayStrings> days_;
+};
+
+// Converts |entry| to a base::Value to be owned by the caller. Only uses
+// services through |service_data|, so it can run off the UI thread.
 base::Value HistoryEntryToValue(
     const BrowsingHistoryService::HistoryEntry& entry,
-    BookmarkModel* bookmark_model,
-    Profile* profile,
-    const syncer::DeviceInfoTracker* tracker,
-    base::Clock* clock) {
+    const EntryServiceData& service_data,
+    EntryDateFormatter* date_formatter) {
   base::Value result(base::Value::Type::DICTIONARY);
   SetHistoryEntryUrlAndTitle(entry, &result);
 
@@ -201,15 +337,16 @@ base::Value HistoryEntryToValue(
   }
   result.SetKey("allTimestamps", std::move(timestamps));
 
+  const EntryDateFormatter::DayStrings& day_strings =
+      date_formatter->GetDayStrings(entry.time);
+
   // Always pass the short date since it is needed both in the search and in
   // the monthly view.
-  result.SetStringKey("dateShort", base::TimeFormatShortDate(entry.time));
+  result.SetStringKey("dateShort", day_strings.date_short);
 
   std::u16string snippet_string;
   std::u16string date_relative_day;
   std::u16string date_time_of_day;
-  bool is_blocked_visit = false;
-  int host_filtering_behavior = -1;
 
   // Only pass in the strings we need (search results need a shortdate
   // and snippet, browse results need day and time information). Makes sure that
@@ -217,49 +354,19 @@ base::Value HistoryEntryToValue(
   if (entry.is_search_result) {
     snippet_string = entry.snippet;
   } else {
-    base::Time midnight = clock->Now().LocalMidnight();
-    std::u16string date_str =
-        ui::TimeFormat::RelativeDate(entry.time, &midnight);
-    if (date_str.empty()) {
-      date_str = base::TimeFormatFriendlyDate(entry.time);
-    } else {
-      date_str = l10n_util::GetStringFUTF16(
-          IDS_HISTORY_DATE_WITH_RELATIVE_TIME, date_str,
-          base::TimeFormatFriendlyDate(entry.time));
-    }
-    date_relative_day = date_str;
+    date_relative_day = day_strings.date_relative_day;
     date_time_of_day = base::TimeFormatTimeOfDay(entry.time);
   }
 
-  std::string device_name;
-  std::string device_type;
-  if (!entry.client_id.empty())
-    GetDeviceNameAndType(tracker, entry.client_id, &device_name, &device_type);
-  result.SetStringKey("deviceName", device_name);
-  result.SetStringKey("deviceType", device_type);
-
-#if BUILDFLAG(ENABLE_SUPERVISED_USERS)
-  SupervisedUserService* supervised_user_service = nullptr;
-  if (profile->IsSupervised()) {
-    supervised_user_service =
-        SupervisedUserServiceFactory::GetForProfile(profile);
-  }
-  if (supervised_user_service) {
-    const SupervisedUserURLFilter* url_filter =
-        supervised_user_service->GetURLFilter();
-    int filtering_behavior =
-        url_filter->GetFilteringBehaviorForURL(entry.url.GetWithEmptyPath());
-    is_blocked_visit = entry.blocked_visit;
-    host_filtering_behavior = filtering_behavior;
-  }
-#endif
-
+  result.SetStringKey("deviceName", service_data.device_name);
+  result.SetStringKey("deviceType", service_data.device_type);
   result.SetStringKey("dateTimeOfDay", date_time_of_day);
   result.SetStringKey("dateRelativeDay", date_relative_day);
   result.SetStringKey("snippet", snippet_string);
-  result.SetBoolKey("starred", bookmark_model->IsBookmarked(entry.url));
-  result.SetIntKey("hostFilteringBehavior", host_filtering_behavior);
-  result.SetBoolKey("blockedVisit", is_blocked_visit);
+  result.SetBoolKey("starred", service_data.starred);
+  result.SetIntKey("hostFilteringBehavior",
+                   service_data.host_filtering_behavior);
+  result.SetBoolKey("blockedVisit", service_data.is_blocked_visit);
   result.SetBoolKey("isUrlInRemoteUserData", IsEntryInRemoteUserData(entry));
   result.SetStringKey("remoteIconUrlForUma",
                       entry.remote_icon_url_for_uma.spec());
@@ -277,6 +384,82 @@ base::Value HistoryEntryToValue(
   return result;
 }
 
+// The results of a query which are converted to values a page at a time, on a
+// worker sequence. Whether an entry is bookmarked is also looked up there,
+// through the thread-safe HistoryBookmarkModel of |bookmark_model_loader|,
+// which is null if the bookmarks aren't loaded yet.
+class ResultsToFormat : public base::RefCountedThreadSafe<ResultsToFormat> {
+ public:
+  ResultsToFormat(std::vector<BrowsingHistoryService::HistoryEntry> entries,
+                  std::vector<EntryServiceData> service_data,
+                  scoped_refptr<bookmarks::ModelLoader> bookmark_model_loader,
+                  base::Time now)
+      : entries_(std::move(entries)),
+        service_data_(std::move(service_data)),
+        bookmark_model_loader_(std::move(bookmark_model_loader)),
+        date_formatter_(now) {
+    DCHECK_EQ(entries_.size(), service_data_.size());
+  }
+
+  ResultsToFormat(const ResultsToFormat&) = delete;
+  ResultsToFormat& operator=(const ResultsToFormat&) = delete;
+
+  // Converts the entries in [begin, end) to a list value.
+  base::Value FormatPage(size_t begin, size_t end) {
+    base::Value page(base::Value::Type::LIST);
+    for (size_t i = begin; i < end; ++i) {
+      service_data_[i].starred = IsBookmarked(entries_[i].url);
+      page.Append(
+          HistoryEntryToValue(entries_[i], service_data_[i], &date_formatter_));
+    }
+    return page;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ResultsToFormat>;
+
+  ~ResultsToFormat() = default;
+
+  bool IsBookmarked(const GURL& url) {
+    if (!bookmark_model_loader_)
+      return false;
+    auto starred = starred_.find(url);
+    if (starred == starred_.end()) {
+      starred = starred_
+                    .emplace(url, bookmark_model_loader_
+                                      ->history_bookmark_model()
+                                      ->IsBookmarked(url))
+                    .first;
+    }
+    return starred->second;
+  }
+
+  const std::vector<BrowsingHistoryService::HistoryEntry> entries_;
+  std::vector<EntryServiceData> service_data_;
+  const scoped_refptr<bookmarks::ModelLoader> bookmark_model_loader_;
+  // Whether a URL is bookmarked.
+  std::map<GURL, bool> starred_;
+  EntryDateFormatter date_formatter_;
+};
+
+// Creates the value which resolves a query, from a list of entry values.
+base::Value CreateQueryResults(const std::u16string& search_text,
+                               bool finished,
+                               base::Value results_value) {
+  base::Value results_info(base::Value::Type::DICTIONARY);
+  // The items which are to be written into results_info_value_ are also
+  // described in chrome/browser/resources/history/history.js in @typedef for
+  // HistoryQuery. Please update it whenever you add or remove any keys in
+  // results_info_value_.
+  results_info.SetStringKey("term", search_text);
+  results_info.SetBoolKey("finished", finished);
+
+  base::Value final_results(base::Value::Type::DICTIONARY);
+  final_results.SetKey("info", std::move(results_info));
+  final_results.SetKey("value", std::move(results_value));
+  return final_results;
+}
+
 }  // namespace
 
 BrowsingHistoryHandler::BrowsingHistoryHandler()
@@ -299,6 +482,7 @@ void BrowsingHistoryHandler::OnJavascriptAllowed() {
 
 void BrowsingHistoryHandler::OnJavascriptDisallowed() {
   weak_factory_.InvalidateWeakPtrs();
+  query_weak_factory_.InvalidateWeakPtrs();
   browsing_history_service_ = nullptr;
   initial_results_ = base::Value();
   deferred_callbacks_.clear();
@@ -363,6 +547,9 @@ void BrowsingHistoryHandler::HandleQueryHistory(const base::ListValue* args) {
   // prevents the QueryHistory() call to the browsing history service.
   query_history_continuation_.Reset();
 
+  // Drop the pages of the previous query which are still being formatted.
+  query_weak_factory_.InvalidateWeakPtrs();
+
   // Cancel the previous query if it is still in flight.
   if (!query_history_callback_id_.empty()) {
     RejectJavascriptCallback(base::Value(query_history_callback_id_),
@@ -482,35 +669,106 @@ void BrowsingHistoryHandler::OnQueryComplete(
   const syncer::DeviceInfoTracker* tracker =
       DeviceInfoSyncServiceFactory::GetForProfile(profile)
           ->GetDeviceInfoTracker();
+  DCHECK(tracker);
+
+  if (base::FeatureList::IsEnabled(
+          features::kWebUIHistoryResultsStreaming)) {
+    // Bookmarks are looked up while formatting, off the UI thread.
+    EntryServiceDataLookup service_data_lookup(profile,
+                                               /*bookmark_model=*/nullptr,
+                                               tracker);
+    std::vector<EntryServiceData> service_data;
+    service_data.reserve(results.size());
+    for (const BrowsingHistoryService::HistoryEntry& entry : results)
+      service_data.push_back(service_data_lookup.Get(entry));
+    // |results| belongs to the service, so it is copied once here, and then
+    // shared by all the pages.
+    auto results_to_format = base::MakeRefCounted<ResultsToFormat>(
+        results, std::move(service_data),
+        bookmark_model && bookmark_model->loaded()
+            ? bookmark_model->model_loader()
+            : nullptr,
+        clock_->Now());
+
+    if (!formatting_task_runner_) {
+      formatting_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner(
+          {base::TaskPriority::USER_BLOCKING});
+    }
+    // The pages are formatted in order on one sequence, so they also come back
+    // in order. An empty result is sent as one empty page.
+    const size_t size = results.size();
+    for (size_t begin = 0; begin == 0 || begin < size;
+         begin += kResultsPageSize) {
+      const size_t end = std::min(begin + kResultsPageSize, size);
+      base::PostTaskAndReplyWithResult(
+          formatting_task_runner_.get(), FROM_HERE,
+          base::BindOnce(&ResultsToFormat::FormatPage, results_to_format, begin,
+                         end),
+          base::BindOnce(&BrowsingHistoryHandler::OnResultsPageFormatted,
+                         query_weak_factory_.GetWeakPtr(),
+                         query_results_info.search_text, begin == 0,
+                         end == size, query_results_info.reached_beginning));
+    }
+    return;
+  }
 
   // Convert the result vector into a ListValue.
-  DCHECK(tracker);
+  EntryServiceDataLookup service_data_lookup(profile, bookmark_model, tracker);
+  EntryDateFormatter date_formatter(clock_->Now());
   base::Value results_value(base::Value::Type::LIST);
   for (const BrowsingHistoryService::HistoryEntry& entry : results) {
-    results_value.Append(
-        HistoryEntryToValue(entry, bookmark_model, profile, tracker, clock_));
+    results_value.Append(HistoryEntryToValue(
+        entry, service_data_lookup.Get(entry), &date_formatter));
   }
 
-  base::Value results_info(base::Value::Type::DICTIONARY);
-  // The items which are to be written into results_info_value_ are also
-  // described in chrome/browser/resources/history/history.js in @typedef for
-  // HistoryQuery. Please update it whenever you add or remove any keys in
-  // results_info_value_.
-  results_info.SetStringKey("term", query_results_info.search_text);
-  results_info.SetBoolKey("finished", query_results_info.reached_beginning);
+  SendQueryResults(CreateQueryResults(query_results_info.search_text,
+                                      query_results_info.reached_beginning,
+                                      std::move(results_value)));
+}
 
-  base::Value final_results(base::Value::Type::DICTIONARY);
-  final_results.SetKey("info", std::move(results_info));
-  final_results.SetKey("value", std::move(results_value));
+void BrowsingHistoryHandler::OnResultsPageFormatted(
+    const std::u16string& search_text,
+    bool first_page,
+    bool last_page,
+    bool reached_beginning,
+    base::Value page) {
+  const bool finished = last_page && reached_beginning;
+  if (first_page) {
+    SendQueryResults(
+        CreateQueryResults(search_text, finished, std::move(page)));
+    return;
+  }
+
+  // JS is not ready yet, and still waits for the first page.
+  if (!initial_results_.is_none()) {
+    base::Value* results_value = initial_results_.FindListKey("value");
+    for (base::Value& entry : page.TakeList())
+      results_value->Append(std::move(entry));
+    initial_results_.FindDictKey("info")->SetBoolKey("finished", finished);
+    return;
+  }
+
+  if (!IsJavascriptAllowed())
+    return;
+
+  // The items which are to be written into results_page are also described in
+  // chrome/browser/resources/history/externs.js in @typedef for
+  // HistoryResultsPage.
+  base::Value results_page(base::Value::Type::DICTIONARY);
+  results_page.SetKey("value", std::move(page));
+  results_page.SetBoolKey("finished", finished);
+  FireWebUIListener("history-results-page", results_page);
+}
 
+void BrowsingHistoryHandler::SendQueryResults(base::Value results) {
   if (query_history_callback_id_.empty()) {
     // This can happen if JS isn't ready yet when the first query comes back.
-    initial_results_ = std::move(final_results);
+    initial_results_ = std::move(results);
     return;
   }
 
   ResolveJavascriptCallback(base::Value(query_history_callback_id_),
-                            std::move(final_results));
+                            std::move(results));
   query_history_callback_id_.clear();
 }
 
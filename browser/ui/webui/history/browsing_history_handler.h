@@ -14,7 +14,9 @@
 
 #include "base/callback.h"
 #include "base/macros.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
 #include "base/time/clock.h"
 #include "base/values.h"
 #include "chrome/browser/history/profile_based_browsing_history_driver.h"
@@ -76,6 +78,19 @@ class BrowsingHistoryHandler : public content::WebUIMessageHandler,
                            ObservingWebHistoryDeletions);
   FRIEND_TEST_ALL_PREFIXES(BrowsingHistoryHandlerTest, MdTruncatesTitles);
 
+  // Called with each page of a query's results, in order, when results are
+  // streamed. The first page resolves the query; the others are sent as
+  // "history-results-page" events.
+  void OnResultsPageFormatted(const std::u16string& search_text,
+                              bool first_page,
+                              bool last_page,
+                              bool reached_beginning,
+                              base::Value page);
+
+  // Resolves the pending query with |results|, or keeps them until JS asks for
+  // them.
+  void SendQueryResults(base::Value results);
+
   // The clock used to vend times.
   base::Clock* clock_;
 
@@ -91,8 +106,15 @@ class BrowsingHistoryHandler : public content::WebUIMessageHandler,
 
   std::string remove_visits_callback_;
 
+  // Formats the pages of streamed results off the UI thread.
+  scoped_refptr<base::SequencedTaskRunner> formatting_task_runner_;
+
   base::WeakPtrFactory<BrowsingHistoryHandler> weak_factory_{this};
 
+  // Weak pointers for the pages of the current query, which are invalidated
+  // when another query starts.
+  base::WeakPtrFactory<BrowsingHistoryHandler> query_weak_factory_{this};
+
   DISALLOW_COPY_AND_ASSIGN(BrowsingHistoryHandler);
 };
 
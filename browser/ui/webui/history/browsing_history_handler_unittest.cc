@@ -7,21 +7,28 @@
 #include <stdint.h>
 #include <memory>
 #include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
 #include "base/macros.h"
 #include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/simple_test_clock.h"
 #include "base/values.h"
 #include "build/build_config.h"
 #include "chrome/browser/bookmarks/bookmark_model_factory.h"
 #include "chrome/browser/history/web_history_service_factory.h"
 #include "chrome/browser/sync/profile_sync_service_factory.h"
+#include "chrome/browser/ui/ui_features.h"
 #include "chrome/test/base/chrome_render_view_host_test_harness.h"
 #include "chrome/test/base/testing_profile.h"
+#include "components/bookmarks/browser/bookmark_model.h"
+#include "components/bookmarks/test/bookmark_test_helpers.h"
 #include "components/history/core/browser/browsing_history_service.h"
 #include "components/history/core/test/fake_web_history_service.h"
 #include "components/sync/base/model_type.h"
@@ -330,4 +337,110 @@ TEST_F(BrowsingHistoryHandlerTest, Reload) {
   // There should be no new Web UI calls, since JS is still disallowed.
   ASSERT_TRUE(web_ui()->call_data().empty());
 }
+
+TEST_F(BrowsingHistoryHandlerTest, StreamsResultsInPages) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kWebUIHistoryResultsStreaming);
+
+  BrowsingHistoryHandlerWithWebUIForTesting handler(web_ui());
+  handler.RegisterMessages();
+  handler.PostponeResults();
+  handler.StartQueryHistory();
+  InitializeWebUI(handler);
+
+  std::vector<history::BrowsingHistoryService::HistoryEntry> entries(60);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    entries[i].url =
+        GURL(base::StringPrintf("https://www.example.com/%zu", i));
+    entries[i].time = PretendNow() - base::TimeDelta::FromHours(i);
+  }
+  history::BrowsingHistoryService::QueryResultsInfo info;
+  info.reached_beginning = true;
+  handler.OnQueryComplete(entries, info, base::OnceClosure());
+  task_environment()->RunUntilIdle();
+
+  // The first page resolves the query, and the others follow as events.
+  ASSERT_EQ(3u, web_ui()->call_data().size());
+  const content::TestWebUI::CallData& first = *web_ui()->call_data()[0];
+  EXPECT_EQ("cr.webUIResponse", first.function_name());
+  EXPECT_FALSE(*first.arg3()->FindBoolPath("info.finished"));
+
+  std::vector<const base::Value*> pages = {first.arg3()};
+  for (size_t i = 1; i < 3; ++i) {
+    const content::TestWebUI::CallData& data = *web_ui()->call_data()[i];
+    EXPECT_EQ("cr.webUIListenerCallback", data.function_name());
+    EXPECT_EQ("history-results-page", data.arg1()->GetString());
+    EXPECT_EQ(i == 2, *data.arg2()->FindBoolKey("finished"));
+    pages.push_back(data.arg2());
+  }
+
+  std::vector<std::string> urls;
+  for (const base::Value* page : pages) {
+    for (const base::Value& entry : page->FindListKey("value")->GetList())
+      urls.push_back(*entry.FindStringKey("url"));
+  }
+  ASSERT_EQ(entries.size(), urls.size());
+  for (size_t i = 0; i < entries.size(); ++i)
+    EXPECT_EQ(entries[i].url.spec(), urls[i]);
+}
+
+TEST_F(BrowsingHistoryHandlerTest, StreamedResultsWaitForJavascript) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kWebUIHistoryResultsStreaming);
+
+  BrowsingHistoryHandlerWithWebUIForTesting handler(web_ui());
+  std::vector<history::BrowsingHistoryService::HistoryEntry> entries(30);
+  for (size_t i = 0; i < entries.size(); ++i)
+    entries[i].url = GURL(base::StringPrintf("https://www.example.com/%zu", i));
+  handler.OnQueryComplete(entries,
+                          history::BrowsingHistoryService::QueryResultsInfo(),
+                          base::OnceClosure());
+  task_environment()->RunUntilIdle();
+  ASSERT_TRUE(web_ui()->call_data().empty());
+
+  // All the pages resolve the first query together.
+  InitializeWebUI(handler);
+  ASSERT_EQ(1u, web_ui()->call_data().size());
+  const base::Value* list =
+      web_ui()->call_data().front()->arg3()->FindListKey("value");
+  ASSERT_TRUE(list);
+  EXPECT_EQ(entries.size(), list->GetList().size());
+}
+
+TEST_F(BrowsingHistoryHandlerTest, StreamedResultsAreStarredOffTheUIThread) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kWebUIHistoryResultsStreaming);
+
+  bookmarks::BookmarkModel* bookmark_model =
+      BookmarkModelFactory::GetForBrowserContext(profile());
+  bookmarks::test::WaitForBookmarkModelToLoad(bookmark_model);
+  const GURL bookmarked_url("https://www.example.com/1");
+  bookmark_model->AddURL(bookmark_model->bookmark_bar_node(), 0, u"Bookmark",
+                         bookmarked_url);
+
+  BrowsingHistoryHandlerWithWebUIForTesting handler(web_ui());
+  handler.RegisterMessages();
+  handler.PostponeResults();
+  handler.StartQueryHistory();
+  InitializeWebUI(handler);
+
+  std::vector<history::BrowsingHistoryService::HistoryEntry> entries(3);
+  for (size_t i = 0; i < entries.size(); ++i)
+    entries[i].url = GURL(base::StringPrintf("https://www.example.com/%zu", i));
+  // A repeated URL is answered from the lookups of the query.
+  entries[2].url = bookmarked_url;
+  handler.OnQueryComplete(entries,
+                          history::BrowsingHistoryService::QueryResultsInfo(),
+                          base::OnceClosure());
+  task_environment()->RunUntilIdle();
+
+  ASSERT_EQ(1u, web_ui()->call_data().size());
+  const base::Value* list =
+      web_ui()->call_data().front()->arg3()->FindListKey("value");
+  ASSERT_TRUE(list);
+  ASSERT_EQ(3u, list->GetList().size());
+  EXPECT_FALSE(*list->GetList()[0].FindBoolKey("starred"));
+  EXPECT_TRUE(*list->GetList()[1].FindBoolKey("starred"));
+  EXPECT_TRUE(*list->GetList()[2].FindBoolKey("starred"));
+}
 #endif
@@ -661,7 +661,9 @@ void PrintPreviewUI::OnCompositePdfPageDone(
 
       auto* client = PdfNupConverterClient::FromWebContents(web_contents);
       DCHECK(client);
-      client->DoNupPdfConvert(
+      // Converted sheets are cached per document, so a new preview of the
+      // same document only converts the sheets whose pages or layout changed.
+      client->DoNupPdfSheetsConvert(
           document_cookie, pages_per_sheet_, page_size(), printable_rect,
           std::move(pdf_page_regions),
           mojo::WrapCallbackWithDefaultInvokeIfNotRun(
@@ -11,7 +11,6 @@
 #include "base/task/post_task.h"
 #include "base/task/thread_pool.h"
 #include "base/values.h"
-#include "chrome/browser/browsing_data/browsing_data_file_system_util.h"
 #include "chrome/browser/chromeos/crostini/crostini_features.h"
 #include "chrome/browser/chromeos/file_manager/path_util.h"
 #include "chrome/browser/profiles/profile.h"
@@ -21,15 +20,7 @@
 #include "components/arc/arc_service_manager.h"
 #include "components/arc/session/arc_bridge_service.h"
 #include "components/arc/storage_manager/arc_storage_manager.h"
-#include "components/browsing_data/content/appcache_helper.h"
-#include "components/browsing_data/content/cache_storage_helper.h"
 #include "components/browsing_data/content/conditional_cache_counting_helper.h"
-#include "components/browsing_data/content/cookie_helper.h"
-#include "components/browsing_data/content/database_helper.h"
-#include "components/browsing_data/content/file_system_helper.h"
-#include "components/browsing_data/content/indexed_db_helper.h"
-#include "components/browsing_data/content/local_storage_helper.h"
-#include "components/browsing_data/content/service_worker_helper.h"
 #include "components/user_manager/user_manager.h"
 #include "content/public/browser/storage_partition.h"
 
@@ -166,30 +157,12 @@ void BrowsingDataSizeCalculator::PerformCalculation() {
       base::BindOnce(&BrowsingDataSizeCalculator::OnGetCacheSize,
                      weak_ptr_factory_.GetWeakPtr()));
 
-  // Fetch the size of site data in browsing data.
-  if (!site_data_size_collector_.get()) {
-    content::StoragePartition* storage_partition =
-        content::BrowserContext::GetDefaultStoragePartition(profile_);
-    site_data_size_collector_ = std::make_unique<SiteDataSizeCollector>(
-        storage_partition->GetPath(),
-        new browsing_data::CookieHelper(storage_partition,
-                                        base::NullCallback()),
-        new browsing_data::DatabaseHelper(profile_),
-        new browsing_data::LocalStorageHelper(profile_),
-        new browsing_data::AppCacheHelper(
-            storage_partition->GetAppCacheService()),
-        new browsing_data::IndexedDBHelper(storage_partition),
-        browsing_data::FileSystemHelper::Create(
-            storage_partition->GetFileSystemContext(),
-            browsing_data_file_system_util::GetAdditionalFileSystemTypes(),
-            storage_partition->GetNativeIOContext()),
-        new browsing_data::ServiceWorkerHelper(
-            storage_partition->GetServiceWorkerContext()),
-        new browsing_data::CacheStorageHelper(storage_partition));
-  }
-  site_data_size_collector_->Fetch(
-      base::BindOnce(&BrowsingDataSizeCalculator::OnGetBrowsingDataSize,
-                     weak_ptr_factory_.GetWeakPtr(), /*is_site_data=*/true));
+  // Fetch the size of site data in browsing data. The callback runs again if
+  // the cached size is refreshed, which updates the reported size.
+  SiteDataSizeCollector::GetForProfile(profile_)->Fetch(
+      base::BindRepeating(&BrowsingDataSizeCalculator::OnGetBrowsingDataSize,
+                          weak_ptr_factory_.GetWeakPtr(),
+                          /*is_site_data=*/true));
 }
 
 void BrowsingDataSizeCalculator::OnGetCacheSize(bool is_upper_limit,
@@ -171,9 +171,6 @@ class BrowsingDataSizeCalculator : public SizeCalculator {
   // True if we have already received the size of http cache.
   bool has_browser_site_data_size_ = false;
 
-  // Helper to compute the total size of all types of site date.
-  std::unique_ptr<SiteDataSizeCollector> site_data_size_collector_;
-
   Profile* profile_;
   base::WeakPtrFactory<BrowsingDataSizeCalculator> weak_ptr_factory_{this};
 };
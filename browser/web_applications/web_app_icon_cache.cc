@@ -0,0 +1,150 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/web_applications/web_app_icon_cache.h"
+
+#include <tuple>
+
+#include "base/bind.h"
+#include "base/check_op.h"
+#include "base/metrics/histogram_functions.h"
+#include "content/public/browser/browser_thread.h"
+
+namespace web_app {
+
+namespace {
+
+// Shared instance. Only set once, except in tests which can reset the
+// instance and create a new one.
+WebAppIconCache* g_instance = nullptr;
+
+}  // namespace
+
+constexpr size_t WebAppIconCache::kDefaultMaxBytes;
+constexpr char WebAppIconCache::kHistogramCacheHit[];
+
+bool WebAppIconCache::Key::operator<(const Key& other) const {
+  return std::tie(web_apps_directory, app_id, purpose, size_px) <
+         std::tie(other.web_apps_directory, other.app_id, other.purpose,
+                  other.size_px);
+}
+
+// static
+WebAppIconCache& WebAppIconCache::GetInstance() {
+  if (!g_instance)
+    g_instance = new WebAppIconCache(kDefaultMaxBytes);
+  return *g_instance;
+}
+
+// static
+void WebAppIconCache::ResetInstanceForTesting(size_t max_bytes) {
+  delete g_instance;
+  g_instance = new WebAppIconCache(max_bytes);
+}
+
+WebAppIconCache::WebAppIconCache(size_t max_bytes)
+    : max_bytes_(max_bytes),
+      entries_(base::MRUCache<Key, SkBitmap>::NO_AUTO_EVICT) {
+  memory_pressure_listener_ = std::make_unique<base::MemoryPressureListener>(
+      FROM_HERE, base::BindRepeating(&WebAppIconCache::OnMemoryPressure,
+                                     base::Unretained(this)));
+}
+
+WebAppIconCache::~WebAppIconCache() = default;
+
+SkBitmap WebAppIconCache::Get(const base::FilePath& web_apps_directory,
+                              const AppId& app_id,
+                              IconPurpose purpose,
+                              SquareSizePx size_px) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto it = entries_.Get(Key{web_apps_directory, app_id, purpose, size_px});
+  const bool hit = it != entries_.end();
+  base::UmaHistogramBoolean(kHistogramCacheHit, hit);
+  if (!hit) {
+    ++miss_count_;
+    return SkBitmap();
+  }
+  ++hit_count_;
+  return it->second;
+}
+
+void WebAppIconCache::Put(const base::FilePath& web_apps_directory,
+                          const AppId& app_id,
+                          IconPurpose purpose,
+                          SquareSizePx size_px,
+                          const SkBitmap& bitmap,
+                          uint64_t epoch) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (epoch != epoch_ || bitmap.drawsNothing())
+    return;
+
+  const size_t bytes = bitmap.computeByteSize();
+  if (bytes > max_bytes_)
+    return;
+
+  Key key{web_apps_directory, app_id, purpose, size_px};
+  auto existing = entries_.Peek(key);
+  if (existing != entries_.end()) {
+    total_bytes_ -= existing->second.computeByteSize();
+    entries_.Erase(existing);
+  }
+
+  EvictUntilBytesAtMost(max_bytes_ - bytes);
+  entries_.Put(std::move(key), bitmap);
+  total_bytes_ += bytes;
+}
+
+void WebAppIconCache::RemoveApp(const base::FilePath& web_apps_directory,
+                                const AppId& app_id) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  ++epoch_;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->first.app_id == app_id &&
+        it->first.web_apps_directory == web_apps_directory) {
+      total_bytes_ -= it->second.computeByteSize();
+      it = entries_.Erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void WebAppIconCache::Clear() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  ++epoch_;
+  entries_.Clear();
+  total_bytes_ = 0;
+}
+
+base::WeakPtr<WebAppIconCache> WebAppIconCache::GetWeakPtr() {
+  return weak_ptr_factory_.GetWeakPtr();
+}
+
+void WebAppIconCache::EvictUntilBytesAtMost(size_t max_bytes) {
+  while (total_bytes_ > max_bytes && !entries_.empty()) {
+    auto lru = entries_.rbegin();
+    DCHECK_GE(total_bytes_, lru->second.computeByteSize());
+    total_bytes_ -= lru->second.computeByteSize();
+    entries_.Erase(lru);
+  }
+}
+
+void WebAppIconCache::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel level) {
+  switch (level) {
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+      return;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+      // Keep the most recently used half, which is likely what is on screen.
+      EvictUntilBytesAtMost(max_bytes_ / 2);
+      return;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+      // Dropping entries doesn't need to invalidate in-flight reads.
+      entries_.Clear();
+      total_bytes_ = 0;
+      return;
+  }
+}
+
+}  // namespace web_app
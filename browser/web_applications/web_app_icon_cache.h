@@ -0,0 +1,119 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_WEB_APPLICATIONS_WEB_APP_ICON_CACHE_H_
+#define CHROME_BROWSER_WEB_APPLICATIONS_WEB_APP_ICON_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/weak_ptr.h"
+#include "chrome/browser/web_applications/components/web_app_id.h"
+#include "chrome/browser/web_applications/components/web_application_info.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+
+namespace web_app {
+
+// A least-recently-used cache of decoded web app icons, keyed by the web apps
+// directory of the profile the app is installed in, app, purpose and size.
+// The cache is bounded by the number of bytes of pixel data it holds rather
+// than by the number of entries, since icon sizes vary from 16px to 512px and
+// above. Entries are dropped under memory pressure.
+//
+// A single instance is shared by the WebAppIconManager of every profile, so
+// that the budget bounds the decoded icons of the whole browser process.
+//
+// Exclusively used from the UI thread.
+class WebAppIconCache {
+ public:
+  // 16 MiB holds every launcher-sized icon of a few hundred apps.
+  static constexpr size_t kDefaultMaxBytes = 16 * 1024 * 1024;
+
+  // Reports whether a Get() call was served from the cache.
+  static constexpr char kHistogramCacheHit[] = "WebApp.Icon.DecodedCacheHit";
+
+  // Returns the instance shared by all profiles.
+  static WebAppIconCache& GetInstance();
+
+  // Replaces the shared instance with one of budget |max_bytes|.
+  static void ResetInstanceForTesting(size_t max_bytes = kDefaultMaxBytes);
+
+  explicit WebAppIconCache(size_t max_bytes = kDefaultMaxBytes);
+  WebAppIconCache(const WebAppIconCache&) = delete;
+  WebAppIconCache& operator=(const WebAppIconCache&) = delete;
+  ~WebAppIconCache();
+
+  // Returns the cached bitmap and marks it most recently used, or returns an
+  // empty bitmap on a miss. Every call counts towards the hit rate.
+  SkBitmap Get(const base::FilePath& web_apps_directory,
+               const AppId& app_id,
+               IconPurpose purpose,
+               SquareSizePx size_px);
+
+  // Adds |bitmap| to the cache, evicting least recently used entries as needed
+  // to stay within the byte budget. Bitmaps larger than the whole budget are
+  // not cached. The insertion is dropped if the cache was invalidated since
+  // |epoch| was obtained, so that a read racing a write can't resurrect stale
+  // pixels.
+  void Put(const base::FilePath& web_apps_directory,
+           const AppId& app_id,
+           IconPurpose purpose,
+           SquareSizePx size_px,
+           const SkBitmap& bitmap,
+           uint64_t epoch);
+
+  // Drops every entry of |app_id| in |web_apps_directory|. Must be called
+  // whenever the icons of an app are rewritten or deleted on disk.
+  void RemoveApp(const base::FilePath& web_apps_directory,
+                 const AppId& app_id);
+  void Clear();
+
+  // Bumped by RemoveApp() and Clear(). Callers reading icons from disk capture
+  // this before posting the read and hand it back to Put().
+  uint64_t epoch() const { return epoch_; }
+
+  size_t size() const { return entries_.size(); }
+  size_t total_bytes() const { return total_bytes_; }
+  size_t max_bytes() const { return max_bytes_; }
+  size_t hit_count() const { return hit_count_; }
+  size_t miss_count() const { return miss_count_; }
+
+  base::WeakPtr<WebAppIconCache> GetWeakPtr();
+
+ private:
+  struct Key {
+    bool operator<(const Key& other) const;
+
+    base::FilePath web_apps_directory;
+    AppId app_id;
+    IconPurpose purpose;
+    SquareSizePx size_px;
+  };
+
+  void EvictUntilBytesAtMost(size_t max_bytes);
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level);
+
+  const size_t max_bytes_;
+  size_t total_bytes_ = 0;
+  uint64_t epoch_ = 0;
+
+  size_t hit_count_ = 0;
+  size_t miss_count_ = 0;
+
+  base::MRUCache<Key, SkBitmap> entries_;
+
+  std::unique_ptr<base::MemoryPressureListener> memory_pressure_listener_;
+
+  base::WeakPtrFactory<WebAppIconCache> weak_ptr_factory_{this};
+};
+
+}  // namespace web_app
+
+#endif  // CHROME_BROWSER_WEB_APPLICATIONS_WEB_APP_ICON_CACHE_H_
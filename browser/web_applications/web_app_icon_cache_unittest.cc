@@ -0,0 +1,182 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/web_applications/web_app_icon_cache.h"
+
+#include "base/files/file_path.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/run_loop.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "chrome/browser/web_applications/test/web_app_icon_test_utils.h"
+#include "content/public/test/browser_task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/skia/include/core/SkColor.h"
+
+namespace web_app {
+
+namespace {
+
+constexpr SquareSizePx kIconSize = 32;
+constexpr size_t kIconBytes = kIconSize * kIconSize * 4;
+
+constexpr char kAppA[] = "a";
+constexpr char kAppB[] = "b";
+constexpr char kAppC[] = "c";
+constexpr char kAppD[] = "d";
+
+constexpr base::FilePath::CharType kProfileDirectory[] =
+    FILE_PATH_LITERAL("Default");
+constexpr base::FilePath::CharType kOtherProfileDirectory[] =
+    FILE_PATH_LITERAL("Profile 1");
+
+}  // namespace
+
+class WebAppIconCacheTest : public testing::Test {
+ protected:
+  void Put(WebAppIconCache& cache,
+           const AppId& app_id,
+           SkColor color,
+           SquareSizePx size_px = kIconSize) {
+    cache.Put(base::FilePath(kProfileDirectory), app_id, IconPurpose::ANY,
+              size_px, CreateSquareIcon(size_px, color), cache.epoch());
+  }
+
+  SkBitmap Get(WebAppIconCache& cache,
+               const AppId& app_id,
+               IconPurpose purpose = IconPurpose::ANY,
+               SquareSizePx size_px = kIconSize) {
+    return cache.Get(base::FilePath(kProfileDirectory), app_id, purpose,
+                     size_px);
+  }
+
+  bool Contains(WebAppIconCache& cache,
+                const AppId& app_id,
+                SquareSizePx size_px = kIconSize) {
+    return !Get(cache, app_id, IconPurpose::ANY, size_px).drawsNothing();
+  }
+
+ private:
+  content::BrowserTaskEnvironment task_environment_;
+};
+
+TEST_F(WebAppIconCacheTest, HitAndMiss) {
+  base::HistogramTester histograms;
+  WebAppIconCache cache;
+
+  EXPECT_TRUE(Get(cache, kAppA).drawsNothing());
+  Put(cache, kAppA, SK_ColorGREEN);
+
+  SkBitmap bitmap = Get(cache, kAppA);
+  ASSERT_FALSE(bitmap.drawsNothing());
+  EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(0, 0));
+
+  // Purpose and size are part of the key.
+  EXPECT_TRUE(Get(cache, kAppA, IconPurpose::MASKABLE).drawsNothing());
+  EXPECT_TRUE(
+      Get(cache, kAppA, IconPurpose::ANY, 2 * kIconSize).drawsNothing());
+
+  EXPECT_EQ(1u, cache.hit_count());
+  EXPECT_EQ(3u, cache.miss_count());
+  histograms.ExpectBucketCount(WebAppIconCache::kHistogramCacheHit, true, 1);
+  histograms.ExpectBucketCount(WebAppIconCache::kHistogramCacheHit, false, 3);
+}
+
+TEST_F(WebAppIconCacheTest, ProfilesDontShareEntries) {
+  WebAppIconCache cache;
+
+  Put(cache, kAppA, SK_ColorGREEN);
+  EXPECT_TRUE(cache
+                  .Get(base::FilePath(kOtherProfileDirectory), kAppA,
+                       IconPurpose::ANY, kIconSize)
+                  .drawsNothing());
+
+  // Removing the app from another profile keeps this profile's icons.
+  cache.RemoveApp(base::FilePath(kOtherProfileDirectory), kAppA);
+  EXPECT_TRUE(Contains(cache, kAppA));
+}
+
+TEST_F(WebAppIconCacheTest, EvictsLeastRecentlyUsedWithinByteBudget) {
+  WebAppIconCache cache(3 * kIconBytes);
+
+  Put(cache, kAppA, SK_ColorRED);
+  Put(cache, kAppB, SK_ColorGREEN);
+  Put(cache, kAppC, SK_ColorBLUE);
+  EXPECT_EQ(3 * kIconBytes, cache.total_bytes());
+
+  // Touch A so that B becomes the least recently used entry.
+  EXPECT_TRUE(Contains(cache, kAppA));
+  Put(cache, kAppD, SK_ColorYELLOW);
+
+  EXPECT_EQ(3u, cache.size());
+  EXPECT_EQ(3 * kIconBytes, cache.total_bytes());
+  EXPECT_TRUE(Contains(cache, kAppA));
+  EXPECT_FALSE(Contains(cache, kAppB));
+  EXPECT_TRUE(Contains(cache, kAppC));
+  EXPECT_TRUE(Contains(cache, kAppD));
+
+  // A bitmap larger than the whole budget isn't cached and evicts nothing.
+  Put(cache, kAppB, SK_ColorBLACK, 4 * kIconSize);
+  EXPECT_EQ(3u, cache.size());
+  EXPECT_FALSE(Contains(cache, kAppB, 4 * kIconSize));
+}
+
+TEST_F(WebAppIconCacheTest, ReplacingEntryKeepsByteCount) {
+  WebAppIconCache cache;
+
+  Put(cache, kAppA, SK_ColorRED);
+  Put(cache, kAppA, SK_ColorGREEN);
+
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(kIconBytes, cache.total_bytes());
+  EXPECT_EQ(SK_ColorGREEN, Get(cache, kAppA).getColor(0, 0));
+}
+
+TEST_F(WebAppIconCacheTest, RemoveAppDropsStaleInsertions) {
+  WebAppIconCache cache;
+
+  Put(cache, kAppA, SK_ColorRED);
+  Put(cache, kAppA, SK_ColorRED, 2 * kIconSize);
+  Put(cache, kAppB, SK_ColorGREEN);
+
+  // Simulates a disk read which started before the app's icons were
+  // rewritten.
+  const uint64_t stale_epoch = cache.epoch();
+  cache.RemoveApp(base::FilePath(kProfileDirectory), kAppA);
+
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(kIconBytes, cache.total_bytes());
+  EXPECT_FALSE(Contains(cache, kAppA));
+  EXPECT_TRUE(Contains(cache, kAppB));
+
+  cache.Put(base::FilePath(kProfileDirectory), kAppA, IconPurpose::ANY,
+            kIconSize, CreateSquareIcon(kIconSize, SK_ColorRED), stale_epoch);
+  EXPECT_FALSE(Contains(cache, kAppA));
+}
+
+TEST_F(WebAppIconCacheTest, MemoryPressure) {
+  WebAppIconCache cache(4 * kIconBytes);
+
+  Put(cache, kAppA, SK_ColorRED);
+  Put(cache, kAppB, SK_ColorGREEN);
+  Put(cache, kAppC, SK_ColorBLUE);
+  Put(cache, kAppD, SK_ColorYELLOW);
+
+  base::MemoryPressureListener::SimulatePressureNotification(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  base::RunLoop().RunUntilIdle();
+
+  // The most recently used half survives.
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(Contains(cache, kAppC));
+  EXPECT_TRUE(Contains(cache, kAppD));
+
+  base::MemoryPressureListener::SimulatePressureNotification(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.total_bytes());
+}
+
+}  // namespace web_app
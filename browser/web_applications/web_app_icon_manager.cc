@@ -4,9 +4,11 @@
 
 #include "chrome/browser/web_applications/web_app_icon_manager.h"
 
+#include <set>
 #include <string>
 #include <utility>
 
+#include "base/barrier_closure.h"
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/containers/adapters.h"
@@ -14,11 +16,14 @@
 #include "base/logging.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/memory/scoped_refptr.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/ranges/algorithm.h"
+#include "base/stl_util.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "chrome/browser/web_applications/components/web_app_utils.h"
 #include "chrome/browser/web_applications/file_utils_wrapper.h"
 #include "chrome/browser/web_applications/web_app.h"
@@ -415,6 +420,13 @@ SkBitmap ReadShortcutsMenuIconBlocking(FileUtilsWrapper* utils,
   return bitmap;
 }
 
+// CPU intensive. May be called on another thread.
+SkBitmap ResizeIcon(const SkBitmap& source, SquareSizePx target_icon_size_px) {
+  return skia::ImageOperations::Resize(source,
+                                       skia::ImageOperations::RESIZE_BEST,
+                                       target_icon_size_px, target_icon_size_px);
+}
+
 // Performs blocking I/O. May be called on another thread.
 // Returns empty map if any errors occurred.
 std::map<SquareSizePx, SkBitmap> ReadIconAndResizeBlocking(
@@ -431,9 +443,7 @@ std::map<SquareSizePx, SkBitmap> ReadIconAndResizeBlocking(
   SkBitmap target;
 
   if (icon_id.size != target_icon_size_px) {
-    target = skia::ImageOperations::Resize(
-        source, skia::ImageOperations::RESIZE_BEST, target_icon_size_px,
-        target_icon_size_px);
+    target = ResizeIcon(source, target_icon_size_px);
   } else {
     target = source;
   }
@@ -442,6 +452,20 @@ std::map<SquareSizePx, SkBitmap> ReadIconAndResizeBlocking(
   return result;
 }
 
+// Performs blocking I/O. May be called on another thread.
+// Returns a bitmap for each of |icon_ids|, in the same order. Bitmaps which
+// couldn't be read are empty.
+std::vector<SkBitmap> ReadIconsBatchBlocking(
+    const std::unique_ptr<FileUtilsWrapper>& utils,
+    const base::FilePath& web_apps_directory,
+    const std::vector<IconId>& icon_ids) {
+  std::vector<SkBitmap> result;
+  result.reserve(icon_ids.size());
+  for (const IconId& icon_id : icon_ids)
+    result.push_back(ReadIconBlocking(utils, web_apps_directory, icon_id));
+  return result;
+}
+
 // Performs blocking I/O. May be called on another thread.
 std::map<SquareSizePx, SkBitmap> ReadIconsBlocking(
     const std::unique_ptr<FileUtilsWrapper>& utils,
@@ -546,6 +570,189 @@ constexpr base::TaskTraits kTaskTraits = {
     base::MayBlock(), base::TaskPriority::USER_VISIBLE,
     base::TaskShutdownBehavior::BLOCK_SHUTDOWN};
 
+constexpr base::TaskTraits kResizeTaskTraits = {
+    base::TaskPriority::USER_VISIBLE,
+    base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN};
+
+// Looks up each of |icon_sizes| in |cache|. Sizes which aren't cached are
+// appended to |missing_sizes|.
+std::map<SquareSizePx, SkBitmap> GetCachedIcons(
+    WebAppIconCache* cache,
+    const base::FilePath& web_apps_directory,
+    const AppId& app_id,
+    IconPurpose purpose,
+    const SortedSizesPx& icon_sizes,
+    std::vector<SquareSizePx>* missing_sizes) {
+  std::map<SquareSizePx, SkBitmap> result;
+  for (SquareSizePx icon_size_px : icon_sizes) {
+    SkBitmap bitmap =
+        cache->Get(web_apps_directory, app_id, purpose, icon_size_px);
+    if (bitmap.drawsNothing())
+      missing_sizes->push_back(icon_size_px);
+    else
+      result[icon_size_px] = std::move(bitmap);
+  }
+  return result;
+}
+
+void CacheIcons(WebAppIconCache* cache,
+                uint64_t epoch,
+                const base::FilePath& web_apps_directory,
+                const AppId& app_id,
+                IconPurpose purpose,
+                const std::map<SquareSizePx, SkBitmap>& icon_bitmaps) {
+  for (const std::pair<const SquareSizePx, SkBitmap>& icon_bitmap :
+       icon_bitmaps) {
+    cache->Put(web_apps_directory, app_id, purpose, icon_bitmap.first,
+               icon_bitmap.second, epoch);
+  }
+}
+
+void OnReadIcons(base::WeakPtr<WebAppIconCache> cache,
+                 uint64_t epoch,
+                 const base::FilePath& web_apps_directory,
+                 const AppId& app_id,
+                 IconPurpose purpose,
+                 std::map<SquareSizePx, SkBitmap> cached_icons,
+                 size_t missing_count,
+                 AppIconManager::ReadIconsCallback callback,
+                 std::map<SquareSizePx, SkBitmap> read_icons) {
+  if (cache) {
+    CacheIcons(cache.get(), epoch, web_apps_directory, app_id, purpose,
+               read_icons);
+  }
+  // Don't complete a failed disk read with cached icons: callers get an empty
+  // map on failure, as when none of the icons is cached.
+  if (read_icons.size() < missing_count) {
+    std::move(callback).Run(std::map<SquareSizePx, SkBitmap>());
+    return;
+  }
+  read_icons.insert(cached_icons.begin(), cached_icons.end());
+  std::move(callback).Run(std::move(read_icons));
+}
+
+void OnReadAllIcons(base::WeakPtr<WebAppIconCache> cache,
+                    uint64_t epoch,
+                    const base::FilePath& web_apps_directory,
+                    const AppId& app_id,
+                    IconBitmaps cached_icons,
+                    std::map<IconPurpose, size_t> missing_counts,
+                    AppIconManager::ReadIconBitmapsCallback callback,
+                    IconBitmaps read_icons) {
+  for (IconPurpose purpose : {IconPurpose::ANY, IconPurpose::MASKABLE}) {
+    std::map<SquareSizePx, SkBitmap> bitmaps =
+        read_icons.GetBitmapsForPurpose(purpose);
+    if (cache) {
+      CacheIcons(cache.get(), epoch, web_apps_directory, app_id, purpose,
+                 bitmaps);
+    }
+    if (bitmaps.size() < missing_counts[purpose]) {
+      read_icons.SetBitmapsForPurpose(purpose, {});
+      continue;
+    }
+    const std::map<SquareSizePx, SkBitmap>& cached_bitmaps =
+        cached_icons.GetBitmapsForPurpose(purpose);
+    bitmaps.insert(cached_bitmaps.begin(), cached_bitmaps.end());
+    read_icons.SetBitmapsForPurpose(purpose, std::move(bitmaps));
+  }
+  std::move(callback).Run(std::move(read_icons));
+}
+
+void OnReadIcon(base::WeakPtr<WebAppIconCache> cache,
+                uint64_t epoch,
+                const base::FilePath& web_apps_directory,
+                const IconId& icon_id,
+                AppIconManager::ReadIconCallback callback,
+                const SkBitmap& bitmap) {
+  if (cache) {
+    cache->Put(web_apps_directory, icon_id.app_id, icon_id.purpose,
+               icon_id.size, bitmap, epoch);
+  }
+  std::move(callback).Run(bitmap);
+}
+
+void StoreResizedIcon(std::map<AppId, SkBitmap>* resized_icons,
+                      const AppId& app_id,
+                      base::RepeatingClosure done_closure,
+                      SkBitmap bitmap) {
+  (*resized_icons)[app_id] = std::move(bitmap);
+  done_closure.Run();
+}
+
+void OnIconsBatchResized(
+    base::WeakPtr<WebAppIconCache> cache,
+    uint64_t epoch,
+    const base::FilePath& web_apps_directory,
+    IconPurpose purpose,
+    SquareSizePx icon_size_px,
+    std::map<AppId, SkBitmap> cached_icons,
+    std::unique_ptr<std::map<AppId, SkBitmap>> read_icons,
+    WebAppIconManager::ReadIconsForAppsCallback callback) {
+  for (const std::pair<const AppId, SkBitmap>& read_icon : *read_icons) {
+    if (cache) {
+      cache->Put(web_apps_directory, read_icon.first, purpose, icon_size_px,
+                 read_icon.second, epoch);
+    }
+    cached_icons[read_icon.first] = read_icon.second;
+  }
+  std::move(callback).Run(std::move(cached_icons));
+}
+
+// Resizes, in parallel, those of |read_bitmaps| which don't already have the
+// requested size.
+void OnReadIconsBatch(base::WeakPtr<WebAppIconCache> cache,
+                      uint64_t epoch,
+                      const base::FilePath& web_apps_directory,
+                      IconPurpose purpose,
+                      SquareSizePx icon_size_px,
+                      std::vector<IconId> icon_ids,
+                      std::map<AppId, SkBitmap> cached_icons,
+                      WebAppIconManager::ReadIconsForAppsCallback callback,
+                      std::vector<SkBitmap> read_bitmaps) {
+  DCHECK_EQ(icon_ids.size(), read_bitmaps.size());
+
+  auto read_icons = std::make_unique<std::map<AppId, SkBitmap>>();
+  std::vector<size_t> indices_to_resize;
+  for (size_t i = 0; i < icon_ids.size(); ++i) {
+    if (read_bitmaps[i].empty())
+      continue;
+    if (icon_ids[i].size == icon_size_px)
+      (*read_icons)[icon_ids[i].app_id] = read_bitmaps[i];
+    else
+      indices_to_resize.push_back(i);
+  }
+
+  // |read_icons| is owned by the barrier's final closure, which outlives all
+  // of the StoreResizedIcon() replies.
+  std::map<AppId, SkBitmap>* read_icons_ptr = read_icons.get();
+  base::RepeatingClosure barrier = base::BarrierClosure(
+      base::checked_cast<int>(indices_to_resize.size()),
+      base::BindOnce(OnIconsBatchResized, std::move(cache), epoch,
+                     web_apps_directory, purpose, icon_size_px,
+                     std::move(cached_icons), std::move(read_icons),
+                     std::move(callback)));
+
+  for (size_t i : indices_to_resize) {
+    base::ThreadPool::PostTaskAndReplyWithResult(
+        FROM_HERE, kResizeTaskTraits,
+        base::BindOnce(ResizeIcon, std::move(read_bitmaps[i]), icon_size_px),
+        base::BindOnce(StoreResizedIcon, read_icons_ptr, icon_ids[i].app_id,
+                       barrier));
+  }
+}
+
+void OnIconsWritten(base::WeakPtr<WebAppIconCache> cache,
+                    const base::FilePath& web_apps_directory,
+                    const AppId& app_id,
+                    WebAppIconManager::WriteDataCallback callback,
+                    bool success) {
+  // Reads which started while the write was in progress may have cached the
+  // old icons.
+  if (cache)
+    cache->RemoveApp(web_apps_directory, app_id);
+  std::move(callback).Run(success);
+}
+
 }  // namespace
 
 WebAppIconManager::WebAppIconManager(Profile* profile,
@@ -562,11 +769,16 @@ void WebAppIconManager::WriteData(AppId app_id,
                                   WriteDataCallback callback) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
+  icon_cache().RemoveApp(web_apps_directory_, app_id);
+  WriteDataCallback invalidate_and_reply =
+      base::BindOnce(OnIconsWritten, icon_cache().GetWeakPtr(),
+                     web_apps_directory_, app_id, std::move(callback));
+
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, kTaskTraits,
       base::BindOnce(WriteDataBlocking, utils_->Clone(), web_apps_directory_,
                      std::move(app_id), std::move(icon_bitmaps)),
-      std::move(callback));
+      std::move(invalidate_and_reply));
 }
 
 void WebAppIconManager::WriteShortcutsMenuIconsData(
@@ -586,17 +798,20 @@ void WebAppIconManager::WriteShortcutsMenuIconsData(
 void WebAppIconManager::DeleteData(AppId app_id, WriteDataCallback callback) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
+  icon_cache().RemoveApp(web_apps_directory_, app_id);
+  WriteDataCallback invalidate_and_reply =
+      base::BindOnce(OnIconsWritten, icon_cache().GetWeakPtr(),
+                     web_apps_directory_, app_id, std::move(callback));
+
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, kTaskTraits,
       base::BindOnce(DeleteDataBlocking, utils_->Clone(), web_apps_directory_,
                      std::move(app_id)),
-      std::move(callback));
+      std::move(invalidate_and_reply));
 }
 
 void WebAppIconManager::Start() {
-  for (const AppId& app_id : registrar_.GetAppIds()) {
-    ReadFavicon(app_id);
-  }
+  ReadFavicons(registrar_.GetAppIds());
   registrar_observer_.Add(&registrar_);
 }
 
@@ -650,13 +865,24 @@ void WebAppIconManager::ReadIcons(const AppId& app_id,
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   DCHECK(HasIcons(app_id, purpose, icon_sizes));
 
+  std::vector<SquareSizePx> missing_sizes;
+  std::map<SquareSizePx, SkBitmap> cached_icons =
+      GetCachedIcons(&icon_cache(), web_apps_directory_, app_id, purpose,
+                     icon_sizes, &missing_sizes);
+  if (missing_sizes.empty()) {
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(std::move(callback), std::move(cached_icons)));
+    return;
+  }
+
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, kTaskTraits,
-      base::BindOnce(
-          ReadIconsBlocking, utils_->Clone(), web_apps_directory_, app_id,
-          purpose,
-          std::vector<SquareSizePx>(icon_sizes.begin(), icon_sizes.end())),
-      std::move(callback));
+      base::BindOnce(ReadIconsBlocking, utils_->Clone(), web_apps_directory_,
+                     app_id, purpose, missing_sizes),
+      base::BindOnce(OnReadIcons, icon_cache().GetWeakPtr(),
+                     icon_cache().epoch(), web_apps_directory_, app_id, purpose,
+                     std::move(cached_icons), missing_sizes.size(),
+                     std::move(callback)));
 }
 
 void WebAppIconManager::ReadAllIcons(const AppId& app_id,
@@ -668,21 +894,36 @@ void WebAppIconManager::ReadAllIcons(const AppId& app_id,
     return;
   }
 
+  // Only the icons missing from the cache are read from disk.
   std::map<IconPurpose, std::vector<SquareSizePx>> icon_purposes_to_sizes;
-  const SortedSizesPx& sizes_any =
-      web_app->downloaded_icon_sizes(IconPurpose::ANY);
-  icon_purposes_to_sizes[IconPurpose::ANY] =
-      std::vector<SquareSizePx>(sizes_any.begin(), sizes_any.end());
-  const SortedSizesPx& sizes_maskable =
-      web_app->downloaded_icon_sizes(IconPurpose::MASKABLE);
-  icon_purposes_to_sizes[IconPurpose::MASKABLE] =
-      std::vector<SquareSizePx>(sizes_maskable.begin(), sizes_maskable.end());
+  std::map<IconPurpose, size_t> missing_counts;
+  IconBitmaps cached_icons;
+  bool all_cached = true;
+  for (IconPurpose purpose : {IconPurpose::ANY, IconPurpose::MASKABLE}) {
+    std::vector<SquareSizePx> missing_sizes;
+    cached_icons.SetBitmapsForPurpose(
+        purpose,
+        GetCachedIcons(&icon_cache(), web_apps_directory_, app_id, purpose,
+                       web_app->downloaded_icon_sizes(purpose),
+                       &missing_sizes));
+    all_cached &= missing_sizes.empty();
+    missing_counts[purpose] = missing_sizes.size();
+    icon_purposes_to_sizes[purpose] = std::move(missing_sizes);
+  }
+  if (all_cached) {
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(std::move(callback), std::move(cached_icons)));
+    return;
+  }
 
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, kTaskTraits,
       base::BindOnce(ReadAllIconsBlocking, utils_->Clone(), web_apps_directory_,
                      app_id, std::move(icon_purposes_to_sizes)),
-      std::move(callback));
+      base::BindOnce(OnReadAllIcons, icon_cache().GetWeakPtr(),
+                     icon_cache().epoch(), web_apps_directory_, app_id,
+                     std::move(cached_icons), std::move(missing_counts),
+                     std::move(callback)));
 }
 
 void WebAppIconManager::ReadAllShortcutsMenuIcons(
@@ -717,11 +958,22 @@ void WebAppIconManager::ReadSmallestIcon(
   ReadIconCallback wrapped = base::BindOnce(
       WrapReadIconWithPurposeCallback, std::move(callback), best_icon->purpose);
 
+  SkBitmap cached_icon = icon_cache().Get(web_apps_directory_, app_id,
+                                          best_icon->purpose,
+                                          best_icon->size_px);
+  if (!cached_icon.drawsNothing()) {
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(std::move(wrapped), std::move(cached_icon)));
+    return;
+  }
+
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, kTaskTraits,
       base::BindOnce(ReadIconBlocking, utils_->Clone(), web_apps_directory_,
-                     std::move(icon_id)),
-      std::move(wrapped));
+                     icon_id),
+      base::BindOnce(OnReadIcon, icon_cache().GetWeakPtr(),
+                     icon_cache().epoch(), web_apps_directory_, icon_id,
+                     std::move(wrapped)));
 }
 
 void WebAppIconManager::ReadSmallestCompressedIcon(
@@ -757,6 +1009,10 @@ void WebAppIconManager::OnWebAppInstalled(const AppId& app_id) {
   ReadFavicon(app_id);
 }
 
+void WebAppIconManager::OnWebAppUninstalled(const AppId& app_id) {
+  icon_cache().RemoveApp(web_apps_directory_, app_id);
+}
+
 void WebAppIconManager::OnAppRegistrarDestroyed() {
   registrar_observer_.RemoveAll();
 }
@@ -776,13 +1032,74 @@ void WebAppIconManager::ReadIconAndResize(const AppId& app_id,
     return;
   }
 
+  // Resized icons are cached under the size they were resized to.
+  SkBitmap cached_icon =
+      icon_cache().Get(web_apps_directory_, app_id, purpose, desired_icon_size);
+  if (!cached_icon.drawsNothing()) {
+    std::map<SquareSizePx, SkBitmap> result;
+    result[desired_icon_size] = std::move(cached_icon);
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(std::move(callback), std::move(result)));
+    return;
+  }
+
   IconId icon_id(app_id, best_icon->purpose, best_icon->size_px);
   base::ThreadPool::PostTaskAndReplyWithResult(
       FROM_HERE, kTaskTraits,
       base::BindOnce(ReadIconAndResizeBlocking, utils_->Clone(),
                      web_apps_directory_, std::move(icon_id),
                      desired_icon_size),
-      std::move(callback));
+      base::BindOnce(OnReadIcons, icon_cache().GetWeakPtr(),
+                     icon_cache().epoch(), web_apps_directory_, app_id, purpose,
+                     std::map<SquareSizePx, SkBitmap>(),
+                     /*missing_count=*/1u, std::move(callback)));
+}
+
+void WebAppIconManager::ReadIconsAndResizeForApps(
+    const std::vector<AppId>& app_ids,
+    IconPurpose purpose,
+    SquareSizePx desired_icon_size,
+    ReadIconsForAppsCallback callback) const {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+  std::map<AppId, SkBitmap> cached_icons;
+  std::vector<IconId> icons_to_read;
+  std::set<AppId> requested_app_ids;
+  for (const AppId& app_id : app_ids) {
+    if (!requested_app_ids.insert(app_id).second)
+      continue;
+
+    SkBitmap cached_icon = icon_cache().Get(web_apps_directory_, app_id,
+                                            purpose, desired_icon_size);
+    if (!cached_icon.drawsNothing()) {
+      cached_icons[app_id] = std::move(cached_icon);
+      continue;
+    }
+
+    // Same preference as ReadIconAndResize(): shrink rather than enlarge.
+    base::Optional<IconSizeAndPurpose> best_icon =
+        FindIconMatchBigger(app_id, {purpose}, desired_icon_size);
+    if (!best_icon)
+      best_icon = FindIconMatchSmaller(app_id, {purpose}, desired_icon_size);
+    if (best_icon)
+      icons_to_read.emplace_back(app_id, best_icon->purpose, best_icon->size_px);
+  }
+
+  if (icons_to_read.empty()) {
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(std::move(callback), std::move(cached_icons)));
+    return;
+  }
+
+  std::vector<IconId> icon_ids = icons_to_read;
+  base::ThreadPool::PostTaskAndReplyWithResult(
+      FROM_HERE, kTaskTraits,
+      base::BindOnce(ReadIconsBatchBlocking, utils_->Clone(),
+                     web_apps_directory_, std::move(icons_to_read)),
+      base::BindOnce(OnReadIconsBatch, icon_cache().GetWeakPtr(),
+                     icon_cache().epoch(), web_apps_directory_, purpose,
+                     desired_icon_size, std::move(icon_ids),
+                     std::move(cached_icons), std::move(callback)));
 }
 
 void WebAppIconManager::SetFaviconReadCallbackForTesting(
@@ -822,6 +1139,32 @@ void WebAppIconManager::ReadFavicon(const AppId& app_id) {
                                    weak_ptr_factory_.GetWeakPtr(), app_id));
 }
 
+void WebAppIconManager::ReadFavicons(std::vector<AppId> app_ids) {
+  base::EraseIf(app_ids, [this](const AppId& app_id) {
+    return !HasSmallestIcon(app_id, {IconPurpose::ANY}, gfx::kFaviconSize);
+  });
+  if (app_ids.empty())
+    return;
+
+  // A profile with many apps would otherwise post a file task per app.
+  std::vector<AppId> requested_app_ids = app_ids;
+  ReadIconsAndResizeForApps(
+      requested_app_ids, IconPurpose::ANY, gfx::kFaviconSize,
+      base::BindOnce(&WebAppIconManager::OnReadFavicons,
+                     weak_ptr_factory_.GetWeakPtr(), std::move(app_ids)));
+}
+
+void WebAppIconManager::OnReadFavicons(const std::vector<AppId>& app_ids,
+                                       std::map<AppId, SkBitmap> icons) {
+  for (const AppId& app_id : app_ids) {
+    auto it = icons.find(app_id);
+    if (it != icons.end())
+      favicon_cache_[app_id] = std::move(it->second);
+    if (favicon_read_callback_)
+      favicon_read_callback_.Run(app_id);
+  }
+}
+
 void WebAppIconManager::OnReadFavicon(
     const AppId& app_id,
     const std::map<SquareSizePx, SkBitmap> icons) {
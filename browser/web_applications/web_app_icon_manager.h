@@ -18,6 +18,7 @@
 #include "chrome/browser/web_applications/components/app_registrar.h"
 #include "chrome/browser/web_applications/components/app_registrar_observer.h"
 #include "chrome/browser/web_applications/components/web_application_info.h"
+#include "chrome/browser/web_applications/web_app_icon_cache.h"
 
 class Profile;
 
@@ -86,6 +87,7 @@ class WebAppIconManager : public AppIconManager, public AppRegistrarObserver {
 
   // AppRegistrarObserver:
   void OnWebAppInstalled(const AppId& app_id) override;
+  void OnWebAppUninstalled(const AppId& app_id) override;
   void OnAppRegistrarDestroyed() override;
 
   // Calls back with an icon of the |desired_icon_size| and |purpose|, resizing
@@ -97,9 +99,29 @@ class WebAppIconManager : public AppIconManager, public AppRegistrarObserver {
                          SquareSizePx desired_icon_size,
                          ReadIconsCallback callback) const;
 
+  using ReadIconsForAppsCallback =
+      base::OnceCallback<void(std::map<AppId, SkBitmap> icon_bitmaps)>;
+  // Batched version of |ReadIconAndResize| for launcher-like surfaces showing
+  // many apps at once. All icons not already in the decoded icon cache are
+  // read and decoded in a single file task; icons which need resizing are then
+  // resized in parallel. Apps without any icon of |purpose| are omitted from
+  // the result.
+  void ReadIconsAndResizeForApps(const std::vector<AppId>& app_ids,
+                                 IconPurpose purpose,
+                                 SquareSizePx desired_icon_size,
+                                 ReadIconsForAppsCallback callback) const;
+
   void SetFaviconReadCallbackForTesting(FaviconReadCallback callback);
 
+  WebAppIconCache& icon_cache_for_testing() { return icon_cache(); }
+
  private:
+  // Decoded icons served by the Read*() methods, shared with the icon managers
+  // of other profiles.
+  static WebAppIconCache& icon_cache() {
+    return WebAppIconCache::GetInstance();
+  }
+
   base::Optional<IconSizeAndPurpose> FindIconMatchSmaller(
       const AppId& app_id,
       const std::vector<IconPurpose>& purposes,
@@ -108,6 +130,10 @@ class WebAppIconManager : public AppIconManager, public AppRegistrarObserver {
   void ReadFavicon(const AppId& app_id);
   void OnReadFavicon(const AppId& app_id,
                      std::map<SquareSizePx, SkBitmap> icons);
+  // Reads the favicons of all |app_ids| in one batch, at startup.
+  void ReadFavicons(std::vector<AppId> app_ids);
+  void OnReadFavicons(const std::vector<AppId>& app_ids,
+                      std::map<AppId, SkBitmap> icons);
 
   WebAppRegistrar& registrar_;
   base::FilePath web_apps_directory_;
@@ -11,6 +11,7 @@
 
 #include "base/callback_helpers.h"
 #include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
 #include "base/run_loop.h"
 #include "base/test/bind.h"
 #include "chrome/browser/web_applications/components/web_app_constants.h"
@@ -29,6 +30,7 @@
 #include "chrome/browser/web_applications/web_app_sync_bridge.h"
 #include "chrome/test/base/testing_profile.h"
 #include "extensions/common/constants.h"
+#include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "third_party/skia/include/core/SkColor.h"
@@ -50,6 +52,9 @@ class WebAppIconManagerTest : public WebAppTest {
         std::make_unique<TestWebAppRegistryController>();
     test_registry_controller_->SetUp(profile());
 
+    // The decoded icon cache is shared by all profiles of the process.
+    WebAppIconCache::ResetInstanceForTesting();
+
     auto file_utils = std::make_unique<TestFileUtils>();
     file_utils_ = file_utils.get();
 
@@ -1143,6 +1148,165 @@ TEST_F(WebAppIconManagerTest, ReadIconAndResize_Failure) {
   }
 }
 
+TEST_F(WebAppIconManagerTest, ReadIcons_ServedFromCache) {
+  auto web_app = CreateWebApp();
+  const AppId app_id = web_app->app_id();
+
+  const std::vector<int> sizes_px{icon_size::k32, icon_size::k64};
+  const std::vector<SkColor> colors{SK_ColorGREEN, SK_ColorYELLOW};
+  WriteIcons(app_id, {IconPurpose::ANY}, sizes_px, colors);
+
+  web_app->SetDownloadedIconSizes(IconPurpose::ANY, sizes_px);
+
+  controller().RegisterApp(std::move(web_app));
+
+  auto read_icons = [&]() {
+    std::map<SquareSizePx, SkBitmap> result;
+    base::RunLoop run_loop;
+    icon_manager().ReadIcons(
+        app_id, IconPurpose::ANY, sizes_px,
+        base::BindLambdaForTesting(
+            [&](std::map<SquareSizePx, SkBitmap> icon_bitmaps) {
+              result = std::move(icon_bitmaps);
+              run_loop.Quit();
+            }));
+    run_loop.Run();
+    return result;
+  };
+
+  EXPECT_EQ(2u, read_icons().size());
+  EXPECT_EQ(0u, icon_manager().icon_cache_for_testing().hit_count());
+
+  // Remove the icons from disk: the second read must not touch the disk.
+  EXPECT_TRUE(
+      base::DeletePathRecursively(GetAppIconsAnyDir(profile(), app_id)));
+
+  std::map<SquareSizePx, SkBitmap> icon_bitmaps = read_icons();
+  ASSERT_EQ(2u, icon_bitmaps.size());
+  EXPECT_EQ(SK_ColorGREEN, icon_bitmaps[icon_size::k32].getColor(0, 0));
+  EXPECT_EQ(SK_ColorYELLOW, icon_bitmaps[icon_size::k64].getColor(0, 0));
+  EXPECT_EQ(2u, icon_manager().icon_cache_for_testing().hit_count());
+
+  // Rewriting the icons invalidates the cached ones.
+  WriteIcons(app_id, {IconPurpose::ANY}, sizes_px,
+             {SK_ColorBLUE, SK_ColorRED});
+  icon_bitmaps = read_icons();
+  ASSERT_EQ(2u, icon_bitmaps.size());
+  EXPECT_EQ(SK_ColorBLUE, icon_bitmaps[icon_size::k32].getColor(0, 0));
+  EXPECT_EQ(SK_ColorRED, icon_bitmaps[icon_size::k64].getColor(0, 0));
+}
+
+TEST_F(WebAppIconManagerTest, ReadIcons_CachedIconsAndReadFailure) {
+  auto web_app = CreateWebApp();
+  const AppId app_id = web_app->app_id();
+
+  // Only the first icon is written to disk.
+  WriteIcons(app_id, {IconPurpose::ANY}, {icon_size::k32}, {SK_ColorGREEN});
+  web_app->SetDownloadedIconSizes(IconPurpose::ANY,
+                                  {icon_size::k32, icon_size::k64});
+
+  controller().RegisterApp(std::move(web_app));
+
+  auto read_icons = [&](const SortedSizesPx& icon_sizes) {
+    std::map<SquareSizePx, SkBitmap> result;
+    base::RunLoop run_loop;
+    icon_manager().ReadIcons(
+        app_id, IconPurpose::ANY, icon_sizes,
+        base::BindLambdaForTesting(
+            [&](std::map<SquareSizePx, SkBitmap> icon_bitmaps) {
+              result = std::move(icon_bitmaps);
+              run_loop.Quit();
+            }));
+    run_loop.Run();
+    return result;
+  };
+
+  // Caches the first icon.
+  EXPECT_EQ(1u, read_icons({icon_size::k32}).size());
+
+  // Failing to read the second icon doesn't return the cached one alone.
+  EXPECT_TRUE(read_icons({icon_size::k32, icon_size::k64}).empty());
+}
+
+TEST_F(WebAppIconManagerTest, ReadIconsAndResizeForApps) {
+  auto web_app_exact = CreateWebApp();
+  const AppId app_id_exact = web_app_exact->app_id();
+  WriteIcons(app_id_exact, {IconPurpose::ANY}, {icon_size::k64},
+             {SK_ColorGREEN});
+  web_app_exact->SetDownloadedIconSizes(IconPurpose::ANY, {icon_size::k64});
+  controller().RegisterApp(std::move(web_app_exact));
+
+  auto web_app_resize = std::make_unique<WebApp>(
+      GenerateAppIdFromURL(GURL("https://example.org/")));
+  const AppId app_id_resize = web_app_resize->app_id();
+  web_app_resize->AddSource(Source::kSync);
+  web_app_resize->SetDisplayMode(DisplayMode::kStandalone);
+  web_app_resize->SetUserDisplayMode(DisplayMode::kStandalone);
+  web_app_resize->SetName("Other name");
+  web_app_resize->SetStartUrl(GURL("https://example.org/"));
+  WriteIcons(app_id_resize, {IconPurpose::ANY},
+             {icon_size::k32, icon_size::k256}, {SK_ColorBLUE, SK_ColorRED});
+  web_app_resize->SetDownloadedIconSizes(IconPurpose::ANY,
+                                         {icon_size::k32, icon_size::k256});
+  controller().RegisterApp(std::move(web_app_resize));
+
+  const AppId app_id_unknown =
+      GenerateAppIdFromURL(GURL("https://example.net/"));
+
+  for (int pass = 0; pass < 2; ++pass) {
+    std::map<AppId, SkBitmap> result;
+    base::RunLoop run_loop;
+    icon_manager().ReadIconsAndResizeForApps(
+        {app_id_exact, app_id_resize, app_id_unknown, app_id_exact},
+        IconPurpose::ANY, icon_size::k64,
+        base::BindLambdaForTesting([&](std::map<AppId, SkBitmap> icons) {
+          result = std::move(icons);
+          run_loop.Quit();
+        }));
+    run_loop.Run();
+
+    ASSERT_EQ(2u, result.size());
+    EXPECT_EQ(icon_size::k64, result[app_id_exact].width());
+    EXPECT_EQ(SK_ColorGREEN, result[app_id_exact].getColor(0, 0));
+    // Prefers shrinking the larger icon.
+    EXPECT_EQ(icon_size::k64, result[app_id_resize].width());
+    EXPECT_EQ(SK_ColorRED, result[app_id_resize].getColor(0, 0));
+  }
+
+  // The second pass was served from the cache.
+  EXPECT_EQ(2u, icon_manager().icon_cache_for_testing().hit_count());
+}
+
+TEST_F(WebAppIconManagerTest, CacheIsSharedBetweenManagers) {
+  auto web_app = CreateWebApp();
+  const AppId app_id = web_app->app_id();
+  WriteIcons(app_id, {IconPurpose::ANY}, {icon_size::k32}, {SK_ColorGREEN});
+  web_app->SetDownloadedIconSizes(IconPurpose::ANY, {icon_size::k32});
+  controller().RegisterApp(std::move(web_app));
+
+  auto read_icons = [&](WebAppIconManager& manager) {
+    std::map<SquareSizePx, SkBitmap> result;
+    base::RunLoop run_loop;
+    manager.ReadIcons(app_id, IconPurpose::ANY, {icon_size::k32},
+                      base::BindLambdaForTesting(
+                          [&](std::map<SquareSizePx, SkBitmap> icon_bitmaps) {
+                            result = std::move(icon_bitmaps);
+                            run_loop.Quit();
+                          }));
+    run_loop.Run();
+    return result;
+  };
+
+  EXPECT_EQ(1u, read_icons(icon_manager()).size());
+
+  // Another manager of the same profile, e.g. after the web app provider was
+  // recreated, is served the icon decoded by the first one.
+  WebAppIconManager other_icon_manager(profile(), registrar(),
+                                       std::make_unique<TestFileUtils>());
+  EXPECT_EQ(1u, read_icons(other_icon_manager).size());
+  EXPECT_EQ(1u, icon_manager().icon_cache_for_testing().hit_count());
+}
+
 TEST_F(WebAppIconManagerTest, MatchSizes) {
   EXPECT_EQ(kWebAppIconSmall, extension_misc::EXTENSION_ICON_SMALL);
 }
@@ -1176,6 +1340,47 @@ TEST_F(WebAppIconManagerTest, CacheExistingAppFavicon) {
   EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(0, 0));
 }
 
+TEST_F(WebAppIconManagerTest, CacheExistingAppsFaviconsInOneBatch) {
+  auto web_app = CreateWebApp();
+  const AppId app_id = web_app->app_id();
+  WriteIcons(app_id, {IconPurpose::ANY}, {gfx::kFaviconSize},
+             {SK_ColorGREEN});
+  web_app->SetDownloadedIconSizes(IconPurpose::ANY, {gfx::kFaviconSize});
+  controller().RegisterApp(std::move(web_app));
+
+  auto other_web_app = std::make_unique<WebApp>(
+      GenerateAppIdFromURL(GURL("https://example.org/")));
+  const AppId other_app_id = other_web_app->app_id();
+  other_web_app->AddSource(Source::kSync);
+  other_web_app->SetDisplayMode(DisplayMode::kStandalone);
+  other_web_app->SetUserDisplayMode(DisplayMode::kStandalone);
+  other_web_app->SetName("Other name");
+  other_web_app->SetStartUrl(GURL("https://example.org/"));
+  WriteIcons(other_app_id, {IconPurpose::ANY}, {icon_size::k48},
+             {SK_ColorBLUE});
+  other_web_app->SetDownloadedIconSizes(IconPurpose::ANY, {icon_size::k48});
+  controller().RegisterApp(std::move(other_web_app));
+
+  std::vector<AppId> cached_app_ids;
+  base::RunLoop run_loop;
+  icon_manager().SetFaviconReadCallbackForTesting(
+      base::BindLambdaForTesting([&](const AppId& cached_app_id) {
+        cached_app_ids.push_back(cached_app_id);
+        if (cached_app_ids.size() == 2u)
+          run_loop.Quit();
+      }));
+
+  icon_manager().Start();
+  run_loop.Run();
+
+  EXPECT_THAT(cached_app_ids,
+              testing::UnorderedElementsAre(app_id, other_app_id));
+  EXPECT_EQ(SK_ColorGREEN, icon_manager().GetFavicon(app_id).getColor(0, 0));
+  SkBitmap other_bitmap = icon_manager().GetFavicon(other_app_id);
+  EXPECT_EQ(gfx::kFaviconSize, other_bitmap.width());
+  EXPECT_EQ(SK_ColorBLUE, other_bitmap.getColor(0, 0));
+}
+
 TEST_F(WebAppIconManagerTest, CacheAppFaviconWithResize) {
   auto web_app = CreateWebApp();
   const AppId app_id = web_app->app_id();
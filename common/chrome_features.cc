@@ -898,6 +898,16 @@ const base::Feature kThirdPartyModulesBlocking{
     "ThirdPartyModulesBlocking", base::FEATURE_DISABLED_BY_DEFAULT};
 #endif
 
+// Allows sampling per-process stats into traces which enable the
+// "disabled-by-default-system_stats.process" category.
+const base::Feature kTracePerProcessStats{"TracePerProcessStats",
+                                          base::FEATURE_ENABLED_BY_DEFAULT};
+
+// The initial interval between per-process stats samples. The interval grows
+// when sampling gets expensive or the trace buffer fills up.
+const base::FeatureParam<int> kTracePerProcessStatsIntervalMs{
+    &kTracePerProcessStats, "interval_ms", 100};
+
 // Disable downloads of unsafe file types over insecure transports if initiated
 // from a secure page
 const base::Feature kTreatUnsafeDownloadsAsActive{
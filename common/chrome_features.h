@@ -603,6 +603,11 @@ COMPONENT_EXPORT(CHROME_FEATURES)
 extern const base::Feature kThirdPartyModulesBlocking;
 #endif
 
+COMPONENT_EXPORT(CHROME_FEATURES)
+extern const base::Feature kTracePerProcessStats;
+COMPONENT_EXPORT(CHROME_FEATURES)
+extern const base::FeatureParam<int> kTracePerProcessStatsIntervalMs;
+
 COMPONENT_EXPORT(CHROME_FEATURES)
 extern const base::Feature kTreatUnsafeDownloadsAsActive;
 
@@ -358,6 +358,16 @@ const char kKioskModePrinting[]             = "kiosk-printing";
 const char kLoadMediaRouterComponentExtension[] =
     "load-media-router-component-extension";
 
+// Keeps the stack sampling profiles of all processes in memory so that they
+// can be exported as a pprof profile for local analysis, and enables the
+// profiler in every process. The optional value is the fraction of execution
+// time to sample, in (0, 1]; it defaults to 1, i.e. continuous sampling.
+const char kLocalStackProfiles[]            = "local-stack-profiles";
+
+// With --local-stack-profiles, the file the browser process writes the kept
+// profiles to every minute, as a pprof profile.
+const char kLocalStackProfilesFile[]        = "local-stack-profiles-file";
+
 // Makes Chrome default browser
 const char kMakeDefaultBrowser[]            = "make-default-browser";
 
@@ -4,6 +4,8 @@
 
 #include "chrome/common/google_url_loader_throttle.h"
 
+#include <utility>
+
 #include "base/feature_list.h"
 #include "base/metrics/histogram_functions.h"
 #include "build/build_config.h"
@@ -43,6 +45,11 @@ void GoogleURLLoaderThrottle::UpdateCorsExemptHeader(
 #endif
 }
 
+// static
+bool GoogleURLLoaderThrottle::MayAffectRequest(const GURL& url) {
+  return url.SchemeIsHTTPOrHTTPS();
+}
+
 GoogleURLLoaderThrottle::GoogleURLLoaderThrottle(
 #if defined(OS_ANDROID)
     const std::string& client_data_header,
@@ -50,13 +57,30 @@ GoogleURLLoaderThrottle::GoogleURLLoaderThrottle(
     bool is_tab_large_enough,
 #endif
     chrome::mojom::DynamicParams dynamic_params)
+    : GoogleURLLoaderThrottle(
+#if defined(OS_ANDROID)
+          client_data_header,
+          night_mode_enabled,
+          is_tab_large_enough,
+#endif
+          base::MakeRefCounted<SharedDynamicParams>(
+              std::move(dynamic_params))) {}
+
+GoogleURLLoaderThrottle::GoogleURLLoaderThrottle(
+#if defined(OS_ANDROID)
+    std::string client_data_header,
+    bool night_mode_enabled,
+    bool is_tab_large_enough,
+#endif
+    scoped_refptr<const SharedDynamicParams> dynamic_params)
     :
 #if defined(OS_ANDROID)
-      client_data_header_(client_data_header),
+      client_data_header_(std::move(client_data_header)),
       night_mode_enabled_(night_mode_enabled),
       is_tab_large_enough_(is_tab_large_enough),
 #endif
       dynamic_params_(std::move(dynamic_params)) {
+  DCHECK(dynamic_params_);
 }
 
 GoogleURLLoaderThrottle::~GoogleURLLoaderThrottle() = default;
@@ -66,7 +90,7 @@ void GoogleURLLoaderThrottle::DetachFromCurrentSequence() {}
 void GoogleURLLoaderThrottle::WillStartRequest(
     network::ResourceRequest* request,
     bool* defer) {
-  if (dynamic_params_.force_safe_search) {
+  if (dynamic_params_->data.force_safe_search) {
     GURL new_url;
     safe_search_util::ForceGoogleSafeSearch(request->url, &new_url);
     if (!new_url.is_empty())
@@ -75,21 +99,21 @@ void GoogleURLLoaderThrottle::WillStartRequest(
 
   static_assert(safe_search_util::YOUTUBE_RESTRICT_OFF == 0,
                 "OFF must be first");
-  if (dynamic_params_.youtube_restrict >
+  if (dynamic_params_->data.youtube_restrict >
           safe_search_util::YOUTUBE_RESTRICT_OFF &&
-      dynamic_params_.youtube_restrict <
+      dynamic_params_->data.youtube_restrict <
           safe_search_util::YOUTUBE_RESTRICT_COUNT) {
     safe_search_util::ForceYouTubeRestrict(
         request->url, &request->cors_exempt_headers,
         static_cast<safe_search_util::YouTubeRestrictMode>(
-            dynamic_params_.youtube_restrict));
+            dynamic_params_->data.youtube_restrict));
   }
 
-  if (!dynamic_params_.allowed_domains_for_apps.empty() &&
+  if (!dynamic_params_->data.allowed_domains_for_apps.empty() &&
       request->url.DomainIs("google.com")) {
     request->cors_exempt_headers.SetHeader(
         safe_search_util::kGoogleAppsAllowedDomains,
-        dynamic_params_.allowed_domains_for_apps);
+        dynamic_params_->data.allowed_domains_for_apps);
   }
 
 #if defined(OS_ANDROID)
@@ -133,26 +157,26 @@ void GoogleURLLoaderThrottle::WillRedirectRequest(
   // URLLoaderThrottles can only change the redirect URL when the network
   // service is enabled. The non-network service path handles this in
   // ChromeNetworkDelegate.
-  if (dynamic_params_.force_safe_search) {
+  if (dynamic_params_->data.force_safe_search) {
     safe_search_util::ForceGoogleSafeSearch(redirect_info->new_url,
                                             &redirect_info->new_url);
   }
 
-  if (dynamic_params_.youtube_restrict >
+  if (dynamic_params_->data.youtube_restrict >
           safe_search_util::YOUTUBE_RESTRICT_OFF &&
-      dynamic_params_.youtube_restrict <
+      dynamic_params_->data.youtube_restrict <
           safe_search_util::YOUTUBE_RESTRICT_COUNT) {
     safe_search_util::ForceYouTubeRestrict(
         redirect_info->new_url, modified_cors_exempt_headers,
         static_cast<safe_search_util::YouTubeRestrictMode>(
-            dynamic_params_.youtube_restrict));
+            dynamic_params_->data.youtube_restrict));
   }
 
-  if (!dynamic_params_.allowed_domains_for_apps.empty() &&
+  if (!dynamic_params_->data.allowed_domains_for_apps.empty() &&
       redirect_info->new_url.DomainIs("google.com")) {
     modified_cors_exempt_headers->SetHeader(
         safe_search_util::kGoogleAppsAllowedDomains,
-        dynamic_params_.allowed_domains_for_apps);
+        dynamic_params_->data.allowed_domains_for_apps);
   }
 
 #if defined(OS_ANDROID)
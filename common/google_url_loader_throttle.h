@@ -5,11 +5,15 @@
 #ifndef CHROME_COMMON_GOOGLE_URL_LOADER_THROTTLE_H_
 #define CHROME_COMMON_GOOGLE_URL_LOADER_THROTTLE_H_
 
+#include <string>
+
+#include "base/memory/ref_counted.h"
 #include "build/build_config.h"
 #include "chrome/common/renderer_configuration.mojom.h"
 #include "extensions/buildflags/buildflags.h"
 #include "services/network/public/mojom/network_context.mojom.h"
 #include "third_party/blink/public/common/loader/url_loader_throttle.h"
+#include "url/gurl.h"
 
 // This class changes requests for Google-specific features (e.g. adding &
 // removing Varitaions headers, Safe Search & Restricted YouTube & restricting
@@ -18,13 +22,25 @@ class GoogleURLLoaderThrottle
     : public blink::URLLoaderThrottle,
       public base::SupportsWeakPtr<GoogleURLLoaderThrottle> {
  public:
+  // Dynamic params which can be shared by the throttles created while they
+  // are current, instead of being copied into each of them.
+  using SharedDynamicParams =
+      base::RefCountedData<chrome::mojom::DynamicParams>;
+
 #if defined(OS_ANDROID)
   GoogleURLLoaderThrottle(const std::string& client_data_header,
                           bool night_mode_enabled,
                           bool is_tab_large_enough,
                           chrome::mojom::DynamicParams dynamic_params);
+  GoogleURLLoaderThrottle(
+      std::string client_data_header,
+      bool night_mode_enabled,
+      bool is_tab_large_enough,
+      scoped_refptr<const SharedDynamicParams> dynamic_params);
 #else
   explicit GoogleURLLoaderThrottle(chrome::mojom::DynamicParams dynamic_params);
+  explicit GoogleURLLoaderThrottle(
+      scoped_refptr<const SharedDynamicParams> dynamic_params);
 #endif
 
   ~GoogleURLLoaderThrottle() override;
@@ -32,6 +48,11 @@ class GoogleURLLoaderThrottle
   static void UpdateCorsExemptHeader(
       network::mojom::NetworkContextParams* params);
 
+  // Returns false if a throttle can't change a request for |url|, nor its
+  // redirects or response. Only HTTP(S) requests can reach the Google
+  // properties handled here.
+  static bool MayAffectRequest(const GURL& url);
+
   // blink::URLLoaderThrottle:
   void DetachFromCurrentSequence() override;
   void WillStartRequest(network::ResourceRequest* request,
@@ -55,7 +76,7 @@ class GoogleURLLoaderThrottle
   bool night_mode_enabled_;
   bool is_tab_large_enough_;
 #endif
-  const chrome::mojom::DynamicParams dynamic_params_;
+  const scoped_refptr<const SharedDynamicParams> dynamic_params_;
 };
 
 #endif  // CHROME_COMMON_GOOGLE_URL_LOADER_THROTTLE_H_
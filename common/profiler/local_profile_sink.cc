@@ -0,0 +1,355 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/common/profiler/local_profile_sink.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "base/command_line.h"
+#include "base/files/file_path.h"
+#include "base/files/important_file_writer.h"
+#include "base/no_destructor.h"
+#include "base/strings/string_piece.h"
+#include "chrome/common/profiler/process_type.h"
+#include "chrome/common/profiler/thread_profiler_configuration.h"
+
+namespace {
+
+// Field numbers of the messages in pprof's profile.proto.
+namespace pprof {
+enum ProfileField {
+  kSampleType = 1,
+  kSample = 2,
+  kMapping = 3,
+  kLocation = 4,
+  kStringTable = 6,
+  kTimeNanos = 9,
+  kDurationNanos = 10,
+  kPeriodType = 11,
+  kPeriod = 12,
+};
+enum ValueTypeField { kValueTypeType = 1, kValueTypeUnit = 2 };
+enum SampleField { kSampleLocationId = 1, kSampleValue = 2, kSampleLabel = 3 };
+enum LabelField { kLabelKey = 1, kLabelStr = 2 };
+enum MappingField {
+  kMappingId = 1,
+  kMappingMemoryStart = 2,
+  kMappingMemoryLimit = 3,
+  kMappingBuildId = 6,
+};
+enum LocationField {
+  kLocationId = 1,
+  kLocationMappingId = 2,
+  kLocationAddress = 3,
+};
+}  // namespace pprof
+
+// Protocol buffer wire types.
+constexpr int kWireTypeVarint = 0;
+constexpr int kWireTypeLengthDelimited = 2;
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void AppendVarintField(int field, uint64_t value, std::string* out) {
+  AppendVarint((field << 3) | kWireTypeVarint, out);
+  AppendVarint(value, out);
+}
+
+void AppendBytesField(int field, base::StringPiece bytes, std::string* out) {
+  AppendVarint((field << 3) | kWireTypeLengthDelimited, out);
+  AppendVarint(bytes.size(), out);
+  out->append(bytes.data(), bytes.size());
+}
+
+void AppendPackedField(int field,
+                       const std::vector<uint64_t>& values,
+                       std::string* out) {
+  std::string packed;
+  for (uint64_t value : values)
+    AppendVarint(value, &packed);
+  AppendBytesField(field, packed, out);
+}
+
+// Aggregates call stack profiles into a pprof profile. Every frame becomes a
+// location in the mapping of its module, with the module's build id and the
+// frame's offset within the module as address, so that pprof can symbolize
+// the profile against the binaries.
+class PprofBuilder {
+ public:
+  PprofBuilder() {
+    strings_.emplace_back();
+    // The strings used by Serialize() are added up front so that it can be
+    // const.
+    for (const char* string :
+         {"samples", "count", "wall", "nanoseconds", "process", "thread"}) {
+      GetStringId(string);
+    }
+  }
+
+  PprofBuilder(const PprofBuilder&) = delete;
+  PprofBuilder& operator=(const PprofBuilder&) = delete;
+
+  void AddProfile(base::Time start_time,
+                  const metrics::SampledProfile& profile) {
+    const metrics::CallStackProfile& call_stack_profile =
+        profile.call_stack_profile();
+    const base::TimeDelta sampling_period =
+        base::TimeDelta::FromMilliseconds(
+            call_stack_profile.sampling_period_ms());
+    if (period_.is_zero())
+      period_ = sampling_period;
+
+    const base::Time end_time =
+        start_time + base::TimeDelta::FromMilliseconds(
+                         call_stack_profile.profile_duration_ms());
+    if (start_time_.is_null() || start_time < start_time_)
+      start_time_ = start_time;
+    end_time_ = std::max(end_time_, end_time);
+
+    std::vector<uint64_t> mapping_ids;
+    for (const auto& module_id : call_stack_profile.module_id())
+      mapping_ids.push_back(GetMappingId(module_id.build_id()));
+
+    const uint64_t process = GetStringId(metrics::Process_Name(
+        profile.has_process() ? profile.process() : metrics::UNKNOWN_PROCESS));
+    const uint64_t thread = GetStringId(metrics::Thread_Name(
+        profile.has_thread() ? profile.thread() : metrics::UNKNOWN_THREAD));
+
+    for (const auto& sample : call_stack_profile.stack_sample()) {
+      if (sample.stack_index() < 0 ||
+          sample.stack_index() >= call_stack_profile.stack_size()) {
+        continue;
+      }
+      SampleKey key{{}, process, thread};
+      for (const auto& frame :
+           call_stack_profile.stack(sample.stack_index()).frame()) {
+        const bool has_module =
+            frame.has_module_id_index() && frame.module_id_index() >= 0 &&
+            frame.module_id_index() < static_cast<int>(mapping_ids.size());
+        key.location_ids.push_back(GetLocationId(
+            has_module ? mapping_ids[frame.module_id_index()] : 0,
+            frame.address()));
+      }
+      const int64_t count = sample.has_count() ? sample.count() : 1;
+      SampleValues& values = samples_[std::move(key)];
+      values.count += count;
+      values.wall_time += count * sampling_period;
+    }
+  }
+
+  std::string Serialize() const {
+    std::string out;
+    AppendValueType(pprof::kSampleType, "samples", "count", &out);
+    AppendValueType(pprof::kSampleType, "wall", "nanoseconds", &out);
+
+    const uint64_t process_key = FindStringId("process");
+    const uint64_t thread_key = FindStringId("thread");
+    for (const auto& sample : samples_) {
+      std::string message;
+      AppendPackedField(pprof::kSampleLocationId, sample.first.location_ids,
+                        &message);
+      AppendPackedField(
+          pprof::kSampleValue,
+          {static_cast<uint64_t>(sample.second.count),
+           static_cast<uint64_t>(sample.second.wall_time.InNanoseconds())},
+          &message);
+      AppendLabel(process_key, sample.first.process, &message);
+      AppendLabel(thread_key, sample.first.thread, &message);
+      AppendBytesField(pprof::kSample, message, &out);
+    }
+
+    for (size_t i = 0; i < mappings_.size(); ++i) {
+      std::string message;
+      AppendVarintField(pprof::kMappingId, i + 1, &message);
+      AppendVarintField(pprof::kMappingMemoryStart, 0, &message);
+      AppendVarintField(pprof::kMappingMemoryLimit, mappings_[i].memory_limit,
+                        &message);
+      AppendVarintField(pprof::kMappingBuildId, mappings_[i].build_id,
+                        &message);
+      AppendBytesField(pprof::kMapping, message, &out);
+    }
+
+    for (const auto& location : location_ids_) {
+      std::string message;
+      AppendVarintField(pprof::kLocationId, location.second, &message);
+      if (location.first.first) {
+        AppendVarintField(pprof::kLocationMappingId, location.first.first,
+                          &message);
+      }
+      AppendVarintField(pprof::kLocationAddress, location.first.second,
+                        &message);
+      AppendBytesField(pprof::kLocation, message, &out);
+    }
+
+    for (const std::string& string : strings_)
+      AppendBytesField(pprof::kStringTable, string, &out);
+
+    if (!start_time_.is_null()) {
+      AppendVarintField(
+          pprof::kTimeNanos,
+          (start_time_ - base::Time::UnixEpoch()).InNanoseconds(), &out);
+      AppendVarintField(pprof::kDurationNanos,
+                        (end_time_ - start_time_).InNanoseconds(), &out);
+    }
+    AppendValueType(pprof::kPeriodType, "wall", "nanoseconds", &out);
+    AppendVarintField(pprof::kPeriod, period_.InNanoseconds(), &out);
+    return out;
+  }
+
+ private:
+  struct SampleKey {
+    std::vector<uint64_t> location_ids;
+    uint64_t process;
+    uint64_t thread;
+
+    bool operator<(const SampleKey& other) const {
+      return std::tie(location_ids, process, thread) <
+             std::tie(other.location_ids, other.process, other.thread);
+    }
+  };
+
+  struct SampleValues {
+    int64_t count = 0;
+    base::TimeDelta wall_time;
+  };
+
+  struct Mapping {
+    uint64_t build_id;
+    uint64_t memory_limit = 0;
+  };
+
+  uint64_t GetStringId(const std::string& string) {
+    auto result = string_ids_.emplace(string, strings_.size());
+    if (result.second)
+      strings_.push_back(string);
+    return result.first->second;
+  }
+
+  uint64_t FindStringId(const std::string& string) const {
+    return string_ids_.at(string);
+  }
+
+  uint64_t GetMappingId(const std::string& build_id) {
+    auto result = mapping_ids_.emplace(build_id, mappings_.size() + 1);
+    if (result.second)
+      mappings_.push_back({GetStringId(build_id)});
+    return result.first->second;
+  }
+
+  uint64_t GetLocationId(uint64_t mapping_id, uint64_t address) {
+    if (mapping_id) {
+      Mapping& mapping = mappings_[mapping_id - 1];
+      mapping.memory_limit = std::max(mapping.memory_limit, address + 1);
+    }
+    auto result = location_ids_.emplace(std::make_pair(mapping_id, address),
+                                        location_ids_.size() + 1);
+    return result.first->second;
+  }
+
+  void AppendValueType(int field,
+                       const char* type,
+                       const char* unit,
+                       std::string* out) const {
+    std::string message;
+    AppendVarintField(pprof::kValueTypeType, FindStringId(type), &message);
+    AppendVarintField(pprof::kValueTypeUnit, FindStringId(unit), &message);
+    AppendBytesField(field, message, out);
+  }
+
+  static void AppendLabel(uint64_t key, uint64_t value, std::string* out) {
+    std::string message;
+    AppendVarintField(pprof::kLabelKey, key, &message);
+    AppendVarintField(pprof::kLabelStr, value, &message);
+    AppendBytesField(pprof::kSampleLabel, message, out);
+  }
+
+  // The string table, where the first string must be empty.
+  std::vector<std::string> strings_;
+  std::map<std::string, uint64_t> string_ids_;
+
+  // Mappings by build id. Ids start at 1, 0 meaning no mapping.
+  std::vector<Mapping> mappings_;
+  std::map<std::string, uint64_t> mapping_ids_;
+
+  // Location ids by mapping id and address.
+  std::map<std::pair<uint64_t, uint64_t>, uint64_t> location_ids_;
+
+  std::map<SampleKey, SampleValues> samples_;
+
+  base::Time start_time_;
+  base::Time end_time_;
+  base::TimeDelta period_;
+};
+
+}  // namespace
+
+LocalProfileSink::LocalProfileSink(size_t max_profiles)
+    : max_profiles_(max_profiles) {}
+
+LocalProfileSink::~LocalProfileSink() = default;
+
+// static
+LocalProfileSink* LocalProfileSink::Get() {
+  static LocalProfileSink* const sink = []() -> LocalProfileSink* {
+    if (!ThreadProfilerConfiguration::Get()->IsLocalProfilingEnabled() ||
+        GetProfileParamsProcess(*base::CommandLine::ForCurrentProcess()) !=
+            metrics::CallStackProfileParams::BROWSER_PROCESS) {
+      return nullptr;
+    }
+    static base::NoDestructor<LocalProfileSink> instance(kMaxProfiles);
+    return instance.get();
+  }();
+  return sink;
+}
+
+void LocalProfileSink::AddProfile(base::TimeTicks start_timestamp,
+                                  metrics::SampledProfile profile) {
+  const base::Time start_time =
+      base::Time::Now() - (base::TimeTicks::Now() - start_timestamp);
+  base::AutoLock lock(lock_);
+  if (profiles_.size() == max_profiles_)
+    profiles_.pop_front();
+  profiles_.push_back({start_time, std::move(profile)});
+}
+
+void LocalProfileSink::AddSerializedProfile(
+    base::TimeTicks start_timestamp,
+    const std::string& serialized_profile) {
+  metrics::SampledProfile profile;
+  if (!profile.ParseFromString(serialized_profile))
+    return;
+  AddProfile(start_timestamp, std::move(profile));
+}
+
+size_t LocalProfileSink::profile_count() const {
+  base::AutoLock lock(lock_);
+  return profiles_.size();
+}
+
+std::string LocalProfileSink::SerializeAsPprof() const {
+  PprofBuilder builder;
+  {
+    base::AutoLock lock(lock_);
+    for (const Entry& entry : profiles_)
+      builder.AddProfile(entry.start_time, entry.profile);
+  }
+  return builder.Serialize();
+}
+
+bool LocalProfileSink::WriteToFile(const base::FilePath& path) const {
+  return base::ImportantFileWriter::WriteFileAtomically(path,
+                                                        SerializeAsPprof());
+}
@@ -0,0 +1,80 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_COMMON_PROFILER_LOCAL_PROFILE_SINK_H_
+#define CHROME_COMMON_PROFILER_LOCAL_PROFILE_SINK_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "base/containers/circular_deque.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "base/time/time.h"
+#include "third_party/metrics_proto/sampled_profile.pb.h"
+
+namespace base {
+class FilePath;
+}  // namespace base
+
+// LocalProfileSink keeps the most recent stack sampling profiles of all
+// processes and threads in memory, so that they can be exported on demand as a
+// single pprof profile when a machine is slow. It exists only in the browser
+// process, and only when the --local-stack-profiles switch is set; child
+// process profiles reach it through the CallStackProfileCollector interface.
+//
+// Frames are exported as module build ids and offsets, for offline
+// symbolization. The sink is thread-safe.
+class LocalProfileSink {
+ public:
+  // The number of profiles kept by the sink returned by Get(). At the default
+  // 30 second profile duration this covers several minutes of the busiest
+  // threads.
+  static constexpr size_t kMaxProfiles = 200;
+
+  explicit LocalProfileSink(size_t max_profiles);
+  ~LocalProfileSink();
+
+  LocalProfileSink(const LocalProfileSink&) = delete;
+  LocalProfileSink& operator=(const LocalProfileSink&) = delete;
+
+  // Returns the sink for the browser process, or null if local profiling is
+  // not enabled.
+  static LocalProfileSink* Get();
+
+  // Adds |profile|, which started at |start_timestamp|, dropping the oldest
+  // profile if the sink is full.
+  void AddProfile(base::TimeTicks start_timestamp,
+                  metrics::SampledProfile profile);
+
+  // Like AddProfile(), for a profile serialized by a child process. Profiles
+  // which fail to parse are dropped.
+  void AddSerializedProfile(base::TimeTicks start_timestamp,
+                            const std::string& serialized_profile);
+
+  size_t profile_count() const;
+
+  // Aggregates the profiles in the sink into a serialized pprof profile.
+  // Identical stacks are merged per process and thread, which are recorded as
+  // sample labels.
+  std::string SerializeAsPprof() const;
+
+  // Writes SerializeAsPprof() to |path|, replacing the file atomically.
+  // Blocks, so must not be called on the UI thread.
+  bool WriteToFile(const base::FilePath& path) const;
+
+ private:
+  struct Entry {
+    base::Time start_time;
+    metrics::SampledProfile profile;
+  };
+
+  const size_t max_profiles_;
+
+  mutable base::Lock lock_;
+  base::circular_deque<Entry> profiles_ GUARDED_BY(lock_);
+};
+
+#endif  // CHROME_COMMON_PROFILER_LOCAL_PROFILE_SINK_H_
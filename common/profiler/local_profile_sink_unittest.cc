@@ -0,0 +1,91 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/common/profiler/local_profile_sink.h"
+
+#include <stdint.h>
+
+#include <string>
+
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/metrics_proto/sampled_profile.pb.h"
+
+namespace {
+
+// Returns a profile of |process| and |thread| with one sample of a two frame
+// stack in the module with |build_id|.
+metrics::SampledProfile CreateProfile(metrics::Process process,
+                                      metrics::Thread thread,
+                                      const std::string& build_id) {
+  metrics::SampledProfile profile;
+  profile.set_process(process);
+  profile.set_thread(thread);
+  metrics::CallStackProfile* call_stack_profile =
+      profile.mutable_call_stack_profile();
+  call_stack_profile->set_profile_duration_ms(1000);
+  call_stack_profile->set_sampling_period_ms(100);
+  call_stack_profile->add_module_id()->set_build_id(build_id);
+  metrics::CallStackProfile::Stack* stack = call_stack_profile->add_stack();
+  for (uint64_t address : {0x1234u, 0x5678u}) {
+    metrics::CallStackProfile::Location* frame = stack->add_frame();
+    frame->set_address(address);
+    frame->set_module_id_index(0);
+  }
+  call_stack_profile->add_stack_sample()->set_stack_index(0);
+  return profile;
+}
+
+}  // namespace
+
+TEST(LocalProfileSinkTest, KeepsMostRecentProfiles) {
+  LocalProfileSink sink(2);
+  for (int i = 0; i < 3; ++i) {
+    sink.AddProfile(base::TimeTicks::Now(),
+                    CreateProfile(metrics::BROWSER_PROCESS,
+                                  metrics::MAIN_THREAD, "AAAA"));
+  }
+  EXPECT_EQ(2u, sink.profile_count());
+}
+
+TEST(LocalProfileSinkTest, DropsMalformedSerializedProfiles) {
+  LocalProfileSink sink(LocalProfileSink::kMaxProfiles);
+  sink.AddSerializedProfile(base::TimeTicks::Now(), "\xff\xff\xff");
+  EXPECT_EQ(0u, sink.profile_count());
+
+  sink.AddSerializedProfile(
+      base::TimeTicks::Now(),
+      CreateProfile(metrics::RENDERER_PROCESS, metrics::MAIN_THREAD, "AAAA")
+          .SerializeAsString());
+  EXPECT_EQ(1u, sink.profile_count());
+}
+
+TEST(LocalProfileSinkTest, SerializeAsPprof) {
+  LocalProfileSink sink(LocalProfileSink::kMaxProfiles);
+  EXPECT_FALSE(sink.SerializeAsPprof().empty());
+
+  sink.AddProfile(
+      base::TimeTicks::Now(),
+      CreateProfile(metrics::BROWSER_PROCESS, metrics::MAIN_THREAD, "AAAA"));
+  const std::string one_profile = sink.SerializeAsPprof();
+  EXPECT_NE(std::string::npos, one_profile.find("AAAA"));
+  EXPECT_NE(std::string::npos, one_profile.find("BROWSER_PROCESS"));
+  EXPECT_NE(std::string::npos, one_profile.find("MAIN_THREAD"));
+
+  // Identical stacks of the same thread are merged into one sample, which
+  // keeps the size of the profile the same.
+  sink.AddProfile(
+      base::TimeTicks::Now(),
+      CreateProfile(metrics::BROWSER_PROCESS, metrics::MAIN_THREAD, "AAAA"));
+  EXPECT_EQ(one_profile.size(), sink.SerializeAsPprof().size());
+
+  // Other processes and modules are added.
+  sink.AddProfile(
+      base::TimeTicks::Now(),
+      CreateProfile(metrics::GPU_PROCESS, metrics::IO_THREAD, "BBBB"));
+  const std::string two_processes = sink.SerializeAsPprof();
+  EXPECT_NE(std::string::npos, two_processes.find("GPU_PROCESS"));
+  EXPECT_NE(std::string::npos, two_processes.find("IO_THREAD"));
+  EXPECT_NE(std::string::npos, two_processes.find("BBBB"));
+}
@@ -4,9 +4,13 @@
 
 #include "chrome/common/profiler/main_thread_stack_sampling_profiler.h"
 
+#include <utility>
+
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "chrome/common/profiler/local_profile_sink.h"
 #include "chrome/common/profiler/process_type.h"
 #include "chrome/common/profiler/thread_profiler.h"
 #include "components/metrics/call_stack_profile_metrics_provider.h"
@@ -14,6 +18,18 @@
 
 namespace {
 
+// Receives the browser process profiles, keeping them for local export instead
+// of uploading them if local profiling is enabled.
+void ReceiveBrowserProcessProfile(base::TimeTicks start_timestamp,
+                                  metrics::SampledProfile profile) {
+  if (LocalProfileSink* local_sink = LocalProfileSink::Get()) {
+    local_sink->AddProfile(start_timestamp, std::move(profile));
+    return;
+  }
+  metrics::CallStackProfileMetricsProvider::ReceiveProfile(start_timestamp,
+                                                           std::move(profile));
+}
+
 // Returns the profiler appropriate for the current process.
 std::unique_ptr<ThreadProfiler> CreateThreadProfiler() {
   const metrics::CallStackProfileParams::Process process =
@@ -21,8 +37,8 @@ std::unique_ptr<ThreadProfiler> CreateThreadProfiler() {
 
   // TODO(wittman): Do this for other process types too.
   if (process == metrics::CallStackProfileParams::BROWSER_PROCESS) {
-    ThreadProfiler::SetBrowserProcessReceiverCallback(base::BindRepeating(
-        &metrics::CallStackProfileMetricsProvider::ReceiveProfile));
+    ThreadProfiler::SetBrowserProcessReceiverCallback(
+        base::BindRepeating(&ReceiveBrowserProcessProfile));
     return ThreadProfiler::CreateAndStartOnMainThread();
   }
 
@@ -54,9 +54,6 @@ namespace {
 // chrome_dll, by the time we need to register the main thread task runner.
 ThreadProfiler* g_main_thread_instance = nullptr;
 
-// Run continuous profiling 2% of the time.
-constexpr double kFractionOfExecutionTimeToSample = 0.02;
-
 bool IsCurrentProcessBackgrounded() {
 #if defined(OS_MAC)
   // Port provider that returns the calling process's task port, ignoring its
@@ -180,11 +177,13 @@ const base::RepeatingClosure GetApplyPerSampleMetadataCallback(
 // The collection start time is chosen randomly within each period such that the
 // entire collection is contained within the period.
 //
-// The kFractionOfExecutionTimeToSample and SamplingParams settings at the top
-// of the file specify fraction = 0.02 and sampling period = 1 sample / .1s
-// sampling interval * 300 samples = 30s. The period length works out to
+// The default fraction of execution time to sample in
+// ThreadProfilerConfiguration and the SamplingParams settings at the top of the
+// file specify fraction = 0.02 and sampling period = 1 sample / .1s sampling
+// interval * 300 samples = 30s. The period length works out to
 // 30s/0.02 = 1500s = 25m. So every 25 minutes a random 30 second continuous
-// interval will be picked to sample.
+// interval will be picked to sample. With --local-stack-profiles the fraction
+// defaults to 1, so that collections run back to back.
 PeriodicSamplingScheduler::PeriodicSamplingScheduler(
     base::TimeDelta sampling_duration,
     double fraction_of_execution_time_to_sample,
@@ -372,7 +371,8 @@ ThreadProfiler::ThreadProfiler(
 
   periodic_sampling_scheduler_ = std::make_unique<PeriodicSamplingScheduler>(
       sampling_params.samples_per_profile * sampling_params.sampling_interval,
-      kFractionOfExecutionTimeToSample, startup_profiling_completion_time);
+      ThreadProfilerConfiguration::Get()->GetFractionOfExecutionTimeToSample(),
+      startup_profiling_completion_time);
 
   if (owning_thread_task_runner_)
     ScheduleNextPeriodicCollection();
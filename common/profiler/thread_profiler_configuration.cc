@@ -9,6 +9,7 @@
 #include "base/no_destructor.h"
 #include "base/notreached.h"
 #include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "build/branding_buildflags.h"
 #include "chrome/common/channel_info.h"
 #include "chrome/common/chrome_switches.h"
@@ -30,6 +31,27 @@ bool IsBrowserTestModeEnabled() {
          switches::kStartStackProfilerBrowserTest;
 }
 
+// Run continuous profiling 2% of the time.
+constexpr double kFractionOfExecutionTimeToSample = 0.02;
+
+// Returns the fraction of execution time to sample if local profiling is
+// enabled, otherwise returns nullopt.
+base::Optional<double> GetLocalProfilingFraction() {
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  if (!command_line->HasSwitch(switches::kLocalStackProfiles))
+    return base::nullopt;
+
+  double fraction;
+  if (!base::StringToDouble(
+          command_line->GetSwitchValueASCII(switches::kLocalStackProfiles),
+          &fraction) ||
+      !(fraction > 0.0) || fraction > 1.0) {
+    return 1.0;
+  }
+  return fraction;
+}
+
 // Returns the channel if this is a Chrome release, otherwise returns nullopt. A
 // build is considered to be a Chrome release if it's official and has Chrome
 // branding.
@@ -65,6 +87,15 @@ ThreadProfilerConfiguration::GetSamplingParams() const {
   return params;
 }
 
+double ThreadProfilerConfiguration::GetFractionOfExecutionTimeToSample()
+    const {
+  return GetLocalProfilingFraction().value_or(kFractionOfExecutionTimeToSample);
+}
+
+bool ThreadProfilerConfiguration::IsLocalProfilingEnabled() const {
+  return GetLocalProfilingFraction().has_value();
+}
+
 bool ThreadProfilerConfiguration::IsProfilerEnabledForCurrentProcess() const {
   if (const ChildProcessConfiguration* child_process_configuration =
           absl::get_if<ChildProcessConfiguration>(&configuration_)) {
@@ -92,7 +123,8 @@ bool ThreadProfilerConfiguration::GetSyntheticFieldTrial(
   const base::Optional<VariationGroup>& variation_group =
       absl::get<BrowserProcessConfiguration>(configuration_);
 
-  if (!variation_group.has_value())
+  // Local profiling forces the profiler on, outside of any variation group.
+  if (!variation_group.has_value() || IsLocalProfilingEnabled())
     return false;
 
   *trial_name = "SyntheticStackProfilingConfiguration";
@@ -127,12 +159,20 @@ void ThreadProfilerConfiguration::AppendCommandLineSwitchForChildProcess(
   if (!EnableForVariationGroup(variation_group))
     return;
 
-  const metrics::CallStackProfileParams::Process child_process =
-      GetProfileParamsProcess(*child_process_command_line);
-  const double enable_fraction =
-      platform_configuration_->GetChildProcessEnableFraction(child_process);
-  if (!(base::RandDouble() < enable_fraction))
-    return;
+  if (IsLocalProfilingEnabled()) {
+    // Local profiling covers every child process.
+    child_process_command_line->AppendSwitchASCII(
+        switches::kLocalStackProfiles,
+        base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(
+            switches::kLocalStackProfiles));
+  } else {
+    const metrics::CallStackProfileParams::Process child_process =
+        GetProfileParamsProcess(*child_process_command_line);
+    const double enable_fraction =
+        platform_configuration_->GetChildProcessEnableFraction(child_process);
+    if (!(base::RandDouble() < enable_fraction))
+      return;
+  }
 
   if (IsBrowserTestModeEnabled()) {
     // Propagate the browser test mode switch argument to the child processes.
@@ -211,6 +251,9 @@ ThreadProfilerConfiguration::GenerateBrowserProcessConfiguration(
       break;
   }
 
+  if (GetLocalProfilingFraction())
+    return kProfileEnabled;
+
   ThreadProfilerPlatformConfiguration::RelativePopulations
       relative_populations =
           platform_configuration.GetEnableRates(release_channel);
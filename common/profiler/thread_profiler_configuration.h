@@ -38,6 +38,13 @@ class ThreadProfilerConfiguration {
   // Get the stack sampling params to use.
   base::StackSamplingProfiler::SamplingParams GetSamplingParams() const;
 
+  // Get the fraction of execution time to spend in periodic collections.
+  double GetFractionOfExecutionTimeToSample() const;
+
+  // True if profiles are kept for local export, see LocalProfileSink. Enabled
+  // by the --local-stack-profiles switch, in every process.
+  bool IsLocalProfilingEnabled() const;
+
   // True if the profiler is enabled for any thread in the current process.
   bool IsProfilerEnabledForCurrentProcess() const;
 
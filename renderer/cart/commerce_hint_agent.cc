@@ -162,6 +162,26 @@ bool PartialMatch(base::StringPiece str, const re2::RE2& re) {
   return RE2::PartialMatch(re2::StringPiece(str.data(), str.size()), re);
 }
 
+// Returns false if |str| can't match GetAddToCartPattern(), whose matches all
+// contain "cart", "basket" or "bag" in any ASCII case. This single pass is much
+// cheaper than the pattern, which doesn't start with a literal RE2 could skip
+// ahead to, and rejects most requests: analytics beacons, logging, etc.
+bool MayMatchAddToCart(base::StringPiece str) {
+  for (size_t i = 0; i < str.size(); ++i) {
+    const char c = base::ToLowerASCII(str[i]);
+    if (c != 'c' && c != 'b')
+      continue;
+    const base::StringPiece rest = str.substr(i);
+    if (base::StartsWith(rest, "cart", base::CompareCase::INSENSITIVE_ASCII) ||
+        base::StartsWith(rest, "bag", base::CompareCase::INSENSITIVE_ASCII) ||
+        base::StartsWith(rest, "basket",
+                         base::CompareCase::INSENSITIVE_ASCII)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 // This is based on top 30 US shopping sites.
 // TODO(crbug/1164236): cover more shopping sites.
 const re2::RE2& GetAddToCartPattern() {
@@ -223,12 +243,13 @@ const re2::RE2& GetVisitCartPattern(const GURL& url) {
     // clang-format on
     return *instance;
   }
-  if (heuristic_regex_map->find(domain) == heuristic_regex_map->end()) {
-    heuristic_regex_map->insert(
-        {domain, std::make_unique<re2::RE2>(heuristic_string_map->at(domain),
-                                            options)});
+  // Per-domain patterns are compiled once per renderer, and shared by frames.
+  std::unique_ptr<re2::RE2>& pattern = (*heuristic_regex_map)[domain];
+  if (!pattern) {
+    pattern =
+        std::make_unique<re2::RE2>(heuristic_string_map->at(domain), options);
   }
-  return *heuristic_regex_map->at(domain);
+  return *pattern;
 }
 
 // TODO(crbug/1164236): cover more shopping sites.
@@ -399,7 +420,8 @@ CommerceHintAgent::CommerceHintAgent(content::RenderFrame* render_frame)
 CommerceHintAgent::~CommerceHintAgent() = default;
 
 bool CommerceHintAgent::IsAddToCart(base::StringPiece str) {
-  return PartialMatch(str.substr(0, kLengthLimit), GetAddToCartPattern());
+  str = str.substr(0, kLengthLimit);
+  return MayMatchAddToCart(str) && PartialMatch(str, GetAddToCartPattern());
 }
 
 bool CommerceHintAgent::IsVisitCart(const GURL& url) {
@@ -519,6 +541,14 @@ void CommerceHintAgent::OnProductsExtracted(
   OnCartProductUpdated(render_frame(), std::move(products));
 }
 
+bool CommerceHintAgent::IsMainFrameVisitCart(const GURL& main_frame_url) {
+  if (main_frame_url != visit_cart_url_) {
+    visit_cart_url_ = main_frame_url;
+    is_visit_cart_ = IsVisitCart(main_frame_url);
+  }
+  return is_visit_cart_;
+}
+
 void CommerceHintAgent::OnDestruct() {
   delete this;
 }
@@ -538,7 +568,7 @@ void CommerceHintAgent::WillSendRequest(const blink::WebURLRequest& request) {
 
   if (!url.SchemeIs(url::kHttpsScheme))
     return;
-  if (IsVisitCart(url) && IsSameDomainXHR(url.host(), request)) {
+  if (IsSameDomainXHR(url.host(), request) && IsMainFrameVisitCart(url)) {
     DVLOG(1) << "In-cart XHR: " << request.Url();
     ExtractProducts();
   }
@@ -611,7 +641,7 @@ void CommerceHintAgent::DidObserveLayoutShift(double score,
   if (!url.SchemeIs(url::kHttpsScheme))
     return;
 
-  if (IsVisitCart(url)) {
+  if (IsMainFrameVisitCart(url)) {
     DVLOG(1) << "In-cart layout shift: " << url;
     ExtractProducts();
   }
@@ -43,7 +43,13 @@ class CommerceHintAgent
   static std::string ExtractButtonText(const blink::WebFormElement& form);
 
  private:
+  // Returns IsVisitCart(|main_frame_url|), cached for the last URL as it is
+  // checked on every request and layout shift of the main frame.
+  bool IsMainFrameVisitCart(const GURL& main_frame_url);
+
   GURL starting_url_;
+  GURL visit_cart_url_;
+  bool is_visit_cart_ = false;
   base::WeakPtrFactory<CommerceHintAgent> weak_factory_{this};
 
   class JavaScriptRequest : public blink::WebScriptExecutionCallback {
@@ -5,6 +5,7 @@
 #include "chrome/renderer/cart/commerce_hint_agent.h"
 
 #include "base/cfi_buildflags.h"
+#include "base/stl_util.h"
 #include "base/test/scoped_feature_list.h"
 #include "build/build_config.h"
 #include "components/search/ntp_features.h"
@@ -34,6 +35,8 @@ const char* kAddToCart[] = {
   "cnc/checkout/cartItems/addItemToCart", // kohls.com
   "\"event\":\"product_added_to_cart\"", // staples.com
   "checkout/basket/add_and_show", // wayfair.com
+  "ADD_TO_BAG",
+  "Add-To-Basket",
 };
 
 const char* kNotAddToCart[] = {
@@ -819,6 +822,45 @@ float BenchmarkIsAddToCart(base::StringPiece str) {
   return elapsed_us;
 }
 
+// Paths and payloads of the requests of a session on shopping sites: mostly
+// analytics beacons, logging and API calls, a few of them adding to cart.
+// clang-format off
+const char* kRequestCorpus[] = {
+  "/g/collect",
+  "v=2&tid=G-XXXXXXXX&gtm=2oe5v0&_p=1234567890&cid=123.456&ul=en-us"
+      "&sr=1920x1080&_s=3&sid=1620000000&sct=1&seg=1"
+      "&dl=https%3A%2F%2Fwww.example.com%2Fp%2F1&dt=Product%20Page"
+      "&en=page_view",
+  "/b/ss/examplecom/1/JS-2.22.0/s1234567890",
+  "AQB=1&ndh=1&pf=1&t=1%2F4%2F2021%2012%3A0%3A0%202%20420&ce=UTF-8"
+      "&pageName=product%3Adetail&g=https%3A%2F%2Fwww.example.com%2Fp%2F1",
+  "/api/v1/recommendations",
+  "{\"productIds\":[\"123\",\"456\"],\"placement\":\"pdp-carousel\"}",
+  "/log",
+  "[{\"type\":\"impression\",\"ts\":1620000000,\"items\":[1,2,3,4,5]}]",
+  "/graphql",
+  "{\"operationName\":\"ProductReviews\",\"variables\":{\"id\":\"123\"}}",
+  "/cart/add.js",
+  "form_type=product&utf8=%E2%9C%93&id=39876543210&quantity=1",
+  "/api/cart/items",
+  "{\"action\":\"add_to_cart\",\"sku\":\"123-456\",\"qty\":1}",
+};
+// clang-format on
+
+float BenchmarkRequestCorpus() {
+  const base::TimeTicks now = base::TimeTicks::Now();
+  for (int i = 0; i < kTestIterations; ++i) {
+    for (auto* str : kRequestCorpus)
+      CommerceHintAgent::IsAddToCart(str);
+  }
+  const base::TimeTicks end = base::TimeTicks::Now();
+  float elapsed_us = static_cast<float>((end - now).InMicroseconds()) /
+                     kTestIterations / base::size(kRequestCorpus);
+  LOG(INFO) << "IsAddToCart() of the request corpus took: " << elapsed_us
+            << " µs per request";
+  return elapsed_us;
+}
+
 float BenchmarkIsVisitCart(const GURL& url) {
   const base::TimeTicks now = base::TimeTicks::Now();
   for (int i = 0; i < kTestIterations; ++i) {
@@ -881,8 +923,10 @@ float BenchmarkShouldSkip(base::StringPiece str) {
     BUILDFLAG(CFI_ICALL_CHECK) || BUILDFLAG(CFI_ENFORCEMENT_DIAGNOSTIC) || \
     BUILDFLAG(CFI_ENFORCEMENT_TRAP)
 #define MAYBE_RegexBenchmark DISABLED_RegexBenchmark
+#define MAYBE_RequestCorpusBenchmark DISABLED_RequestCorpusBenchmark
 #else
 #define MAYBE_RegexBenchmark RegexBenchmark
+#define MAYBE_RequestCorpusBenchmark RequestCorpusBenchmark
 #endif
 
 TEST(CommerceHintAgentTest, MAYBE_RegexBenchmark) {
@@ -934,3 +978,21 @@ TEST(CommerceHintAgentTest, MAYBE_RegexBenchmark) {
     str += str;
   }
 }
+
+TEST(CommerceHintAgentTest, MAYBE_RequestCorpusBenchmark) {
+  size_t add_to_cart_count = 0;
+  for (auto* str : kRequestCorpus)
+    add_to_cart_count += CommerceHintAgent::IsAddToCart(str);
+  EXPECT_EQ(2u, add_to_cart_count);
+
+  int slow_factor = 1;
+#if !defined(NDEBUG)
+  slow_factor *= 4;
+#endif
+#if defined(OS_ANDROID)
+  slow_factor *= 10;
+#endif
+
+  // Typical value is ~0.5us, as most requests don't run the pattern.
+  EXPECT_LT(BenchmarkRequestCorpus(), 5.0 * slow_factor);
+}
@@ -1433,7 +1433,10 @@ bool ChromeContentRendererClient::ShouldReportDetailedMessageForSource(
 std::unique_ptr<blink::WebContentSettingsClient>
 ChromeContentRendererClient::CreateWorkerContentSettingsClient(
     content::RenderFrame* render_frame) {
-  return std::make_unique<WorkerContentSettingsClient>(render_frame);
+  return std::make_unique<WorkerContentSettingsClient>(
+      render_frame, chrome_observer_
+                        ? chrome_observer_->content_setting_rules_index()
+                        : nullptr);
 }
 
 #if !defined(OS_ANDROID)
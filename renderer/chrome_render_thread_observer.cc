@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <set>
@@ -24,6 +25,7 @@
 #include "base/path_service.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
 #include "base/task/post_task.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/thread_task_runner_handle.h"
@@ -35,6 +37,7 @@
 #include "chrome/common/media/media_resource_provider.h"
 #include "chrome/common/net/net_resource_provider.h"
 #include "chrome/common/url_constants.h"
+#include "components/content_settings/core/common/content_settings.mojom.h"
 #include "components/visitedlink/renderer/visitedlink_reader.h"
 #include "content/public/child/child_thread.h"
 #include "content/public/common/content_switches.h"
@@ -186,9 +189,19 @@ void ChromeRenderThreadObserver::ChromeOSListener::BindOnIOThread(
 }
 #endif  // BUILDFLAG(IS_CHROMEOS_ASH)
 
-chrome::mojom::DynamicParams* GetDynamicConfigParams() {
-  static base::NoDestructor<chrome::mojom::DynamicParams> dynamic_params;
-  return dynamic_params.get();
+using SharedDynamicParams = base::RefCountedData<chrome::mojom::DynamicParams>;
+
+// Guards |GetDynamicConfigParams()|, which is read by the URL loader throttle
+// providers of workers.
+base::Lock& GetDynamicConfigParamsLock() {
+  static base::NoDestructor<base::Lock> lock;
+  return *lock;
+}
+
+scoped_refptr<const SharedDynamicParams>& GetDynamicConfigParams() {
+  static base::NoDestructor<scoped_refptr<const SharedDynamicParams>>
+      dynamic_params(base::MakeRefCounted<SharedDynamicParams>());
+  return *dynamic_params;
 }
 
 ChromeRenderThreadObserver::ChromeRenderThreadObserver()
@@ -207,9 +220,10 @@ ChromeRenderThreadObserver::ChromeRenderThreadObserver()
 ChromeRenderThreadObserver::~ChromeRenderThreadObserver() {}
 
 // static
-const chrome::mojom::DynamicParams&
+scoped_refptr<const SharedDynamicParams>
 ChromeRenderThreadObserver::GetDynamicParams() {
-  return *GetDynamicConfigParams();
+  base::AutoLock lock(GetDynamicConfigParamsLock());
+  return GetDynamicConfigParams();
 }
 
 void ChromeRenderThreadObserver::RegisterMojoInterfaces(
@@ -240,12 +254,82 @@ void ChromeRenderThreadObserver::SetInitialConfiguration(
 
 void ChromeRenderThreadObserver::SetConfiguration(
     chrome::mojom::DynamicParamsPtr params) {
-  *GetDynamicConfigParams() = std::move(*params);
+  auto dynamic_params =
+      base::MakeRefCounted<SharedDynamicParams>(std::move(*params));
+  base::AutoLock lock(GetDynamicConfigParamsLock());
+  GetDynamicConfigParams() = std::move(dynamic_params);
 }
 
 void ChromeRenderThreadObserver::SetContentSettingRules(
     const RendererContentSettingRules& rules) {
   content_setting_rules_ = rules;
+  content_setting_rules_version_ = 0;
+  OnContentSettingRulesChanged();
+}
+
+void ChromeRenderThreadObserver::SetContentSettingRulesSnapshot(
+    uint64_t version,
+    base::ReadOnlySharedMemoryRegion snapshot) {
+  if (version == content_setting_rules_version_)
+    return;
+
+  base::ReadOnlySharedMemoryMapping mapping = snapshot.Map();
+  RendererContentSettingRules rules;
+  if (!mapping.IsValid() ||
+      !content_settings::mojom::RendererContentSettingRules::Deserialize(
+          mapping.memory(), mapping.size(), &rules)) {
+    return;
+  }
+  content_setting_rules_ = std::move(rules);
+  content_setting_rules_version_ = version;
+  OnContentSettingRulesChanged();
+}
+
+void ChromeRenderThreadObserver::UpdateContentSettingRules(
+    uint64_t base_version,
+    uint64_t version,
+    std::vector<chrome::mojom::ContentSettingRulesSplicePtr> splices) {
+  if (content_setting_rules_version_ == 0 ||
+      base_version != content_setting_rules_version_) {
+    return;
+  }
+
+  for (auto& splice : splices) {
+    std::vector<ContentSettingPatternSource>* rules = nullptr;
+    switch (splice->list) {
+      case chrome::mojom::ContentSettingRulesList::kImage:
+        rules = &content_setting_rules_.image_rules;
+        break;
+      case chrome::mojom::ContentSettingRulesList::kScript:
+        rules = &content_setting_rules_.script_rules;
+        break;
+      case chrome::mojom::ContentSettingRulesList::kMixedContent:
+        rules = &content_setting_rules_.mixed_content_rules;
+        break;
+    }
+    if (splice->start > rules->size() ||
+        splice->remove_count > rules->size() - splice->start) {
+      // The rules no longer match the browser's, so wait for the next
+      // snapshot.
+      content_setting_rules_version_ = 0;
+      break;
+    }
+    auto begin = rules->begin() + splice->start;
+    rules->erase(begin, begin + splice->remove_count);
+    rules->insert(rules->begin() + splice->start,
+                  std::make_move_iterator(splice->insert.begin()),
+                  std::make_move_iterator(splice->insert.end()));
+  }
+  if (content_setting_rules_version_ != 0)
+    content_setting_rules_version_ = version;
+  OnContentSettingRulesChanged();
+}
+
+void ChromeRenderThreadObserver::OnContentSettingRulesChanged() {
+  if (content_setting_rules_index_) {
+    content_setting_rules_index_->Set(
+        base::MakeRefCounted<ContentSettingRulesIndex>(content_setting_rules_));
+  }
 }
 
 void ChromeRenderThreadObserver::OnRendererConfigurationAssociatedRequest(
@@ -258,3 +342,14 @@ const RendererContentSettingRules*
 ChromeRenderThreadObserver::content_setting_rules() const {
   return &content_setting_rules_;
 }
+
+scoped_refptr<SharedContentSettingRulesIndex>
+ChromeRenderThreadObserver::content_setting_rules_index() {
+  if (!content_setting_rules_index_) {
+    content_setting_rules_index_ =
+        base::MakeRefCounted<SharedContentSettingRulesIndex>(
+            base::MakeRefCounted<ContentSettingRulesIndex>(
+                content_setting_rules_));
+  }
+  return content_setting_rules_index_;
+}
@@ -5,13 +5,20 @@
 #ifndef CHROME_RENDERER_CHROME_RENDER_THREAD_OBSERVER_H_
 #define CHROME_RENDERER_CHROME_RENDER_THREAD_OBSERVER_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/compiler_specific.h"
 #include "base/macros.h"
+#include "base/memory/read_only_shared_memory_region.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_refptr.h"
 #include "build/chromeos_buildflags.h"
 #include "chrome/common/renderer_configuration.mojom.h"
+#include "chrome/renderer/content_setting_rules_index.h"
 #include "components/content_settings/core/common/content_settings.h"
 #include "content/public/renderer/render_thread_observer.h"
 #include "mojo/public/cpp/bindings/associated_receiver_set.h"
@@ -84,13 +91,19 @@ class ChromeRenderThreadObserver : public content::RenderThreadObserver,
   static bool is_incognito_process() { return is_incognito_process_; }
 
   // Return the dynamic parameters - those that may change while the
-  // render process is running.
-  static const chrome::mojom::DynamicParams& GetDynamicParams();
+  // render process is running. The returned parameters are never modified, so
+  // they can be shared with other threads; an update replaces them.
+  static scoped_refptr<const base::RefCountedData<chrome::mojom::DynamicParams>>
+  GetDynamicParams();
 
   // Returns a pointer to the content setting rules owned by
   // |ChromeRenderThreadObserver|.
   const RendererContentSettingRules* content_setting_rules() const;
 
+  // Returns the holder of the index of the current content setting rules. The
+  // holder gets a new index whenever the rules change.
+  scoped_refptr<SharedContentSettingRulesIndex> content_setting_rules_index();
+
   visitedlink::VisitedLinkReader* visited_link_reader() {
     return visited_link_reader_.get();
   }
@@ -116,6 +129,16 @@ class ChromeRenderThreadObserver : public content::RenderThreadObserver,
   void SetConfiguration(chrome::mojom::DynamicParamsPtr params) override;
   void SetContentSettingRules(
       const RendererContentSettingRules& rules) override;
+  void SetContentSettingRulesSnapshot(
+      uint64_t version,
+      base::ReadOnlySharedMemoryRegion snapshot) override;
+  void UpdateContentSettingRules(
+      uint64_t base_version,
+      uint64_t version,
+      std::vector<chrome::mojom::ContentSettingRulesSplicePtr> splices)
+      override;
+  // Indexes |content_setting_rules_| again, if the index is in use.
+  void OnContentSettingRulesChanged();
   void OnRendererConfigurationAssociatedRequest(
       mojo::PendingAssociatedReceiver<chrome::mojom::RendererConfiguration>
           receiver);
@@ -124,6 +147,12 @@ class ChromeRenderThreadObserver : public content::RenderThreadObserver,
   std::unique_ptr<blink::WebResourceRequestSenderDelegate>
       resource_request_sender_delegate_;
   RendererContentSettingRules content_setting_rules_;
+  // The version of |content_setting_rules_| published by the browser, or 0 if
+  // the rules were not sent as a versioned snapshot.
+  uint64_t content_setting_rules_version_ = 0;
+  // Created lazily, and given a new index whenever |content_setting_rules_|
+  // changes.
+  scoped_refptr<SharedContentSettingRulesIndex> content_setting_rules_index_;
 
   std::unique_ptr<visitedlink::VisitedLinkReader> visited_link_reader_;
 
@@ -0,0 +1,130 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/content_setting_rules_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+#include "url/gurl.h"
+
+namespace {
+
+// Returns the host under which a rule whose primary pattern is |pattern| is
+// indexed, or an empty string if the rule has to be checked for every URL.
+std::string GetIndexHost(const ContentSettingsPattern& pattern) {
+  if (pattern.MatchesAllHosts())
+    return std::string();
+  std::string host = pattern.GetHost();
+  // IPv6 literals and fully qualified hosts may be spelled differently than
+  // in URLs, so they are not indexed.
+  if (host.find_first_of(":[]") != std::string::npos ||
+      base::EndsWith(host, ".")) {
+    return std::string();
+  }
+  return host;
+}
+
+}  // namespace
+
+ContentSettingRulesIndex::RuleList::RuleList(
+    const std::vector<ContentSettingPatternSource>& rules)
+    : rules_(rules) {
+  for (size_t i = 0; i < rules_.size(); ++i) {
+    std::string host = GetIndexHost(rules_[i].primary_pattern);
+    if (host.empty())
+      host_independent_rules_.push_back(i);
+    else
+      rules_by_host_[host].push_back(i);
+  }
+}
+
+ContentSettingRulesIndex::RuleList::~RuleList() = default;
+
+const ContentSettingPatternSource*
+ContentSettingRulesIndex::RuleList::FindFirstMatch(
+    const GURL& primary_url,
+    const GURL* secondary_url) const {
+  base::StringPiece host = primary_url.host_piece();
+  if (base::EndsWith(host, ".")) {
+    for (size_t i = 0; i < rules_.size(); ++i) {
+      if (Matches(i, primary_url, secondary_url))
+        return &rules_[i];
+    }
+    return nullptr;
+  }
+
+  // Rules for the host itself, and domain wildcard rules for its parent
+  // domains.
+  std::vector<size_t> candidates = host_independent_rules_;
+  if (!rules_by_host_.empty()) {
+    while (!host.empty()) {
+      auto it = rules_by_host_.find(host.as_string());
+      if (it != rules_by_host_.end()) {
+        candidates.insert(candidates.end(), it->second.begin(),
+                          it->second.end());
+      }
+      const size_t dot = host.find('.');
+      if (dot == base::StringPiece::npos)
+        break;
+      host.remove_prefix(dot + 1);
+    }
+  }
+
+  // The first matching rule in rule order takes precedence.
+  std::sort(candidates.begin(), candidates.end());
+  for (size_t index : candidates) {
+    if (Matches(index, primary_url, secondary_url))
+      return &rules_[index];
+  }
+  return nullptr;
+}
+
+bool ContentSettingRulesIndex::RuleList::Matches(
+    size_t index,
+    const GURL& primary_url,
+    const GURL* secondary_url) const {
+  const ContentSettingPatternSource& rule = rules_[index];
+  return rule.primary_pattern.Matches(primary_url) &&
+         (!secondary_url || rule.secondary_pattern.Matches(*secondary_url));
+}
+
+ContentSettingRulesIndex::ContentSettingRulesIndex(
+    const RendererContentSettingRules& rules)
+    : script_rules_(rules.script_rules),
+      mixed_content_rules_(rules.mixed_content_rules) {}
+
+ContentSettingRulesIndex::~ContentSettingRulesIndex() = default;
+
+const ContentSettingPatternSource* ContentSettingRulesIndex::FindScriptRule(
+    const GURL& top_frame_url,
+    const GURL& script_url) const {
+  return script_rules_.FindFirstMatch(top_frame_url, &script_url);
+}
+
+const ContentSettingPatternSource*
+ContentSettingRulesIndex::FindMixedContentRule(
+    const GURL& top_frame_url) const {
+  return mixed_content_rules_.FindFirstMatch(top_frame_url, nullptr);
+}
+
+SharedContentSettingRulesIndex::SharedContentSettingRulesIndex(
+    scoped_refptr<const ContentSettingRulesIndex> index)
+    : index_(std::move(index)) {}
+
+SharedContentSettingRulesIndex::~SharedContentSettingRulesIndex() = default;
+
+scoped_refptr<const ContentSettingRulesIndex>
+SharedContentSettingRulesIndex::Get() const {
+  base::AutoLock lock(lock_);
+  return index_;
+}
+
+void SharedContentSettingRulesIndex::Set(
+    scoped_refptr<const ContentSettingRulesIndex> index) {
+  base::AutoLock lock(lock_);
+  index_ = std::move(index);
+}
@@ -0,0 +1,111 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_RENDERER_CONTENT_SETTING_RULES_INDEX_H_
+#define CHROME_RENDERER_CONTENT_SETTING_RULES_INDEX_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "components/content_settings/core/common/content_settings.h"
+
+class GURL;
+
+// Finds the first script or mixed content rule of a
+// RendererContentSettingRules that matches a URL, without evaluating every
+// rule. Rules are bucketed by the host of their primary pattern, so a lookup
+// only evaluates the rules for the host of the URL and its parent domains,
+// plus the rules whose primary pattern is not tied to a host. The index holds
+// a copy of the rules and is immutable, so it can be shared with worker
+// threads.
+class ContentSettingRulesIndex
+    : public base::RefCountedThreadSafe<ContentSettingRulesIndex> {
+ public:
+  explicit ContentSettingRulesIndex(const RendererContentSettingRules& rules);
+
+  ContentSettingRulesIndex(const ContentSettingRulesIndex&) = delete;
+  ContentSettingRulesIndex& operator=(const ContentSettingRulesIndex&) = delete;
+
+  // Returns the first script rule whose primary pattern matches
+  // |top_frame_url| and whose secondary pattern matches |script_url|, or null.
+  const ContentSettingPatternSource* FindScriptRule(
+      const GURL& top_frame_url,
+      const GURL& script_url) const;
+
+  // Returns the first mixed content rule whose primary pattern matches
+  // |top_frame_url|, or null.
+  const ContentSettingPatternSource* FindMixedContentRule(
+      const GURL& top_frame_url) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<ContentSettingRulesIndex>;
+
+  class RuleList {
+   public:
+    explicit RuleList(const std::vector<ContentSettingPatternSource>& rules);
+    RuleList(const RuleList&) = delete;
+    RuleList& operator=(const RuleList&) = delete;
+    ~RuleList();
+
+    // Returns the first rule whose primary pattern matches |primary_url| and,
+    // if |secondary_url| is not null, whose secondary pattern matches it.
+    const ContentSettingPatternSource* FindFirstMatch(
+        const GURL& primary_url,
+        const GURL* secondary_url) const;
+
+   private:
+    bool Matches(size_t index,
+                 const GURL& primary_url,
+                 const GURL* secondary_url) const;
+
+    const std::vector<ContentSettingPatternSource> rules_;
+    // Indices of the rules for each primary pattern host, in rule order.
+    std::unordered_map<std::string, std::vector<size_t>> rules_by_host_;
+    // Indices of the rules which may match any host, in rule order.
+    std::vector<size_t> host_independent_rules_;
+  };
+
+  ~ContentSettingRulesIndex();
+
+  const RuleList script_rules_;
+  const RuleList mixed_content_rules_;
+};
+
+// Holds the current ContentSettingRulesIndex of the renderer. The holder is
+// owned by the ChromeRenderThreadObserver, which replaces the index whenever
+// the rules change, and shared with worker threads, which always look up the
+// latest index.
+class SharedContentSettingRulesIndex
+    : public base::RefCountedThreadSafe<SharedContentSettingRulesIndex> {
+ public:
+  explicit SharedContentSettingRulesIndex(
+      scoped_refptr<const ContentSettingRulesIndex> index);
+
+  SharedContentSettingRulesIndex(const SharedContentSettingRulesIndex&) =
+      delete;
+  SharedContentSettingRulesIndex& operator=(
+      const SharedContentSettingRulesIndex&) = delete;
+
+  // Returns the current index. It stays valid, but is no longer updated, once
+  // the index is replaced.
+  scoped_refptr<const ContentSettingRulesIndex> Get() const;
+
+  void Set(scoped_refptr<const ContentSettingRulesIndex> index);
+
+ private:
+  friend class base::RefCountedThreadSafe<SharedContentSettingRulesIndex>;
+
+  ~SharedContentSettingRulesIndex();
+
+  mutable base::Lock lock_;
+  scoped_refptr<const ContentSettingRulesIndex> index_ GUARDED_BY(lock_);
+};
+
+#endif  // CHROME_RENDERER_CONTENT_SETTING_RULES_INDEX_H_
@@ -0,0 +1,181 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/content_setting_rules_index.h"
+
+#include <string>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "components/content_settings/core/common/content_settings_pattern.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace {
+
+ContentSettingPatternSource CreateRule(const std::string& primary_pattern,
+                                       const std::string& secondary_pattern,
+                                       ContentSetting setting) {
+  return ContentSettingPatternSource(
+      ContentSettingsPattern::FromString(primary_pattern),
+      ContentSettingsPattern::FromString(secondary_pattern),
+      base::Value(setting), std::string(), false);
+}
+
+// Returns the setting of the first script rule which matches, like
+// WorkerContentSettingsClient did before rules were indexed.
+ContentSetting FindScriptSettingLinearly(
+    const RendererContentSettingRules& rules,
+    const GURL& top_frame_url,
+    const GURL& script_url) {
+  for (const auto& rule : rules.script_rules) {
+    if (rule.primary_pattern.Matches(top_frame_url) &&
+        rule.secondary_pattern.Matches(script_url)) {
+      return rule.GetContentSetting();
+    }
+  }
+  return CONTENT_SETTING_DEFAULT;
+}
+
+ContentSetting GetSetting(const ContentSettingPatternSource* rule) {
+  return rule ? rule->GetContentSetting() : CONTENT_SETTING_DEFAULT;
+}
+
+}  // namespace
+
+TEST(ContentSettingRulesIndexTest, Empty) {
+  auto index = base::MakeRefCounted<ContentSettingRulesIndex>(
+      RendererContentSettingRules());
+  EXPECT_FALSE(index->FindScriptRule(GURL("https://example.com/"),
+                                     GURL("https://example.com/a.js")));
+  EXPECT_FALSE(index->FindMixedContentRule(GURL("https://example.com/")));
+}
+
+TEST(ContentSettingRulesIndexTest, FirstMatchingRuleWins) {
+  RendererContentSettingRules rules;
+  rules.script_rules.push_back(
+      CreateRule("https://www.example.com", "*", CONTENT_SETTING_ALLOW));
+  rules.script_rules.push_back(
+      CreateRule("[*.]example.com", "https://cdn.test", CONTENT_SETTING_BLOCK));
+  rules.script_rules.push_back(
+      CreateRule("[*.]example.com", "*", CONTENT_SETTING_ALLOW));
+  rules.script_rules.push_back(CreateRule("*", "*", CONTENT_SETTING_BLOCK));
+  auto index = base::MakeRefCounted<ContentSettingRulesIndex>(rules);
+
+  // An exact host rule.
+  EXPECT_EQ(CONTENT_SETTING_ALLOW,
+            GetSetting(index->FindScriptRule(GURL("https://www.example.com/"),
+                                             GURL("https://cdn.test/a.js"))));
+  // Domain wildcard rules, for the domain and its subdomains.
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            GetSetting(index->FindScriptRule(GURL("https://example.com/"),
+                                             GURL("https://cdn.test/a.js"))));
+  EXPECT_EQ(CONTENT_SETTING_ALLOW,
+            GetSetting(index->FindScriptRule(GURL("https://a.b.example.com/"),
+                                             GURL("https://other.test/a.js"))));
+  // The wildcard rule for other hosts.
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            GetSetting(index->FindScriptRule(GURL("https://example.org/"),
+                                             GURL("https://cdn.test/a.js"))));
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            GetSetting(index->FindScriptRule(GURL("https://notexample.com/"),
+                                             GURL("https://cdn.test/a.js"))));
+}
+
+TEST(ContentSettingRulesIndexTest, MixedContentRules) {
+  RendererContentSettingRules rules;
+  rules.mixed_content_rules.push_back(
+      CreateRule("https://example.com:443", "*", CONTENT_SETTING_ALLOW));
+  rules.mixed_content_rules.push_back(
+      CreateRule("*", "*", CONTENT_SETTING_BLOCK));
+  auto index = base::MakeRefCounted<ContentSettingRulesIndex>(rules);
+
+  EXPECT_EQ(CONTENT_SETTING_ALLOW, GetSetting(index->FindMixedContentRule(
+                                       GURL("https://example.com/"))));
+  EXPECT_EQ(CONTENT_SETTING_BLOCK, GetSetting(index->FindMixedContentRule(
+                                       GURL("https://www.example.com/"))));
+  EXPECT_FALSE(index->FindScriptRule(GURL("https://example.com/"),
+                                     GURL("https://example.com/a.js")));
+}
+
+TEST(ContentSettingRulesIndexTest, UnindexedHosts) {
+  RendererContentSettingRules rules;
+  rules.script_rules.push_back(
+      CreateRule("http://[::1]", "*", CONTENT_SETTING_BLOCK));
+  rules.script_rules.push_back(
+      CreateRule("http://127.0.0.1", "*", CONTENT_SETTING_BLOCK));
+  rules.script_rules.push_back(
+      CreateRule("file:///tmp/page.html", "*", CONTENT_SETTING_BLOCK));
+  rules.script_rules.push_back(CreateRule("*", "*", CONTENT_SETTING_ALLOW));
+  auto index = base::MakeRefCounted<ContentSettingRulesIndex>(rules);
+
+  for (const char* url : {"http://[::1]/", "http://127.0.0.1/",
+                          "file:///tmp/page.html", "https://example.com./",
+                          "http://127.0.0.2/", "file:///tmp/other.html"}) {
+    SCOPED_TRACE(url);
+    EXPECT_EQ(FindScriptSettingLinearly(rules, GURL(url),
+                                        GURL("https://cdn.test/a.js")),
+              GetSetting(index->FindScriptRule(GURL(url),
+                                               GURL("https://cdn.test/a.js"))));
+  }
+}
+
+// Checks that lookups agree with scanning the rules in order, with many rules
+// for overlapping hosts.
+TEST(ContentSettingRulesIndexTest, MatchesLinearScan) {
+  RendererContentSettingRules rules;
+  for (int i = 0; i < 200; ++i) {
+    const std::string host = base::StringPrintf("site%d.test", i % 50);
+    const ContentSetting setting =
+        i % 3 ? CONTENT_SETTING_BLOCK : CONTENT_SETTING_ALLOW;
+    if (i % 4 == 0) {
+      rules.script_rules.push_back(CreateRule("[*.]" + host, "*", setting));
+    } else if (i % 4 == 1) {
+      rules.script_rules.push_back(
+          CreateRule("https://www." + host, "[*.]cdn.test", setting));
+    } else if (i % 4 == 2) {
+      rules.script_rules.push_back(CreateRule(
+          "https://" + host + ":443", "https://cdn" + host, setting));
+    } else {
+      rules.script_rules.push_back(
+          CreateRule("http://sub." + host, "*", setting));
+    }
+  }
+  rules.script_rules.push_back(CreateRule("*", "*", CONTENT_SETTING_ALLOW));
+  auto index = base::MakeRefCounted<ContentSettingRulesIndex>(rules);
+
+  for (int i = 0; i < 60; ++i) {
+    for (const char* prefix : {"https://", "https://www.", "http://sub.",
+                               "https://sub.www."}) {
+      const GURL top_frame_url(
+          base::StringPrintf("%ssite%d.test/", prefix, i));
+      for (const char* script_url :
+           {"https://cdn.test/a.js", "https://a.cdn.test/a.js",
+            "https://other.test/a.js"}) {
+        SCOPED_TRACE(top_frame_url.spec() + " " + script_url);
+        EXPECT_EQ(FindScriptSettingLinearly(rules, top_frame_url,
+                                            GURL(script_url)),
+                  GetSetting(index->FindScriptRule(top_frame_url,
+                                                   GURL(script_url))));
+      }
+    }
+  }
+}
+
+TEST(ContentSettingRulesIndexTest, SharedIndexIsUpdated) {
+  auto shared_index = base::MakeRefCounted<SharedContentSettingRulesIndex>(
+      base::MakeRefCounted<ContentSettingRulesIndex>(
+          RendererContentSettingRules()));
+  const GURL top_frame_url("https://example.com/");
+  const GURL script_url("https://example.com/a.js");
+  EXPECT_FALSE(shared_index->Get()->FindScriptRule(top_frame_url, script_url));
+
+  RendererContentSettingRules rules;
+  rules.script_rules.push_back(CreateRule("*", "*", CONTENT_SETTING_BLOCK));
+  shared_index->Set(base::MakeRefCounted<ContentSettingRulesIndex>(rules));
+  EXPECT_EQ(CONTENT_SETTING_BLOCK,
+            GetSetting(shared_index->Get()->FindScriptRule(top_frame_url,
+                                                           script_url)));
+}
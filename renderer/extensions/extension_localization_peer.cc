@@ -4,6 +4,7 @@
 
 #include "chrome/renderer/extensions/extension_localization_peer.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -76,6 +77,26 @@ void ExtensionLocalizationPeer::OnStartLoadingResponseBody(
     mojo::ScopedDataPipeConsumerHandle body) {
   data_pipe_state_.body_state_ = DataPipeState::BodyState::kReadingBody;
   data_pipe_state_.source_handle_ = std::move(body);
+
+  mojo::ScopedDataPipeConsumerHandle consumer_to_send;
+  MojoResult result = mojo::CreateDataPipe(
+      nullptr, data_pipe_state_.destination_handle_, consumer_to_send);
+  if (result != MOJO_RESULT_OK) {
+    AbortBody(net::ERR_INSUFFICIENT_RESOURCES);
+    return;
+  }
+
+  // The body is streamed, so the original peer can start reading it right
+  // away.
+  original_peer_->OnReceivedResponse(std::move(response_head_));
+  original_peer_->OnStartLoadingResponseBody(std::move(consumer_to_send));
+
+  data_pipe_state_.destination_watcher_.Watch(
+      data_pipe_state_.destination_handle_.get(),
+      MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
+      MOJO_TRIGGER_CONDITION_SIGNALS_SATISFIED,
+      base::BindRepeating(&ExtensionLocalizationPeer::OnWritableBody,
+                          base::Unretained(this)));
   data_pipe_state_.source_watcher_.Watch(
       data_pipe_state_.source_handle_.get(),
       MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
@@ -122,6 +143,8 @@ void ExtensionLocalizationPeer::OnReadableBody(
   DCHECK(data_pipe_state_.source_handle_.is_valid());
   DCHECK_EQ(DataPipeState::BodyState::kReadingBody,
             data_pipe_state_.body_state_);
+  // Reading resumes once the destination took the previous data.
+  DCHECK(output_data_.empty());
 
   const void* buffer;
   uint32_t read_bytes = 0;
@@ -136,114 +159,134 @@ void ExtensionLocalizationPeer::OnReadableBody(
   if (result == MOJO_RESULT_FAILED_PRECONDITION) {
     data_pipe_state_.source_watcher_.Cancel();
     data_pipe_state_.source_handle_.reset();
-    StartSendingBody();
+    data_pipe_state_.body_state_ = DataPipeState::BodyState::kSendingBody;
+    ProcessPendingData(/*end_of_body=*/true);
+    SendOutputData();
     return;
   }
 
   if (result != MOJO_RESULT_OK) {
     // Something went wrong.
-    data_pipe_state_.source_watcher_.Cancel();
-    data_pipe_state_.source_handle_.reset();
-    completion_status_ = network::URLLoaderCompletionStatus(net::ERR_FAILED);
-    data_pipe_state_.body_state_ = DataPipeState::BodyState::kDone;
-    CompleteRequest();
+    AbortBody(net::ERR_FAILED);
     return;
   }
 
-  data_.append(static_cast<const char*>(buffer), read_bytes);
+  base::StringPiece chunk(static_cast<const char*>(buffer), read_bytes);
+  bool written = true;
+  if (pending_data_.empty() && !NeedsReplacement(chunk)) {
+    // Nothing to replace: write the chunk straight from the source pipe.
+    written = WriteData(chunk);
+  } else {
+    pending_data_.append(chunk.data(), chunk.size());
+    ProcessPendingData(/*end_of_body=*/false);
+  }
 
   result = data_pipe_state_.source_handle_->EndReadData(read_bytes);
   DCHECK_EQ(MOJO_RESULT_OK, result);
-  data_pipe_state_.source_watcher_.ArmOrNotify();
-}
-
-void ExtensionLocalizationPeer::StartSendingBody() {
-  DCHECK(!data_pipe_state_.source_handle_.is_valid());
-  DCHECK_EQ(DataPipeState::BodyState::kReadingBody,
-            data_pipe_state_.body_state_);
-
-  data_pipe_state_.body_state_ = DataPipeState::BodyState::kSendingBody;
 
-  ReplaceMessages();
-
-  mojo::ScopedDataPipeConsumerHandle consumer_to_send;
-  MojoResult result = mojo::CreateDataPipe(
-      nullptr, data_pipe_state_.destination_handle_, consumer_to_send);
-  if (result != MOJO_RESULT_OK) {
-    completion_status_ =
-        network::URLLoaderCompletionStatus(net::ERR_INSUFFICIENT_RESOURCES);
-    data_pipe_state_.body_state_ = DataPipeState::BodyState::kDone;
-    CompleteRequest();
+  if (!written) {
+    AbortBody(net::ERR_FAILED);
     return;
   }
-
-  original_peer_->OnReceivedResponse(std::move(response_head_));
-  original_peer_->OnStartLoadingResponseBody(std::move(consumer_to_send));
-
-  data_pipe_state_.destination_watcher_.Watch(
-      data_pipe_state_.destination_handle_.get(),
-      MOJO_HANDLE_SIGNAL_WRITABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
-      MOJO_TRIGGER_CONDITION_SIGNALS_SATISFIED,
-      base::BindRepeating(&ExtensionLocalizationPeer::OnWritableBody,
-                          base::Unretained(this)));
-  data_pipe_state_.destination_watcher_.ArmOrNotify();
+  SendOutputData();
 }
 
 void ExtensionLocalizationPeer::OnWritableBody(
     MojoResult,
     const mojo::HandleSignalsState&) {
   DCHECK(data_pipe_state_.destination_handle_.is_valid());
-  DCHECK_EQ(DataPipeState::BodyState::kSendingBody,
-            data_pipe_state_.body_state_);
+  DCHECK_NE(DataPipeState::BodyState::kDone, data_pipe_state_.body_state_);
+  SendOutputData();
+}
 
-  uint32_t available = data_.size() - data_pipe_state_.sent_in_bytes_;
-  MojoResult result = data_pipe_state_.destination_handle_->WriteData(
-      data_.data() + data_pipe_state_.sent_in_bytes_, &available,
-      MOJO_WRITE_DATA_FLAG_NONE);
-  if (result == MOJO_RESULT_SHOULD_WAIT) {
-    data_pipe_state_.destination_watcher_.ArmOrNotify();
-    return;
+// static
+size_t ExtensionLocalizationPeer::GetIncompleteTemplateOffset(
+    base::StringPiece text) {
+  // A template is "__MSG_" followed by a valid message name and "__". A
+  // message name is made of ASCII letters, digits, '_' and '@', so the
+  // template is complete at the first "__" after "__MSG_", and there is no
+  // template if another character comes first. Only the last "__MSG_" can be
+  // incomplete, as any earlier one ends at the latest at its "__".
+  static constexpr base::StringPiece kMessageBegin = "__MSG_";
+  const size_t begin = text.rfind(kMessageBegin);
+  if (begin != base::StringPiece::npos) {
+    bool complete = false;
+    for (size_t i = begin + kMessageBegin.size(); i < text.size(); ++i) {
+      const char c = text[i];
+      if (!base::IsAsciiAlpha(c) && !base::IsAsciiDigit(c) && c != '_' &&
+          c != '@') {
+        complete = true;
+        break;
+      }
+      if (c == '_' && i + 1 < text.size() && text[i + 1] == '_') {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete)
+      return begin;
   }
 
-  if (result != MOJO_RESULT_OK) {
-    // The pipe is closed on the receiver side.
-    data_ = std::string();
-    data_pipe_state_.destination_watcher_.Cancel();
-    data_pipe_state_.destination_handle_.reset();
-    data_pipe_state_.body_state_ = DataPipeState::BodyState::kDone;
-    completion_status_ = network::URLLoaderCompletionStatus(net::ERR_FAILED);
-    CompleteRequest();
-    return;
+  // The text may end with the start of "__MSG_".
+  for (size_t length = std::min(text.size(), kMessageBegin.size() - 1);
+       length > 0; --length) {
+    if (text.ends_with(kMessageBegin.substr(0, length)))
+      return text.size() - length;
   }
+  return text.size();
+}
 
-  data_pipe_state_.sent_in_bytes_ += available;
+bool ExtensionLocalizationPeer::NeedsReplacement(
+    base::StringPiece chunk) const {
+  if (!message_sender_ || !request_url_.is_valid() || replacement_stopped_)
+    return false;
+  return chunk.find("__MSG_") != base::StringPiece::npos ||
+         GetIncompleteTemplateOffset(chunk) != chunk.size();
+}
 
-  if (data_pipe_state_.sent_in_bytes_ == data_.size()) {
-    // We sent all of the data.
-    data_ = std::string();
-    data_pipe_state_.destination_watcher_.Cancel();
-    data_pipe_state_.destination_handle_.reset();
-    data_pipe_state_.body_state_ = DataPipeState::BodyState::kDone;
-    if (completion_status_.has_value())
-      CompleteRequest();
+void ExtensionLocalizationPeer::ProcessPendingData(bool end_of_body) {
+  const size_t length = end_of_body
+                            ? pending_data_.size()
+                            : GetIncompleteTemplateOffset(pending_data_);
+  if (length == 0)
     return;
+
+  std::string text;
+  if (length == pending_data_.size()) {
+    text.swap(pending_data_);
+  } else {
+    text.assign(pending_data_, 0, length);
+    pending_data_.erase(0, length);
   }
+  ReplaceMessages(&text);
 
-  // Wait until the pipe is ready to send the next chunk of data.
-  data_pipe_state_.destination_watcher_.ArmOrNotify();
+  if (output_data_.empty()) {
+    output_data_.swap(text);
+    output_data_offset_ = 0;
+  } else {
+    output_data_.append(text);
+  }
 }
 
-void ExtensionLocalizationPeer::ReplaceMessages() {
-  if (!message_sender_ || data_.empty())
+void ExtensionLocalizationPeer::ReplaceMessages(std::string* text) {
+  if (!message_sender_ || replacement_stopped_)
     return;
 
   if (!request_url_.is_valid())
     return;
 
+  // Only ask the browser for the catalogs if there is something to replace.
+  if (text->find("__MSG_") == std::string::npos)
+    return;
+
   std::string extension_id = request_url_.host();
   extensions::L10nMessagesMap* l10n_messages =
       extensions::GetL10nMessagesMap(extension_id);
   if (!l10n_messages) {
+    if (requested_messages_)
+      return;
+    requested_messages_ = true;
+
     extensions::L10nMessagesMap messages;
     message_sender_->Send(new ExtensionHostMsg_GetMessageBundle(
         extension_id, &messages));
@@ -258,12 +301,79 @@ void ExtensionLocalizationPeer::ReplaceMessages() {
   }
 
   std::string error;
-  if (extensions::MessageBundle::ReplaceMessagesWithExternalDictionary(
-          *l10n_messages, &data_, &error)) {
-    data_.resize(data_.size());
+  if (!extensions::MessageBundle::ReplaceMessagesWithExternalDictionary(
+          *l10n_messages, text, &error)) {
+    replacement_stopped_ = true;
   }
 }
 
+bool ExtensionLocalizationPeer::WriteData(base::StringPiece data) {
+  DCHECK(output_data_.empty());
+  uint32_t written = data.size();
+  MojoResult result = data_pipe_state_.destination_handle_->WriteData(
+      data.data(), &written, MOJO_WRITE_DATA_FLAG_NONE);
+  if (result == MOJO_RESULT_SHOULD_WAIT)
+    written = 0;
+  else if (result != MOJO_RESULT_OK)
+    return false;
+
+  if (written < data.size()) {
+    output_data_.assign(data.data() + written, data.size() - written);
+    output_data_offset_ = 0;
+  }
+  return true;
+}
+
+void ExtensionLocalizationPeer::SendOutputData() {
+  while (output_data_offset_ < output_data_.size()) {
+    uint32_t available = output_data_.size() - output_data_offset_;
+    MojoResult result = data_pipe_state_.destination_handle_->WriteData(
+        output_data_.data() + output_data_offset_, &available,
+        MOJO_WRITE_DATA_FLAG_NONE);
+    if (result == MOJO_RESULT_SHOULD_WAIT) {
+      // Wait until the pipe is ready to send the next chunk of data.
+      data_pipe_state_.destination_watcher_.ArmOrNotify();
+      return;
+    }
+    if (result != MOJO_RESULT_OK) {
+      // The pipe is closed on the receiver side.
+      AbortBody(net::ERR_FAILED);
+      return;
+    }
+    output_data_offset_ += available;
+  }
+  output_data_.clear();
+  output_data_offset_ = 0;
+
+  if (data_pipe_state_.body_state_ == DataPipeState::BodyState::kReadingBody) {
+    data_pipe_state_.source_watcher_.ArmOrNotify();
+    return;
+  }
+
+  // We sent all of the data.
+  DCHECK_EQ(DataPipeState::BodyState::kSendingBody,
+            data_pipe_state_.body_state_);
+  DCHECK(pending_data_.empty());
+  data_pipe_state_.destination_watcher_.Cancel();
+  data_pipe_state_.destination_handle_.reset();
+  data_pipe_state_.body_state_ = DataPipeState::BodyState::kDone;
+  if (completion_status_.has_value())
+    CompleteRequest();
+}
+
+void ExtensionLocalizationPeer::AbortBody(int error_code) {
+  data_pipe_state_.source_watcher_.Cancel();
+  data_pipe_state_.source_handle_.reset();
+  data_pipe_state_.destination_watcher_.Cancel();
+  data_pipe_state_.destination_handle_.reset();
+  data_pipe_state_.body_state_ = DataPipeState::BodyState::kDone;
+  pending_data_ = std::string();
+  output_data_ = std::string();
+  output_data_offset_ = 0;
+  completion_status_ = network::URLLoaderCompletionStatus(error_code);
+  CompleteRequest();
+}
+
 void ExtensionLocalizationPeer::CompleteRequest() {
   DCHECK(completion_status_.has_value());
   // Body should have been sent to the origial peer at this point when it's
@@ -11,6 +11,7 @@
 #include <string>
 
 #include "base/macros.h"
+#include "base/strings/string_piece.h"
 #include "mojo/public/cpp/system/data_pipe.h"
 #include "mojo/public/cpp/system/simple_watcher.h"
 #include "services/network/public/cpp/url_loader_completion_status.h"
@@ -32,11 +33,13 @@ class Sender;
 //
 // The main flow of method calls is like this:
 // 1.   OnReceivedResponse() when the response header is ready.
-// 2-a. OnStartLoadingResponseBody() when the body streaming starts. It starts
-//      to read the body from the data pipe. After finishing to read the whole
-//      body, this class replaces the body using the message catalogs, sends the
-//      response header, sends a data pipe to the original peer, and starts to
-//      send the body over the data pipe.
+// 2-a. OnStartLoadingResponseBody() when the body streaming starts. It sends
+//      the response header and a data pipe to the original peer, and then
+//      streams the body from one data pipe to the other. Chunks without
+//      templates are written through as they are. Text which may contain a
+//      template, including one split across chunks, is buffered until the
+//      template is complete, and the templates are replaced using the message
+//      catalogs before the text is sent.
 // 2-b. OnCompletedRequest() when the final status is available. The status code
 //      is stored as a member.
 // 3.   CompleteRequest() when both of 2-a and 2-b finish. Sends the stored
@@ -73,12 +76,37 @@ class ExtensionLocalizationPeer : public blink::WebRequestPeer {
                             const GURL& request_url);
 
   void OnReadableBody(MojoResult, const mojo::HandleSignalsState&);
-  void StartSendingBody();
   void OnWritableBody(MojoResult, const mojo::HandleSignalsState&);
 
+  // Returns the offset from which |text| may be the start of a template that
+  // continues in the following data, or the size of |text| if there is none.
+  static size_t GetIncompleteTemplateOffset(base::StringPiece text);
+
+  // Returns true if |chunk| has to go through |pending_data_| before it is
+  // sent.
+  bool NeedsReplacement(base::StringPiece chunk) const;
+
+  // Moves the text of |pending_data_| in which all templates are complete to
+  // |output_data_|, replacing the templates. At the end of the body, all of
+  // |pending_data_| is moved.
+  void ProcessPendingData(bool end_of_body);
+
   // Loads message catalogs, and replaces all __MSG_some_name__ templates within
-  // loaded file.
-  void ReplaceMessages();
+  // |text|. Once a template can't be replaced, the rest of the body is left
+  // as is.
+  void ReplaceMessages(std::string* text);
+
+  // Writes |data| to the destination, and keeps what doesn't fit in
+  // |output_data_|. Returns false if the destination is closed.
+  bool WriteData(base::StringPiece data);
+
+  // Writes |output_data_| to the destination, then continues reading the
+  // body, or finishes it.
+  void SendOutputData();
+
+  // Stops streaming the body after an error, and completes the request with
+  // |error_code|.
+  void AbortBody(int error_code);
 
   void CompleteRequest();
 
@@ -105,16 +133,14 @@ class ExtensionLocalizationPeer : public blink::WebRequestPeer {
     mojo::ScopedDataPipeProducerHandle destination_handle_;
     mojo::SimpleWatcher destination_watcher_;
 
-    // Size sent to the destination.
-    size_t sent_in_bytes_ = 0;
-
     // Shows the state of streaming the body to the |original_peer_|.
     enum class BodyState {
       // Before getting |source_handle_|.
       kInitial,
-      // Reading the body from |source_handle_|.
+      // Reading the body from |source_handle_|, and sending it via
+      // |destination_handle_|.
       kReadingBody,
-      // Sending the body via |destination_handle_|.
+      // Read all the body, sending the rest of it via |destination_handle_|.
       kSendingBody,
       // Sent all the body to |destination_handle_|.
       kDone
@@ -132,8 +158,21 @@ class ExtensionLocalizationPeer : public blink::WebRequestPeer {
   // message catalog.
   IPC::Sender* message_sender_;
 
-  // Buffer for incoming data. We wait until OnCompletedRequest before using it.
-  std::string data_;
+  // Incoming data which may end with an incomplete template.
+  std::string pending_data_;
+
+  // Data waiting for space in the destination data pipe, from
+  // |output_data_offset_| on. The body is not read while there is some.
+  std::string output_data_;
+  size_t output_data_offset_ = 0;
+
+  // Set once a template could not be replaced. The rest of the body is sent
+  // as is, like MessageBundle leaves the text after such a template.
+  bool replacement_stopped_ = false;
+
+  // Whether the message catalogs were requested from the browser for this
+  // request.
+  bool requested_messages_ = false;
 
   // Original request URL.
   GURL request_url_;
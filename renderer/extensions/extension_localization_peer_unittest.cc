@@ -9,6 +9,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/macros.h"
@@ -42,6 +43,12 @@ static const char* const kExtensionUrl_2 =
 static const char* const kExtensionUrl_3 =
     "chrome-extension://some_id3/popup.css";
 
+static const char* const kExtensionUrl_4 =
+    "chrome-extension://some_id4/popup.css";
+
+static const char* const kExtensionUrl_5 =
+    "chrome-extension://some_id5/popup.css";
+
 void MessageDeleter(IPC::Message* message) {
   delete message;
 }
@@ -150,8 +157,6 @@ class ExtensionLocalizationPeerTest : public testing::Test {
         static_cast<ExtensionLocalizationPeer*>(peer.get()));
   }
 
-  std::string GetData() { return filter_peer_->data_; }
-
   void SetData(const std::string& data) {
     MojoCreateDataPipeOptions options;
     options.struct_size = sizeof(MojoCreateDataPipeOptions);
@@ -167,6 +172,21 @@ class ExtensionLocalizationPeerTest : public testing::Test {
     producer.reset();
   }
 
+  // Writes |chunks| one at a time, letting the peer process each of them
+  // before the next one is written.
+  void SetDataInChunks(const std::vector<std::string>& chunks) {
+    mojo::ScopedDataPipeProducerHandle producer;
+    mojo::ScopedDataPipeConsumerHandle consumer;
+    MojoResult result = mojo::CreateDataPipe(nullptr, producer, consumer);
+    EXPECT_EQ(MOJO_RESULT_OK, result);
+    filter_peer_->OnStartLoadingResponseBody(std::move(consumer));
+    for (const std::string& chunk : chunks) {
+      mojo::BlockingCopyFromString(chunk, producer);
+      base::RunLoop().RunUntilIdle();
+    }
+    producer.reset();
+  }
+
   mojo::ScopedDataPipeConsumerHandle CreateEmptyBodyDataPipe() const {
     mojo::ScopedDataPipeConsumerHandle consumer;
     mojo::ScopedDataPipeProducerHandle producer;
@@ -223,7 +243,7 @@ TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestEmptyData) {
 TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestNoCatalogs) {
   SetUpExtensionLocalizationPeer("text/css", GURL(kExtensionUrl_1));
 
-  const std::string kExpectedData = "some text";
+  const std::string kExpectedData = "some __MSG_text__";
   EXPECT_CALL(*sender_, Send(_));
 
   EXPECT_CALL(*original_peer_, OnReceivedResponse(_)).Times(1);
@@ -246,6 +266,23 @@ TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestNoCatalogs) {
   original_peer_->RunUntilBodyBecomesReady();
 }
 
+TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestNoTemplates) {
+  SetUpExtensionLocalizationPeer("text/css", GURL(kExtensionUrl_4));
+
+  // The catalogs are not needed, so Send is skipped.
+  const std::string kExpectedData = "some text with __underscores__";
+  EXPECT_CALL(*sender_, Send(_)).Times(0);
+
+  EXPECT_CALL(*original_peer_, OnReceivedResponse(_));
+  EXPECT_CALL(*original_peer_, OnReceivedDataInternal(kExpectedData));
+  network::URLLoaderCompletionStatus status(net::OK);
+  EXPECT_CALL(*original_peer_, OnCompletedRequest(status));
+
+  SetData(kExpectedData);
+  filter_peer_->OnCompletedRequest(status);
+  original_peer_->RunUntilBodyBecomesReady();
+}
+
 TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestWithCatalogs) {
   SetUpExtensionLocalizationPeer("text/css", GURL(kExtensionUrl_2));
 
@@ -296,3 +333,27 @@ TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestReplaceMessagesFails) {
   filter_peer_->OnCompletedRequest(status);
   original_peer_->RunUntilBodyBecomesReady();
 }
+
+TEST_F(ExtensionLocalizationPeerTest, OnCompletedRequestTemplateAcrossChunks) {
+  SetUpExtensionLocalizationPeer("text/css", GURL(kExtensionUrl_5));
+
+  extensions::L10nMessagesMap messages;
+  messages.insert(std::make_pair("text", "new text"));
+  extensions::ExtensionToL10nMessagesMap& l10n_messages_map =
+      *extensions::GetExtensionToL10nMessagesMap();
+  l10n_messages_map["some_id5"] = messages;
+
+  EXPECT_CALL(*sender_, Send(_)).Times(0);
+
+  // The template is replaced although no chunk holds all of it.
+  EXPECT_CALL(*original_peer_, OnReceivedResponse(_));
+  EXPECT_CALL(*original_peer_,
+              OnReceivedDataInternal("a { } some new text __ end _"));
+
+  network::URLLoaderCompletionStatus status(net::OK);
+  EXPECT_CALL(*original_peer_, OnCompletedRequest(status));
+
+  SetDataInChunks({"a { } some _", "_MS", "G_te", "xt__ __", " end _"});
+  filter_peer_->OnCompletedRequest(status);
+  original_peer_->RunUntilBodyBecomesReady();
+}
@@ -0,0 +1,177 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/subresource_redirect/robots_rules_matcher.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check_op.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+
+namespace subresource_redirect {
+
+RobotsRulesMatcher::CompiledRule::CompiledRule() = default;
+RobotsRulesMatcher::CompiledRule::CompiledRule(CompiledRule&& other) = default;
+RobotsRulesMatcher::CompiledRule& RobotsRulesMatcher::CompiledRule::operator=(
+    CompiledRule&& other) = default;
+RobotsRulesMatcher::CompiledRule::~CompiledRule() = default;
+
+RobotsRulesMatcher::TrieNode::TrieNode() = default;
+RobotsRulesMatcher::TrieNode::TrieNode(TrieNode&& other) = default;
+RobotsRulesMatcher::TrieNode& RobotsRulesMatcher::TrieNode::operator=(
+    TrieNode&& other) = default;
+RobotsRulesMatcher::TrieNode::~TrieNode() = default;
+
+RobotsRulesMatcher::RobotsRulesMatcher(const std::vector<Rule>& rules) {
+  rules_.reserve(rules.size());
+  trie_.emplace_back();
+  for (const Rule& rule : rules) {
+    base::StringPiece pattern(rule.pattern);
+    CompiledRule compiled;
+    compiled.is_allow_rule = rule.is_allow_rule;
+    if (!pattern.empty() && pattern.back() == '$') {
+      compiled.anchored_at_end = true;
+      pattern.remove_suffix(1);
+    }
+
+    // A '$' before the end of the pattern is a literal character.
+    const size_t star = pattern.find('*');
+    const base::StringPiece prefix = pattern.substr(0, star);
+    compiled.prefix_length = prefix.size();
+    if (star != base::StringPiece::npos) {
+      compiled.has_wildcard = true;
+      base::StringPiece rest = pattern.substr(star + 1);
+      while (true) {
+        const size_t next_star = rest.find('*');
+        compiled.segments.push_back(rest.substr(0, next_star).as_string());
+        if (next_star == base::StringPiece::npos)
+          break;
+        rest = rest.substr(next_star + 1);
+      }
+    }
+
+    uint32_t node = 0;
+    for (char c : prefix) {
+      auto it = trie_[node].children.find(c);
+      if (it != trie_[node].children.end()) {
+        node = it->second;
+        continue;
+      }
+      const uint32_t child = static_cast<uint32_t>(trie_.size());
+      trie_[node].children.emplace(c, child);
+      trie_.emplace_back();
+      node = child;
+    }
+    trie_[node].rules.push_back(static_cast<uint32_t>(rules_.size()));
+    rules_.push_back(std::move(compiled));
+  }
+}
+
+RobotsRulesMatcher::~RobotsRulesMatcher() = default;
+
+base::Optional<bool> RobotsRulesMatcher::Match(const std::string& path) const {
+  // Collect the rules whose literal prefix is a prefix of |path|. Each trie
+  // node lists its rules in increasing order.
+  std::vector<uint32_t> candidates;
+  uint32_t node = 0;
+  size_t depth = 0;
+  while (true) {
+    const TrieNode& trie_node = trie_[node];
+    candidates.insert(candidates.end(), trie_node.rules.begin(),
+                      trie_node.rules.end());
+    if (depth == path.size())
+      break;
+    auto it = trie_node.children.find(path[depth]);
+    if (it == trie_node.children.end())
+      break;
+    node = it->second;
+    ++depth;
+  }
+
+  // The rules are ordered, and the first one which matches wins.
+  std::sort(candidates.begin(), candidates.end());
+  for (uint32_t index : candidates) {
+    const CompiledRule& rule = rules_[index];
+    if (MatchesSuffix(path, rule))
+      return rule.is_allow_rule;
+  }
+  return base::nullopt;
+}
+
+// static
+bool RobotsRulesMatcher::MatchesSuffix(const std::string& path,
+                                       const CompiledRule& rule) {
+  DCHECK_LE(rule.prefix_length, path.size());
+  if (!rule.has_wildcard) {
+    return !rule.anchored_at_end || rule.prefix_length == path.size();
+  }
+
+  // Each '*' matches any run of characters, so matching every segment at its
+  // leftmost possible position leaves the most room for the following ones.
+  const base::StringPiece text(path);
+  size_t position = rule.prefix_length;
+  const size_t last = rule.segments.size() - 1;
+  for (size_t i = 0; i < last; ++i) {
+    const size_t found = text.find(rule.segments[i], position);
+    if (found == base::StringPiece::npos)
+      return false;
+    position = found + rule.segments[i].size();
+  }
+
+  const std::string& last_segment = rule.segments[last];
+  if (!rule.anchored_at_end)
+    return text.find(last_segment, position) != base::StringPiece::npos;
+  return text.size() - position >= last_segment.size() &&
+         base::EndsWith(text, last_segment);
+}
+
+// Algorithm taken from
+// https://github.com/google/robotstxt/blob/f465f0ede81099dd8bc4aeb2966b3a892bd488b3/robots.cc#L74
+// static
+bool RobotsRulesMatcher::MatchesPattern(const std::string& path,
+                                        const std::string& pattern) {
+  // Fast path return when pattern is a simple string and not a regex.
+  if (pattern.find('*') == std::string::npos &&
+      pattern.find('$') == std::string::npos) {
+    return base::StartsWith(path, pattern);
+  }
+
+  size_t numpos = 1;
+  std::vector<size_t> pos(path.length() + 1, 0);
+
+  // The pos[] array holds a sorted list of indexes of 'path', with length
+  // 'numpos'.  At the start and end of each iteration of the main loop below,
+  // the pos[] array will hold a list of the prefixes of the 'path' which can
+  // match the current prefix of 'pattern'. If this list is ever empty,
+  // return false. If we reach the end of 'pattern' with at least one element
+  // in pos[], return true.
+
+  for (auto pat = pattern.begin(); pat != pattern.end(); ++pat) {
+    if (*pat == '$' && pat + 1 == pattern.end()) {
+      return (pos[numpos - 1] == path.length());
+    }
+    if (*pat == '*') {
+      numpos = path.length() - pos[0] + 1;
+      for (size_t i = 1; i < numpos; i++) {
+        pos[i] = pos[i - 1] + 1;
+      }
+    } else {
+      // Includes '$' when not at end of pattern.
+      size_t newnumpos = 0;
+      for (size_t i = 0; i < numpos; i++) {
+        if (pos[i] < path.length() && path[pos[i]] == *pat) {
+          pos[newnumpos++] = pos[i] + 1;
+        }
+      }
+      numpos = newnumpos;
+      if (numpos == 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace subresource_redirect
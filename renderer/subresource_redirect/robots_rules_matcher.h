@@ -0,0 +1,93 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_RENDERER_SUBRESOURCE_REDIRECT_ROBOTS_RULES_MATCHER_H_
+#define CHROME_RENDERER_SUBRESOURCE_REDIRECT_ROBOTS_RULES_MATCHER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "base/optional.h"
+
+namespace subresource_redirect {
+
+// Matches URL paths against an ordered list of robots.txt rules, where the
+// first matching rule decides whether the path is allowed. The rules are
+// compiled once: the literal prefix of every pattern, i.e. everything before
+// its first '*' or its terminating '$', is stored in a trie, and the rest of
+// the pattern is split into the literal segments between '*'s. A check walks
+// the trie along the path to find the rules whose literal prefix matches, and
+// only evaluates the wildcard segments of those rules, in rule order, stopping
+// at the first match.
+class RobotsRulesMatcher {
+ public:
+  struct Rule {
+    bool is_allow_rule;
+    std::string pattern;
+  };
+
+  explicit RobotsRulesMatcher(const std::vector<Rule>& rules);
+  ~RobotsRulesMatcher();
+
+  RobotsRulesMatcher(const RobotsRulesMatcher&) = delete;
+  RobotsRulesMatcher& operator=(const RobotsRulesMatcher&) = delete;
+
+  // Returns whether the first rule matching |path| is an allow rule, or
+  // base::nullopt if no rule matches.
+  base::Optional<bool> Match(const std::string& path) const;
+
+  size_t rule_count() const { return rules_.size(); }
+
+  // Returns true if |path| matches |pattern|. Pattern is anchored at the
+  // beginning of path. '$' is special only at the end of pattern. This is the
+  // reference backtracking matcher which the compiled rules are equivalent to.
+  static bool MatchesPattern(const std::string& path,
+                             const std::string& pattern);
+
+ private:
+  struct CompiledRule {
+    CompiledRule();
+    CompiledRule(CompiledRule&& other);
+    CompiledRule& operator=(CompiledRule&& other);
+    ~CompiledRule();
+
+    bool is_allow_rule = false;
+    // Length of the literal prefix, which is matched by the trie.
+    size_t prefix_length = 0;
+    // Whether the pattern continues with a '*' after the literal prefix. If
+    // not, the pattern is either a plain prefix, or a prefix followed by '$'.
+    bool has_wildcard = false;
+    // The literal segments following each '*' of the pattern.
+    std::vector<std::string> segments;
+    // Whether the pattern ends with '$'.
+    bool anchored_at_end = false;
+  };
+
+  struct TrieNode {
+    TrieNode();
+    TrieNode(TrieNode&& other);
+    TrieNode& operator=(TrieNode&& other);
+    ~TrieNode();
+
+    base::flat_map<char, uint32_t> children;
+    // Indices of the rules whose literal prefix ends at this node.
+    std::vector<uint32_t> rules;
+  };
+
+  // Returns true if the part of |path| after the literal prefix matches the
+  // rest of |rule|.
+  static bool MatchesSuffix(const std::string& path, const CompiledRule& rule);
+
+  std::vector<CompiledRule> rules_;
+  // Node 0 is the root, for the empty prefix.
+  std::vector<TrieNode> trie_;
+};
+
+}  // namespace subresource_redirect
+
+#endif  // CHROME_RENDERER_SUBRESOURCE_REDIRECT_ROBOTS_RULES_MATCHER_H_
@@ -0,0 +1,168 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fuzzer/FuzzedDataProvider.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/command_line.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/strings/strcat.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/renderer/subresource_redirect/robots_rules_matcher.h"
+#include "components/subresource_redirect/proto/robots_rules.pb.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "url/gurl.h"
+
+namespace subresource_redirect {
+
+namespace {
+
+// Directory of robots_rules_parser_fuzzer inputs to replay, e.g. a corpus
+// downloaded from ClusterFuzz. When not given, only the synthetic robots file
+// is measured.
+constexpr char kCorpusDirSwitch[] = "corpus-dir";
+
+constexpr char kMetricPrefix[] = "RobotsRulesMatcher.";
+constexpr char kMetricLinearTime[] = "linear_time";
+constexpr char kMetricCompiledTime[] = "compiled_time";
+constexpr char kMetricCompileTime[] = "compile_time";
+
+using Rule = RobotsRulesMatcher::Rule;
+
+struct RobotsCase {
+  std::vector<Rule> rules;
+  std::vector<std::string> paths;
+};
+
+// Parses the rules the same way RobotsRulesParser does.
+std::vector<Rule> ParseRules(const std::string& serialized_rules) {
+  std::vector<Rule> rules;
+  proto::RobotsRules robots_rules;
+  if (!robots_rules.ParseFromString(serialized_rules))
+    return rules;
+  for (const auto& rule : robots_rules.image_ordered_rules()) {
+    if (rule.has_allowed_pattern())
+      rules.push_back({true, rule.allowed_pattern()});
+    else if (rule.has_disallowed_pattern())
+      rules.push_back({false, rule.disallowed_pattern()});
+  }
+  return rules;
+}
+
+std::string GetPathWithQuery(const GURL& url) {
+  std::string path_with_query = url.path();
+  if (url.has_query())
+    base::StrAppend(&path_with_query, {"?", url.query()});
+  return path_with_query;
+}
+
+// Reads the fuzzer inputs in |corpus_dir|, splitting each one into rules and
+// URL exactly like robots_rules_parser_fuzzer.cc does.
+RobotsCase ReadCorpus(const base::FilePath& corpus_dir) {
+  RobotsCase corpus_case;
+  base::FileEnumerator files(corpus_dir, /*recursive=*/false,
+                             base::FileEnumerator::FILES);
+  for (base::FilePath file = files.Next(); !file.empty(); file = files.Next()) {
+    std::string data;
+    if (!base::ReadFileToString(file, &data))
+      continue;
+    FuzzedDataProvider provider(reinterpret_cast<const uint8_t*>(data.data()),
+                                data.size());
+    std::string rules = provider.ConsumeRandomLengthString();
+    std::string url = provider.ConsumeRandomLengthString();
+    for (Rule& rule : ParseRules(rules))
+      corpus_case.rules.push_back(std::move(rule));
+    corpus_case.paths.push_back(GetPathWithQuery(GURL(url)));
+  }
+  return corpus_case;
+}
+
+// A large robots file in the shape of those of image heavy sites: mostly
+// literal directory rules, some wildcard rules, and image paths which mostly
+// fall through to the broad rules at the end.
+RobotsCase CreateSyntheticCase() {
+  RobotsCase synthetic_case;
+  for (int i = 0; i < 400; ++i) {
+    synthetic_case.rules.push_back(
+        {i % 3 == 0, base::StringPrintf("/section%d/private/", i)});
+  }
+  for (int i = 0; i < 100; ++i) {
+    synthetic_case.rules.push_back(
+        {false, base::StringPrintf("/*/tmp%d/*.jpg$", i)});
+  }
+  synthetic_case.rules.push_back({false, "/*?*sessionid="});
+  synthetic_case.rules.push_back({true, "/"});
+  for (int i = 0; i < 1000; ++i) {
+    synthetic_case.paths.push_back(base::StringPrintf(
+        "/section%d/images/photo%d.jpg?w=%d", i % 500, i, 100 + i % 7));
+  }
+  return synthetic_case;
+}
+
+base::Optional<bool> MatchLinearly(const std::vector<Rule>& rules,
+                                   const std::string& path) {
+  for (const Rule& rule : rules) {
+    if (RobotsRulesMatcher::MatchesPattern(path, rule.pattern))
+      return rule.is_allow_rule;
+  }
+  return base::nullopt;
+}
+
+void RunBenchmark(const std::string& story, const RobotsCase& robots_case) {
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story);
+  reporter.RegisterImportantMetric(kMetricLinearTime, "ms");
+  reporter.RegisterImportantMetric(kMetricCompiledTime, "ms");
+  reporter.RegisterImportantMetric(kMetricCompileTime, "ms");
+
+  std::vector<base::Optional<bool>> linear_results;
+  linear_results.reserve(robots_case.paths.size());
+  base::ElapsedTimer linear_timer;
+  for (const std::string& path : robots_case.paths)
+    linear_results.push_back(MatchLinearly(robots_case.rules, path));
+  reporter.AddResult(kMetricLinearTime, linear_timer.Elapsed());
+
+  base::ElapsedTimer compile_timer;
+  RobotsRulesMatcher matcher(robots_case.rules);
+  reporter.AddResult(kMetricCompileTime, compile_timer.Elapsed());
+
+  std::vector<base::Optional<bool>> compiled_results;
+  compiled_results.reserve(robots_case.paths.size());
+  base::ElapsedTimer compiled_timer;
+  for (const std::string& path : robots_case.paths)
+    compiled_results.push_back(matcher.Match(path));
+  reporter.AddResult(kMetricCompiledTime, compiled_timer.Elapsed());
+
+  EXPECT_EQ(linear_results, compiled_results);
+}
+
+}  // namespace
+
+TEST(RobotsRulesMatcherPerfTest, SyntheticImageHeavySite) {
+  RunBenchmark("synthetic_502_rules_1000_paths", CreateSyntheticCase());
+}
+
+// Replays the fuzzer corpus, matching every URL in it against all the rules in
+// it, so that the odd patterns fuzzing found are part of the comparison.
+TEST(RobotsRulesMatcherPerfTest, FuzzerCorpus) {
+  const base::FilePath corpus_dir =
+      base::CommandLine::ForCurrentProcess()->GetSwitchValuePath(
+          kCorpusDirSwitch);
+  if (corpus_dir.empty())
+    return;
+  const RobotsCase corpus_case = ReadCorpus(corpus_dir);
+  RunBenchmark(base::StringPrintf("fuzzer_corpus_%zu_rules_%zu_paths",
+                                  corpus_case.rules.size(),
+                                  corpus_case.paths.size()),
+               corpus_case);
+}
+
+}  // namespace subresource_redirect
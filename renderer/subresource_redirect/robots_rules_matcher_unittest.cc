@@ -0,0 +1,106 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/subresource_redirect/robots_rules_matcher.h"
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace subresource_redirect {
+
+namespace {
+
+using Rule = RobotsRulesMatcher::Rule;
+
+// Returns the result of checking |path| against |rules| one by one with the
+// reference matcher.
+base::Optional<bool> MatchLinearly(const std::vector<Rule>& rules,
+                                   const std::string& path) {
+  for (const Rule& rule : rules) {
+    if (RobotsRulesMatcher::MatchesPattern(path, rule.pattern))
+      return rule.is_allow_rule;
+  }
+  return base::nullopt;
+}
+
+}  // namespace
+
+TEST(RobotsRulesMatcherTest, NoRules) {
+  RobotsRulesMatcher matcher({});
+  EXPECT_EQ(base::nullopt, matcher.Match(""));
+  EXPECT_EQ(base::nullopt, matcher.Match("/foo.jpg"));
+}
+
+TEST(RobotsRulesMatcherTest, FirstMatchingRuleWins) {
+  RobotsRulesMatcher matcher({{true, "/foo/bar"},
+                              {false, "/foo"},
+                              {true, "*.png$"},
+                              {false, "/"}});
+  EXPECT_EQ(true, matcher.Match("/foo/bar.jpg"));
+  EXPECT_EQ(false, matcher.Match("/foo/baz.jpg"));
+  EXPECT_EQ(false, matcher.Match("/foo.png"));
+  EXPECT_EQ(true, matcher.Match("/bar.png"));
+  EXPECT_EQ(false, matcher.Match("/bar.png?size=2"));
+  EXPECT_EQ(base::nullopt, matcher.Match(""));
+}
+
+TEST(RobotsRulesMatcherTest, Wildcards) {
+  RobotsRulesMatcher matcher({{false, "/a*b*c$"},
+                              {false, "/x*"},
+                              {false, "/lit$eral"},
+                              {false, "$"},
+                              {true, "/end$"}});
+  EXPECT_EQ(false, matcher.Match("/abc"));
+  EXPECT_EQ(false, matcher.Match("/a-b-c-c"));
+  EXPECT_EQ(base::nullopt, matcher.Match("/a-b-c-d"));
+  EXPECT_EQ(base::nullopt, matcher.Match("/ac"));
+  EXPECT_EQ(false, matcher.Match("/x"));
+  EXPECT_EQ(false, matcher.Match("/lit$eral.jpg"));
+  EXPECT_EQ(false, matcher.Match(""));
+  EXPECT_EQ(true, matcher.Match("/end"));
+  EXPECT_EQ(base::nullopt, matcher.Match("/end/"));
+}
+
+// The compiled matcher gives the same result as checking every rule with the
+// reference matcher.
+TEST(RobotsRulesMatcherTest, EquivalentToLinearMatching) {
+  const std::vector<std::string> patterns = {
+      "",      "*",        "$",       "/",          "/$",       "/a",
+      "/a$",   "/a*",      "/a*$",    "/a*b",       "/a*b$",    "*b",
+      "*b$",   "/a$b",     "/a**b",   "*a*a*a",     "/ab*ab$",  "/b/*.jpg",
+      "/*.j*", "/*?*s=1$", "/a*$*$",  "/aa*aa*aa$", "**",       "/a/b/c"};
+  const std::vector<std::string> paths = {
+      "",        "/",      "/a",       "/b",          "/ab",      "/aab",
+      "/abab",   "/a$b",   "/a/b/c",   "/a/b/c/d",    "/b/x.jpg", "/b/x.jpg?",
+      "/aaaaaa", "/aaaaa", "/x.jpg?s=1", "/x.jpg?s=12", "/ba",    "/a*b"};
+
+  // Try every pattern as the first rule, followed by all the others in turn,
+  // alternating allow and disallow.
+  for (size_t first = 0; first < patterns.size(); ++first) {
+    std::vector<Rule> rules;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+      const std::string& pattern = patterns[(first + i) % patterns.size()];
+      rules.push_back({i % 2 == 0, pattern});
+    }
+    RobotsRulesMatcher matcher(rules);
+    for (const std::string& path : paths) {
+      EXPECT_EQ(MatchLinearly(rules, path), matcher.Match(path))
+          << "path: " << path << " first rule: " << patterns[first];
+    }
+  }
+
+  // And each pattern on its own.
+  for (const std::string& pattern : patterns) {
+    RobotsRulesMatcher matcher({{false, pattern}});
+    for (const std::string& path : paths) {
+      EXPECT_EQ(RobotsRulesMatcher::MatchesPattern(path, pattern),
+                matcher.Match(path).has_value())
+          << "path: " << path << " pattern: " << pattern;
+    }
+  }
+}
+
+}  // namespace subresource_redirect
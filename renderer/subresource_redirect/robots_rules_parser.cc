@@ -8,9 +8,9 @@
 #include "base/logging.h"
 #include "base/metrics/histogram_macros.h"
 #include "base/strings/strcat.h"
-#include "base/strings/string_util.h"
 #include "base/time/time.h"
 #include "base/timer/elapsed_timer.h"
+#include "chrome/renderer/subresource_redirect/robots_rules_matcher.h"
 #include "chrome/renderer/subresource_redirect/subresource_redirect_params.h"
 #include "components/subresource_redirect/proto/robots_rules.pb.h"
 
@@ -18,52 +18,6 @@ namespace subresource_redirect {
 
 namespace {
 
-// Returns true if URL path matches the specified pattern. Pattern is anchored
-// at the beginning of path. '$' is special only at the end of pattern.
-// Algorithm taken from
-// https://github.com/google/robotstxt/blob/f465f0ede81099dd8bc4aeb2966b3a892bd488b3/robots.cc#L74
-bool IsMatchingRobotsRule(const std::string& path, const std::string& pattern) {
-  // Fast path return when pattern is a simple string and not a regex.
-  if (pattern.find('*') == std::string::npos &&
-      pattern.find('$') == std::string::npos) {
-    return base::StartsWith(path, pattern);
-  }
-
-  size_t numpos = 1;
-  std::vector<size_t> pos(path.length() + 1, 0);
-
-  // The pos[] array holds a sorted list of indexes of 'path', with length
-  // 'numpos'.  At the start and end of each iteration of the main loop below,
-  // the pos[] array will hold a list of the prefixes of the 'path' which can
-  // match the current prefix of 'pattern'. If this list is ever empty,
-  // return false. If we reach the end of 'pattern' with at least one element
-  // in pos[], return true.
-
-  for (auto pat = pattern.begin(); pat != pattern.end(); ++pat) {
-    if (*pat == '$' && pat + 1 == pattern.end()) {
-      return (pos[numpos - 1] == path.length());
-    }
-    if (*pat == '*') {
-      numpos = path.length() - pos[0] + 1;
-      for (size_t i = 1; i < numpos; i++) {
-        pos[i] = pos[i - 1] + 1;
-      }
-    } else {
-      // Includes '$' when not at end of pattern.
-      size_t newnumpos = 0;
-      for (size_t i = 0; i < numpos; i++) {
-        if (pos[i] < path.length() && path[pos[i]] == *pat) {
-          pos[newnumpos++] = pos[i] + 1;
-        }
-      }
-      numpos = newnumpos;
-      if (numpos == 0)
-        return false;
-    }
-  }
-  return true;
-}
-
 void RecordRobotsRulesReceiveResultHistogram(
     RobotsRulesParser::SubresourceRedirectRobotsRulesReceiveResult result) {
   UMA_HISTOGRAM_ENUMERATION(
@@ -77,12 +31,11 @@ void RecordRobotsRulesApplyDurationHistogram(base::TimeDelta duration) {
 
 }  // namespace
 
-bool RobotsRulesParser::RobotsRule::Match(const std::string& path) const {
-  return IsMatchingRobotsRule(path, pattern_);
-}
+constexpr size_t RobotsRulesParser::kMaxCachedCheckResults;
 
 RobotsRulesParser::RobotsRulesParser(
-    const base::TimeDelta& rules_receive_timeout) {
+    const base::TimeDelta& rules_receive_timeout)
+    : check_results_cache_(kMaxCachedCheckResults) {
   // Using base::Unretained(this) is safe here, since the timer
   // |rules_receive_timeout_timer_| is owned by |this| and destroyed before
   // |this|.
@@ -101,7 +54,8 @@ RobotsRulesParser::~RobotsRulesParser() {
 
 void RobotsRulesParser::UpdateRobotsRules(
     const base::Optional<std::string>& rules) {
-  robots_rules_.clear();
+  robots_rules_matcher_.reset();
+  check_results_cache_.Clear();
   rules_receive_timeout_timer_.Stop();
 
   proto::RobotsRules robots_rules;
@@ -113,16 +67,18 @@ void RobotsRulesParser::UpdateRobotsRules(
   rules_receive_state_ = is_parse_success ? RulesReceiveState::kSuccess
                                           : RulesReceiveState::kParseFailed;
   if (is_parse_success) {
-    robots_rules_.reserve(robots_rules.image_ordered_rules_size());
+    std::vector<RobotsRulesMatcher::Rule> rules_list;
+    rules_list.reserve(robots_rules.image_ordered_rules_size());
     for (const auto& rule : robots_rules.image_ordered_rules()) {
       if (rule.has_allowed_pattern()) {
-        robots_rules_.emplace_back(true, rule.allowed_pattern());
+        rules_list.push_back({true, rule.allowed_pattern()});
       } else if (rule.has_disallowed_pattern()) {
-        robots_rules_.emplace_back(false, rule.disallowed_pattern());
+        rules_list.push_back({false, rule.disallowed_pattern()});
       }
     }
+    robots_rules_matcher_ = std::make_unique<RobotsRulesMatcher>(rules_list);
     UMA_HISTOGRAM_COUNTS_1000("SubresourceRedirect.RobotRulesDecider.Count",
-                              robots_rules_.size());
+                              robots_rules_matcher_->rule_count());
   }
 
   // Respond to the pending requests, even if robots proto parse failed.
@@ -154,25 +110,27 @@ RobotsRulesParser::CheckRobotsRules(int routing_id,
 }
 
 RobotsRulesParser::CheckResult RobotsRulesParser::CheckRobotsRulesImmediate(
-    const std::string& url_path) const {
+    const std::string& url_path) {
   if (rules_receive_state_ == RulesReceiveState::kParseFailed)
     return CheckResult::kDisallowed;
   if (rules_receive_state_ == RulesReceiveState::kTimeout)
     return CheckResult::kDisallowedAfterTimeout;
   DCHECK_EQ(rules_receive_state_, RulesReceiveState::kSuccess);
+  DCHECK(robots_rules_matcher_);
 
   base::ElapsedTimer rules_apply_timer;
-  for (const auto& rule : robots_rules_) {
-    if (rule.Match(url_path)) {
-      RecordRobotsRulesApplyDurationHistogram(rules_apply_timer.Elapsed());
-      return rule.is_allow_rule_ ? CheckResult::kAllowed
-                                 : CheckResult::kDisallowed;
-    }
+  bool is_allowed;
+  auto it = check_results_cache_.Get(url_path);
+  if (it != check_results_cache_.end()) {
+    is_allowed = it->second;
+  } else {
+    // Treat as allowed when none of the allow/disallow rules match.
+    is_allowed = robots_rules_matcher_->Match(url_path).value_or(true);
+    check_results_cache_.Put(url_path, is_allowed);
   }
   RecordRobotsRulesApplyDurationHistogram(rules_apply_timer.Elapsed());
 
-  // Treat as allowed when none of the allow/disallow rules match.
-  return CheckResult::kAllowed;
+  return is_allowed ? CheckResult::kAllowed : CheckResult::kDisallowed;
 }
 
 void RobotsRulesParser::OnRulesReceiveTimeout() {
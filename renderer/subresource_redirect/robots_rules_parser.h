@@ -6,9 +6,12 @@
 #define CHROME_RENDERER_SUBRESOURCE_REDIRECT_ROBOTS_RULES_PARSER_H_
 
 #include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "base/callback_forward.h"
+#include "base/containers/mru_cache.h"
 #include "base/macros.h"
 #include "base/time/time.h"
 #include "base/timer/timer.h"
@@ -16,12 +19,20 @@
 
 namespace subresource_redirect {
 
+class RobotsRulesMatcher;
+
 // Holds the robots rules for a singe origin, and enables checking whether an
 // url path is allowed or disallowed. Also supports a timeout to receive the
 // robots rules after which it will be treated as a full disallow. The check
-// result is delivered via callback asynchronously.
+// result is delivered via callback asynchronously. The rules are compiled into
+// a RobotsRulesMatcher once received, and the results of the most recently
+// checked paths are remembered, since pages often request the same path from
+// several frames or elements.
 class RobotsRulesParser {
  public:
+  // The number of path check results remembered.
+  static constexpr size_t kMaxCachedCheckResults = 128;
+
   // The final result of robots rule retrieval.
   // This should be kept in sync with
   // SubresourceRedirectRobotsRulesReceiveResult in enums.xml.
@@ -92,21 +103,10 @@ class RobotsRulesParser {
  private:
   friend class SubresourceRedirectRobotsRulesParserTest;
 
-  // Contains one robots.txt rule.
-  struct RobotsRule {
-    RobotsRule(bool is_allow_rule, const std::string& pattern)
-        : is_allow_rule_(is_allow_rule), pattern_(pattern) {}
-
-    bool Match(const std::string& path) const;
-
-    const bool is_allow_rule_;
-    const std::string pattern_;
-  };
-
   // Returns the immediate result of whether the URL path is allowed or
   // disallowed by robots rules. Should be called only when rules retrieval
   // state is in a terminal state, i.e., rules receive timer is not running.
-  CheckResult CheckRobotsRulesImmediate(const std::string& url_path) const;
+  CheckResult CheckRobotsRulesImmediate(const std::string& url_path);
 
   // Called on rules receive timeout. All pending checks for robots rules are
   // notified that the timeout expired and the requests known to |this| are
@@ -116,8 +116,13 @@ class RobotsRulesParser {
   // Current state of the rules retrieval.
   RulesReceiveState rules_receive_state_;
 
-  // Ordered list of robots rules from longest to shortest.
-  std::vector<RobotsRule> robots_rules_;
+  // The robots rules, ordered from longest to shortest, compiled for
+  // matching. Null until rules are received and parsed successfully.
+  std::unique_ptr<RobotsRulesMatcher> robots_rules_matcher_;
+
+  // Whether the recently checked URL paths are allowed. Cleared when the rules
+  // change.
+  base::MRUCache<std::string, bool> check_results_cache_;
 
   // Contains the requests that are pending for robots rules to be received,
   // keyed by routing ID. Key is the rouging ID and the value holds the URL path
@@ -417,4 +417,18 @@ TEST_F(SubresourceRedirectRobotsRulesParserTest,
   VerifyTotalRobotsRulesApplyHistograms(4);
 }
 
+TEST_F(SubresourceRedirectRobotsRulesParserTest,
+       RememberedResultsAreDroppedOnRulesUpdate) {
+  SetUpRobotsRules({{kRuleTypeDisallow, "/foo"}});
+  CheckRobotsRules("/foo.jpg", RobotsRulesParser::CheckResult::kDisallowed);
+  CheckRobotsRules("/foo.jpg", RobotsRulesParser::CheckResult::kDisallowed);
+  CheckRobotsRules("/bar.jpg", RobotsRulesParser::CheckResult::kAllowed);
+  VerifyTotalRobotsRulesApplyHistograms(3);
+
+  SetUpRobotsRules({{kRuleTypeAllow, "/foo"}, {kRuleTypeDisallow, "/"}});
+  CheckRobotsRules("/foo.jpg", RobotsRulesParser::CheckResult::kAllowed);
+  CheckRobotsRules("/bar.jpg", RobotsRulesParser::CheckResult::kDisallowed);
+  VerifyTotalRobotsRulesApplyHistograms(5);
+}
+
 }  // namespace subresource_redirect
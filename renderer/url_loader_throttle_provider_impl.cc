@@ -13,6 +13,7 @@
 #include "base/threading/thread_task_runner_handle.h"
 #include "build/build_config.h"
 #include "build/chromeos_buildflags.h"
+#include "chrome/common/chrome_features.h"
 #include "chrome/common/google_url_loader_throttle.h"
 #include "chrome/renderer/chrome_content_renderer_client.h"
 #include "chrome/renderer/chrome_render_frame_observer.h"
@@ -24,6 +25,7 @@
 #include "components/no_state_prefetch/renderer/no_state_prefetch_helper.h"
 #include "components/safe_browsing/content/renderer/renderer_url_loader_throttle.h"
 #include "components/safe_browsing/core/features.h"
+#include "components/subresource_redirect/common/subresource_redirect_features.h"
 #include "content/public/common/content_features.h"
 #include "content/public/renderer/render_frame.h"
 #include "content/public/renderer/render_thread.h"
@@ -46,15 +48,6 @@
 namespace {
 
 #if BUILDFLAG(ENABLE_EXTENSIONS)
-std::unique_ptr<extensions::ExtensionThrottleManager>
-CreateExtensionThrottleManager() {
-  if (base::CommandLine::ForCurrentProcess()->HasSwitch(
-          extensions::switches::kDisableExtensionsHttpThrottling)) {
-    return nullptr;
-  }
-  return std::make_unique<extensions::ExtensionThrottleManager>();
-}
-
 void SetExtensionThrottleManagerTestPolicy(
     extensions::ExtensionThrottleManager* extension_throttle_manager) {
   std::unique_ptr<net::BackoffEntry::Policy> policy(
@@ -85,16 +78,51 @@ void SetExtensionThrottleManagerTestPolicy(
       });
   extension_throttle_manager->SetBackoffPolicyForTests(std::move(policy));
 }
+
+std::unique_ptr<extensions::ExtensionThrottleManager>
+CreateExtensionThrottleManager(bool use_test_policy) {
+  auto extension_throttle_manager =
+      std::make_unique<extensions::ExtensionThrottleManager>();
+  if (use_test_policy)
+    SetExtensionThrottleManagerTestPolicy(extension_throttle_manager.get());
+  return extension_throttle_manager;
+}
 #endif
 
 }  // namespace
 
+URLLoaderThrottleProviderImpl::Config::Config(
+    blink::URLLoaderThrottleProviderType type,
+    ChromeContentRendererClient* chrome_content_renderer_client)
+    : type_(type),
+      chrome_content_renderer_client_(chrome_content_renderer_client),
+#if BUILDFLAG(ENABLE_EXTENSIONS)
+      extension_throttling_enabled_(
+          !base::CommandLine::ForCurrentProcess()->HasSwitch(
+              extensions::switches::kDisableExtensionsHttpThrottling)),
+      use_extension_throttle_test_policy_(
+          base::CommandLine::ForCurrentProcess()->HasSwitch(
+              extensions::switches::kSetExtensionThrottleTestParams)),
+#endif
+      subresource_redirect_enabled_(
+          subresource_redirect::
+              ShouldEnablePublicImageHintsBasedCompression() ||
+          subresource_redirect::
+              ShouldEnableLoginRobotsCheckedImageCompression()),
+      src_video_redirect_enabled_(
+          subresource_redirect::
+              ShouldRecordLoginRobotsCheckedSrcVideoMetrics()),
+      lite_video_enabled_(base::FeatureList::IsEnabled(features::kLiteVideo)) {
+}
+
+URLLoaderThrottleProviderImpl::Config::~Config() = default;
+
 URLLoaderThrottleProviderImpl::URLLoaderThrottleProviderImpl(
     blink::ThreadSafeBrowserInterfaceBrokerProxy* broker,
     blink::URLLoaderThrottleProviderType type,
     ChromeContentRendererClient* chrome_content_renderer_client)
-    : type_(type),
-      chrome_content_renderer_client_(chrome_content_renderer_client) {
+    : config_(base::MakeRefCounted<Config>(type,
+                                           chrome_content_renderer_client)) {
   DETACH_FROM_THREAD(thread_checker_);
   broker->GetInterface(safe_browsing_remote_.InitWithNewPipeAndPassReceiver());
 }
@@ -105,8 +133,7 @@ URLLoaderThrottleProviderImpl::~URLLoaderThrottleProviderImpl() {
 
 URLLoaderThrottleProviderImpl::URLLoaderThrottleProviderImpl(
     const URLLoaderThrottleProviderImpl& other)
-    : type_(other.type_),
-      chrome_content_renderer_client_(other.chrome_content_renderer_client_) {
+    : config_(other.config_) {
   DETACH_FROM_THREAD(thread_checker_);
   if (other.safe_browsing_) {
     other.safe_browsing_->Clone(
@@ -139,9 +166,17 @@ URLLoaderThrottleProviderImpl::CreateThrottles(
   bool is_frame_resource =
       blink::IsRequestDestinationFrame(request_destination);
 
+  const blink::URLLoaderThrottleProviderType type = config_->type();
   DCHECK(!is_frame_resource ||
-         type_ == blink::URLLoaderThrottleProviderType::kFrame);
+         type == blink::URLLoaderThrottleProviderType::kFrame);
 
+  // Most throttles only act on HTTP(S) requests. Others, e.g. for blob: or
+  // chrome-extension: URLs, skip creating them.
+  const GURL url = request.Url();
+  const bool is_http_or_https = url.SchemeIsHTTPOrHTTPS();
+
+  // Safe Browsing decides itself which requests it checks, and it also sees
+  // the redirects of non-HTTP(S) requests, so it throttles every subresource.
   if (!is_frame_resource) {
     if (safe_browsing_remote_)
       safe_browsing_.Bind(std::move(safe_browsing_remote_));
@@ -150,8 +185,10 @@ URLLoaderThrottleProviderImpl::CreateThrottles(
             safe_browsing_.get(), render_frame_id));
   }
 
-  if (type_ == blink::URLLoaderThrottleProviderType::kFrame &&
-      !is_frame_resource) {
+  // NoStatePrefetchHelper looks up the frame of |render_frame_id|, so it never
+  // creates a throttle without one.
+  if (type == blink::URLLoaderThrottleProviderType::kFrame &&
+      !is_frame_resource && render_frame_id != MSG_ROUTING_NONE) {
     auto throttle =
         prerender::NoStatePrefetchHelper::MaybeCreateThrottle(render_frame_id);
     if (throttle)
@@ -159,13 +196,10 @@ URLLoaderThrottleProviderImpl::CreateThrottles(
   }
 
 #if BUILDFLAG(ENABLE_EXTENSIONS)
-  if (!extension_throttle_manager_)
-    extension_throttle_manager_ = CreateExtensionThrottleManager();
-
-  if (extension_throttle_manager_) {
-    if (base::CommandLine::ForCurrentProcess()->HasSwitch(
-            extensions::switches::kSetExtensionThrottleTestParams)) {
-      SetExtensionThrottleManagerTestPolicy(extension_throttle_manager_.get());
+  if (config_->extension_throttling_enabled()) {
+    if (!extension_throttle_manager_) {
+      extension_throttle_manager_ = CreateExtensionThrottleManager(
+          config_->use_extension_throttle_test_policy());
     }
 
     std::unique_ptr<blink::URLLoaderThrottle> throttle =
@@ -175,43 +209,54 @@ URLLoaderThrottleProviderImpl::CreateThrottles(
   }
 #endif
 
+  if (GoogleURLLoaderThrottle::MayAffectRequest(url)) {
 #if defined(OS_ANDROID)
-  std::string client_data_header;
-  if (!is_frame_resource && render_frame_id != MSG_ROUTING_NONE) {
-    client_data_header =
-        ChromeRenderFrameObserver::GetCCTClientHeader(render_frame_id);
-  }
+    std::string client_data_header;
+    if (!is_frame_resource && render_frame_id != MSG_ROUTING_NONE) {
+      client_data_header =
+          ChromeRenderFrameObserver::GetCCTClientHeader(render_frame_id);
+    }
 #endif
 
-  throttles.emplace_back(std::make_unique<GoogleURLLoaderThrottle>(
+    throttles.emplace_back(std::make_unique<GoogleURLLoaderThrottle>(
 #if defined(OS_ANDROID)
-      client_data_header,
-      /* night_mode_enabled= */ false,
-      /* is_tab_large_enough= */ false,
+        std::move(client_data_header),
+        /* night_mode_enabled= */ false,
+        /* is_tab_large_enough= */ false,
 #endif
-      ChromeRenderThreadObserver::GetDynamicParams()));
+        ChromeRenderThreadObserver::GetDynamicParams()));
+  }
 
 #if BUILDFLAG(IS_CHROMEOS_ASH)
   throttles.emplace_back(std::make_unique<MergeSessionLoaderThrottle>(
-      chrome_content_renderer_client_->GetChromeObserver()
+      config_->chrome_content_renderer_client()
+          ->GetChromeObserver()
           ->chromeos_listener()));
 #endif  // BUILDFLAG(IS_CHROMEOS_ASH)
 
-  auto throttle = subresource_redirect::SubresourceRedirectURLLoaderThrottle::
-      MaybeCreateThrottle(request, render_frame_id);
-  if (throttle)
-    throttles.emplace_back(std::move(throttle));
-  auto src_video_redirect_throttle =
-      subresource_redirect::SrcVideoRedirectURLLoaderThrottle::
+  if (is_http_or_https) {
+    if (config_->subresource_redirect_enabled() &&
+        request_destination == network::mojom::RequestDestination::kImage) {
+      auto throttle = subresource_redirect::
+          SubresourceRedirectURLLoaderThrottle::MaybeCreateThrottle(
+              request, render_frame_id);
+      if (throttle)
+        throttles.emplace_back(std::move(throttle));
+    }
+    if (config_->src_video_redirect_enabled() &&
+        request_destination == network::mojom::RequestDestination::kVideo) {
+      auto throttle = subresource_redirect::SrcVideoRedirectURLLoaderThrottle::
           MaybeCreateThrottle(request, render_frame_id);
-  if (src_video_redirect_throttle)
-    throttles.emplace_back(std::move(src_video_redirect_throttle));
-
-  if (render_frame_id != MSG_ROUTING_NONE) {
-    auto throttle = lite_video::LiteVideoURLLoaderThrottle::MaybeCreateThrottle(
-        request, render_frame_id);
-    if (throttle)
-      throttles.emplace_back(std::move(throttle));
+      if (throttle)
+        throttles.emplace_back(std::move(throttle));
+    }
+    if (config_->lite_video_enabled() && render_frame_id != MSG_ROUTING_NONE) {
+      auto throttle =
+          lite_video::LiteVideoURLLoaderThrottle::MaybeCreateThrottle(
+              request, render_frame_id);
+      if (throttle)
+        throttles.emplace_back(std::move(throttle));
+    }
   }
 
   return throttles;
@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
 #include "base/threading/thread_checker.h"
 #include "components/safe_browsing/content/common/safe_browsing.mojom.h"
 #include "extensions/buildflags/buildflags.h"
@@ -26,6 +27,55 @@ class ChromeContentRendererClient;
 // destructed on a single thread, which can be different from the render thread.
 class URLLoaderThrottleProviderImpl : public blink::URLLoaderThrottleProvider {
  public:
+  // The state which doesn't change over the lifetime of a provider. It is
+  // computed once on the render thread, and shared with all the clones of the
+  // provider, which may live on other threads.
+  class Config : public base::RefCountedThreadSafe<Config> {
+   public:
+    Config(blink::URLLoaderThrottleProviderType type,
+           ChromeContentRendererClient* chrome_content_renderer_client);
+    Config(const Config&) = delete;
+    Config& operator=(const Config&) = delete;
+
+    blink::URLLoaderThrottleProviderType type() const { return type_; }
+    ChromeContentRendererClient* chrome_content_renderer_client() const {
+      return chrome_content_renderer_client_;
+    }
+
+#if BUILDFLAG(ENABLE_EXTENSIONS)
+    bool extension_throttling_enabled() const {
+      return extension_throttling_enabled_;
+    }
+    bool use_extension_throttle_test_policy() const {
+      return use_extension_throttle_test_policy_;
+    }
+#endif
+
+    // Whether the features of the throttles which are only created for some
+    // requests are enabled in this process.
+    bool subresource_redirect_enabled() const {
+      return subresource_redirect_enabled_;
+    }
+    bool src_video_redirect_enabled() const {
+      return src_video_redirect_enabled_;
+    }
+    bool lite_video_enabled() const { return lite_video_enabled_; }
+
+   private:
+    friend class base::RefCountedThreadSafe<Config>;
+    ~Config();
+
+    const blink::URLLoaderThrottleProviderType type_;
+    ChromeContentRendererClient* const chrome_content_renderer_client_;
+#if BUILDFLAG(ENABLE_EXTENSIONS)
+    const bool extension_throttling_enabled_;
+    const bool use_extension_throttle_test_policy_;
+#endif
+    const bool subresource_redirect_enabled_;
+    const bool src_video_redirect_enabled_;
+    const bool lite_video_enabled_;
+  };
+
   URLLoaderThrottleProviderImpl(
       blink::ThreadSafeBrowserInterfaceBrokerProxy* broker,
       blink::URLLoaderThrottleProviderType type,
@@ -45,8 +95,7 @@ class URLLoaderThrottleProviderImpl : public blink::URLLoaderThrottleProvider {
   // general use.
   URLLoaderThrottleProviderImpl(const URLLoaderThrottleProviderImpl& other);
 
-  blink::URLLoaderThrottleProviderType type_;
-  ChromeContentRendererClient* const chrome_content_renderer_client_;
+  const scoped_refptr<const Config> config_;
 
   mojo::PendingRemote<safe_browsing::mojom::SafeBrowsing> safe_browsing_remote_;
   mojo::Remote<safe_browsing::mojom::SafeBrowsing> safe_browsing_;
@@ -0,0 +1,162 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/renderer/url_loader_throttle_provider_impl.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/renderer/chrome_content_renderer_client.h"
+#include "chrome/test/base/chrome_render_view_test.h"
+#include "content/public/renderer/render_frame.h"
+#include "content/public/renderer/render_view.h"
+#include "services/network/public/mojom/fetch_api.mojom-shared.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/blink/public/platform/web_url.h"
+#include "third_party/blink/public/platform/web_url_request.h"
+#include "url/gurl.h"
+
+namespace {
+
+constexpr char kMetricPrefix[] = "URLLoaderThrottleProvider.";
+constexpr char kMetricTimePerRequest[] = "create_throttles_time_per_request";
+constexpr char kMetricThrottlesPerRequest[] = "throttles_per_request";
+
+// Number of times the requests of a page are run through the provider.
+constexpr int kIterations = 20;
+
+struct TestRequest {
+  std::string url;
+  network::mojom::RequestDestination destination;
+};
+
+// The subresources of a page which makes many requests: mostly images and
+// scripts over HTTPS, and some requests which never reach the network.
+std::vector<TestRequest> CreatePageRequests() {
+  std::vector<TestRequest> requests;
+  for (int i = 0; i < 1000; ++i) {
+    switch (i % 10) {
+      case 0:
+      case 1:
+      case 2:
+      case 3:
+        requests.push_back(
+            {base::StringPrintf("https://img.example.com/%d.jpg", i),
+             network::mojom::RequestDestination::kImage});
+        break;
+      case 4:
+      case 5:
+        requests.push_back(
+            {base::StringPrintf("https://cdn.example.com/%d.js", i),
+             network::mojom::RequestDestination::kScript});
+        break;
+      case 6:
+        requests.push_back(
+            {base::StringPrintf("https://www.example.com/api?q=%d", i),
+             network::mojom::RequestDestination::kEmpty});
+        break;
+      case 7:
+        requests.push_back(
+            {base::StringPrintf("https://fonts.example.com/%d.woff2", i),
+             network::mojom::RequestDestination::kFont});
+        break;
+      case 8:
+        requests.push_back(
+            {base::StringPrintf("blob:https://www.example.com/"
+                                "%08d-0000-0000-0000-000000000000",
+                                i),
+             network::mojom::RequestDestination::kImage});
+        break;
+      case 9:
+        requests.push_back(
+            {base::StringPrintf("chrome-extension://abcdefghijklmnop/%d.css",
+                                i),
+             network::mojom::RequestDestination::kStyle});
+        break;
+    }
+  }
+  return requests;
+}
+
+}  // namespace
+
+class URLLoaderThrottleProviderImplPerfTest : public ChromeRenderViewTest {
+ protected:
+  std::unique_ptr<blink::URLLoaderThrottleProvider> CreateProvider() {
+    return static_cast<ChromeContentRendererClient*>(
+               content_renderer_client_.get())
+        ->CreateURLLoaderThrottleProvider(
+            blink::URLLoaderThrottleProviderType::kFrame);
+  }
+
+  size_t CreateThrottles(blink::URLLoaderThrottleProvider* provider,
+                         const GURL& url,
+                         network::mojom::RequestDestination destination) {
+    blink::WebURLRequest request;
+    request.SetUrl(url);
+    request.SetRequestDestination(destination);
+    return provider
+        ->CreateThrottles(view_->GetMainRenderFrame()->GetRoutingID(), request)
+        .size();
+  }
+};
+
+// Requests which none of the throttles can act on don't get throttles which
+// only act on HTTP(S) requests.
+TEST_F(URLLoaderThrottleProviderImplPerfTest, SkipsThrottlesForLocalSchemes) {
+  std::unique_ptr<blink::URLLoaderThrottleProvider> provider =
+      CreateProvider();
+  const size_t https_throttles =
+      CreateThrottles(provider.get(), GURL("https://www.example.com/a.png"),
+                      network::mojom::RequestDestination::kImage);
+  const size_t blob_throttles = CreateThrottles(
+      provider.get(),
+      GURL("blob:https://www.example.com/"
+           "00000000-0000-0000-0000-000000000000"),
+      network::mojom::RequestDestination::kImage);
+  EXPECT_LT(blob_throttles, https_throttles);
+}
+
+TEST_F(URLLoaderThrottleProviderImplPerfTest, CreateThrottlesForPage) {
+  std::unique_ptr<blink::URLLoaderThrottleProvider> provider =
+      CreateProvider();
+  const std::vector<TestRequest> test_requests = CreatePageRequests();
+
+  // The requests are built up front, so that only CreateThrottles() is timed.
+  std::vector<std::unique_ptr<blink::WebURLRequest>> requests;
+  for (const TestRequest& test_request : test_requests) {
+    auto request = std::make_unique<blink::WebURLRequest>();
+    request->SetUrl(GURL(test_request.url));
+    request->SetRequestDestination(test_request.destination);
+    requests.push_back(std::move(request));
+  }
+
+  const int render_frame_id = view_->GetMainRenderFrame()->GetRoutingID();
+  size_t throttle_count = 0;
+  base::ElapsedTimer timer;
+  for (int i = 0; i < kIterations; ++i) {
+    for (const auto& request : requests) {
+      throttle_count +=
+          provider->CreateThrottles(render_frame_id, *request).size();
+    }
+  }
+  const base::TimeDelta elapsed = timer.Elapsed();
+
+  const size_t request_count = kIterations * requests.size();
+  perf_test::PerfResultReporter reporter(
+      kMetricPrefix,
+      base::StringPrintf("page_with_%zu_requests", requests.size()));
+  reporter.RegisterImportantMetric(kMetricTimePerRequest, "ns");
+  reporter.RegisterImportantMetric(kMetricThrottlesPerRequest, "count");
+  reporter.AddResult(kMetricTimePerRequest,
+                     static_cast<double>(elapsed.InNanoseconds()) /
+                         request_count);
+  reporter.AddResult(kMetricThrottlesPerRequest,
+                     static_cast<double>(throttle_count) / request_count);
+}
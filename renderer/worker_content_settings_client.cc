@@ -4,6 +4,8 @@
 
 #include "chrome/renderer/worker_content_settings_client.h"
 
+#include <utility>
+
 #include "base/memory/ptr_util.h"
 #include "components/content_settings/renderer/content_settings_agent_impl.h"
 #include "content/public/renderer/render_frame.h"
@@ -16,8 +18,10 @@
 #include "url/origin.h"
 
 WorkerContentSettingsClient::WorkerContentSettingsClient(
-    content::RenderFrame* render_frame)
-    : render_frame_id_(render_frame->GetRoutingID()) {
+    content::RenderFrame* render_frame,
+    scoped_refptr<SharedContentSettingRulesIndex> content_setting_rules_index)
+    : render_frame_id_(render_frame->GetRoutingID()),
+      content_setting_rules_index_(std::move(content_setting_rules_index)) {
   blink::WebLocalFrame* frame = render_frame->GetWebFrame();
   const blink::WebDocument& document = frame->GetDocument();
   if (document.GetSecurityOrigin().IsOpaque() ||
@@ -34,7 +38,6 @@ WorkerContentSettingsClient::WorkerContentSettingsClient(
   content_settings::ContentSettingsAgentImpl* agent =
       content_settings::ContentSettingsAgentImpl::Get(render_frame);
   allow_running_insecure_content_ = agent->allow_running_insecure_content();
-  content_setting_rules_ = agent->GetContentSettingRules();
 }
 
 WorkerContentSettingsClient::WorkerContentSettingsClient(
@@ -45,7 +48,7 @@ WorkerContentSettingsClient::WorkerContentSettingsClient(
       top_frame_origin_(other.top_frame_origin_),
       allow_running_insecure_content_(other.allow_running_insecure_content_),
       render_frame_id_(other.render_frame_id_),
-      content_setting_rules_(other.content_setting_rules_) {
+      content_setting_rules_index_(other.content_setting_rules_index_) {
   other.EnsureContentSettingsManager();
   other.content_settings_manager_->Clone(
       pending_content_settings_manager_.InitWithNewPipeAndPassReceiver());
@@ -108,15 +111,13 @@ bool WorkerContentSettingsClient::AllowScriptFromSource(
     bool enabled_per_settings,
     const blink::WebURL& script_url) {
   bool allow = enabled_per_settings;
-  if (allow && content_setting_rules_) {
-    GURL top_frame_origin_url = top_frame_origin_.GetURL();
-    for (const auto& rule : content_setting_rules_->script_rules) {
-      if (rule.primary_pattern.Matches(top_frame_origin_url) &&
-          rule.secondary_pattern.Matches(script_url)) {
-        allow = rule.GetContentSetting() != CONTENT_SETTING_BLOCK;
-        break;
-      }
-    }
+  if (allow && content_setting_rules_index_) {
+    scoped_refptr<const ContentSettingRulesIndex> index =
+        content_setting_rules_index_->Get();
+    const ContentSettingPatternSource* rule =
+        index->FindScriptRule(top_frame_origin_.GetURL(), script_url);
+    if (rule)
+      allow = rule->GetContentSetting() != CONTENT_SETTING_BLOCK;
   }
 
   if (!allow) {
@@ -130,12 +131,13 @@ bool WorkerContentSettingsClient::AllowScriptFromSource(
 }
 
 bool WorkerContentSettingsClient::ShouldAutoupgradeMixedContent() {
-  if (content_setting_rules_) {
-    for (const auto& rule : content_setting_rules_->mixed_content_rules) {
-      if (rule.primary_pattern.Matches(top_frame_origin_.GetURL())) {
-        return rule.GetContentSetting() != CONTENT_SETTING_ALLOW;
-      }
-    }
+  if (content_setting_rules_index_) {
+    scoped_refptr<const ContentSettingRulesIndex> index =
+        content_setting_rules_index_->Get();
+    const ContentSettingPatternSource* rule =
+        index->FindMixedContentRule(top_frame_origin_.GetURL());
+    if (rule)
+      return rule->GetContentSetting() != CONTENT_SETTING_ALLOW;
   }
   return false;
 }
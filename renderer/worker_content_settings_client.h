@@ -7,6 +7,7 @@
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "chrome/renderer/content_setting_rules_index.h"
 #include "components/content_settings/common/content_settings_manager.mojom.h"
 #include "mojo/public/cpp/bindings/remote.h"
 #include "third_party/blink/public/platform/web_content_settings_client.h"
@@ -17,14 +18,18 @@ namespace content {
 class RenderFrame;
 }  // namespace content
 
-struct RendererContentSettingRules;
-
 // This client is created on the main renderer thread then passed onto the
 // blink's worker thread. For workers created from other workers, Clone()
 // is called on the "parent" worker's thread.
 class WorkerContentSettingsClient : public blink::WebContentSettingsClient {
  public:
-  explicit WorkerContentSettingsClient(content::RenderFrame* render_frame);
+  // |content_setting_rules_index| may be null, in which case script and mixed
+  // content rules are not applied. Otherwise each lookup uses its current
+  // index, so rule updates reach running workers.
+  WorkerContentSettingsClient(
+      content::RenderFrame* render_frame,
+      scoped_refptr<SharedContentSettingRulesIndex>
+          content_setting_rules_index);
   ~WorkerContentSettingsClient() override;
 
   // WebContentSettingsClient overrides.
@@ -50,7 +55,8 @@ class WorkerContentSettingsClient : public blink::WebContentSettingsClient {
   url::Origin top_frame_origin_;
   bool allow_running_insecure_content_;
   const int32_t render_frame_id_;
-  const RendererContentSettingRules* content_setting_rules_;
+  const scoped_refptr<SharedContentSettingRulesIndex>
+      content_setting_rules_index_;
 
   // Because instances of this class are created on the parent's thread (i.e,
   // on the renderer main thread or on the thread of the parent worker), it is
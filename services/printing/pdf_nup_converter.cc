@@ -4,9 +4,12 @@
 
 #include "chrome/services/printing/pdf_nup_converter.h"
 
+#include <algorithm>
 #include <string>
+#include <tuple>
 #include <utility>
 
+#include "base/bind.h"
 #include "base/containers/span.h"
 #include "components/crash/core/common/crash_key.h"
 #include "pdf/pdf.h"
@@ -15,6 +18,12 @@ namespace printing {
 
 namespace {
 
+// Upper bound on the size of the converted sheets kept by a PdfNupConverter.
+// A converter lives as long as its print preview document, so this covers
+// switching back and forth between a few pages per sheet settings of a large
+// document.
+constexpr size_t kMaxSheetCacheBytes = 64 * 1024 * 1024;
+
 // |pdf_mappings| which has the pdf page data needs to remain valid until
 // ConvertPdfPagesToNupPdf completes, since base::span is a reference type.
 std::vector<base::span<const uint8_t>> CreatePdfPagesVector(
@@ -49,7 +58,27 @@ void RunCallbackWithConversionResult(Callback callback,
 
 }  // namespace
 
-PdfNupConverter::PdfNupConverter() = default;
+PdfNupConverter::SheetKey::SheetKey() = default;
+
+PdfNupConverter::SheetKey::SheetKey(SheetKey&& other) = default;
+
+PdfNupConverter::SheetKey& PdfNupConverter::SheetKey::operator=(
+    SheetKey&& other) = default;
+
+PdfNupConverter::SheetKey::~SheetKey() = default;
+
+bool PdfNupConverter::SheetKey::operator<(const SheetKey& other) const {
+  return std::tie(pages_per_sheet, page_width, page_height, page_digests) <
+         std::tie(other.pages_per_sheet, other.page_width, other.page_height,
+                  other.page_digests);
+}
+
+PdfNupConverter::PdfNupConverter()
+    : sheet_cache_(decltype(sheet_cache_)::NO_AUTO_EVICT) {
+  memory_pressure_listener_ = std::make_unique<base::MemoryPressureListener>(
+      FROM_HERE, base::BindRepeating(&PdfNupConverter::OnMemoryPressure,
+                                     base::Unretained(this)));
+}
 
 PdfNupConverter::~PdfNupConverter() {}
 
@@ -95,6 +124,65 @@ void PdfNupConverter::NupDocumentConvert(
   RunCallbackWithConversionResult(std::move(callback), output_pdf_buffer);
 }
 
+void PdfNupConverter::NupSheetsConvert(
+    uint32_t pages_per_sheet,
+    const gfx::Size& page_size,
+    const gfx::Rect& printable_area,
+    std::vector<base::ReadOnlySharedMemoryRegion> pdf_page_regions,
+    NupSheetsConvertCallback callback) {
+  std::vector<base::ReadOnlySharedMemoryMapping> pdf_mappings;
+  std::vector<base::span<const uint8_t>> input_pdf_buffers =
+      CreatePdfPagesVector(pdf_page_regions, &pdf_mappings);
+  if (pages_per_sheet == 0 || input_pdf_buffers.empty()) {
+    std::move(callback).Run(mojom::PdfNupConverter::Status::CONVERSION_FAILURE,
+                            base::ReadOnlySharedMemoryRegion());
+    return;
+  }
+
+  // Holds a reference to every sheet, since building later sheets may evict
+  // earlier ones from the cache.
+  std::vector<scoped_refptr<base::RefCountedBytes>> sheets;
+  for (size_t first = 0; first < input_pdf_buffers.size();
+       first += pages_per_sheet) {
+    const size_t last =
+        std::min<size_t>(first + pages_per_sheet, input_pdf_buffers.size());
+    scoped_refptr<base::RefCountedBytes> sheet = GetOrConvertSheet(
+        std::vector<base::span<const uint8_t>>(
+            input_pdf_buffers.begin() + first,
+            input_pdf_buffers.begin() + last),
+        pages_per_sheet, page_size);
+    if (!sheet) {
+      std::move(callback).Run(
+          mojom::PdfNupConverter::Status::CONVERSION_FAILURE,
+          base::ReadOnlySharedMemoryRegion());
+      return;
+    }
+    sheets.push_back(std::move(sheet));
+  }
+
+  if (sheets.size() == 1 && printable_area == gfx::Rect(page_size)) {
+    RunCallbackWithConversionResult(std::move(callback), sheets[0]->data());
+    return;
+  }
+
+  // Concatenate the sheets, one per page. Each sheet already has the output
+  // page size, so this only scales its content into the printable area, the
+  // same way an N-up conversion with |printable_area| would. Changing the
+  // margins therefore reuses the cached sheets.
+  std::vector<base::span<const uint8_t>> sheet_buffers;
+  for (const auto& sheet : sheets)
+    sheet_buffers.push_back(base::make_span(sheet->front(), sheet->size()));
+  std::vector<uint8_t> output_pdf_buffer = chrome_pdf::ConvertPdfPagesToNupPdf(
+      std::move(sheet_buffers), 1, page_size, printable_area);
+  if (output_pdf_buffer.empty()) {
+    std::move(callback).Run(mojom::PdfNupConverter::Status::CONVERSION_FAILURE,
+                            base::ReadOnlySharedMemoryRegion());
+    return;
+  }
+
+  RunCallbackWithConversionResult(std::move(callback), output_pdf_buffer);
+}
+
 void PdfNupConverter::SetWebContentsURL(const GURL& url) {
   // Record the most recent url we tried to print. This should be sufficient
   // for users using print preview by default.
@@ -102,4 +190,52 @@ void PdfNupConverter::SetWebContentsURL(const GURL& url) {
   crash_key.Set(url.spec());
 }
 
+scoped_refptr<base::RefCountedBytes> PdfNupConverter::GetOrConvertSheet(
+    std::vector<base::span<const uint8_t>> pages,
+    uint32_t pages_per_sheet,
+    const gfx::Size& page_size) {
+  SheetKey key;
+  key.pages_per_sheet = pages_per_sheet;
+  key.page_width = page_size.width();
+  key.page_height = page_size.height();
+  for (const auto& page : pages)
+    key.page_digests.push_back(base::SHA1HashSpan(page));
+
+  auto it = sheet_cache_.Get(key);
+  if (it != sheet_cache_.end()) {
+    ++sheet_cache_hits_;
+    return it->second;
+  }
+
+  std::vector<uint8_t> output_pdf_buffer = chrome_pdf::ConvertPdfPagesToNupPdf(
+      std::move(pages), pages_per_sheet, page_size, gfx::Rect(page_size));
+  if (output_pdf_buffer.empty())
+    return nullptr;
+
+  scoped_refptr<base::RefCountedBytes> sheet =
+      base::RefCountedBytes::TakeVector(&output_pdf_buffer);
+  if (sheet->size() <= kMaxSheetCacheBytes) {
+    EvictSheetsUntilBytesAtMost(kMaxSheetCacheBytes - sheet->size());
+    sheet_cache_bytes_ += sheet->size();
+    sheet_cache_.Put(std::move(key), sheet);
+  }
+  return sheet;
+}
+
+void PdfNupConverter::EvictSheetsUntilBytesAtMost(size_t max_bytes) {
+  while (sheet_cache_bytes_ > max_bytes && !sheet_cache_.empty()) {
+    auto lru = sheet_cache_.rbegin();
+    sheet_cache_bytes_ -= lru->second->size();
+    sheet_cache_.Erase(lru);
+  }
+}
+
+void PdfNupConverter::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel level) {
+  if (level == base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE)
+    return;
+  sheet_cache_.Clear();
+  sheet_cache_bytes_ = 0;
+}
+
 }  // namespace printing
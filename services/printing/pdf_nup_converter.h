@@ -5,10 +5,19 @@
 #ifndef CHROME_SERVICES_PRINTING_PDF_NUP_CONVERTER_H_
 #define CHROME_SERVICES_PRINTING_PDF_NUP_CONVERTER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <memory>
+#include <vector>
 
+#include "base/containers/mru_cache.h"
+#include "base/containers/span.h"
+#include "base/hash/sha1.h"
 #include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
 #include "base/memory/read_only_shared_memory_region.h"
+#include "base/memory/ref_counted_memory.h"
 #include "chrome/services/printing/public/mojom/pdf_nup_converter.mojom.h"
 
 namespace printing {
@@ -30,9 +39,54 @@ class PdfNupConverter : public printing::mojom::PdfNupConverter {
                           const gfx::Rect& printable_area,
                           base::ReadOnlySharedMemoryRegion src_pdf_region,
                           NupDocumentConvertCallback callback) override;
+  void NupSheetsConvert(
+      uint32_t pages_per_sheet,
+      const gfx::Size& page_size,
+      const gfx::Rect& printable_area,
+      std::vector<base::ReadOnlySharedMemoryRegion> pdf_page_regions,
+      NupSheetsConvertCallback callback) override;
   void SetWebContentsURL(const GURL& url) override;
 
+  size_t sheet_cache_size_for_testing() const { return sheet_cache_.size(); }
+  size_t sheet_cache_bytes_for_testing() const { return sheet_cache_bytes_; }
+  size_t sheet_cache_hits_for_testing() const { return sheet_cache_hits_; }
+
  private:
+  // Identifies a converted N-up sheet: the layout of the pages on it and the
+  // digests of the source pages placed on it. The printable area isn't part
+  // of the key: sheets are converted over the whole page and only scaled into
+  // the printable area when the output document is built.
+  struct SheetKey {
+    SheetKey();
+    SheetKey(SheetKey&& other);
+    SheetKey& operator=(SheetKey&& other);
+    ~SheetKey();
+
+    bool operator<(const SheetKey& other) const;
+
+    uint32_t pages_per_sheet = 0;
+    int page_width = 0;
+    int page_height = 0;
+    std::vector<base::SHA1Digest> page_digests;
+  };
+
+  // Returns the single-page N-up PDF for |pages|, laid out over the whole
+  // page, either from |sheet_cache_| or by converting it. Returns nullptr on
+  // failure.
+  scoped_refptr<base::RefCountedBytes> GetOrConvertSheet(
+      std::vector<base::span<const uint8_t>> pages,
+      uint32_t pages_per_sheet,
+      const gfx::Size& page_size);
+  void EvictSheetsUntilBytesAtMost(size_t max_bytes);
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel level);
+
+  base::MRUCache<SheetKey, scoped_refptr<base::RefCountedBytes>> sheet_cache_;
+  size_t sheet_cache_bytes_ = 0;
+  size_t sheet_cache_hits_ = 0;
+
+  std::unique_ptr<base::MemoryPressureListener> memory_pressure_listener_;
+
   DISALLOW_COPY_AND_ASSIGN(PdfNupConverter);
 };
 
@@ -0,0 +1,168 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/services/printing/pdf_nup_converter.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/task_environment.h"
+#include "pdf/pdf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace printing {
+
+namespace {
+
+constexpr int kPageWidth = 612;
+constexpr int kPageHeight = 792;
+
+// Builds a single-page PDF whose content depends on |label|.
+std::string CreatePagePdf(int label) {
+  const std::string content =
+      base::StringPrintf("BT /F1 24 Tf 72 700 Td (Page %d) Tj ET", label);
+  return base::StringPrintf(
+      "%%PDF-1.4\n"
+      "1 0 obj\n<< /Length %zu >>\nstream\n%s\nendstream\nendobj\n"
+      "2 0 obj\n<< /Type /Page /Parent 3 0 R /Contents 1 0 R >>\nendobj\n"
+      "3 0 obj\n<< /Type /Pages /Kids [ 2 0 R ] /Count 1 "
+      "/MediaBox [ 0 0 %d %d ] >>\nendobj\n"
+      "4 0 obj\n<< /Type /Catalog /Pages 3 0 R >>\nendobj\n"
+      "trailer\n<< /Root 4 0 R >>\n%%%%EOF\n",
+      content.size() + 1, content.c_str(), kPageWidth, kPageHeight);
+}
+
+base::ReadOnlySharedMemoryRegion CreatePdfRegion(const std::string& content) {
+  auto pdf_region = base::ReadOnlySharedMemoryRegion::Create(content.size());
+  EXPECT_TRUE(pdf_region.IsValid());
+  memcpy(pdf_region.mapping.memory(), content.data(), content.size());
+  return std::move(pdf_region.region);
+}
+
+std::vector<base::ReadOnlySharedMemoryRegion> CreatePageRegions(
+    const std::vector<int>& labels) {
+  std::vector<base::ReadOnlySharedMemoryRegion> regions;
+  for (int label : labels)
+    regions.push_back(CreatePdfRegion(CreatePagePdf(label)));
+  return regions;
+}
+
+}  // namespace
+
+class PdfNupConverterTest : public testing::Test {
+ protected:
+  // Runs NupSheetsConvert() and returns the page count of the resulting
+  // document, or 0 on failure.
+  int ConvertSheets(uint32_t pages_per_sheet,
+                    const gfx::Rect& printable_area,
+                    const std::vector<int>& labels) {
+    base::RunLoop run_loop;
+    mojom::PdfNupConverter::Status status =
+        mojom::PdfNupConverter::Status::CONVERSION_FAILURE;
+    base::ReadOnlySharedMemoryRegion result;
+    converter_.NupSheetsConvert(
+        pages_per_sheet, gfx::Size(kPageWidth, kPageHeight), printable_area,
+        CreatePageRegions(labels),
+        base::BindOnce(
+            [](mojom::PdfNupConverter::Status* status_out,
+               base::ReadOnlySharedMemoryRegion* region_out,
+               base::OnceClosure quit, mojom::PdfNupConverter::Status status,
+               base::ReadOnlySharedMemoryRegion region) {
+              *status_out = status;
+              *region_out = std::move(region);
+              std::move(quit).Run();
+            },
+            &status, &result, run_loop.QuitClosure()));
+    run_loop.Run();
+    if (status != mojom::PdfNupConverter::Status::SUCCESS)
+      return 0;
+
+    base::ReadOnlySharedMemoryMapping mapping = result.Map();
+    EXPECT_TRUE(mapping.IsValid());
+    int page_count = 0;
+    EXPECT_TRUE(chrome_pdf::GetPDFDocInfo(
+        mapping.GetMemoryAsSpan<const uint8_t>(), &page_count, nullptr));
+    return page_count;
+  }
+
+  gfx::Rect FullPage() const { return gfx::Rect(kPageWidth, kPageHeight); }
+
+  PdfNupConverter converter_;
+
+ private:
+  base::test::SingleThreadTaskEnvironment task_environment_;
+};
+
+TEST_F(PdfNupConverterTest, SheetsConvert) {
+  EXPECT_EQ(3, ConvertSheets(2, FullPage(), {1, 2, 3, 4, 5}));
+  EXPECT_EQ(3u, converter_.sheet_cache_size_for_testing());
+  EXPECT_EQ(0u, converter_.sheet_cache_hits_for_testing());
+}
+
+TEST_F(PdfNupConverterTest, SheetsConvertOnlyRegeneratesChangedSheets) {
+  ASSERT_EQ(2, ConvertSheets(2, FullPage(), {1, 2, 3, 4}));
+
+  // Same layout and pages: every sheet comes from the cache.
+  EXPECT_EQ(2, ConvertSheets(2, FullPage(), {1, 2, 3, 4}));
+  EXPECT_EQ(2u, converter_.sheet_cache_hits_for_testing());
+  EXPECT_EQ(2u, converter_.sheet_cache_size_for_testing());
+
+  // Only the second sheet's pages changed.
+  EXPECT_EQ(2, ConvertSheets(2, FullPage(), {1, 2, 5, 6}));
+  EXPECT_EQ(3u, converter_.sheet_cache_hits_for_testing());
+  EXPECT_EQ(3u, converter_.sheet_cache_size_for_testing());
+
+  // A new pages per sheet setting is a new layout.
+  EXPECT_EQ(1, ConvertSheets(4, FullPage(), {1, 2, 3, 4}));
+  EXPECT_EQ(3u, converter_.sheet_cache_hits_for_testing());
+  EXPECT_EQ(4u, converter_.sheet_cache_size_for_testing());
+
+  // Switching back to the previous layout hits again.
+  EXPECT_EQ(2, ConvertSheets(2, FullPage(), {1, 2, 3, 4}));
+  EXPECT_EQ(5u, converter_.sheet_cache_hits_for_testing());
+}
+
+TEST_F(PdfNupConverterTest, SheetsConvertReusesSheetsAfterMarginsChange) {
+  ASSERT_EQ(2, ConvertSheets(2, FullPage(), {1, 2, 3, 4}));
+
+  // The sheets are only scaled into the new printable area.
+  const gfx::Rect printable_area(36, 36, kPageWidth - 72, kPageHeight - 72);
+  EXPECT_EQ(2, ConvertSheets(2, printable_area, {1, 2, 3, 4}));
+  EXPECT_EQ(2u, converter_.sheet_cache_hits_for_testing());
+  EXPECT_EQ(2u, converter_.sheet_cache_size_for_testing());
+
+  // Also when the call holds a single sheet, as print preview does.
+  EXPECT_EQ(1, ConvertSheets(2, printable_area, {1, 2}));
+  EXPECT_EQ(3u, converter_.sheet_cache_hits_for_testing());
+  EXPECT_EQ(2u, converter_.sheet_cache_size_for_testing());
+}
+
+TEST_F(PdfNupConverterTest, SheetsConvertFailure) {
+  EXPECT_EQ(0, ConvertSheets(0, FullPage(), {1, 2}));
+  EXPECT_EQ(0, ConvertSheets(2, FullPage(), {}));
+  EXPECT_EQ(0u, converter_.sheet_cache_size_for_testing());
+}
+
+TEST_F(PdfNupConverterTest, MemoryPressureClearsSheetCache) {
+  ASSERT_EQ(2, ConvertSheets(4, FullPage(), {1, 2, 3, 4, 5}));
+  EXPECT_NE(0u, converter_.sheet_cache_bytes_for_testing());
+
+  base::MemoryPressureListener::SimulatePressureNotification(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(0u, converter_.sheet_cache_size_for_testing());
+  EXPECT_EQ(0u, converter_.sheet_cache_bytes_for_testing());
+}
+
+}  // namespace printing
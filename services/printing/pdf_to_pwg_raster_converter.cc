@@ -4,14 +4,24 @@
 
 #include "chrome/services/printing/pdf_to_pwg_raster_converter.h"
 
+#include <algorithm>
 #include <limits>
+#include <map>
 #include <string>
 #include <utility>
 
+#include "base/bind.h"
 #include "base/containers/span.h"
 #include "base/memory/read_only_shared_memory_region.h"
+#include "base/numerics/checked_math.h"
+#include "base/numerics/ranges.h"
+#include "base/stl_util.h"
+#include "base/system/sys_info.h"
+#include "base/task/thread_pool.h"
+#include "base/threading/sequenced_task_runner_handle.h"
 #include "components/pwg_encoder/bitmap_image.h"
 #include "components/pwg_encoder/pwg_encoder.h"
+#include "mojo/public/cpp/bindings/remote.h"
 #include "pdf/pdf.h"
 #include "printing/mojom/print.mojom.h"
 #include "printing/pdf_render_settings.h"
@@ -20,6 +30,112 @@ namespace printing {
 
 namespace {
 
+// Reserve 64 KB per page when buffering a whole document.
+constexpr size_t kEstimatedSizePerPage = 64 * 1024;
+
+// Upper bound on the number of pages rendered but not yet sent by a streaming
+// conversion, and on the memory their bitmaps may use. At 600 DPI, a single
+// Letter page bitmap takes about 130 MB.
+constexpr size_t kMaxStreamingPagesInFlight = 8;
+constexpr size_t kMaxStreamingBitmapBytesInFlight = 512 * 1024 * 1024;
+
+// Returns false if |pdf_data| isn't a PDF or has an unreasonable page count.
+bool GetPageCount(base::span<const uint8_t> pdf_data, int* total_page_count) {
+  static constexpr size_t kMaxPageCount =
+      std::numeric_limits<size_t>::max() / kEstimatedSizePerPage;
+  return chrome_pdf::GetPDFDocInfo(pdf_data, total_page_count, nullptr) &&
+         *total_page_count > 0 &&
+         static_cast<size_t>(*total_page_count) < kMaxPageCount;
+}
+
+chrome_pdf::RenderOptions GetRenderOptions(const PdfRenderSettings& settings) {
+  return {
+      .stretch_to_bounds = false,
+      .keep_aspect_ratio = true,
+      .autorotate = settings.autorotate,
+      .use_color = settings.use_color,
+      .render_device_type = chrome_pdf::RenderDeviceType::kPrinter,
+  };
+}
+
+pwg_encoder::PwgHeaderInfo GetPwgHeaderInfo(
+    const PdfRenderSettings& settings,
+    const PwgRasterSettings& bitmap_settings,
+    int page_number,
+    int total_page_count) {
+  pwg_encoder::PwgHeaderInfo header_info;
+  header_info.dpi = settings.dpi;
+  header_info.total_pages = total_page_count;
+  header_info.color_space = bitmap_settings.use_color
+                                ? pwg_encoder::PwgHeaderInfo::SRGB
+                                : pwg_encoder::PwgHeaderInfo::SGRAY;
+
+  switch (bitmap_settings.duplex_mode) {
+    case mojom::DuplexMode::kUnknownDuplexMode:
+      NOTREACHED();
+      break;
+    case mojom::DuplexMode::kSimplex:
+      // Already defaults to false/false.
+      break;
+    case mojom::DuplexMode::kLongEdge:
+      header_info.duplex = true;
+      break;
+    case mojom::DuplexMode::kShortEdge:
+      header_info.duplex = true;
+      header_info.tumble = true;
+      break;
+  }
+
+  // Transform odd pages.
+  if (page_number % 2) {
+    switch (bitmap_settings.odd_page_transform) {
+      case TRANSFORM_NORMAL:
+        break;
+      case TRANSFORM_ROTATE_180:
+        header_info.flipx = true;
+        header_info.flipy = true;
+        break;
+      case TRANSFORM_FLIP_HORIZONTAL:
+        header_info.flipx = true;
+        break;
+      case TRANSFORM_FLIP_VERTICAL:
+        header_info.flipy = true;
+        break;
+    }
+  }
+
+  if (bitmap_settings.rotate_all_pages) {
+    header_info.flipx = !header_info.flipx;
+    header_info.flipy = !header_info.flipy;
+  }
+
+  return header_info;
+}
+
+int GetPageNumber(const PwgRasterSettings& bitmap_settings,
+                  int page_index,
+                  int total_page_count) {
+  return bitmap_settings.reverse_page_order ? total_page_count - 1 - page_index
+                                            : page_index;
+}
+
+size_t GetMaxStreamingPagesInFlight(const gfx::Size& page_size) {
+  const size_t bitmap_bytes =
+      base::CheckMul<size_t>(page_size.width(), page_size.height(), 4)
+          .ValueOrDefault(std::numeric_limits<size_t>::max());
+  const size_t max_by_memory =
+      kMaxStreamingBitmapBytesInFlight / std::max<size_t>(bitmap_bytes, 1);
+  const size_t max_by_cpu = base::SysInfo::NumberOfProcessors();
+  return base::ClampToRange(std::min(max_by_memory, max_by_cpu), size_t{1},
+                            kMaxStreamingPagesInFlight);
+}
+
+// Runs on a worker thread.
+std::string EncodePage(const pwg_encoder::BitmapImage* image,
+                       const pwg_encoder::PwgHeaderInfo& header_info) {
+  return pwg_encoder::PwgEncoder::EncodePage(*image, header_info);
+}
+
 base::ReadOnlySharedMemoryRegion RenderPdfPagesToPwgRaster(
     base::ReadOnlySharedMemoryRegion pdf_region,
     const PdfRenderSettings& settings,
@@ -33,33 +149,18 @@ base::ReadOnlySharedMemoryRegion RenderPdfPagesToPwgRaster(
   auto pdf_data = pdf_mapping.GetMemoryAsSpan<const uint8_t>();
 
   // Get the page count and reserve 64 KB per page in |pwg_data| below.
-  static constexpr size_t kEstimatedSizePerPage = 64 * 1024;
-  static constexpr size_t kMaxPageCount =
-      std::numeric_limits<size_t>::max() / kEstimatedSizePerPage;
   int total_page_count = 0;
-  if (!chrome_pdf::GetPDFDocInfo(pdf_data, &total_page_count, nullptr) ||
-      total_page_count <= 0 ||
-      static_cast<size_t>(total_page_count) >= kMaxPageCount) {
+  if (!GetPageCount(pdf_data, &total_page_count))
     return invalid_pwg_region;
-  }
 
   std::string pwg_data;
   pwg_data.reserve(total_page_count * kEstimatedSizePerPage);
   pwg_data = pwg_encoder::PwgEncoder::GetDocumentHeader();
   pwg_encoder::BitmapImage image(settings.area.size(),
                                  pwg_encoder::BitmapImage::BGRA);
-  const chrome_pdf::RenderOptions options = {
-      .stretch_to_bounds = false,
-      .keep_aspect_ratio = true,
-      .autorotate = settings.autorotate,
-      .use_color = settings.use_color,
-      .render_device_type = chrome_pdf::RenderDeviceType::kPrinter,
-  };
+  const chrome_pdf::RenderOptions options = GetRenderOptions(settings);
   for (int i = 0; i < total_page_count; ++i) {
-    int page_number = i;
-
-    if (bitmap_settings.reverse_page_order)
-      page_number = total_page_count - 1 - page_number;
+    int page_number = GetPageNumber(bitmap_settings, i, total_page_count);
 
     if (!chrome_pdf::RenderPDFPageToBitmap(pdf_data, page_number,
                                            image.pixel_data(), image.size(),
@@ -67,54 +168,9 @@ base::ReadOnlySharedMemoryRegion RenderPdfPagesToPwgRaster(
       return invalid_pwg_region;
     }
 
-    pwg_encoder::PwgHeaderInfo header_info;
-    header_info.dpi = settings.dpi;
-    header_info.total_pages = total_page_count;
-    header_info.color_space = bitmap_settings.use_color
-                                  ? pwg_encoder::PwgHeaderInfo::SRGB
-                                  : pwg_encoder::PwgHeaderInfo::SGRAY;
-
-    switch (bitmap_settings.duplex_mode) {
-      case mojom::DuplexMode::kUnknownDuplexMode:
-        NOTREACHED();
-        break;
-      case mojom::DuplexMode::kSimplex:
-        // Already defaults to false/false.
-        break;
-      case mojom::DuplexMode::kLongEdge:
-        header_info.duplex = true;
-        break;
-      case mojom::DuplexMode::kShortEdge:
-        header_info.duplex = true;
-        header_info.tumble = true;
-        break;
-    }
-
-    // Transform odd pages.
-    if (page_number % 2) {
-      switch (bitmap_settings.odd_page_transform) {
-        case TRANSFORM_NORMAL:
-          break;
-        case TRANSFORM_ROTATE_180:
-          header_info.flipx = true;
-          header_info.flipy = true;
-          break;
-        case TRANSFORM_FLIP_HORIZONTAL:
-          header_info.flipx = true;
-          break;
-        case TRANSFORM_FLIP_VERTICAL:
-          header_info.flipy = true;
-          break;
-      }
-    }
-
-    if (bitmap_settings.rotate_all_pages) {
-      header_info.flipx = !header_info.flipx;
-      header_info.flipy = !header_info.flipy;
-    }
-
-    std::string pwg_page =
-        pwg_encoder::PwgEncoder::EncodePage(image, header_info);
+    std::string pwg_page = pwg_encoder::PwgEncoder::EncodePage(
+        image, GetPwgHeaderInfo(settings, bitmap_settings, page_number,
+                                total_page_count));
     if (pwg_page.empty())
       return invalid_pwg_region;
     pwg_data += pwg_page;
@@ -132,6 +188,181 @@ base::ReadOnlySharedMemoryRegion RenderPdfPagesToPwgRaster(
 
 }  // namespace
 
+// Renders pages one at a time on the service sequence, since PDFium is not
+// thread-safe, and encodes them on thread pool workers, which is where most of
+// the time goes at high DPI. Encoded pages are sent to the client in order, as
+// soon as every page before them has been sent. The number of pages rendered
+// but not yet sent is bounded, and so is the memory held by their bitmaps.
+class PdfToPwgRasterConverter::StreamingJob {
+ public:
+  StreamingJob(base::WeakPtr<PdfToPwgRasterConverter> converter,
+               base::ReadOnlySharedMemoryMapping pdf_mapping,
+               int total_page_count,
+               const PdfRenderSettings& settings,
+               const PwgRasterSettings& bitmap_settings,
+               mojo::PendingRemote<mojom::PwgRasterStreamClient> client)
+      : converter_(std::move(converter)),
+        pdf_mapping_(std::move(pdf_mapping)),
+        total_page_count_(total_page_count),
+        settings_(settings),
+        bitmap_settings_(bitmap_settings),
+        max_pages_in_flight_(
+            GetMaxStreamingPagesInFlight(settings.area.size())),
+        client_(std::move(client)) {
+    client_.set_disconnect_handler(base::BindOnce(
+        &StreamingJob::Finish, base::Unretained(this), /*success=*/false));
+  }
+  StreamingJob(const StreamingJob&) = delete;
+  StreamingJob& operator=(const StreamingJob&) = delete;
+  ~StreamingJob() = default;
+
+  void Start() { RenderNextPage(); }
+
+ private:
+  void ScheduleRenderNextPage() {
+    if (render_scheduled_)
+      return;
+    render_scheduled_ = true;
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(&StreamingJob::RenderNextPage,
+                                  weak_ptr_factory_.GetWeakPtr()));
+  }
+
+  void RenderNextPage() {
+    render_scheduled_ = false;
+    if (finished_ || next_page_to_render_ == total_page_count_ ||
+        pages_in_flight_ >= max_pages_in_flight_) {
+      return;
+    }
+
+    const int page_index = next_page_to_render_++;
+    const int page_number =
+        GetPageNumber(bitmap_settings_, page_index, total_page_count_);
+
+    std::unique_ptr<pwg_encoder::BitmapImage> image;
+    if (free_images_.empty()) {
+      image = std::make_unique<pwg_encoder::BitmapImage>(
+          settings_.area.size(), pwg_encoder::BitmapImage::BGRA);
+    } else {
+      image = std::move(free_images_.back());
+      free_images_.pop_back();
+    }
+
+    if (!chrome_pdf::RenderPDFPageToBitmap(
+            pdf_mapping_.GetMemoryAsSpan<const uint8_t>(), page_number,
+            image->pixel_data(), image->size(), settings_.dpi,
+            GetRenderOptions(settings_))) {
+      Finish(/*success=*/false);
+      return;
+    }
+
+    ++pages_in_flight_;
+    // The reply owns |image|, and is destroyed only after EncodePage() ran.
+    const pwg_encoder::BitmapImage* image_ptr = image.get();
+    base::ThreadPool::PostTaskAndReplyWithResult(
+        FROM_HERE,
+        {base::TaskPriority::USER_BLOCKING,
+         base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN},
+        base::BindOnce(&EncodePage, image_ptr,
+                       GetPwgHeaderInfo(settings_, bitmap_settings_,
+                                        page_number, total_page_count_)),
+        base::BindOnce(&StreamingJob::OnPageEncoded,
+                       weak_ptr_factory_.GetWeakPtr(), page_index,
+                       std::move(image)));
+
+    // Yield between pages, so that encoded pages get sent while the rest of
+    // the document renders.
+    ScheduleRenderNextPage();
+  }
+
+  void OnPageEncoded(int page_index,
+                     std::unique_ptr<pwg_encoder::BitmapImage> image,
+                     std::string pwg_page) {
+    if (finished_)
+      return;
+
+    free_images_.push_back(std::move(image));
+    if (pwg_page.empty()) {
+      Finish(/*success=*/false);
+      return;
+    }
+
+    encoded_pages_[page_index] = std::move(pwg_page);
+    SendEncodedPages();
+    ScheduleRenderNextPage();
+  }
+
+  void SendEncodedPages() {
+    auto it = encoded_pages_.begin();
+    while (!finished_ && it != encoded_pages_.end() &&
+           it->first == next_page_to_send_) {
+      const std::string header =
+          next_page_to_send_ == 0 ? pwg_encoder::PwgEncoder::GetDocumentHeader()
+                                  : std::string();
+      base::MappedReadOnlyRegion chunk =
+          base::ReadOnlySharedMemoryRegion::Create(header.size() +
+                                                   it->second.size());
+      if (!chunk.IsValid()) {
+        Finish(/*success=*/false);
+        return;
+      }
+
+      char* chunk_data = static_cast<char*>(chunk.mapping.memory());
+      memcpy(chunk_data, header.data(), header.size());
+      memcpy(chunk_data + header.size(), it->second.data(), it->second.size());
+      client_->OnPageConverted(std::move(chunk.region));
+
+      it = encoded_pages_.erase(it);
+      ++next_page_to_send_;
+      --pages_in_flight_;
+    }
+
+    if (next_page_to_send_ == total_page_count_)
+      Finish(/*success=*/true);
+  }
+
+  // Reports the result and schedules the deletion of |this|. Must not be
+  // followed by any other work.
+  void Finish(bool success) {
+    if (finished_)
+      return;
+    finished_ = true;
+
+    if (client_.is_connected()) {
+      client_->OnConversionDone(success,
+                                success ? total_page_count_ : /*page_count=*/0);
+    }
+    encoded_pages_.clear();
+    free_images_.clear();
+
+    base::SequencedTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::BindOnce(&PdfToPwgRasterConverter::OnStreamingJobDone,
+                                  converter_, base::Unretained(this)));
+  }
+
+  const base::WeakPtr<PdfToPwgRasterConverter> converter_;
+  const base::ReadOnlySharedMemoryMapping pdf_mapping_;
+  const int total_page_count_;
+  const PdfRenderSettings settings_;
+  const PwgRasterSettings bitmap_settings_;
+  const size_t max_pages_in_flight_;
+  mojo::Remote<mojom::PwgRasterStreamClient> client_;
+
+  int next_page_to_render_ = 0;
+  int next_page_to_send_ = 0;
+  // Pages rendered but not sent yet.
+  size_t pages_in_flight_ = 0;
+  bool render_scheduled_ = false;
+  bool finished_ = false;
+
+  // Encoded pages waiting for the pages before them, keyed by page index.
+  std::map<int, std::string> encoded_pages_;
+  // Bitmaps of already encoded pages, reused for the next pages.
+  std::vector<std::unique_ptr<pwg_encoder::BitmapImage>> free_images_;
+
+  base::WeakPtrFactory<StreamingJob> weak_ptr_factory_{this};
+};
+
 PdfToPwgRasterConverter::PdfToPwgRasterConverter() = default;
 
 PdfToPwgRasterConverter::~PdfToPwgRasterConverter() {}
@@ -147,4 +378,32 @@ void PdfToPwgRasterConverter::Convert(
   std::move(callback).Run(std::move(region), page_count);
 }
 
+void PdfToPwgRasterConverter::ConvertStreaming(
+    base::ReadOnlySharedMemoryRegion pdf_region,
+    const PdfRenderSettings& pdf_settings,
+    const PwgRasterSettings& pwg_raster_settings,
+    mojo::PendingRemote<mojom::PwgRasterStreamClient> client) {
+  base::ReadOnlySharedMemoryMapping pdf_mapping = pdf_region.Map();
+  int total_page_count = 0;
+  if (!pdf_mapping.IsValid() ||
+      !GetPageCount(pdf_mapping.GetMemoryAsSpan<const uint8_t>(),
+                    &total_page_count)) {
+    mojo::Remote<mojom::PwgRasterStreamClient>(std::move(client))
+        ->OnConversionDone(/*success=*/false, /*page_count=*/0);
+    return;
+  }
+
+  streaming_jobs_.push_back(std::make_unique<StreamingJob>(
+      weak_ptr_factory_.GetWeakPtr(), std::move(pdf_mapping), total_page_count,
+      pdf_settings, pwg_raster_settings, std::move(client)));
+  streaming_jobs_.back()->Start();
+}
+
+void PdfToPwgRasterConverter::OnStreamingJobDone(StreamingJob* job) {
+  base::EraseIf(streaming_jobs_,
+                [job](const std::unique_ptr<StreamingJob>& streaming_job) {
+                  return streaming_job.get() == job;
+                });
+}
+
 }  // namespace printing
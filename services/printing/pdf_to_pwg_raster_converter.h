@@ -6,9 +6,12 @@
 #define CHROME_SERVICES_PRINTING_PDF_TO_PWG_RASTER_CONVERTER_H_
 
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
+#include "base/memory/weak_ptr.h"
 #include "chrome/services/printing/public/mojom/pdf_to_pwg_raster_converter.mojom.h"
+#include "mojo/public/cpp/bindings/pending_remote.h"
 
 namespace printing {
 
@@ -26,6 +29,18 @@ class PdfToPwgRasterConverter
                const PdfRenderSettings& pdf_settings,
                const PwgRasterSettings& pwg_raster_settings,
                ConvertCallback callback) override;
+  void ConvertStreaming(
+      base::ReadOnlySharedMemoryRegion pdf_region,
+      const PdfRenderSettings& pdf_settings,
+      const PwgRasterSettings& pwg_raster_settings,
+      mojo::PendingRemote<mojom::PwgRasterStreamClient> client) override;
+
+  class StreamingJob;
+  void OnStreamingJobDone(StreamingJob* job);
+
+  std::vector<std::unique_ptr<StreamingJob>> streaming_jobs_;
+
+  base::WeakPtrFactory<PdfToPwgRasterConverter> weak_ptr_factory_{this};
 
   DISALLOW_COPY_AND_ASSIGN(PdfToPwgRasterConverter);
 };
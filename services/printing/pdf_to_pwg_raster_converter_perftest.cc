@@ -0,0 +1,238 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/services/printing/pdf_to_pwg_raster_converter.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/read_only_shared_memory_region.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/task_environment.h"
+#include "base/timer/elapsed_timer.h"
+#include "mojo/public/cpp/bindings/receiver.h"
+#include "printing/mojom/print.mojom.h"
+#include "printing/pdf_render_settings.h"
+#include "printing/pwg_raster_settings.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace printing {
+
+namespace {
+
+constexpr char kMetricPrefix[] = "PdfToPwgRaster.";
+constexpr char kMetricConvertTime[] = "convert_time";
+constexpr char kMetricTimeToFirstPage[] = "time_to_first_page";
+constexpr char kMetricLargestBuffer[] = "largest_buffer";
+
+constexpr int kPageCount = 12;
+// US Letter, in points.
+constexpr int kPageWidthPt = 612;
+constexpr int kPageHeightPt = 792;
+
+// Builds a PDF with |page_count| pages, each filled with colored stripes so
+// that PWG encoding has actual runs to compress. There is no xref table, which
+// PDFium reconstructs.
+std::string CreateMultiPagePdf(int page_count) {
+  std::string content;
+  for (int i = 0; i < 24; ++i) {
+    base::StringAppendF(&content, "%.2f %.2f %.2f rg 36 %d 540 %d re f\n",
+                        (i % 3) / 2.0, (i % 5) / 4.0, (i % 7) / 6.0,
+                        36 + i * 30, 15 + i % 10);
+  }
+
+  std::string pdf = "%PDF-1.4\n";
+  base::StringAppendF(&pdf, "1 0 obj\n<< /Length %zu >>\nstream\n%s",
+                      content.size(), content.c_str());
+  pdf += "endstream\nendobj\n";
+
+  std::string kids;
+  for (int i = 0; i < page_count; ++i) {
+    const int object_number = 3 + i;
+    base::StringAppendF(&kids, "%d 0 R ", object_number);
+    base::StringAppendF(&pdf,
+                        "%d 0 obj\n<< /Type /Page /Parent 2 0 R "
+                        "/Contents 1 0 R >>\nendobj\n",
+                        object_number);
+  }
+  base::StringAppendF(&pdf,
+                      "2 0 obj\n<< /Type /Pages /Kids [ %s] /Count %d "
+                      "/MediaBox [ 0 0 %d %d ] >>\nendobj\n",
+                      kids.c_str(), page_count, kPageWidthPt, kPageHeightPt);
+  const int catalog_number = 3 + page_count;
+  base::StringAppendF(&pdf,
+                      "%d 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n"
+                      "trailer\n<< /Root %d 0 R >>\n%%%%EOF\n",
+                      catalog_number, catalog_number);
+  return pdf;
+}
+
+base::ReadOnlySharedMemoryRegion CreatePdfRegion(const std::string& pdf) {
+  base::MappedReadOnlyRegion memory =
+      base::ReadOnlySharedMemoryRegion::Create(pdf.size());
+  CHECK(memory.IsValid());
+  memcpy(memory.mapping.memory(), pdf.data(), pdf.size());
+  return std::move(memory.region);
+}
+
+PdfRenderSettings GetRenderSettings(int dpi) {
+  return PdfRenderSettings(
+      gfx::Rect(0, 0, kPageWidthPt * dpi / 72, kPageHeightPt * dpi / 72),
+      gfx::Point(0, 0), gfx::Size(dpi, dpi),
+      /*autorotate=*/false, /*use_color=*/true,
+      PdfRenderSettings::Mode::NORMAL);
+}
+
+PwgRasterSettings GetPwgSettings() {
+  PwgRasterSettings pwg_settings;
+  pwg_settings.duplex_mode = mojom::DuplexMode::kLongEdge;
+  pwg_settings.odd_page_transform =
+      PwgRasterTransformType::TRANSFORM_ROTATE_180;
+  pwg_settings.rotate_all_pages = false;
+  pwg_settings.reverse_page_order = false;
+  pwg_settings.use_color = true;
+  return pwg_settings;
+}
+
+class StreamClient : public mojom::PwgRasterStreamClient {
+ public:
+  explicit StreamClient(base::OnceClosure done_closure)
+      : done_closure_(std::move(done_closure)) {}
+
+  mojo::PendingRemote<mojom::PwgRasterStreamClient> BindNewPipeAndPassRemote() {
+    return receiver_.BindNewPipeAndPassRemote();
+  }
+
+  // mojom::PwgRasterStreamClient:
+  void OnPageConverted(
+      base::ReadOnlySharedMemoryRegion pwg_page_region) override {
+    if (chunk_count_++ == 0)
+      time_to_first_page_ = timer_.Elapsed();
+    largest_chunk_size_ =
+        std::max(largest_chunk_size_, pwg_page_region.GetSize());
+    base::ReadOnlySharedMemoryMapping mapping = pwg_page_region.Map();
+    ASSERT_TRUE(mapping.IsValid());
+    data_.append(static_cast<const char*>(mapping.memory()), mapping.size());
+  }
+  void OnConversionDone(bool success, uint32_t page_count) override {
+    success_ = success;
+    page_count_ = page_count;
+    std::move(done_closure_).Run();
+  }
+
+  const std::string& data() const { return data_; }
+  bool success() const { return success_; }
+  uint32_t page_count() const { return page_count_; }
+  size_t chunk_count() const { return chunk_count_; }
+  size_t largest_chunk_size() const { return largest_chunk_size_; }
+  base::TimeDelta time_to_first_page() const { return time_to_first_page_; }
+
+ private:
+  base::OnceClosure done_closure_;
+  mojo::Receiver<mojom::PwgRasterStreamClient> receiver_{this};
+  base::ElapsedTimer timer_;
+  std::string data_;
+  bool success_ = false;
+  uint32_t page_count_ = 0;
+  size_t chunk_count_ = 0;
+  size_t largest_chunk_size_ = 0;
+  base::TimeDelta time_to_first_page_;
+};
+
+}  // namespace
+
+class PdfToPwgRasterConverterPerfTest : public testing::TestWithParam<int> {
+ protected:
+  perf_test::PerfResultReporter SetUpReporter(const std::string& mode) {
+    perf_test::PerfResultReporter reporter(
+        kMetricPrefix,
+        base::StringPrintf("%s_%d_pages_%d_dpi", mode.c_str(), kPageCount,
+                           GetParam()));
+    reporter.RegisterImportantMetric(kMetricConvertTime, "ms");
+    reporter.RegisterImportantMetric(kMetricTimeToFirstPage, "ms");
+    reporter.RegisterImportantMetric(kMetricLargestBuffer, "bytes");
+    return reporter;
+  }
+
+  mojom::PdfToPwgRasterConverter* converter() { return &converter_; }
+
+ private:
+  base::test::TaskEnvironment task_environment_;
+  PdfToPwgRasterConverter converter_;
+};
+
+// Compares the buffered Convert() with ConvertStreaming(), and checks that
+// both produce the same PWG document.
+TEST_P(PdfToPwgRasterConverterPerfTest, ConvertMultiPageDocument) {
+  const std::string pdf = CreateMultiPagePdf(kPageCount);
+  const PdfRenderSettings render_settings = GetRenderSettings(GetParam());
+
+  std::string buffered_data;
+  {
+    perf_test::PerfResultReporter reporter = SetUpReporter("buffered");
+    base::ReadOnlySharedMemoryRegion pwg_region;
+    uint32_t page_count = 0;
+    base::RunLoop run_loop;
+    base::ElapsedTimer timer;
+    converter()->Convert(
+        CreatePdfRegion(pdf), render_settings, GetPwgSettings(),
+        base::BindOnce(
+            [](base::ReadOnlySharedMemoryRegion* region_out,
+               uint32_t* page_count_out, base::OnceClosure quit,
+               base::ReadOnlySharedMemoryRegion region, uint32_t page_count) {
+              *region_out = std::move(region);
+              *page_count_out = page_count;
+              std::move(quit).Run();
+            },
+            &pwg_region, &page_count, run_loop.QuitClosure()));
+    run_loop.Run();
+    const base::TimeDelta elapsed = timer.Elapsed();
+
+    ASSERT_TRUE(pwg_region.IsValid());
+    EXPECT_EQ(static_cast<uint32_t>(kPageCount), page_count);
+    base::ReadOnlySharedMemoryMapping mapping = pwg_region.Map();
+    ASSERT_TRUE(mapping.IsValid());
+    buffered_data.assign(static_cast<const char*>(mapping.memory()),
+                         mapping.size());
+
+    reporter.AddResult(kMetricConvertTime, elapsed);
+    // Nothing is available before the whole document is converted.
+    reporter.AddResult(kMetricTimeToFirstPage, elapsed);
+    reporter.AddResult(kMetricLargestBuffer, buffered_data.size());
+  }
+
+  {
+    perf_test::PerfResultReporter reporter = SetUpReporter("streaming");
+    base::RunLoop run_loop;
+    StreamClient client(run_loop.QuitClosure());
+    base::ElapsedTimer timer;
+    converter()->ConvertStreaming(CreatePdfRegion(pdf), render_settings,
+                                  GetPwgSettings(),
+                                  client.BindNewPipeAndPassRemote());
+    run_loop.Run();
+    const base::TimeDelta elapsed = timer.Elapsed();
+
+    ASSERT_TRUE(client.success());
+    EXPECT_EQ(static_cast<uint32_t>(kPageCount), client.page_count());
+    EXPECT_EQ(static_cast<size_t>(kPageCount), client.chunk_count());
+    EXPECT_EQ(buffered_data, client.data());
+
+    reporter.AddResult(kMetricConvertTime, elapsed);
+    reporter.AddResult(kMetricTimeToFirstPage, client.time_to_first_page());
+    reporter.AddResult(kMetricLargestBuffer, client.largest_chunk_size());
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(All,
+                         PdfToPwgRasterConverterPerfTest,
+                         testing::Values(150, 300, 600));
+
+}  // namespace printing
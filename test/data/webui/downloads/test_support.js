@@ -49,6 +49,9 @@ class FakePageHandler {
   /** @override */
   getDownloads(searchTerms) {}
 
+  /** @override */
+  setVisibleRowCount(count) {}
+
   /** @override */
   openFileRequiringGesture(id) {}
 